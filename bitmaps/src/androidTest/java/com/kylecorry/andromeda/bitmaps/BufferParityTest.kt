@@ -0,0 +1,251 @@
+package com.kylecorry.andromeda.bitmaps
+
+import android.graphics.Bitmap
+import android.graphics.PixelFormat
+import android.hardware.HardwareBuffer
+import android.media.Image
+import android.media.ImageReader
+import android.media.ImageWriter
+import android.os.Build
+import androidx.annotation.RequiresApi
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+import kotlin.random.Random
+
+/**
+ * Checks that the direct ByteBuffer, FloatBuffer and HardwareBuffer variants give the same bytes
+ * as the ByteArray, FloatArray and Bitmap ones.
+ */
+class BufferParityTest {
+
+    // Odd, so that the rows of a HardwareBuffer are padded.
+    private val width = 67
+    private val height = 45
+
+    private val matrix = floatArrayOf(
+        0.6f, 0.2f, 0.1f, 0f,
+        0.3f, 0.7f, 0.1f, 0f,
+        0.1f, 0.1f, 0.8f, 0f,
+        0f, 0f, 0f, 1f
+    )
+
+    @Test
+    fun byteBufferMatchesArrayAndBitmap() {
+        val array = createImage()
+        val buffer = directBuffer(array)
+        val bitmap = toBitmap(array, width, height)
+
+        val blurred = Toolkit.blur(array, 4, width, height, 3)
+        assertArrayEquals(blurred, toBytes(Toolkit.blur(buffer, 4, width, height, 3)))
+        assertArrayEquals(blurred, toBytes(Toolkit.blur(bitmap, 3)))
+
+        val transformed = Toolkit.colorMatrix(array, 4, width, height, 4, matrix)
+        assertArrayEquals(
+            transformed,
+            toBytes(Toolkit.colorMatrix(buffer, 4, width, height, 4, matrix))
+        )
+        assertArrayEquals(transformed, toBytes(Toolkit.colorMatrix(bitmap, matrix)))
+
+        val resized = Toolkit.resize(array, 4, width, height, 40, 29)
+        assertArrayEquals(resized, toBytes(Toolkit.resize(buffer, 4, width, height, 40, 29)))
+        assertArrayEquals(resized, toBytes(Toolkit.resize(bitmap, 40, 29)))
+
+        val restriction = Range2d(3, 50, 7, 40)
+        val histogram = Toolkit.histogram(array, 4, width, height, restriction)
+        assertArrayEquals(histogram, Toolkit.histogram(buffer, 4, width, height, restriction))
+        assertArrayEquals(histogram, Toolkit.histogram(bitmap, restriction))
+    }
+
+    @Test
+    fun floatBufferMatchesFloatArray() {
+        val r = Random(2)
+        val array = FloatArray(width * height * 3) { r.nextFloat() }
+        for (i in array.indices step 23) {
+            array[i] = Float.NaN
+        }
+        val buffer = ByteBuffer.allocateDirect(array.size * 4).order(ByteOrder.nativeOrder())
+            .asFloatBuffer().put(array)
+        buffer.rewind()
+
+        assertArrayEquals(
+            Toolkit.blur(array, 3, width, height, 4),
+            toFloats(Toolkit.blur(buffer, 3, width, height, 4)),
+            0f
+        )
+        val colorMatrix = floatArrayOf(
+            0.5f, 0.2f, 0.1f, 0f,
+            0.3f, 0.5f, 0.1f, 0f,
+            0.2f, 0.3f, 0.8f, 0f,
+            0f, 0f, 0f, 0f
+        )
+        assertArrayEquals(
+            Toolkit.colorMatrix(array, 3, width, height, 3, colorMatrix),
+            toFloats(Toolkit.colorMatrix(buffer, 3, width, height, 3, colorMatrix)),
+            0f
+        )
+        assertArrayEquals(
+            Toolkit.interpolateFloatBitmap(array, width, height, 3, 100, 80),
+            toFloats(Toolkit.interpolateFloatBitmap(buffer, width, height, 3, 100, 80)),
+            0f
+        )
+    }
+
+    @Test
+    fun paddedHardwareBufferMatchesArray() {
+        assumeTrue(Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q)
+        val array = createImage()
+        val input = ImageBuffer(width, height)
+        input.write(array)
+        val inputBuffer = input.image.hardwareBuffer!!
+
+        assertArrayEquals(
+            Toolkit.blur(array, 4, width, height, 3),
+            readBack(Toolkit.blur(inputBuffer, 3))
+        )
+        assertArrayEquals(
+            Toolkit.colorMatrix(array, 4, width, height, 4, matrix),
+            readBack(Toolkit.colorMatrix(inputBuffer, matrix))
+        )
+        assertArrayEquals(
+            Toolkit.resize(array, 4, width, height, 40, 29),
+            readBack(Toolkit.resize(inputBuffer, 40, 29))
+        )
+
+        val restriction = Range2d(3, 50, 7, 40)
+        assertArrayEquals(
+            Toolkit.histogram(array, 4, width, height, restriction),
+            Toolkit.histogram(inputBuffer, restriction)
+        )
+        assertEquals(
+            Toolkit.average(array, width, height, 4, restriction),
+            Toolkit.average(inputBuffer, 4, restriction),
+            0.0
+        )
+
+        inputBuffer.close()
+        input.close()
+    }
+
+    private fun createImage(): ByteArray {
+        val r = Random(1)
+        val array = ByteArray(width * height * 4) { r.nextInt(256).toByte() }
+        // Opaque, so that the premultiplied Bitmaps hold the same bytes.
+        for (i in 3 until array.size step 4) {
+            array[i] = 255.toByte()
+        }
+        return array
+    }
+
+    private fun directBuffer(array: ByteArray): ByteBuffer {
+        val buffer = ByteBuffer.allocateDirect(array.size).order(ByteOrder.nativeOrder())
+        buffer.put(array).rewind()
+        return buffer
+    }
+
+    private fun toBitmap(array: ByteArray, width: Int, height: Int): Bitmap {
+        val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        bitmap.copyPixelsFromBuffer(ByteBuffer.wrap(array))
+        return bitmap
+    }
+
+    private fun toBytes(bitmap: Bitmap): ByteArray {
+        val array = ByteArray(bitmap.width * bitmap.height * 4)
+        bitmap.copyPixelsToBuffer(ByteBuffer.wrap(array))
+        return array
+    }
+
+    private fun toBytes(buffer: ByteBuffer): ByteArray {
+        val array = ByteArray(buffer.capacity())
+        buffer.rewind()
+        buffer.get(array)
+        return array
+    }
+
+    private fun toFloats(buffer: FloatBuffer): FloatArray {
+        val array = FloatArray(buffer.capacity())
+        buffer.rewind()
+        buffer.get(array)
+        return array
+    }
+
+    /**
+     * Copies the HardwareBuffer made by the toolkit, which the CPU can't read from Kotlin, into
+     * one whose rows can be read, and returns its packed bytes.
+     */
+    @RequiresApi(Build.VERSION_CODES.Q)
+    private fun readBack(buffer: HardwareBuffer): ByteArray {
+        val copy = ImageBuffer(buffer.width, buffer.height)
+        val copyBuffer = copy.image.hardwareBuffer!!
+        Toolkit.blend(BlendingMode.SRC, buffer, copyBuffer)
+        val array = copy.read()
+        copyBuffer.close()
+        copy.close()
+        buffer.close()
+        return array
+    }
+
+    /**
+     * A RGBA_8888 HardwareBuffer whose pixels the test can write and read through an Image. Its
+     * rows are padded to the stride the allocator picks.
+     */
+    @RequiresApi(Build.VERSION_CODES.Q)
+    private class ImageBuffer(private val width: Int, private val height: Int) {
+        private val reader = ImageReader.newInstance(
+            width,
+            height,
+            PixelFormat.RGBA_8888,
+            1,
+            HardwareBuffer.USAGE_CPU_READ_OFTEN or HardwareBuffer.USAGE_CPU_WRITE_OFTEN
+        )
+        private val writer = ImageWriter.newInstance(reader.surface, 1)
+        private var pending: Image? = writer.dequeueInputImage()
+        private var acquired: Image? = null
+
+        /**
+         * The image of the consumer side. The first access queues the pixels written so far.
+         */
+        val image: Image
+            get() {
+                if (acquired == null) {
+                    writer.queueInputImage(pending)
+                    pending = null
+                    acquired = reader.acquireNextImage()
+                }
+                return acquired!!
+            }
+
+        fun write(array: ByteArray) {
+            val plane = pending!!.planes[0]
+            assertEquals(4, plane.pixelStride)
+            val buffer = plane.buffer
+            for (y in 0 until height) {
+                buffer.position(y * plane.rowStride)
+                buffer.put(array, y * width * 4, width * 4)
+            }
+        }
+
+        fun read(): ByteArray {
+            // The planes are mapped on first access, after the toolkit wrote to the buffer.
+            val plane = image.planes[0]
+            val buffer = plane.buffer
+            val array = ByteArray(width * height * 4)
+            for (y in 0 until height) {
+                buffer.position(y * plane.rowStride)
+                buffer.get(array, y * width * 4, width * 4)
+            }
+            return array
+        }
+
+        fun close() {
+            pending?.close()
+            acquired?.close()
+            writer.close()
+            reader.close()
+        }
+    }
+}
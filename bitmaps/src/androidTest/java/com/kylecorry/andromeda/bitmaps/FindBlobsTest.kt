@@ -2,6 +2,7 @@ package com.kylecorry.andromeda.bitmaps
 
 import android.graphics.Bitmap
 import android.graphics.Color
+import android.graphics.Rect
 import org.junit.Assert.assertEquals
 import org.junit.Test
 
@@ -47,6 +48,45 @@ class FindBlobsTest {
         assertEquals(10000, sameBlobs[0].width() * sameBlobs[0].height())
     }
 
+    @Test
+    fun findBlobsWithStatistics() {
+        val bitmap = createBitmap()
+
+        // An L shaped blob: a 10x2 bar with a 2x8 leg below its left end
+        for (x in 0 until 10) {
+            for (y in 0 until 2) {
+                bitmap.setPixel(x + 20, y + 30, Color.WHITE)
+            }
+        }
+        for (x in 0 until 2) {
+            for (y in 2 until 10) {
+                bitmap.setPixel(x + 20, y + 30, Color.WHITE)
+            }
+        }
+
+        // A single pixel
+        bitmap.setPixel(70, 70, Color.WHITE)
+
+        val blobs = Toolkit.findBlobsWithStatistics(bitmap, 4, 127f, 10)
+
+        assertEquals(2, blobs.size)
+        assertEquals(Rect(20, 30, 30, 40), blobs[0].bounds)
+        assertEquals(100, blobs[0].area)
+        assertEquals(36, blobs[0].pixelCount)
+        assertEquals(818f / 36, blobs[0].centroidX, 0.0001f)
+        assertEquals(1178f / 36, blobs[0].centroidY, 0.0001f)
+        assertEquals(Rect(70, 70, 71, 71), blobs[1].bounds)
+        assertEquals(1, blobs[1].pixelCount)
+        assertEquals(70f, blobs[1].centroidX, 0.0001f)
+
+        // The restriction cuts the blobs at its edges
+        val restricted =
+            Toolkit.findBlobsWithStatistics(bitmap, 4, 127f, 10, Range2d(25, 60, 0, 100))
+        assertEquals(1, restricted.size)
+        assertEquals(Rect(25, 30, 30, 32), restricted[0].bounds)
+        assertEquals(10, restricted[0].pixelCount)
+    }
+
     private fun createBitmap(width: Int = 100, height: Int = 100): Bitmap {
         return Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
     }
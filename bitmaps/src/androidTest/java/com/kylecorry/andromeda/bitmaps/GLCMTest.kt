@@ -6,7 +6,11 @@ import android.graphics.Rect
 import org.junit.Assert.assertEquals
 import org.junit.Assert.fail
 import org.junit.Test
+import kotlin.math.abs
+import kotlin.math.ln
+import kotlin.math.max
 import kotlin.math.roundToInt
+import kotlin.math.sqrt
 import kotlin.random.Random
 
 class GLCMTest {
@@ -95,6 +99,198 @@ class GLCMTest {
 
     }
 
+    @Test
+    fun glcmFeaturesMatchGlcm() {
+        val random = createRandomBitmap(100, 100, transparent = true)
+        val steps = intArrayOf(0, 1, 1, 0, 1, 1)
+
+        for (levels in intArrayOf(1, 8, 100, 256)) {
+            for (channel in byteArrayOf(0, 4)) {
+                for (symmetric in booleanArrayOf(false, true)) {
+                    for (excludeTransparent in booleanArrayOf(false, true)) {
+                        for (restriction in listOf(null, Range2d(7, 81, 3, 90))) {
+                            val expected = features(
+                                Toolkit.glcm(
+                                    random, levels, channel, symmetric, false,
+                                    excludeTransparent, steps, restriction
+                                )
+                            )
+                            for (sparse in booleanArrayOf(false, true)) {
+                                featuresEqual(
+                                    expected,
+                                    Toolkit.glcmFeatures(
+                                        random, levels, channel, symmetric,
+                                        excludeTransparent, steps, sparse, restriction
+                                    )
+                                )
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    @Test
+    fun sparseGlcmFeaturesSpill() {
+        // Each thread sees far more distinct pairs than its hash table holds before spilling
+        // into the 64 bit counters.
+        val random = createRandomBitmap(256, 256)
+        val steps = intArrayOf(0, 1, 1, 0, -1, 0, 0, -1)
+
+        for (channel in byteArrayOf(1, 4)) {
+            val expected = features(
+                Toolkit.glcm(random, 256, channel, true, false, false, steps)
+            )
+            featuresEqual(
+                expected,
+                Toolkit.glcmFeatures(random, 256, channel, true, false, steps, sparse = true)
+            )
+            featuresEqual(
+                expected,
+                Toolkit.glcmFeatures(random, 256, channel, true, false, steps, sparse = false)
+            )
+        }
+    }
+
+    @Test
+    fun glcmFeaturesBatchMatchesSingleLevels() {
+        val random = createRandomBitmap(120, 90, transparent = true)
+        val levels = intArrayOf(2, 16, 100, 255, 256)
+        val steps = intArrayOf(0, 1, 1, 0, 2, 2)
+        val restriction = Range2d(10, 110, 0, 80)
+
+        for (excludeTransparent in booleanArrayOf(false, true)) {
+            for (sparse in booleanArrayOf(false, true)) {
+                val batch = Toolkit.glcmFeatures(
+                    random, levels, 4, true, excludeTransparent, steps, sparse, restriction
+                )
+                assertEquals(levels.size, batch.size)
+                for (i in levels.indices) {
+                    val single = Toolkit.glcmFeatures(
+                        random, levels[i], 4, true, excludeTransparent, steps, sparse,
+                        restriction
+                    )
+                    featuresEqual(toArray(single), batch[i], 0f)
+                    featuresEqual(
+                        features(
+                            Toolkit.glcm(
+                                random, levels[i], 4, true, false, excludeTransparent, steps,
+                                restriction
+                            )
+                        ),
+                        batch[i]
+                    )
+                }
+            }
+        }
+    }
+
+    @Test
+    fun glcmFeaturesWithoutPairsAreZero() {
+        val transparent = createBitmap(20, 20)
+        val features = Toolkit.glcmFeatures(
+            transparent, 16, 0, true, true, intArrayOf(0, 1)
+        )
+        featuresEqual(FloatArray(8), features, 0f)
+    }
+
+    /**
+     * The Haralick features of a GLCM of counts, in the order of [GlcmFeatures].
+     */
+    private fun features(glcm: FloatArray): FloatArray {
+        val levels = sqrt(glcm.size.toDouble()).roundToInt()
+        val total = glcm.sumOf { it.toDouble() }
+        if (total == 0.0) {
+            return FloatArray(8)
+        }
+        var contrast = 0.0
+        var dissimilarity = 0.0
+        var homogeneity = 0.0
+        var angularSecondMoment = 0.0
+        var entropy = 0.0
+        var maxProbability = 0.0
+        var meanI = 0.0
+        var meanJ = 0.0
+        for (i in 0 until levels) {
+            for (j in 0 until levels) {
+                val p = glcm[i * levels + j] / total
+                if (p == 0.0) continue
+                val d = (i - j).toDouble()
+                contrast += d * d * p
+                dissimilarity += abs(d) * p
+                homogeneity += p / (1 + d * d)
+                angularSecondMoment += p * p
+                entropy -= p * ln(p)
+                maxProbability = max(maxProbability, p)
+                meanI += i * p
+                meanJ += j * p
+            }
+        }
+        var varianceI = 0.0
+        var varianceJ = 0.0
+        var covariance = 0.0
+        for (i in 0 until levels) {
+            for (j in 0 until levels) {
+                val p = glcm[i * levels + j] / total
+                varianceI += (i - meanI) * (i - meanI) * p
+                varianceJ += (j - meanJ) * (j - meanJ) * p
+                covariance += (i - meanI) * (j - meanJ) * p
+            }
+        }
+        val correlation = if (varianceI > 0 && varianceJ > 0) {
+            covariance / sqrt(varianceI * varianceJ)
+        } else {
+            1.0
+        }
+        return doubleArrayOf(
+            contrast, dissimilarity, homogeneity, angularSecondMoment, sqrt(angularSecondMoment),
+            entropy, correlation, maxProbability
+        ).map { it.toFloat() }.toFloatArray()
+    }
+
+    private fun toArray(features: GlcmFeatures): FloatArray {
+        return floatArrayOf(
+            features.contrast,
+            features.dissimilarity,
+            features.homogeneity,
+            features.angularSecondMoment,
+            features.energy,
+            features.entropy,
+            features.correlation,
+            features.maxProbability
+        )
+    }
+
+    private fun featuresEqual(
+        expected: FloatArray,
+        actual: GlcmFeatures,
+        relativeEpsilon: Float = 1e-4f
+    ) {
+        val values = toArray(actual)
+        for (i in expected.indices) {
+            assertEquals(expected[i], values[i], relativeEpsilon * max(1f, abs(expected[i])))
+        }
+    }
+
+    private fun createRandomBitmap(
+        width: Int,
+        height: Int,
+        transparent: Boolean = false
+    ): Bitmap {
+        val bitmap = createBitmap(width, height)
+        val r = Random(2)
+        for (x in 0 until width) {
+            for (y in 0 until height) {
+                val alpha = if (transparent && r.nextInt(10) == 0) 0 else 255
+                bitmap.setPixel(
+                    x, y, Color.argb(alpha, r.nextInt(256), r.nextInt(256), r.nextInt(256))
+                )
+            }
+        }
+        return bitmap
+    }
+
     private fun arraysEqual(a: FloatArray, b: FloatArray, epsilon: Float = 0.001f) {
         assertEquals(a.size, b.size)
         for (i in a.indices) {
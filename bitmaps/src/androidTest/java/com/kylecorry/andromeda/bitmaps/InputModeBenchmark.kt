@@ -0,0 +1,83 @@
+package com.kylecorry.andromeda.bitmaps
+
+import android.hardware.HardwareBuffer
+import android.os.Build
+import android.os.SystemClock
+import android.util.Log
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Compares the time of the ByteArray, direct ByteBuffer and HardwareBuffer variants of a few
+ * operations. The medians are logged under the InputModeBenchmark tag.
+ */
+class InputModeBenchmark {
+
+    @Test
+    fun oneMegapixel() {
+        benchmark(1024, 1024)
+    }
+
+    @Test
+    fun twelveMegapixels() {
+        benchmark(4000, 3000)
+    }
+
+    private fun benchmark(width: Int, height: Int) {
+        val array = ByteArray(width * height * 4) { (it * 31).toByte() }
+        val buffer = ByteBuffer.allocateDirect(array.size).order(ByteOrder.nativeOrder())
+        buffer.put(array).rewind()
+
+        log(width, height, "array", "blur", median { Toolkit.blur(array, 4, width, height, 5) })
+        log(width, height, "buffer", "blur", median { Toolkit.blur(buffer, 4, width, height, 5) })
+        log(width, height, "array", "threshold", median {
+            Toolkit.threshold(array, width, height, 0.5f, true, 4)
+        })
+        log(width, height, "buffer", "threshold", median {
+            Toolkit.threshold(buffer, width, height, 0.5f, true, 4)
+        })
+        log(width, height, "array", "average", median {
+            Toolkit.average(array, width, height, 4)
+        })
+        log(width, height, "buffer", "average", median {
+            Toolkit.average(buffer, width, height, 4)
+        })
+
+        assumeTrue(Build.VERSION.SDK_INT >= Build.VERSION_CODES.O)
+        val hardwareBuffer = HardwareBuffer.create(
+            width,
+            height,
+            HardwareBuffer.RGBA_8888,
+            1,
+            HardwareBuffer.USAGE_CPU_READ_OFTEN or HardwareBuffer.USAGE_CPU_WRITE_OFTEN
+        )
+        log(width, height, "hardware", "blur", median {
+            Toolkit.blur(hardwareBuffer, 5).close()
+        })
+        log(width, height, "hardware", "threshold", median {
+            Toolkit.threshold(hardwareBuffer, 0.5f, true, 4).close()
+        })
+        log(width, height, "hardware", "average", median {
+            Toolkit.average(hardwareBuffer, 4)
+        })
+        hardwareBuffer.close()
+    }
+
+    private fun median(block: () -> Unit): Long {
+        // The first run warms up the thread pool and the caches.
+        block()
+        val times = LongArray(9) {
+            val start = SystemClock.elapsedRealtimeNanos()
+            block()
+            SystemClock.elapsedRealtimeNanos() - start
+        }
+        times.sort()
+        return times[times.size / 2]
+    }
+
+    private fun log(width: Int, height: Int, mode: String, operation: String, nanos: Long) {
+        Log.i("InputModeBenchmark", "${width}x$height $operation $mode: ${nanos / 1000} us")
+    }
+}
@@ -0,0 +1,120 @@
+package com.kylecorry.andromeda.bitmaps
+
+import android.graphics.Bitmap
+import android.graphics.Color
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Test
+import kotlin.math.sqrt
+import kotlin.random.Random
+
+class StatisticsTest {
+
+    private val all = Statistic.entries.toSet()
+
+    @Test
+    fun matchesTheSinglePurposeOps() {
+        val bitmap = createRandomBitmap()
+
+        for (channel in 0..4) {
+            val stats = Toolkit.statistics(bitmap, channel.toByte(), all)
+            val minMax = Toolkit.minMax(bitmap, channel.toByte())
+            val average = Toolkit.average(bitmap, channel.toByte())
+            val standardDeviation = Toolkit.standardDeviation(bitmap, channel.toByte())
+            val moment = Toolkit.moment(bitmap, channel.toByte())
+
+            assertEquals(minMax[0], stats.min!!, 0f)
+            assertEquals(minMax[1], stats.max!!, 0f)
+            assertEquals(average, stats.average!!, 1e-9)
+            assertEquals(standardDeviation, stats.standardDeviation!!, 1e-9)
+            assertEquals(moment[0], stats.momentX!!, 1e-3f)
+            assertEquals(moment[1], stats.momentY!!, 1e-3f)
+            assertArrayEquals(Toolkit.histogram(bitmap), stats.histogram)
+        }
+    }
+
+    @Test
+    fun matchesTheSinglePurposeOpsWithRestriction() {
+        val bitmap = createRandomBitmap()
+        val restriction = Range2d(5, 48, 11, 37)
+        val total = bitmap.width * bitmap.height
+        val count = (restriction.endX - restriction.startX) *
+                (restriction.endY - restriction.startY)
+
+        for (channel in 0..4) {
+            val stats = Toolkit.statistics(bitmap, channel.toByte(), all, restriction)
+            val minMax = Toolkit.minMax(bitmap, channel.toByte(), restriction)
+            val moment = Toolkit.moment(bitmap, channel.toByte(), restriction)
+
+            // average and standardDeviation divide by the size of the whole image, statistics by
+            // the number of pixels in the restriction
+            val average = Toolkit.average(bitmap, channel.toByte(), restriction) * total / count
+            val variance = Toolkit.standardDeviation(
+                bitmap, channel.toByte(), average, restriction
+            ).let { it * it } * total / count
+
+            assertEquals(minMax[0], stats.min!!, 0f)
+            assertEquals(minMax[1], stats.max!!, 0f)
+            assertEquals(average, stats.average!!, 1e-9)
+            assertEquals(sqrt(variance), stats.standardDeviation!!, 1e-9)
+            assertEquals(moment[0], stats.momentX!!, 1e-3f)
+            assertEquals(moment[1], stats.momentY!!, 1e-3f)
+            assertArrayEquals(Toolkit.histogram(bitmap, restriction), stats.histogram)
+        }
+    }
+
+    @Test
+    fun matchesAReference() {
+        val bitmap = createRandomBitmap()
+        val restriction = Range2d(5, 48, 11, 37)
+        val values = mutableListOf<Int>()
+        var sumOfX = 0.0
+        var sumOfY = 0.0
+        for (y in restriction.startY until restriction.endY) {
+            for (x in restriction.startX until restriction.endX) {
+                val value = Color.green(bitmap.getPixel(x, y))
+                values.add(value)
+                sumOfX += x * value
+                sumOfY += y * value
+            }
+        }
+        val mean = values.sum().toDouble() / values.size
+        val variance = values.sumOf { (it - mean) * (it - mean) } / values.size
+
+        val stats = Toolkit.statistics(bitmap, 1, all, restriction)
+
+        assertEquals(values.min().toFloat(), stats.min!!, 0f)
+        assertEquals(values.max().toFloat(), stats.max!!, 0f)
+        assertEquals(mean, stats.average!!, 1e-9)
+        assertEquals(sqrt(variance), stats.standardDeviation!!, 1e-9)
+        assertEquals((sumOfX / values.sum()).toFloat(), stats.momentX!!, 1e-3f)
+        assertEquals((sumOfY / values.sum()).toFloat(), stats.momentY!!, 1e-3f)
+    }
+
+    @Test
+    fun onlyComputesTheRequestedStatistics() {
+        val bitmap = createRandomBitmap()
+
+        val stats = Toolkit.statistics(bitmap, 4, setOf(Statistic.Average))
+
+        assertEquals(Toolkit.average(bitmap, 4), stats.average!!, 1e-9)
+        assertNull(stats.min)
+        assertNull(stats.max)
+        assertNull(stats.standardDeviation)
+        assertNull(stats.momentX)
+        assertNull(stats.momentY)
+        assertNull(stats.histogram)
+    }
+
+    private fun createRandomBitmap(width: Int = 67, height: Int = 53): Bitmap {
+        val bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888)
+        val r = Random(1)
+        for (i in 0 until width) {
+            for (j in 0 until height) {
+                bitmap.setPixel(i, j, Color.rgb(r.nextInt(256), r.nextInt(256), r.nextInt(256)))
+            }
+        }
+        return bitmap
+    }
+}
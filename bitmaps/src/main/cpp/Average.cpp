@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
+#include "Reduction.h"
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
 #include "Utils.h"
@@ -9,10 +12,12 @@
 namespace renderscript {
 
     class AverageTask : public Task {
-        const uchar4 *mIn;
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
         const uint32_t mThreadCount;
-        std::vector<double> mTotals;
+        // The sums of the cell values of each thread. For gray, the values are r + g + b.
+        PerThread<uint64_t> mTotals;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -22,7 +27,8 @@ namespace renderscript {
         AverageTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
                    uint32_t threadCount, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
                   mChannel{channel},
                   mThreadCount{threadCount},
                   mTotals(threadCount) {}
@@ -33,45 +39,33 @@ namespace renderscript {
     void
     AverageTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                             size_t endY) {
-
+        uint64_t total = 0;
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-            for (size_t x = startX; x < endX; x++) {
-                auto v = *in;
-                double value;
-                if (mChannel == 0) {
-                    value = v.r;
-                } else if (mChannel == 1) {
-                    value = v.g;
-                } else if (mChannel == 2) {
-                    value = v.b;
-                } else if (mChannel == 3) {
-                    value = v.a;
-                } else {
-                    value = (v.r + v.g + v.b) / 3.0;
-                }
-
-                mTotals[threadIndex] += value;
-
-                in++;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerReductionRun) {
+                ReductionSums run;
+                reduceRun(in + x, std::min(endX - x, kMaxCellsPerReductionRun), mChannel,
+                          mUsesSimd, &run);
+                total += run.sum;
             }
         }
+        mTotals[threadIndex] += total;
     }
 
     double AverageTask::collate() {
-        double sum = 0;
+        uint64_t sum = 0;
         for (uint32_t t = 0; t < mThreadCount; t++) {
             sum += mTotals[t];
         }
-        return sum / (mSizeX * mSizeY);
+        const double scale = mChannel <= 3 ? 1.0 : 3.0;
+        return sum / scale / (mSizeX * mSizeY);
     }
 
     double RenderScriptToolkit::average(const uint8_t *input, size_t sizeX,
                                      size_t sizeY, uint8_t channel,
                                      const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
             return 0;
         }
 #endif
@@ -81,4 +75,80 @@ namespace renderscript {
         return task.collate();
     }
 
+    class FloatAverageTask : public Task {
+        const float *mIn;
+        const size_t mInStride;
+        const uint8_t mChannel;
+        const uint32_t mThreadCount;
+        // The sums of the cell values of each thread, and how many cells weren't NaN.
+        PerThread<double> mTotals;
+        PerThread<size_t> mCounts;
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        FloatAverageTask(const float *input, size_t sizeX, size_t sizeY, size_t vectorSize,
+                         uint8_t channel, uint32_t threadCount, const Restriction *restriction)
+                : Task{sizeX, sizeY, vectorSize, true, restriction},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * vectorSize * sizeof(float))},
+                  mChannel{channel},
+                  mThreadCount{threadCount},
+                  mTotals(threadCount),
+                  mCounts(threadCount) {
+            setElementSize(sizeof(float));
+        }
+
+        double collate();
+    };
+
+    void
+    FloatAverageTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                  size_t endY) {
+        FloatReductionSums all;
+        for (size_t y = startY; y < endY; y++) {
+            const float *in = reinterpret_cast<const float *>(
+                    reinterpret_cast<const uint8_t *>(mIn) + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerFloatReductionRun) {
+                reduceRun(in + x * mVectorSize,
+                          std::min(endX - x, kMaxCellsPerFloatReductionRun), mVectorSize,
+                          mChannel, 0.f, &all);
+            }
+        }
+        mTotals[threadIndex] += all.sum;
+        mCounts[threadIndex] += all.count;
+    }
+
+    double FloatAverageTask::collate() {
+        double sum = 0;
+        size_t count = 0;
+        for (uint32_t t = 0; t < mThreadCount; t++) {
+            sum += mTotals[t];
+            count += mCounts[t];
+        }
+        return count == 0 ? NAN : sum / count;
+    }
+
+    double RenderScriptToolkit::average(const float *input, size_t sizeX, size_t sizeY,
+                                        size_t vectorSize, uint8_t channel,
+                                        const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                              sizeX * vectorSize * sizeof(float), 0)) {
+            return 0;
+        }
+        if (vectorSize < 1 || vectorSize > 4) {
+            ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+            return 0;
+        }
+#endif
+
+        FloatAverageTask task(input, sizeX, sizeY, vectorSize, channel,
+                              processor->getNumberOfThreads(), restriction);
+        processor->doTask(&task);
+        return task.collate();
+    }
+
 }  // namespace renderscript
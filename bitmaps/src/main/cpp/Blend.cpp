@@ -32,9 +32,12 @@ class BlendTask : public Task {
     // The type of blending to do.
     RenderScriptToolkit::BlendingMode mMode;
     // The input we're blending.
-    const uchar4* mIn;
+    const uint8_t* mIn;
     // The destination, used both for input and output.
-    uchar4* mOut;
+    uint8_t* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
 
     void blend(RenderScriptToolkit::BlendingMode mode, const uchar4* in, uchar4* out,
                uint32_t length);
@@ -47,8 +50,10 @@ class BlendTask : public Task {
               size_t sizeY, const Restriction* restriction)
         : Task{sizeX, sizeY, 4, true, restriction},
           mMode{mode},
-          mIn{reinterpret_cast<const uchar4*>(in)},
-          mOut{reinterpret_cast<uchar4*>(out)} {}
+          mIn{in},
+          mOut{out},
+          mInStride{inputStride(sizeX * sizeof(uchar4))},
+          mOutStride{outputStride(sizeX * sizeof(uchar4))} {}
 };
 
 #if defined(ARCH_ARM_USE_INTRINSICS)
@@ -339,7 +344,7 @@ void BlendTask::blend(RenderScriptToolkit::BlendingMode mode, const uchar4* in,
         break;
 
     default:
-        ALOGE("Called unimplemented value %d", mode);
+        ALOGE("Called unimplemented value %d", static_cast<int>(mode));
         assert(false);
     }
 }
@@ -347,15 +352,16 @@ void BlendTask::blend(RenderScriptToolkit::BlendingMode mode, const uchar4* in,
 void BlendTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                             size_t endY) {
     for (size_t y = startY; y < endY; y++) {
-        size_t offset = y * mSizeX + startX;
-        blend(mMode, mIn + offset, mOut + offset, endX - startX);
+        const uchar4* in = reinterpret_cast<const uchar4*>(mIn + mInStride * y);
+        uchar4* out = reinterpret_cast<uchar4*>(mOut + mOutStride * y);
+        blend(mMode, in + startX, out + startX, endX - startX);
     }
 }
 
 void RenderScriptToolkit::blend(BlendingMode mode, const uint8_t* in, uint8_t* out, size_t sizeX,
                                 size_t sizeY, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
         return;
     }
 #endif
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <new>
 
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
@@ -8,250 +11,536 @@
 
 namespace renderscript {
 
-    struct Point {
-        size_t x;
-        size_t y;
-    };
+    namespace {
+
+        /**
+         * The label of the pixels below the threshold.
+         */
+        constexpr uint32_t kBackground = UINT32_MAX;
+
+        /**
+         * Set in the entry of a root once the blobs are numbered, the other bits being the
+         * number of the blob. The indices of the pixels have it clear.
+         */
+        constexpr uint32_t kNumbered = 0x80000000;
+
+        /**
+         * The number of blobs a thread sums up locally within a tile, see measure().
+         */
+        constexpr size_t kCachedBlobs = 16;
+
+        /**
+         * The bounds and sums of the pixels of a blob, or of the part of a blob a thread has seen.
+         */
+        struct BlobSums {
+            size_t left = SIZE_MAX;
+            size_t top = SIZE_MAX;
+            size_t right = 0;
+            size_t bottom = 0;
+            uint64_t pixelCount = 0;
+            uint64_t sumX = 0;
+            uint64_t sumY = 0;
+
+            /**
+             * Adds the pixels [startX, endX) of row y.
+             */
+            void addRun(size_t startX, size_t endX, size_t y) {
+                left = std::min(left, startX);
+                right = std::max(right, endX);
+                top = std::min(top, y);
+                bottom = std::max(bottom, y + 1);
+                const uint64_t count = endX - startX;
+                pixelCount += count;
+                // The sum of startX..endX - 1.
+                sumX += (startX + endX - 1) * count / 2;
+                sumY += y * count;
+            }
 
-    struct Rect {
-        size_t left;
-        size_t top;
-        size_t right;
-        size_t bottom;
-    };
+            void merge(const BlobSums &other) {
+                left = std::min(left, other.left);
+                top = std::min(top, other.top);
+                right = std::max(right, other.right);
+                bottom = std::max(bottom, other.bottom);
+                pixelCount += other.pixelCount;
+                sumX += other.sumX;
+                sumY += other.sumY;
+            }
+
+            size_t area() const { return (right - left) * (bottom - top); }
+        };
+
+        void atomicMin(std::atomic<size_t> &value, size_t other) {
+            size_t current = value.load(std::memory_order_relaxed);
+            while (other < current &&
+                   !value.compare_exchange_weak(current, other, std::memory_order_relaxed)) {
+            }
+        }
+
+        void atomicMax(std::atomic<size_t> &value, size_t other) {
+            size_t current = value.load(std::memory_order_relaxed);
+            while (other > current &&
+                   !value.compare_exchange_weak(current, other, std::memory_order_relaxed)) {
+            }
+        }
 
+        /**
+         * The sums of a blob, added to by all the threads.
+         */
+        struct SharedBlobSums {
+            std::atomic<size_t> left{SIZE_MAX};
+            std::atomic<size_t> top{SIZE_MAX};
+            std::atomic<size_t> right{0};
+            std::atomic<size_t> bottom{0};
+            std::atomic<uint64_t> pixelCount{0};
+            std::atomic<uint64_t> sumX{0};
+            std::atomic<uint64_t> sumY{0};
+
+            void merge(const BlobSums &other) {
+                atomicMin(left, other.left);
+                atomicMin(top, other.top);
+                atomicMax(right, other.right);
+                atomicMax(bottom, other.bottom);
+                pixelCount.fetch_add(other.pixelCount, std::memory_order_relaxed);
+                sumX.fetch_add(other.sumX, std::memory_order_relaxed);
+                sumY.fetch_add(other.sumY, std::memory_order_relaxed);
+            }
+
+            BlobSums load() const {
+                BlobSums sums;
+                sums.left = left.load(std::memory_order_relaxed);
+                sums.top = top.load(std::memory_order_relaxed);
+                sums.right = right.load(std::memory_order_relaxed);
+                sums.bottom = bottom.load(std::memory_order_relaxed);
+                sums.pixelCount = pixelCount.load(std::memory_order_relaxed);
+                sums.sumX = sumX.load(std::memory_order_relaxed);
+                sums.sumY = sumY.load(std::memory_order_relaxed);
+                return sums;
+            }
+        };
+
+        /**
+         * The values compared to the threshold are the channel, or the sum of red, green, and
+         * blue divided by 3. Finds the smallest one at or above the threshold once, so that each
+         * pixel needs only an integer compare.
+         */
+        int cutoffOf(float threshold, uint8_t channel) {
+            const int maxValue = channel <= 3 ? 255 : 255 * 3;
+            const double divisor = channel <= 3 ? 1.0 : 3.0;
+            int cutoff = 0;
+            while (cutoff <= maxValue && !((float) (cutoff / divisor) >= threshold)) {
+                cutoff++;
+            }
+            return cutoff;
+        }
+
+        /**
+         * The union-find forest of count pixels, borrowed from the arena. The atomics are
+         * constructed in place, which doesn't write to the memory as their default constructor
+         * is trivial. The LABEL pass sets every entry.
+         */
+        std::atomic<uint32_t> *allocateParents(ScratchArena &scratch, size_t count) {
+            std::atomic<uint32_t> *parents = scratch.allocate<std::atomic<uint32_t>>(count);
+            for (size_t i = 0; i < count; i++) {
+                new (&parents[i]) std::atomic<uint32_t>;
+            }
+            return parents;
+        }
+    }  // namespace
+
+    /**
+     * Finds the 4-connected groups of pixels at or above the threshold, with a union-find
+     * labelling of the restricted area done in four passes over the tiles:
+     *  - LABEL: each tile links the runs of pixels of its rows, and joins them to the runs
+     *    they touch in the row above.
+     *  - MERGE: the trees of neighboring tiles are joined along the tile borders.
+     *  - NUMBER: the roots of the trees, i.e. the blobs, are numbered from 0.
+     *  - MEASURE: the pixels are summed by blob, in an array indexed by the number.
+     *
+     * The forest is kept in mParents, one entry per pixel of the restricted area. Each pixel
+     * above the threshold points to a pixel of the same blob and a root points to itself. Roots
+     * are only ever linked to a smaller root, which is what makes the concurrent joins of the
+     * MERGE pass safe without locks: a join is a compare and swap of a root entry, retried if
+     * another thread linked the root first. The passes are ordered by doTask, so the relaxed
+     * loads and stores are enough. NUMBER replaces the entry of each root by its number, with
+     * kNumbered set, which needs fewer than 2^31 pixels.
+     */
     class BlobFinderTask : public Task {
-        const uchar4 *mIn;
+    public:
+        enum class Pass {
+            LABEL,
+            MERGE,
+            NUMBER,
+            MEASURE,
+        };
+
+    private:
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
-        const float mThreshold;
-        std::vector<std::vector<Rect>> mRects;
+        // The smallest value, as given by valueOf, that is at or above the threshold.
+        const int mCutoff;
+        // The restricted area.
+        const size_t mOriginX;
+        const size_t mOriginY;
+        const size_t mWidth;
+        const size_t mHeight;
+        // Borrowed from the scratch arena of the calling thread, like mBlobs.
+        ScratchArena &mScratch;
+        std::atomic<uint32_t> *mParents;
+        Pass mPass = Pass::LABEL;
+        // The largest tile of the LABEL pass, per thread. The full tiles set the tile grid.
+        PerThread<size_t> mTileSizeX;
+        PerThread<size_t> mTileSizeY;
+        size_t mGridX = 0;
+        size_t mGridY = 0;
+        // The number of blobs, counted by the NUMBER pass, and their sums.
+        std::atomic<uint32_t> mBlobCount{0};
+        SharedBlobSums *mBlobs = nullptr;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                          size_t endY) override;
 
-        std::vector<Rect> getAllRects();
+        void label(int threadIndex, size_t startX, size_t startY, size_t endX, size_t endY);
+
+        void merge(size_t startX, size_t startY, size_t endX, size_t endY);
 
-        void removeDuplicates(std::vector<Rect> &rects);
+        void number(size_t startX, size_t startY, size_t endX, size_t endY);
 
-        void sortByArea(std::vector<Rect> &rects);
+        void measure(size_t startX, size_t startY, size_t endX, size_t endY);
 
-        Rect findBlob(size_t x, size_t y);
+        int valueOf(uchar4 v) const { return mChannel <= 3 ? v[mChannel] : v.r + v.g + v.b; }
+
+        uint32_t find(uint32_t index);
+
+        void unite(uint32_t a, uint32_t b);
+
+        uint32_t blobOf(uint32_t index);
+
+        uint32_t indexOf(size_t x, size_t y) const {
+            return (uint32_t) ((y - mOriginY) * mWidth + (x - mOriginX));
+        }
 
     public:
         BlobFinderTask(const uint8_t *input, size_t sizeX, size_t sizeY, float threshold,
-                       uint8_t channel, uint32_t threadCount, const Restriction *restriction)
+                       uint8_t channel, uint32_t threadCount, ScratchArena &scratch,
+                       const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, false, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
                   mChannel{channel},
-                  mThreshold{threshold},
-                  mRects(threadCount) {}
-
-        void collate(size_t maxBlobs, int *out);
+                  mCutoff{cutoffOf(threshold, channel)},
+                  mOriginX{restriction == nullptr ? 0 : restriction->startX},
+                  mOriginY{restriction == nullptr ? 0 : restriction->startY},
+                  mWidth{restriction == nullptr ? sizeX : restriction->endX - restriction->startX},
+                  mHeight{
+                          restriction == nullptr ? sizeY : restriction->endY - restriction->startY},
+                  mScratch{scratch},
+                  mParents{allocateParents(scratch, mWidth * mHeight)},
+                  mTileSizeX(threadCount),
+                  mTileSizeY(threadCount) {}
+
+        void setPass(Pass pass);
+
+        void collate(size_t maxBlobs, int *out, double *statistics);
     };
 
-    void
-    BlobFinderTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
-                                size_t endY) {
-        // Rects of the form x, y, width, height, x, y, width, height, ...
-        std::vector<Rect> &rects = mRects[threadIndex];
-
-        for (size_t y = startY; y < endY; y++) {
-            for (size_t x = startX; x < endX; x++) {
-                // First check to see if any of the clusters contain this value
-                bool foundMatch = false;
-                size_t clusterIndex;
-                for (size_t i = 0; i < rects.size(); i++) {
-                    Rect rect = rects[i];
-                    if (x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom) {
-                        clusterIndex = i;
-                        foundMatch = true;
-                        break;
-                    }
-                }
-
-                if (foundMatch) {
-                    // Skip to the right of the cluster
-                    x = rects[clusterIndex].right;
-                    continue;
-                }
 
-                // No existing cluster found, search for one
-                auto blob = findBlob(x, y);
-                if (blob.left != 0 || blob.top != 0 || blob.right != 0 || blob.bottom != 0) {
-                    rects.push_back(blob);
-                }
+    uint32_t BlobFinderTask::find(uint32_t index) {
+        while (true) {
+            uint32_t parent = mParents[index].load(std::memory_order_relaxed);
+            if (parent == index) {
+                return index;
+            }
+            // Path halving. The grandparent is also an ancestor, so this is safe even if another
+            // thread changes the parent in the meantime.
+            uint32_t grandparent = mParents[parent].load(std::memory_order_relaxed);
+            if (grandparent != parent) {
+                mParents[index].store(grandparent, std::memory_order_relaxed);
             }
+            index = grandparent;
         }
     }
 
-    Rect BlobFinderTask::findBlob(size_t x, size_t y) {
-        std::vector<Point> visited;
-        std::vector<Point> toVisit;
-        size_t minX = 0;
-        size_t minY = 0;
-        size_t maxX = 0;
-        size_t maxY = 0;
-        bool found = false;
-
-        toVisit.push_back({x, y});
-
-        while (!toVisit.empty()) {
-            Point current = toVisit.back();
-            toVisit.pop_back();
-
-            // If we've already visited this point, skip it
-            bool skip = false;
-            for (auto &i: visited) {
-                if (i.x == current.x && i.y == current.y) {
-                    skip = true;
-                    break;
-                }
+    void BlobFinderTask::unite(uint32_t a, uint32_t b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) {
+                return;
             }
-            if (skip) {
-                continue;
+            if (a < b) {
+                std::swap(a, b);
             }
+            // Link the larger root to the smaller one, unless another thread linked it already.
+            uint32_t expected = a;
+            if (mParents[a].compare_exchange_weak(expected, b, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
 
-            visited.push_back(current);
-
-            // If we're out of bounds, skip
-            if (current.x < 0 || current.x >= mSizeX || current.y < 0 ||
-                current.y >= mSizeY) {
-                continue;
+    uint32_t BlobFinderTask::blobOf(uint32_t index) {
+        while (true) {
+            uint32_t parent = mParents[index].load(std::memory_order_relaxed);
+            if (parent & kNumbered) {
+                return parent & ~kNumbered;
+            }
+            // Path halving, as in find.
+            uint32_t grandparent = mParents[parent].load(std::memory_order_relaxed);
+            if (grandparent & kNumbered) {
+                return grandparent & ~kNumbered;
             }
+            mParents[index].store(grandparent, std::memory_order_relaxed);
+            index = grandparent;
+        }
+    }
 
-            size_t offset = mSizeX * current.y + current.x;
-            const uchar4 *in = mIn + offset;
-            auto v = *in;
-            float value;
-            if (mChannel == 0) {
-                value = v.r;
-            } else if (mChannel == 1) {
-                value = v.g;
-            } else if (mChannel == 2) {
-                value = v.b;
-            } else if (mChannel == 3) {
-                value = v.a;
-            } else {
-                value = (float) ((v.r + v.g + v.b) / 3.0);
+    void BlobFinderTask::setPass(Pass pass) {
+        if (pass == Pass::MERGE) {
+            for (size_t t = 0; t < mTileSizeX.size(); t++) {
+                mGridX = std::max(mGridX, mTileSizeX[t]);
+                mGridY = std::max(mGridY, mTileSizeY[t]);
+            }
+        } else if (pass == Pass::MEASURE) {
+            const uint32_t blobCount = mBlobCount.load(std::memory_order_relaxed);
+            mBlobs = mScratch.allocate<SharedBlobSums>(blobCount);
+            for (uint32_t i = 0; i < blobCount; i++) {
+                new (&mBlobs[i]) SharedBlobSums;
             }
+        }
+        mPass = pass;
+    }
 
-            if (value >= mThreshold) {
-                if (!found || current.x < minX) {
-                    minX = current.x;
-                }
+    void
+    BlobFinderTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                size_t endY) {
+        switch (mPass) {
+            case Pass::LABEL:
+                label(threadIndex, startX, startY, endX, endY);
+                break;
+            case Pass::MERGE:
+                merge(startX, startY, endX, endY);
+                break;
+            case Pass::NUMBER:
+                number(startX, startY, endX, endY);
+                break;
+            case Pass::MEASURE:
+                measure(startX, startY, endX, endY);
+                break;
+        }
+    }
 
-                if (!found || current.y < minY) {
-                    minY = current.y;
-                }
+    void BlobFinderTask::label(int threadIndex, size_t startX, size_t startY, size_t endX,
+                               size_t endY) {
+        mTileSizeX[threadIndex] = std::max(mTileSizeX[threadIndex], endX - startX);
+        mTileSizeY[threadIndex] = std::max(mTileSizeY[threadIndex], endY - startY);
 
-                if (!found || current.x > maxX) {
-                    maxX = current.x;
+        // No other thread reads this tile's entries during this pass. The pixels of a run of
+        // pixels above the threshold point to the first one, so the run needs to be joined to
+        // the row above only once per run of neighbors above the threshold that it touches.
+        for (size_t y = startY; y < endY; y++) {
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            const uint32_t rowIndex = indexOf(mOriginX, y);
+            uint32_t runStart = kBackground;
+            bool previousHasTop = false;
+            for (size_t x = startX; x < endX; x++) {
+                const uint32_t index = rowIndex + (uint32_t) (x - mOriginX);
+                if (valueOf(in[x]) < mCutoff) {
+                    mParents[index].store(kBackground, std::memory_order_relaxed);
+                    runStart = kBackground;
+                    previousHasTop = false;
+                    continue;
                 }
 
-                if (!found || current.y > maxY) {
-                    maxY = current.y;
+                if (runStart == kBackground) {
+                    runStart = index;
                 }
+                mParents[index].store(runStart, std::memory_order_relaxed);
 
-                found = true;
-
-                Point p1 = {current.x + 1, current.y};
-                Point p2 = {current.x - 1, current.y};
-                Point p3 = {current.x, current.y + 1};
-                Point p4 = {current.x, current.y - 1};
-                toVisit.push_back(p1);
-                toVisit.push_back(p2);
-                toVisit.push_back(p3);
-                toVisit.push_back(p4);
+                const bool hasTop = y > startY &&
+                                    mParents[index - mWidth].load(std::memory_order_relaxed) !=
+                                    kBackground;
+                if (hasTop && !previousHasTop) {
+                    unite(index, index - (uint32_t) mWidth);
+                }
+                previousHasTop = hasTop;
             }
         }
+    }
 
-        if (found) {
-            return Rect{minX, minY, maxX + 1, maxY + 1};
-        } else {
-            return Rect{0, 0, 0, 0};
+    void BlobFinderTask::merge(size_t startX, size_t startY, size_t endX, size_t endY) {
+        // The top borders of the LABEL tiles in this tile.
+        for (size_t y = startY; y < endY; y++) {
+            if (y == mOriginY || (y - mOriginY) % mGridY != 0) {
+                continue;
+            }
+            for (size_t x = startX; x < endX; x++) {
+                const uint32_t index = indexOf(x, y);
+                if (mParents[index].load(std::memory_order_relaxed) != kBackground &&
+                    mParents[index - mWidth].load(std::memory_order_relaxed) != kBackground) {
+                    unite(index, index - (uint32_t) mWidth);
+                }
+            }
         }
-    }
 
-    void BlobFinderTask::removeDuplicates(std::vector<Rect> &rects) {
-        for (size_t i = 0; i < rects.size(); i++) {
-            for (size_t j = i + 1; j < rects.size(); j++) {
-                Rect &a = rects[i];
-                Rect &b = rects[j];
-                if (a.left == b.left && a.top == b.top && a.right == b.right &&
-                    a.bottom == b.bottom) {
-                    // Remove the duplicate
-                    rects.erase(rects.begin() + j);
-                    j--;
+        // The left borders.
+        size_t firstBorder = mOriginX + divideRoundingUp(startX - mOriginX, mGridX) * mGridX;
+        if (firstBorder == mOriginX) {
+            firstBorder += mGridX;
+        }
+        for (size_t x = firstBorder; x < endX; x += mGridX) {
+            for (size_t y = startY; y < endY; y++) {
+                const uint32_t index = indexOf(x, y);
+                if (mParents[index].load(std::memory_order_relaxed) != kBackground &&
+                    mParents[index - 1].load(std::memory_order_relaxed) != kBackground) {
+                    unite(index, index - 1);
                 }
             }
         }
     }
 
-    void BlobFinderTask::sortByArea(std::vector<Rect> &rects) {
-        std::sort(rects.begin(), rects.end(), [](const Rect &a, const Rect &b) {
-            return (a.right - a.left) * (a.bottom - a.top) >
-                   (b.right - b.left) * (b.bottom - b.top);
-        });
+    void BlobFinderTask::number(size_t startX, size_t startY, size_t endX, size_t endY) {
+        // The roots of the tile take consecutive numbers, reserved at once.
+        uint32_t rootCount = 0;
+        for (size_t y = startY; y < endY; y++) {
+            for (size_t x = startX; x < endX; x++) {
+                const uint32_t index = indexOf(x, y);
+                rootCount += mParents[index].load(std::memory_order_relaxed) == index;
+            }
+        }
+        if (rootCount == 0) {
+            return;
+        }
+        uint32_t blob = mBlobCount.fetch_add(rootCount, std::memory_order_relaxed);
+        for (size_t y = startY; y < endY; y++) {
+            for (size_t x = startX; x < endX; x++) {
+                const uint32_t index = indexOf(x, y);
+                if (mParents[index].load(std::memory_order_relaxed) == index) {
+                    mParents[index].store(kNumbered | blob++, std::memory_order_relaxed);
+                }
+            }
+        }
     }
 
-    std::vector<Rect> BlobFinderTask::getAllRects() {
-        // Flatten
-        std::vector<Rect> rects;
-        for (auto &mRect: mRects) {
-            for (auto &rect: mRect) {
-                rects.push_back(rect);
+    void BlobFinderTask::measure(size_t startX, size_t startY, size_t endX, size_t endY) {
+        // The runs are summed up here before being added to the shared sums, so that a blob
+        // that spans the tile is added to them about once per tile rather than once per run.
+        BlobSums cached[kCachedBlobs];
+        uint32_t cachedBlobs[kCachedBlobs];
+        std::fill_n(cachedBlobs, kCachedBlobs, kBackground);
+        for (size_t y = startY; y < endY; y++) {
+            const uint32_t rowIndex = indexOf(mOriginX, y);
+            // The pixels of a run of pixels above the threshold are all in the same blob.
+            size_t x = startX;
+            while (x < endX) {
+                if (mParents[rowIndex + (x - mOriginX)].load(std::memory_order_relaxed) ==
+                    kBackground) {
+                    x++;
+                    continue;
+                }
+                const size_t runStart = x;
+                while (x < endX && mParents[rowIndex + (x - mOriginX)].load(
+                        std::memory_order_relaxed) != kBackground) {
+                    x++;
+                }
+                const uint32_t blob = blobOf(rowIndex + (uint32_t) (runStart - mOriginX));
+                const size_t slot = blob % kCachedBlobs;
+                if (cachedBlobs[slot] != blob) {
+                    if (cachedBlobs[slot] != kBackground) {
+                        mBlobs[cachedBlobs[slot]].merge(cached[slot]);
+                    }
+                    cachedBlobs[slot] = blob;
+                    cached[slot] = BlobSums{};
+                }
+                cached[slot].addRun(runStart, x, y);
+            }
+        }
+        for (size_t slot = 0; slot < kCachedBlobs; slot++) {
+            if (cachedBlobs[slot] != kBackground) {
+                mBlobs[cachedBlobs[slot]].merge(cached[slot]);
             }
         }
-
-        // Merge rects that are the same
-        removeDuplicates(rects);
-
-        // Sort the rects by size
-        sortByArea(rects);
-
-        return rects;
     }
 
-    void BlobFinderTask::collate(size_t maxBlobs, int *out) {
+    void BlobFinderTask::collate(size_t maxBlobs, int *out, double *statistics) {
+        const uint32_t blobCount = mBlobCount.load(std::memory_order_relaxed);
+        BlobSums *blobs = mScratch.allocate<BlobSums>(blobCount);
+        for (uint32_t i = 0; i < blobCount; i++) {
+            new (&blobs[i]) BlobSums(mBlobs[i].load());
+        }
 
-        // Step 1: Get all the rects
-        std::vector<Rect> sortedRects = getAllRects();
+        // Sort by the area of the bounding box. The other keys make the order deterministic.
+        auto isLarger = [](const BlobSums &a, const BlobSums &b) {
+            if (a.area() != b.area()) {
+                return a.area() > b.area();
+            }
+            if (a.pixelCount != b.pixelCount) {
+                return a.pixelCount > b.pixelCount;
+            }
+            if (a.top != b.top) {
+                return a.top < b.top;
+            }
+            return a.left < b.left;
+        };
+        const size_t count = std::min<size_t>(maxBlobs, blobCount);
+        std::partial_sort(blobs, blobs + count, blobs + blobCount, isLarger);
 
-        // Step 2: Copy the largest N clusters to the output, but ignore duplicates
         for (size_t i = 0; i < maxBlobs; i++) {
-            if (i >= sortedRects.size()) {
+            if (i >= count) {
                 // Fill the rest with zeros
-                out[i * 4] = 0;
-                out[i * 4 + 1] = 0;
-                out[i * 4 + 2] = 0;
-                out[i * 4 + 3] = 0;
+                std::fill(out + i * 4, out + i * 4 + 4, 0);
+                if (statistics != nullptr) {
+                    std::fill(statistics + i * 4, statistics + i * 4 + 4, 0.0);
+                }
                 continue;
             }
 
-            // Copy the rect to the output and move to the next
-            Rect rect = sortedRects[i];
-            out[i * 4] = (int) rect.left;
-            out[i * 4 + 1] = (int) rect.top;
-            out[i * 4 + 2] = (int) rect.right;
-            out[i * 4 + 3] = (int) rect.bottom;
+            const BlobSums &blob = blobs[i];
+            out[i * 4] = (int) blob.left;
+            out[i * 4 + 1] = (int) blob.top;
+            out[i * 4 + 2] = (int) blob.right;
+            out[i * 4 + 3] = (int) blob.bottom;
+            if (statistics != nullptr) {
+                statistics[i * 4] = (double) blob.area();
+                statistics[i * 4 + 1] = (double) blob.pixelCount;
+                statistics[i * 4 + 2] = (double) blob.sumX / blob.pixelCount;
+                statistics[i * 4 + 3] = (double) blob.sumY / blob.pixelCount;
+            }
         }
     }
 
-    void RenderScriptToolkit::findBlobs(const uint8_t *input, int *output, size_t maxBlobs,
-                                        size_t sizeX, size_t sizeY, float threshold,
-                                        uint8_t channel, const Restriction *restriction) {
+    void RenderScriptToolkit::findBlobs(const uint8_t *input, int *output, double *statistics,
+                                        size_t maxBlobs, size_t sizeX, size_t sizeY,
+                                        float threshold, uint8_t channel,
+                                        const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
+            return;
+        }
+        const size_t width =
+                restriction == nullptr ? sizeX : restriction->endX - restriction->startX;
+        const size_t height =
+                restriction == nullptr ? sizeY : restriction->endY - restriction->startY;
+        if (width * height >= kNumbered) {
+            ALOGE("The area searched for blobs has %zu pixels, it can have at most %u.",
+                  width * height, kNumbered - 1);
             return;
         }
 #endif
 
+        ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
         BlobFinderTask task(input, sizeX, sizeY, threshold, channel,
-                            processor->getNumberOfThreads(),
+                            processor->getNumberOfThreads(), TaskProcessor::callingThreadScratch(),
                             restriction);
         processor->doTask(&task);
-        task.collate(maxBlobs, output);
+        task.setPass(BlobFinderTask::Pass::MERGE);
+        processor->doTask(&task);
+        task.setPass(BlobFinderTask::Pass::NUMBER);
+        processor->doTask(&task);
+        task.setPass(BlobFinderTask::Pass::MEASURE);
+        processor->doTask(&task);
+        task.collate(maxBlobs, output, statistics);
     }
 
 }  // namespace renderscript
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
@@ -25,6 +28,10 @@ namespace renderscript {
 
 #define LOG_TAG "renderscript.toolkit.Blur"
 
+// The largest radius done by BlurTask. Larger radii are approximated with stacked box blurs.
+static constexpr int kMaxDirectBlurRadius = 25;
+static constexpr int kMaxBlurRadius = 1000;
+
 /**
  * Blurs an image or a section of an image.
  *
@@ -35,6 +42,9 @@ class BlurTask : public Task {
     const uchar* mIn;
     // Where we store the blurred image.
     uchar* outArray;
+    // The number of bytes between the starts of two rows of mIn and of outArray.
+    const size_t mInStride;
+    const size_t mOutStride;
     // The size of the kernel radius is limited to 25 in ScriptIntrinsicBlur.java.
     // So, the max kernel size is 51 (= 2 * 25 + 1).
     // Considering SSSE3 case, which requires the size is multiple of 4,
@@ -42,20 +52,12 @@ class BlurTask : public Task {
     float mFp[104];
     uint16_t mIp[104];
 
-    // Working area to store the result of the vertical blur, to be used by the horizontal pass.
-    // There's one area per thread. Since the needed working area may be too large to put on the
-    // stack, we are allocating it from the heap. To avoid paying the allocation cost for each
-    // tile, we cache the scratch area here.
-    std::vector<void*> mScratch;       // Pointers to the scratch areas, one per thread.
-    std::vector<size_t> mScratchSize;  // The size in bytes of the scratch areas, one per thread.
-
     // The radius of the blur, in floating point and integer format.
     float mRadius;
     int mIradius;
 
-    void kernelU4(void* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY,
-                  uint32_t threadIndex);
-    void kernelU1(void* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
+    void kernelU4(void* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY, float4* buf);
+    void kernelU1(void* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY, float* buf);
     void ComputeGaussianWeights();
 
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
@@ -64,29 +66,24 @@ class BlurTask : public Task {
 
    public:
     BlurTask(const uint8_t* in, uint8_t* out, size_t sizeX, size_t sizeY, size_t vectorSize,
-             uint32_t threadCount, float radius, const Restriction* restriction)
+             float radius, const Restriction* restriction)
         : Task{sizeX, sizeY, vectorSize, false, restriction},
           mIn{in},
           outArray{out},
-          mScratch{threadCount},
-          mScratchSize{threadCount},
-          mRadius{std::min(25.0f, radius)} {
+          mInStride{inputStride(sizeX * vectorSize)},
+          mOutStride{outputStride(sizeX * vectorSize)},
+          mRadius{std::min((float)kMaxDirectBlurRadius, radius)} {
         ComputeGaussianWeights();
-    }
-
-    ~BlurTask() {
-        for (size_t i = 0; i < mScratch.size(); i++) {
-            if (mScratch[i]) {
-                free(mScratch[i]);
-            }
-        }
+        setTilingGroup(RenderScriptToolkit::TilingGroup::BLUR);
+        setReach(mIradius);
     }
 };
 
-void BlurTask::ComputeGaussianWeights() {
-    memset(mFp, 0, sizeof(mFp));
-    memset(mIp, 0, sizeof(mIp));
-
+/**
+ * Computes the normalized Gaussian weights of a blur of the given radius, at most
+ * kMaxDirectBlurRadius, and returns the radius in cells. weights receives 2 * radius + 1 values.
+ */
+static int computeGaussianWeights(float radius, float* weights) {
     // Compute gaussian weights for the blur
     // e is the euler's number
     float e = 2.718281828459045f;
@@ -100,7 +97,7 @@ void BlurTask::ComputeGaussianWeights() {
     // The larger the radius gets, the more our gaussian blur
     // will resemble a box blur since with large sigma
     // the gaussian curve begins to lose its shape
-    float sigma = 0.4f * mRadius + 0.6f;
+    float sigma = 0.4f * radius + 0.6f;
 
     // Now compute the coefficients. We will store some redundant values to save
     // some math during the blur calculations precompute some values
@@ -110,17 +107,27 @@ void BlurTask::ComputeGaussianWeights() {
     float normalizeFactor = 0.0f;
     float floatR = 0.0f;
     int r;
-    mIradius = (float)ceil(mRadius) + 0.5f;
-    for (r = -mIradius; r <= mIradius; r ++) {
+    int iradius = (float)ceil(radius) + 0.5f;
+    for (r = -iradius; r <= iradius; r ++) {
         floatR = (float)r;
-        mFp[r + mIradius] = coeff1 * powf(e, floatR * floatR * coeff2);
-        normalizeFactor += mFp[r + mIradius];
+        weights[r + iradius] = coeff1 * powf(e, floatR * floatR * coeff2);
+        normalizeFactor += weights[r + iradius];
     }
 
     // Now we need to normalize the weights because all our coefficients need to add up to one
     normalizeFactor = 1.0f / normalizeFactor;
-    for (r = -mIradius; r <= mIradius; r ++) {
-        mFp[r + mIradius] *= normalizeFactor;
+    for (r = -iradius; r <= iradius; r ++) {
+        weights[r + iradius] *= normalizeFactor;
+    }
+    return iradius;
+}
+
+void BlurTask::ComputeGaussianWeights() {
+    memset(mFp, 0, sizeof(mFp));
+    memset(mIp, 0, sizeof(mIp));
+
+    mIradius = computeGaussianWeights(mRadius, mFp);
+    for (int r = -mIradius; r <= mIradius; r ++) {
         mIp[r + mIradius] = (uint16_t)(mFp[r + mIradius] * 65536.0f + 0.5f);
     }
 }
@@ -365,13 +372,11 @@ static void OneHU1(uint32_t sizeX, uchar* out, int32_t x, const float* ptrIn, co
  * @param xstart The index of the section we're starting to blur.
  * @param xend  The end index of the section.
  * @param currentY The index of the line we're blurring.
- * @param usesSimd Whether this processor supports SIMD.
+ * @param buf A working area of mSizeX + 4 cells, for the result of the vertical blur.
  */
 void BlurTask::kernelU4(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY,
-                        uint32_t threadIndex) {
-    float4 stackbuf[2048];
-    float4 *buf = &stackbuf[0];
-    const uint32_t stride = mSizeX * mVectorSize;
+                        float4 *buf) {
+    const uint32_t stride = mInStride;
 
     uchar4 *out = (uchar4 *)outPtr;
     uint32_t x1 = xstart;
@@ -386,23 +391,18 @@ void BlurTask::kernelU4(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
     }
 #endif
 
-    if (mSizeX > 2048) {
-        if ((mSizeX > mScratchSize[threadIndex]) || !mScratch[threadIndex]) {
-            // Pad the side of the allocation by one unit to allow alignment later
-            mScratch[threadIndex] = realloc(mScratch[threadIndex], (mSizeX + 1) * 16);
-            mScratchSize[threadIndex] = mSizeX;
-        }
-        // realloc only aligns to 8 bytes so we manually align to 16.
-        buf = (float4 *) ((((intptr_t)mScratch[threadIndex]) + 15) & ~0xf);
-    }
-    float4 *fout = (float4 *)buf;
+    // The horizontal pass only needs the vertical blur of the cells up to mIradius away from
+    // the tile, so narrow tiles don't blur whole rows.
+    const uint32_t first = xstart > (uint32_t)mIradius ? xstart - mIradius : 0;
+    const uint32_t last = std::min((uint32_t)mSizeX, xend + mIradius);
+    float4 *fout = (float4 *)buf + first;
     int y = currentY;
     if ((y > mIradius) && (y < ((int)mSizeY - mIradius))) {
-        const uchar *pi = mIn + (y - mIradius) * stride;
-        OneVFU4(fout, pi, stride, mFp, mIradius * 2 + 1, mSizeX, mUsesSimd);
+        const uchar *pi = mIn + (y - mIradius) * stride + first * 4;
+        OneVFU4(fout, pi, stride, mFp, mIradius * 2 + 1, last - first, mUsesSimd);
     } else {
-        x1 = 0;
-        while(mSizeX > x1) {
+        x1 = first;
+        while(last > x1) {
             OneVU4(mSizeY, fout, x1, y, mIn, stride, mFp, mIradius);
             fout++;
             x1++;
@@ -417,11 +417,14 @@ void BlurTask::kernelU4(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
     }
 #if defined(ARCH_X86_HAVE_SSSE3)
     if (mUsesSimd) {
-        if ((x1 + mIradius) < x2) {
+        // The SIMD code can blur the cells whose neighbors up to mIradius away were blurred
+        // vertically, i.e. up to the end of the tile unless it's near the end of the row.
+        if ((x1 + mIradius) < last) {
+            const uint32_t end = std::min(x2, last - mIradius);
             rsdIntrinsicBlurHFU4_K(out, buf - mIradius, mFp,
-                                   mIradius * 2 + 1, x1, x2 - mIradius);
-            out += (x2 - mIradius) - x1;
-            x1 = x2 - mIradius;
+                                   mIradius * 2 + 1, x1, end);
+            out += end - x1;
+            x1 = end;
         }
     }
 #endif
@@ -439,10 +442,11 @@ void BlurTask::kernelU4(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
  * @param xstart The index of the section we're starting to blur.
  * @param xend  The end index of the section.
  * @param currentY The index of the line we're blurring.
+ * @param buf A working area of mSizeX + 4 cells, for the result of the vertical blur.
  */
-void BlurTask::kernelU1(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY) {
-    float buf[4 * 2048];
-    const uint32_t stride = mSizeX * mVectorSize;
+void BlurTask::kernelU1(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY,
+                        float *buf) {
+    const uint32_t stride = mInStride;
 
     uchar *out = (uchar *)outPtr;
     uint32_t x1 = xstart;
@@ -461,14 +465,17 @@ void BlurTask::kernelU1(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
     }
 #endif
 
-    float *fout = (float *)buf;
+    // As in kernelU4, only the cells the horizontal pass reads are blurred vertically.
+    const uint32_t first = xstart > (uint32_t)mIradius ? xstart - mIradius : 0;
+    const uint32_t last = std::min((uint32_t)mSizeX, xend + mIradius);
+    float *fout = (float *)buf + first;
     int y = currentY;
     if ((y > mIradius) && (y < ((int)mSizeY - mIradius -1))) {
-        const uchar *pi = mIn + (y - mIradius) * stride;
-        OneVFU1(fout, pi, stride, mFp, mIradius * 2 + 1, mSizeX, mUsesSimd);
+        const uchar *pi = mIn + (y - mIradius) * stride + first;
+        OneVFU1(fout, pi, stride, mFp, mIradius * 2 + 1, last - first, mUsesSimd);
     } else {
-        x1 = 0;
-        while(mSizeX > x1) {
+        x1 = first;
+        while(last > x1) {
             OneVU1(mSizeY, fout, x1, y, mIn, stride, mFp, mIradius);
             fout++;
             x1++;
@@ -484,15 +491,15 @@ void BlurTask::kernelU1(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
     }
 #if defined(ARCH_X86_HAVE_SSSE3)
     if (mUsesSimd) {
-        if ((x1 + mIradius) < x2) {
-            uint32_t len = x2 - (x1 + mIradius);
+        if ((x1 + mIradius) < last) {
+            uint32_t len = last - (x1 + mIradius);
             len &= ~3;
 
             // rsdIntrinsicBlurHFU1_K() processes each four float values in |buf| at once, so it
             // nees to ensure four more values can be accessed in order to avoid accessing
             // uninitialized buffer.
             if (len > 4) {
-                len -= 4;
+                len = std::min(len - 4, (x2 - x1) & ~3u);
                 rsdIntrinsicBlurHFU1_K(out, ((float *)buf) - mIradius, mFp,
                                        mIradius * 2 + 1, x1, x1 + len);
                 out += len;
@@ -510,32 +517,422 @@ void BlurTask::kernelU1(void *outPtr, uint32_t xstart, uint32_t xend, uint32_t c
 
 void BlurTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                            size_t endY) {
+    // The vertical blur of a row is kept for the horizontal pass. The SIMD code of the
+    // horizontal pass may read a few cells past the end of the row.
+    float* buf = scratch(threadIndex).allocate<float>((mSizeX + 4) * mVectorSize);
     for (size_t y = startY; y < endY; y++) {
-        void* outPtr = outArray + (mSizeX * y + startX) * mVectorSize;
+        void* outPtr = outArray + mOutStride * y + startX * mVectorSize;
         if (mVectorSize == 4) {
-            kernelU4(outPtr, startX, endX, y, threadIndex);
+            kernelU4(outPtr, startX, endX, y, reinterpret_cast<float4*>(buf));
         } else {
-            kernelU1(outPtr, startX, endX, y);
+            kernelU1(outPtr, startX, endX, y, buf);
+        }
+    }
+}
+
+/**
+ * The blur of BlurTask for cells of 1 to 4 packed floats.
+ *
+ * The two passes work on the floats of a row regardless of the cells, four at a time: the
+ * vertical pass sums the same float of neighboring rows, and the horizontal pass the floats that
+ * are a multiple of vectorSize apart, i.e. the same channel of the neighboring cells.
+ */
+class FloatBlurTask : public Task {
+    const float* mIn;
+    float* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
+    float mFp[2 * kMaxDirectBlurRadius + 1];
+    int mIradius;
+
+    // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+    void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override;
+
+   public:
+    FloatBlurTask(const float* in, float* out, size_t sizeX, size_t sizeY, size_t vectorSize,
+                  float radius, const Restriction* restriction)
+        : Task{sizeX, sizeY, vectorSize, false, restriction},
+          mIn{in},
+          mOut{out},
+          mInStride{inputStride(sizeX * vectorSize * sizeof(float))},
+          mOutStride{outputStride(sizeX * vectorSize * sizeof(float))},
+          mIradius{computeGaussianWeights(std::min((float)kMaxDirectBlurRadius, radius), mFp)} {
+        setElementSize(sizeof(float));
+        setTilingGroup(RenderScriptToolkit::TilingGroup::BLUR);
+        setReach(mIradius);
+    }
+};
+
+/**
+ * Sets out[i] to the sum of weights[k] * in[i + k * step] over the taps, for the count floats.
+ */
+static void blurFloatsHorizontally(const float* in, size_t step, const float* weights, int taps,
+                                   size_t count, float* out) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float4 sum = 0.f;
+        for (int k = 0; k < taps; k++) {
+            sum += loadFloat4(in + i + k * step) * weights[k];
+        }
+        storeFloat4(out + i, sum);
+    }
+    for (; i < count; i++) {
+        float sum = 0.f;
+        for (int k = 0; k < taps; k++) {
+            sum += in[i + k * step] * weights[k];
+        }
+        out[i] = sum;
+    }
+}
+
+void FloatBlurTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                size_t endY) {
+    const size_t n = mVectorSize;
+    const int taps = 2 * mIradius + 1;
+    // The vertical blur of the cells [startX - mIradius, endX + mIradius) of a row. The cells
+    // past the edges repeat the edge cells.
+    const ptrdiff_t first = (ptrdiff_t)startX - mIradius;
+    const ptrdiff_t end = (ptrdiff_t)endX + mIradius;
+    const ptrdiff_t insideStart = std::max(first, (ptrdiff_t)0);
+    const ptrdiff_t insideEnd = std::min(end, (ptrdiff_t)mSizeX);
+    float* line = scratch(threadIndex).allocate<float>((end - first) * n);
+    const float* rows[2 * kMaxDirectBlurRadius + 1];
+
+    for (size_t y = startY; y < endY; y++) {
+        for (int k = 0; k < taps; k++) {
+            ptrdiff_t inY = std::min(std::max((ptrdiff_t)y + k - mIradius, (ptrdiff_t)0),
+                                     (ptrdiff_t)mSizeY - 1);
+            rows[k] = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(mIn) +
+                                                     mInStride * inY) + insideStart * n;
+        }
+        weightedSum(rows, mFp, taps, (insideEnd - insideStart) * n,
+                    line + (insideStart - first) * n);
+        for (ptrdiff_t x = first; x < insideStart; x++) {
+            std::copy_n(line + (insideStart - first) * n, n, line + (x - first) * n);
+        }
+        for (ptrdiff_t x = insideEnd; x < end; x++) {
+            std::copy_n(line + (insideEnd - 1 - first) * n, n, line + (x - first) * n);
+        }
+
+        float* out = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(mOut) + mOutStride * y);
+        blurFloatsHorizontally(line, n, mFp, taps, (endX - startX) * n, out + startX * n);
+    }
+}
+
+/**
+ * Computes the radii of three box filters that, applied one after the other, approximate a
+ * Gaussian of the given sigma. See "Fast Almost-Gaussian Filtering" by Peter Kovesi.
+ */
+static void boxRadiiForGaussian(float sigma, int radii[3]) {
+    const int n = 3;
+    // The ideal width of n identical boxes, and the odd widths just below and above it.
+    float idealWidth = sqrtf(12.0f * sigma * sigma / n + 1.0f);
+    int lowerWidth = (int)idealWidth;
+    if (lowerWidth % 2 == 0) {
+        lowerWidth--;
+    }
+    int upperWidth = lowerWidth + 2;
+    // How many boxes use the lower width so that the variance of the sum matches sigma.
+    float idealLowerCount = (12.0f * sigma * sigma - n * lowerWidth * lowerWidth -
+                             4.0f * n * lowerWidth - 3.0f * n) /
+                            (-4.0f * lowerWidth - 4.0f);
+    int lowerCount = (int)roundf(idealLowerCount);
+    for (int i = 0; i < n; i++) {
+        radii[i] = ((i < lowerCount ? lowerWidth : upperWidth) - 1) / 2;
+    }
+}
+
+/**
+ * How the large radius blur reads a cell into the floats its box filters sum, FloatType, and
+ * writes the result back into a cell.
+ */
+template <typename CellType>
+struct BoxBlurCell;
+
+template <>
+struct BoxBlurCell<uchar> {
+    using FloatType = float;
+    static float load(uchar cell) { return convert<float>(cell); }
+    static uchar store(float value) { return convert<uchar>(value + 0.5f); }
+};
+
+template <>
+struct BoxBlurCell<uchar4> {
+    using FloatType = float4;
+    static float4 load(uchar4 cell) { return convert<float4>(cell); }
+    static uchar4 store(float4 value) { return convert<uchar4>(value + 0.5f); }
+};
+
+template <>
+struct BoxBlurCell<FloatCell<1>> {
+    using FloatType = float;
+    static float load(FloatCell<1> cell) { return cell.v[0]; }
+    static FloatCell<1> store(float value) { return FloatCell<1>{{value}}; }
+};
+
+template <size_t N>
+struct BoxBlurCell<FloatCell<N>> {
+    using FloatType = float4;
+    static float4 load(FloatCell<N> cell) {
+        float4 value = 0.f;
+        for (size_t i = 0; i < N; i++) value[i] = cell.v[i];
+        return value;
+    }
+    static FloatCell<N> store(float4 value) {
+        FloatCell<N> cell;
+        for (size_t i = 0; i < N; i++) cell.v[i] = value[i];
+        return cell;
+    }
+};
+
+/**
+ * One pass of the large radius blur.
+ *
+ * Blurs lines of cells with three stacked box filters and writes the results transposed: cell c
+ * of line l ends up at row c, column l of the output. Two passes make the 2D blur, and both read
+ * their input one line at a time. Each box filter is a running sum, so the cost per cell doesn't
+ * depend on the radius. Past the ends of a line, the edge cell is used, like BlurTask does.
+ *
+ * The cells are bytes, or packed floats when the element size is sizeof(float).
+ */
+class BoxBlurPassTask : public Task {
+    // The mSizeY lines of mSizeX cells to blur, and the number of bytes between two lines.
+    const uchar* mIn;
+    const size_t mInStride;
+    // Cell c of line l is written at row c + mOutRowOffset, column l + mOutColumnOffset.
+    uchar* mOut;
+    const size_t mOutStride;
+    const ptrdiff_t mOutRowOffset;
+    const ptrdiff_t mOutColumnOffset;
+    // The radii of the three box filters, and their sum, how far the blur reaches.
+    int mRadii[3];
+    int mReach;
+
+    // The number of lines blurred before they are written out. Each output row then gets this
+    // many consecutive cells at a time rather than one.
+    static constexpr size_t kLinesPerBlock = 16;
+
+    template <typename CellType, typename FloatType>
+    void blurLine(const CellType* in, size_t first, size_t count, FloatType* line,
+                  CellType* out);
+    template <typename CellType>
+    void blurTile(int threadIndex, size_t startX, size_t startY, size_t endX, size_t endY);
+
+    // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+    void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override;
+
+   public:
+    BoxBlurPassTask(const uchar* in, size_t inStride, size_t sizeX, size_t sizeY, uchar* out,
+                    size_t outStride, ptrdiff_t outRowOffset, ptrdiff_t outColumnOffset,
+                    size_t vectorSize, size_t elementSize, const int radii[3],
+                    const Restriction* restriction)
+        : Task{sizeX, sizeY, vectorSize, false, restriction},
+          mIn{in},
+          mInStride{inStride},
+          mOut{out},
+          mOutStride{outStride},
+          mOutRowOffset{outRowOffset},
+          mOutColumnOffset{outColumnOffset},
+          mRadii{radii[0], radii[1], radii[2]},
+          mReach{radii[0] + radii[1] + radii[2]} {
+        setElementSize(elementSize);
+        setMinRowsPerTile(kLinesPerBlock);
+        // The lines are blurred one at a time, so there's no reach across them.
+        setTilingGroup(RenderScriptToolkit::TilingGroup::BLUR);
+    }
+};
+
+/**
+ * Blurs the cells [first, first + count) of a line.
+ *
+ * @param in The start of the line, mSizeX cells.
+ * @param first The first cell to blur.
+ * @param count The number of cells to blur.
+ * @param line A working area of count + 2 * mReach cells.
+ * @param out Where to store the count blurred cells.
+ */
+template <typename CellType, typename FloatType>
+void BoxBlurPassTask::blurLine(const CellType* in, size_t first, size_t count, FloatType* line,
+                               CellType* out) {
+    // Load the cells the blur reaches, repeating the edge cells past the ends.
+    size_t length = count + 2 * mReach;
+    for (size_t i = 0; i < length; i++) {
+        ptrdiff_t x = (ptrdiff_t)(first + i) - mReach;
+        x = std::min(std::max(x, (ptrdiff_t)0), (ptrdiff_t)mSizeX - 1);
+        line[i] = BoxBlurCell<CellType>::load(in[x]);
+    }
+
+    // Each box filter is done in place. Cell j gets the average of the cells [j, j + width),
+    // which shortens the line by width - 1. The cell it replaces is saved to be removed from
+    // the sum afterwards.
+    for (int radius : mRadii) {
+        const size_t width = 2 * radius + 1;
+        const float scale = 1.0f / width;
+        FloatType sum = 0;
+        for (size_t i = 0; i < width; i++) {
+            sum += line[i];
+        }
+        length -= width - 1;
+        for (size_t j = 0; j < length; j++) {
+            FloatType removed = line[j];
+            line[j] = sum * scale;
+            if (j + 1 < length) {
+                sum += line[j + width] - removed;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = BoxBlurCell<CellType>::store(line[i]);
+    }
+}
+
+template <typename CellType>
+void BoxBlurPassTask::blurTile(int threadIndex, size_t startX, size_t startY, size_t endX,
+                               size_t endY) {
+    using FloatType = typename BoxBlurCell<CellType>::FloatType;
+    const size_t count = endX - startX;
+    // The line being blurred, as floats, and the blurred lines of the tile, kept until they're
+    // written transposed.
+    FloatType* line = scratch(threadIndex).allocate<FloatType>(count + 2 * mReach);
+    CellType* block = scratch(threadIndex).allocate<CellType>(kLinesPerBlock * count);
+
+    for (size_t y = startY; y < endY; y += kLinesPerBlock) {
+        const size_t lines = std::min(kLinesPerBlock, endY - y);
+        for (size_t l = 0; l < lines; l++) {
+            auto in = reinterpret_cast<const CellType*>(mIn + mInStride * (y + l));
+            blurLine(in, startX, count, line, block + l * count);
+        }
+        // Write the block transposed, one output row per cell.
+        for (size_t c = 0; c < count; c++) {
+            uchar* row = mOut + mOutStride * ((ptrdiff_t)(startX + c) + mOutRowOffset);
+            auto out = reinterpret_cast<CellType*>(row) + ((ptrdiff_t)y + mOutColumnOffset);
+            for (size_t l = 0; l < lines; l++) {
+                out[l] = block[l * count + c];
+            }
         }
     }
 }
 
+void BoxBlurPassTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                  size_t endY) {
+    if (mElementSize == sizeof(float)) {
+        switch (mVectorSize) {
+            case 1:
+                blurTile<FloatCell<1>>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 2:
+                blurTile<FloatCell<2>>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 3:
+                blurTile<FloatCell<3>>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 4:
+                blurTile<FloatCell<4>>(threadIndex, startX, startY, endX, endY);
+                break;
+        }
+    } else if (mVectorSize == 4) {
+        blurTile<uchar4>(threadIndex, startX, startY, endX, endY);
+    } else {
+        blurTile<uchar>(threadIndex, startX, startY, endX, endY);
+    }
+}
+
+/**
+ * Blurs with a radius larger than kMaxDirectBlurRadius, as two BoxBlurPassTasks.
+ *
+ * The first pass blurs the rows of the input that the vertical blur of the restricted area
+ * reaches, only over the restricted columns, and stores them transposed in a scratch image.
+ * The second pass blurs the rows of that scratch image, i.e. the columns of the image, and
+ * writes them back transposed into the output. The cells have vectorSize elements of
+ * elementSize bytes.
+ */
+static void boxBlur(TaskProcessor* processor, const void* in, void* out, size_t sizeX,
+                    size_t sizeY, size_t vectorSize, size_t elementSize, int radius,
+                    const Restriction* restriction) {
+    int radii[3];
+    boxRadiiForGaussian(0.4f * radius + 0.6f, radii);
+    const size_t reach = radii[0] + radii[1] + radii[2];
+
+    Restriction all{0, sizeX, 0, sizeY};
+    const Restriction& area = restriction != nullptr ? *restriction : all;
+    const size_t cellSize = vectorSize * elementSize;
+    const size_t inStride = area.inputStride != 0 ? area.inputStride : sizeX * cellSize;
+    const size_t outStride = area.outputStride != 0 ? area.outputStride : sizeX * cellSize;
+
+    const size_t firstRow = area.startY - std::min(area.startY, reach);
+    const size_t endRow = std::min(sizeY, area.endY + reach);
+    const size_t columns = area.endX - area.startX;
+    const size_t rows = endRow - firstRow;
+    // The scratch image lives across both passes.
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+    uint8_t* transposed =
+            TaskProcessor::callingThreadScratch().allocate<uint8_t>(columns * rows * cellSize);
+
+    Restriction rowArea{area.startX, area.endX, firstRow, endRow};
+    BoxBlurPassTask rowPass((const uchar*)in, inStride, sizeX, sizeY, transposed,
+                            rows * cellSize, -(ptrdiff_t)area.startX, -(ptrdiff_t)firstRow,
+                            vectorSize, elementSize, radii, &rowArea);
+    processor->doTask(&rowPass);
+
+    Restriction columnArea{area.startY - firstRow, area.endY - firstRow, 0, columns};
+    BoxBlurPassTask columnPass(transposed, rows * cellSize, rows, columns, (uchar*)out,
+                               outStride, firstRow, area.startX, vectorSize, elementSize, radii,
+                               &columnArea);
+    processor->doTask(&columnPass);
+}
+
 void RenderScriptToolkit::blur(const uint8_t* in, uint8_t* out, size_t sizeX, size_t sizeY,
                                size_t vectorSize, int radius, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * vectorSize,
+                          sizeX * vectorSize)) {
         return;
     }
-    if (radius <= 0 || radius > 25) {
-        ALOGE("The radius should be between 1 and 25. %d provided.", radius);
+    if (radius <= 0 || radius > kMaxBlurRadius) {
+        ALOGE("The radius should be between 1 and %d. %d provided.", kMaxBlurRadius, radius);
+        return;
     }
     if (vectorSize != 1 && vectorSize != 4) {
         ALOGE("The vectorSize should be 1 or 4. %zu provided.", vectorSize);
+        return;
     }
 #endif
 
-    BlurTask task(in, out, sizeX, sizeY, vectorSize, processor->getNumberOfThreads(), radius,
-                  restriction);
+    if (radius > kMaxDirectBlurRadius) {
+        boxBlur(processor.get(), in, out, sizeX, sizeY, vectorSize, 1, radius, restriction);
+        return;
+    }
+    BlurTask task(in, out, sizeX, sizeY, vectorSize, radius, restriction);
+    processor->doTask(&task);
+}
+
+void RenderScriptToolkit::blur(const float* in, float* out, size_t sizeX, size_t sizeY,
+                               size_t vectorSize, int radius, const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * vectorSize * sizeof(float),
+                          sizeX * vectorSize * sizeof(float))) {
+        return;
+    }
+    if (radius <= 0 || radius > kMaxBlurRadius) {
+        ALOGE("The radius should be between 1 and %d. %d provided.", kMaxBlurRadius, radius);
+        return;
+    }
+    if (vectorSize < 1 || vectorSize > 4) {
+        ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+        return;
+    }
+#endif
+
+    if (radius > kMaxDirectBlurRadius) {
+        boxBlur(processor.get(), in, out, sizeX, sizeY, vectorSize, sizeof(float), radius,
+                restriction);
+        return;
+    }
+    FloatBlurTask task(in, out, sizeX, sizeY, vectorSize, radius, restriction);
     processor->doTask(&task);
 }
 
@@ -14,11 +14,14 @@
  * limitations under the License.
  */
 
+#include "ColorMatrix.h"
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
 #include "Utils.h"
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <new>
 #include <sys/mman.h>
 
 namespace renderscript {
@@ -164,6 +167,9 @@ class ColorMatrixTask : public Task {
     const void* mIn;
     void* mOut;
     size_t mInputVectorSize;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
     uint32_t mOutstep;
     uint32_t mInstep;
 
@@ -181,6 +187,7 @@ class ColorMatrixTask : public Task {
 #endif
 
     void kernel(uchar* out, uchar* in, uint32_t xstart, uint32_t xend);
+    friend class ColorMatrixKernel;
     void updateCoeffCache(float fpMul, float addMul);
 
     Key_t mLastKey;
@@ -209,7 +216,9 @@ class ColorMatrixTask : public Task {
         : Task{sizeX, sizeY, outputVectorSize, true, restriction},
           mIn{in},
           mOut{out},
-          mInputVectorSize{inputVectorSize} {
+          mInputVectorSize{inputVectorSize},
+          mInStride{inputStride(sizeX * paddedSize(inputVectorSize))},
+          mOutStride{outputStride(sizeX * paddedSize(outputVectorSize))} {
         mLastKey.key = 0;
         mBuf = nullptr;
         mBufSize = 0;
@@ -226,6 +235,8 @@ class ColorMatrixTask : public Task {
 #else
         preLaunch(inputVectorSize, outputVectorSize);
 #endif  // ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
+        setWorkingSetPerCell(mInstep + mOutstep);
+        setTilingGroup(RenderScriptToolkit::TilingGroup::COLOR_MATRIX);
     }
     ~ColorMatrixTask() {
         if (mBuf) munmap(mBuf, mBufSize);
@@ -506,9 +517,15 @@ void * selectKernel(Key_t key)
 {
     void * kernel = nullptr;
 
+    // The x86 kernels only handle uchar4 in and out, and they ignore the add vector.
+    // The dot kernel also copies alpha through.
+    if (key.u.inVecSize != 3 || key.u.outVecSize != 3 || key.u.addMask) {
+        return kernel;
+    }
+
     // inType, outType float if nonzero
     if (!(key.u.inType || key.u.outType)) {
-        if (key.u.dot)
+        if (key.u.dot && key.u.copyAlpha)
             kernel = (void *)rsdIntrinsicColorMatrixDot_K;
         else if (key.u.copyAlpha)
             kernel = (void *)rsdIntrinsicColorMatrix3x3_K;
@@ -986,9 +1003,10 @@ void ColorMatrixTask::preLaunch(size_t inVectorSize, size_t outVectorSize) {
 
 #if defined(ARCH_X86_HAVE_SSSE3)
     if ((mOptKernel == nullptr) || (mLastKey.key != key.key)) {
-        // FIXME: Disable mOptKernel to pass RS color matrix CTS cases
-        // mOptKernel =
-        //     (void (*)(void *, const void *, const int16_t *, uint32_t)) selectKernel(key);
+        // The kernels use the same 8.8 fixed point coefficients as the ARM ones, so results
+        // can differ from the float path by one.
+        mOptKernel =
+            (void (*)(void *, const void *, const int16_t *, uint32_t)) selectKernel(key);
         mLastKey = key;
     }
 
@@ -1029,21 +1047,106 @@ void ColorMatrixTask::preLaunch(size_t inVectorSize, size_t outVectorSize) {
 void ColorMatrixTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                                   size_t endY) {
     for (size_t y = startY; y < endY; y++) {
-        size_t offset = mSizeX * y + startX;
-        uchar* in = ((uchar*)mIn) + offset * paddedSize(mInputVectorSize);
-        uchar* out = ((uchar*)mOut) + offset * paddedSize(mVectorSize);
+        uchar* in = ((uchar*)mIn) + mInStride * y + startX * paddedSize(mInputVectorSize);
+        uchar* out = ((uchar*)mOut) + mOutStride * y + startX * paddedSize(mVectorSize);
         kernel(out, in, startX, endX);
     }
 }
 
 static const float fourZeroes[]{0.0f, 0.0f, 0.0f, 0.0f};
 
+ColorMatrixKernel::ColorMatrixKernel(const float* matrix, const float* addVector,
+                                     ScratchArena& scratch)
+    : mTask{new (scratch.allocate<ColorMatrixTask>(1))
+                    ColorMatrixTask(nullptr, nullptr, 4, 4, 1, 1, matrix,
+                                    addVector != nullptr ? addVector : fourZeroes, nullptr)} {
+    mTask->setUsesSimd(true);
+}
+
+ColorMatrixKernel::~ColorMatrixKernel() { mTask->~ColorMatrixTask(); }
+
+void ColorMatrixKernel::run(uint8_t* out, const uint8_t* in, size_t count) const {
+    // kernel() only reads the state set up by the constructor.
+    mTask->kernel(out, const_cast<uint8_t*>(in), 0, count);
+}
+
+/**
+ * The color matrix for cells of 1 to 4 packed floats.
+ *
+ * There's no normalization: the floats are multiplied as they are and the add vector is added
+ * unscaled. Each cell is done in float4, padded with zeros like the byte cells.
+ */
+class FloatColorMatrixTask : public Task {
+    const float* mIn;
+    float* mOut;
+    const size_t mInputVectorSize;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
+    // The columns of the matrix, i.e. what each channel of the input contributes to the output.
+    float4 mColumns[4];
+    float4 mAdd;
+
+    // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+    void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override;
+
+   public:
+    FloatColorMatrixTask(const float* in, float* out, size_t inputVectorSize,
+                         size_t outputVectorSize, size_t sizeX, size_t sizeY,
+                         const float* matrix, const float* addVector,
+                         const Restriction* restriction)
+        : Task{sizeX, sizeY, outputVectorSize, true, restriction},
+          mIn{in},
+          mOut{out},
+          mInputVectorSize{inputVectorSize},
+          mInStride{inputStride(sizeX * inputVectorSize * sizeof(float))},
+          mOutStride{outputStride(sizeX * outputVectorSize * sizeof(float))},
+          mAdd{loadFloat4(addVector)} {
+        for (int i = 0; i < 4; i++) {
+            mColumns[i] = loadFloat4(matrix + 4 * i);
+        }
+        setElementSize(sizeof(float));
+        setWorkingSetPerCell((inputVectorSize + outputVectorSize) * sizeof(float));
+        setTilingGroup(RenderScriptToolkit::TilingGroup::COLOR_MATRIX);
+    }
+};
+
+void FloatColorMatrixTask::processData(int /* threadIndex */, size_t startX, size_t startY,
+                                       size_t endX, size_t endY) {
+    for (size_t y = startY; y < endY; y++) {
+        const float* in = reinterpret_cast<const float*>(
+                reinterpret_cast<const uint8_t*>(mIn) + mInStride * y) + startX * mInputVectorSize;
+        float* out = reinterpret_cast<float*>(reinterpret_cast<uint8_t*>(mOut) + mOutStride * y) +
+                     startX * mVectorSize;
+        for (size_t x = startX; x < endX; x++) {
+            float4 f = 0.f;
+            if (mInputVectorSize == 4) {
+                f = loadFloat4(in);
+            } else {
+                for (size_t c = 0; c < mInputVectorSize; c++) f[c] = in[c];
+            }
+            const float4 sum = mColumns[0] * f.x + mColumns[1] * f.y + mColumns[2] * f.z +
+                               mColumns[3] * f.w + mAdd;
+            if (mVectorSize == 4) {
+                storeFloat4(out, sum);
+            } else {
+                for (size_t c = 0; c < mVectorSize; c++) out[c] = sum[c];
+            }
+            in += mInputVectorSize;
+            out += mVectorSize;
+        }
+    }
+}
+
 void RenderScriptToolkit::colorMatrix(const void* in, void* out, size_t inputVectorSize,
                                       size_t outputVectorSize, size_t sizeX, size_t sizeY,
                                       const float* matrix, const float* addVector,
                                       const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                          sizeX * paddedSize(inputVectorSize),
+                          sizeX * paddedSize(outputVectorSize))) {
         return;
     }
     if (inputVectorSize < 1 || inputVectorSize > 4) {
@@ -1064,4 +1167,32 @@ void RenderScriptToolkit::colorMatrix(const void* in, void* out, size_t inputVec
     processor->doTask(&task);
 }
 
+void RenderScriptToolkit::colorMatrix(const float* in, float* out, size_t inputVectorSize,
+                                      size_t outputVectorSize, size_t sizeX, size_t sizeY,
+                                      const float* matrix, const float* addVector,
+                                      const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                          sizeX * inputVectorSize * sizeof(float),
+                          sizeX * outputVectorSize * sizeof(float))) {
+        return;
+    }
+    if (inputVectorSize < 1 || inputVectorSize > 4) {
+        ALOGE("The inputVectorSize should be between 1 and 4. %zu provided.", inputVectorSize);
+        return;
+    }
+    if (outputVectorSize < 1 || outputVectorSize > 4) {
+        ALOGE("The outputVectorSize should be between 1 and 4. %zu provided.", outputVectorSize);
+        return;
+    }
+#endif
+
+    if (addVector == nullptr) {
+        addVector = fourZeroes;
+    }
+    FloatColorMatrixTask task(in, out, inputVectorSize, outputVectorSize, sizeX, sizeY, matrix,
+                              addVector, restriction);
+    processor->doTask(&task);
+}
+
 }  // namespace renderscript
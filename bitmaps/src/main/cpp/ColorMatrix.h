@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_RENDERSCRIPT_TOOLKIT_COLORMATRIX_H
+#define ANDROID_RENDERSCRIPT_TOOLKIT_COLORMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace renderscript {
+
+class ColorMatrixTask;
+class ScratchArena;
+
+/**
+ * The SIMD kernel of colorMatrix for RGBA cells, for the ops that apply a color matrix to rows
+ * of their own, like the pipeline. The kernel is set up once, which on ARM compiles the matrix
+ * to machine code, and can then be run from several threads at once.
+ *
+ * Its state is borrowed from a scratch arena, so the kernel must be destroyed before the scope
+ * it was made in ends.
+ */
+class ColorMatrixKernel {
+    ColorMatrixTask* mTask;
+
+   public:
+    /**
+     * @param matrix The 4x4 matrix, in row major format.
+     * @param addVector A vector of four floats, or null for zeroes.
+     * @param scratch The arena the state of the kernel is borrowed from.
+     */
+    ColorMatrixKernel(const float* matrix, const float* addVector, ScratchArena& scratch);
+    ~ColorMatrixKernel();
+
+    ColorMatrixKernel(const ColorMatrixKernel&) = delete;
+    ColorMatrixKernel& operator=(const ColorMatrixKernel&) = delete;
+
+    /**
+     * Transforms count RGBA cells from in to out. Gives the same result as colorMatrix.
+     */
+    void run(uint8_t* out, const uint8_t* in, size_t count) const;
+};
+
+}  // namespace renderscript
+
+#endif  // ANDROID_RENDERSCRIPT_TOOLKIT_COLORMATRIX_H
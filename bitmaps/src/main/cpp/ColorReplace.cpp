@@ -26,8 +26,10 @@
 namespace renderscript {
 
     class ColorReplaceTask : public Task {
-        const uchar4 *mIn;
-        uchar4 *mOut;
+        const uint8_t *mIn;
+        uint8_t *mOut;
+        const size_t mInStride;
+        const size_t mOutStride;
         uchar4 mTargetColor;
         uchar4 mReplacementColor;
         float mTolerance;
@@ -42,8 +44,10 @@ namespace renderscript {
                          uchar4 targetColor, uchar4 replacementColor, float tolerance,
                          bool interpolate, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
-                  mOut{reinterpret_cast<uchar4 *>(output)},
+                  mIn{input},
+                  mOut{output},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
+                  mOutStride{outputStride(sizeX * sizeof(uchar4))},
                   mTargetColor{targetColor},
                   mReplacementColor{replacementColor},
                   mTolerance{tolerance},
@@ -54,9 +58,8 @@ namespace renderscript {
     ColorReplaceTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                                   size_t endY) {
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-            uchar4 *out = mOut + offset;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y) + startX;
+            uchar4 *out = reinterpret_cast<uchar4 *>(mOut + mOutStride * y) + startX;
             for (size_t x = startX; x < endX; x++) {
                 auto v = *in;
 
@@ -101,7 +104,7 @@ namespace renderscript {
                                            float tolerance, bool interpolate,
                                            const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
             return;
         }
 #endif
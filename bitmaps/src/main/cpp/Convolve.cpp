@@ -0,0 +1,540 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "RenderScriptToolkit.h"
+#include "TaskProcessor.h"
+#include "Utils.h"
+
+namespace renderscript {
+
+#define LOG_TAG "renderscript.toolkit.Convolve"
+
+using BorderMode = RenderScriptToolkit::BorderMode;
+
+/**
+ * Returns which of the size cells to read for coordinate i, which may be outside of the image,
+ * or -1 when the ZERO border mode should read a zero.
+ */
+static ptrdiff_t borderIndex(ptrdiff_t i, size_t size, BorderMode mode) {
+    const ptrdiff_t n = size;
+    if (i >= 0 && i < n) {
+        return i;
+    }
+    switch (mode) {
+        case BorderMode::CLAMP:
+            return i < 0 ? 0 : n - 1;
+        case BorderMode::MIRROR: {
+            if (n == 1) {
+                return 0;
+            }
+            const ptrdiff_t period = 2 * (n - 1);
+            i = std::abs(i) % period;
+            return i < n ? i : period - i;
+        }
+        case BorderMode::WRAP:
+            return (i % n + n) % n;
+        case BorderMode::ZERO:
+            return -1;
+    }
+    return -1;
+}
+
+/**
+ * The number of bytes of a cell. Byte cells of 3 are padded to 4, float cells are packed.
+ */
+static size_t cellSize(size_t vectorSize, size_t elementSize) {
+    return elementSize == sizeof(float) ? vectorSize * sizeof(float) : paddedSize(vectorSize);
+}
+
+/**
+ * Copies the cells [first, first + count) of a row to out, following the border mode for the
+ * cells outside of the row. A null row is read as zeros.
+ */
+template <typename CellType>
+static void loadRow(const CellType* row, size_t sizeX, ptrdiff_t first, size_t count,
+                    BorderMode mode, CellType* out) {
+    const CellType zero{};
+    if (row == nullptr) {
+        std::fill(out, out + count, zero);
+        return;
+    }
+    // The cells inside of the row are copied as is, the ones before and after are mapped.
+    const ptrdiff_t end = first + (ptrdiff_t)count;
+    const ptrdiff_t insideStart = std::min(std::max(first, (ptrdiff_t)0), end);
+    const ptrdiff_t insideEnd = std::max(std::min(end, (ptrdiff_t)sizeX), insideStart);
+    for (ptrdiff_t x = first; x < insideStart; x++) {
+        ptrdiff_t i = borderIndex(x, sizeX, mode);
+        out[x - first] = i < 0 ? zero : row[i];
+    }
+    memcpy(out + (insideStart - first), row + insideStart,
+           (insideEnd - insideStart) * sizeof(CellType));
+    for (ptrdiff_t x = insideEnd; x < end; x++) {
+        ptrdiff_t i = borderIndex(x, sizeX, mode);
+        out[x - first] = i < 0 ? zero : row[i];
+    }
+}
+
+/**
+ * Applies a kernel of any size.
+ *
+ * When the kernel is the outer product of a column and a row, i.e. separable, it's done as two
+ * 1D passes in fixed point: each tile first convolves its rows, plus the rows above and below
+ * that the kernel reaches, with the row vector, then combines those with the column vector. That
+ * takes kernelSizeX + kernelSizeY multiplications per cell instead of their product. The other
+ * kernels are applied directly, one kernel row at a time, accumulating a row of the tile in
+ * floats that stays in the cache.
+ *
+ * Cells of packed floats, when the element size is sizeof(float), take the same two paths in
+ * floating point, without the clamping and the fixed point. The floats of a row are summed four
+ * at a time regardless of the cells.
+ */
+class ConvolveTask : public Task {
+    const uchar* mIn;
+    uchar* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
+    const size_t mKernelSizeX;
+    const size_t mKernelSizeY;
+    // The kernel cell that's over the cell being computed.
+    const size_t mCenterX;
+    const size_t mCenterY;
+    const BorderMode mBorderMode;
+    // The kernelSizeX * kernelSizeY coefficients, row-major, used by the direct path.
+    const float* mCoefficients;
+    // For separable kernels, the row and column vectors in fixed point with kFractionBits.
+    // They're borrowed from the scratch arena of the calling thread.
+    bool mSeparable = false;
+    int32_t* mRowIp = nullptr;
+    int32_t* mColumnIp = nullptr;
+    // For separable kernels applied to floats, the row and column vectors as they are.
+    float* mRowFp = nullptr;
+    float* mColumnFp = nullptr;
+
+    // The fixed point coefficients have 12 fractional bits. The row pass keeps 8 of them in its
+    // sums, so the column pass sums have 20.
+    static constexpr int kFractionBits = 12;
+    static constexpr int kRowPassShift = 4;
+    static constexpr int kColumnPassShift = 2 * kFractionBits - kRowPassShift;
+
+    void factorize(ScratchArena& scratch);
+    template <typename CellType, typename FloatType>
+    void convolveDirect(int threadIndex, size_t startX, size_t startY, size_t endX, size_t endY);
+    template <typename CellType, typename IntType>
+    void convolveSeparable(int threadIndex, size_t startX, size_t startY, size_t endX,
+                           size_t endY);
+    template <typename CellType, typename FloatType, typename IntType>
+    void convolve(int threadIndex, size_t startX, size_t startY, size_t endX, size_t endY);
+    template <size_t N>
+    void convolveFloatsDirect(int threadIndex, size_t startX, size_t startY, size_t endX,
+                              size_t endY);
+    template <size_t N>
+    void convolveFloatsSeparable(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                 size_t endY);
+    template <size_t N>
+    void convolveFloats(int threadIndex, size_t startX, size_t startY, size_t endX,
+                        size_t endY);
+
+    // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+    void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override;
+
+   public:
+    ConvolveTask(const void* in, void* out, size_t vectorSize, size_t elementSize, size_t sizeX,
+                 size_t sizeY, const float* coefficients, size_t kernelSizeX, size_t kernelSizeY,
+                 BorderMode borderMode, ScratchArena& scratch, const Restriction* restriction)
+        : Task{sizeX, sizeY, vectorSize, false, restriction},
+          mIn{(const uchar*)in},
+          mOut{(uchar*)out},
+          mInStride{inputStride(sizeX * cellSize(vectorSize, elementSize))},
+          mOutStride{outputStride(sizeX * cellSize(vectorSize, elementSize))},
+          mKernelSizeX{kernelSizeX},
+          mKernelSizeY{kernelSizeY},
+          mCenterX{(kernelSizeX - 1) / 2},
+          mCenterY{(kernelSizeY - 1) / 2},
+          mBorderMode{borderMode},
+          mCoefficients{coefficients} {
+        setElementSize(elementSize);
+        factorize(scratch);
+        setMinRowsPerTile(kernelSizeY);
+        setTilingGroup(RenderScriptToolkit::TilingGroup::CONVOLVE);
+        setReach(std::max(kernelSizeX, kernelSizeY) / 2);
+    }
+};
+
+/**
+ * Quantizes coefficients to fixed point, keeping their sum, i.e. the brightness of the result,
+ * as close as possible. The rounding error of the sum goes to the largest coefficient.
+ */
+static void toFixedPoint(const float* coefficients, size_t count, int fractionBits,
+                         int32_t* fixed) {
+    const float scale = (float)(1 << fractionBits);
+    float sum = 0.f;
+    int32_t fixedSum = 0;
+    size_t largest = 0;
+    for (size_t i = 0; i < count; i++) {
+        fixed[i] = (int32_t)lroundf(coefficients[i] * scale);
+        sum += coefficients[i];
+        fixedSum += fixed[i];
+        if (std::fabs(coefficients[i]) > std::fabs(coefficients[largest])) {
+            largest = i;
+        }
+    }
+    fixed[largest] += (int32_t)lroundf(sum * scale) - fixedSum;
+}
+
+/**
+ * Checks whether the kernel is the outer product of a column and a row and if so, prepares the
+ * fixed point vectors of the separable path, or the float ones for cells of floats.
+ */
+void ConvolveTask::factorize(ScratchArena& scratch) {
+    // The largest coefficient gives the row and column to factor with.
+    size_t pivot = 0;
+    float absoluteSum = 0.f;
+    for (size_t i = 0; i < mKernelSizeX * mKernelSizeY; i++) {
+        if (std::fabs(mCoefficients[i]) > std::fabs(mCoefficients[pivot])) {
+            pivot = i;
+        }
+        absoluteSum += std::fabs(mCoefficients[i]);
+    }
+    const float largest = mCoefficients[pivot];
+    // The sums of the column pass must fit in 32 bits. They reach 255 << kColumnPassShift times
+    // the sum of the absolute coefficients, so that sum must stay below 8, and a bit more for
+    // the rounding to fixed point. A kernel that's all zeros is better done by the direct path.
+    const bool floats = mElementSize == sizeof(float);
+    if (largest == 0.f || (!floats && absoluteSum >= 7.f)) {
+        return;
+    }
+    const size_t pivotX = pivot % mKernelSizeX;
+    const size_t pivotY = pivot / mKernelSizeX;
+
+    float* row = scratch.allocate<float>(mKernelSizeX);
+    float* column = scratch.allocate<float>(mKernelSizeY);
+    std::copy_n(mCoefficients + pivotY * mKernelSizeX, mKernelSizeX, row);
+    for (size_t y = 0; y < mKernelSizeY; y++) {
+        column[y] = mCoefficients[y * mKernelSizeX + pivotX] / largest;
+    }
+    const float tolerance = std::fabs(largest) * 1e-5f;
+    for (size_t y = 0; y < mKernelSizeY; y++) {
+        for (size_t x = 0; x < mKernelSizeX; x++) {
+            if (std::fabs(mCoefficients[y * mKernelSizeX + x] - column[y] * row[x]) > tolerance) {
+                return;
+            }
+        }
+    }
+
+    // Give both vectors the same magnitude so that they lose as little as possible to the
+    // fixed point.
+    float rowSum = 0.f;
+    float columnSum = 0.f;
+    for (size_t x = 0; x < mKernelSizeX; x++) rowSum += std::fabs(row[x]);
+    for (size_t y = 0; y < mKernelSizeY; y++) columnSum += std::fabs(column[y]);
+    const float balance = sqrtf(columnSum / rowSum);
+    for (size_t x = 0; x < mKernelSizeX; x++) row[x] *= balance;
+    for (size_t y = 0; y < mKernelSizeY; y++) column[y] /= balance;
+
+    if (floats) {
+        mRowFp = row;
+        mColumnFp = column;
+        mSeparable = true;
+        return;
+    }
+    mRowIp = scratch.allocate<int32_t>(mKernelSizeX);
+    mColumnIp = scratch.allocate<int32_t>(mKernelSizeY);
+    toFixedPoint(row, mKernelSizeX, kFractionBits, mRowIp);
+    toFixedPoint(column, mKernelSizeY, kFractionBits, mColumnIp);
+    mSeparable = true;
+}
+
+template <typename CellType, typename FloatType>
+void ConvolveTask::convolveDirect(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                  size_t endY) {
+    const size_t width = endX - startX;
+    const size_t rowWidth = width + mKernelSizeX - 1;
+    // The row read with its borders, and the sums of a row of the tile.
+    CellType* row = scratch(threadIndex).allocate<CellType>(rowWidth);
+    FloatType* sums = scratch(threadIndex).allocate<FloatType>(width);
+
+    for (size_t y = startY; y < endY; y++) {
+        std::fill(sums, sums + width, (FloatType)0);
+        for (size_t ky = 0; ky < mKernelSizeY; ky++) {
+            ptrdiff_t inY = borderIndex((ptrdiff_t)(y + ky) - mCenterY, mSizeY, mBorderMode);
+            auto in = inY < 0 ? nullptr : reinterpret_cast<const CellType*>(mIn + mInStride * inY);
+            loadRow(in, mSizeX, (ptrdiff_t)startX - mCenterX, rowWidth, mBorderMode, row);
+            const float* coefficients = mCoefficients + ky * mKernelSizeX;
+            for (size_t kx = 0; kx < mKernelSizeX; kx++) {
+                const float coefficient = coefficients[kx];
+                if (coefficient == 0.f) {
+                    continue;
+                }
+                for (size_t x = 0; x < width; x++) {
+                    sums[x] += convert<FloatType>(row[x + kx]) * coefficient;
+                }
+            }
+        }
+        auto out = reinterpret_cast<CellType*>(mOut + mOutStride * y) + startX;
+        for (size_t x = 0; x < width; x++) {
+            out[x] = convert<CellType>(clamp(sums[x] + 0.5f, 0.f, 255.f));
+        }
+    }
+}
+
+template <typename CellType, typename IntType>
+void ConvolveTask::convolveSeparable(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                     size_t endY) {
+    const size_t width = endX - startX;
+    const size_t rowWidth = width + mKernelSizeX - 1;
+    // The row pass results for the rows of the tile and the ones the kernel reaches.
+    const size_t rows = endY - startY + mKernelSizeY - 1;
+    CellType* row = scratch(threadIndex).allocate<CellType>(rowWidth);
+    IntType* rowSums = scratch(threadIndex).allocate<IntType>((rows + 1) * width);
+    IntType* sums = rowSums + rows * width;
+
+    for (size_t r = 0; r < rows; r++) {
+        ptrdiff_t inY = borderIndex((ptrdiff_t)(startY + r) - mCenterY, mSizeY, mBorderMode);
+        auto in = inY < 0 ? nullptr : reinterpret_cast<const CellType*>(mIn + mInStride * inY);
+        loadRow(in, mSizeX, (ptrdiff_t)startX - mCenterX, rowWidth, mBorderMode, row);
+        IntType* rowSum = rowSums + r * width;
+        std::fill(rowSum, rowSum + width, (IntType)0);
+        for (size_t kx = 0; kx < mKernelSizeX; kx++) {
+            const int32_t coefficient = mRowIp[kx];
+            if (coefficient == 0) {
+                continue;
+            }
+            for (size_t x = 0; x < width; x++) {
+                rowSum[x] += convert<IntType>(row[x + kx]) * coefficient;
+            }
+        }
+        for (size_t x = 0; x < width; x++) {
+            rowSum[x] = (rowSum[x] + (1 << (kRowPassShift - 1))) >> kRowPassShift;
+        }
+    }
+
+    for (size_t y = startY; y < endY; y++) {
+        std::fill(sums, sums + width, (IntType)0);
+        for (size_t ky = 0; ky < mKernelSizeY; ky++) {
+            const int32_t coefficient = mColumnIp[ky];
+            if (coefficient == 0) {
+                continue;
+            }
+            const IntType* rowSum = rowSums + (y - startY + ky) * width;
+            for (size_t x = 0; x < width; x++) {
+                sums[x] += rowSum[x] * coefficient;
+            }
+        }
+        auto out = reinterpret_cast<CellType*>(mOut + mOutStride * y) + startX;
+        for (size_t x = 0; x < width; x++) {
+            IntType value = (sums[x] + (1 << (kColumnPassShift - 1))) >> kColumnPassShift;
+            out[x] = convert<CellType>(clamp(value, 0, 255));
+        }
+    }
+}
+
+template <typename CellType, typename FloatType, typename IntType>
+void ConvolveTask::convolve(int threadIndex, size_t startX, size_t startY, size_t endX,
+                            size_t endY) {
+    if (mSeparable) {
+        convolveSeparable<CellType, IntType>(threadIndex, startX, startY, endX, endY);
+    } else {
+        convolveDirect<CellType, FloatType>(threadIndex, startX, startY, endX, endY);
+    }
+}
+
+template <size_t N>
+void ConvolveTask::convolveFloatsDirect(int threadIndex, size_t startX, size_t startY,
+                                        size_t endX, size_t endY) {
+    const size_t width = endX - startX;
+    const size_t rowWidth = width + mKernelSizeX - 1;
+    // The row read with its borders. The sums are accumulated in the output row.
+    FloatCell<N>* row = scratch(threadIndex).allocate<FloatCell<N>>(rowWidth);
+
+    for (size_t y = startY; y < endY; y++) {
+        float* out = reinterpret_cast<float*>(mOut + mOutStride * y) + startX * N;
+        std::fill_n(out, width * N, 0.f);
+        for (size_t ky = 0; ky < mKernelSizeY; ky++) {
+            ptrdiff_t inY = borderIndex((ptrdiff_t)(y + ky) - mCenterY, mSizeY, mBorderMode);
+            auto in = inY < 0 ? nullptr
+                              : reinterpret_cast<const FloatCell<N>*>(mIn + mInStride * inY);
+            loadRow(in, mSizeX, (ptrdiff_t)startX - mCenterX, rowWidth, mBorderMode, row);
+            const float* coefficients = mCoefficients + ky * mKernelSizeX;
+            for (size_t kx = 0; kx < mKernelSizeX; kx++) {
+                if (coefficients[kx] != 0.f) {
+                    multiplyAdd(row[kx].v, coefficients[kx], width * N, out);
+                }
+            }
+        }
+    }
+}
+
+template <size_t N>
+void ConvolveTask::convolveFloatsSeparable(int threadIndex, size_t startX, size_t startY,
+                                           size_t endX, size_t endY) {
+    const size_t width = endX - startX;
+    const size_t rowWidth = width + mKernelSizeX - 1;
+    // The row pass results for the rows of the tile and the ones the kernel reaches.
+    const size_t rows = endY - startY + mKernelSizeY - 1;
+    FloatCell<N>* row = scratch(threadIndex).allocate<FloatCell<N>>(rowWidth);
+    float* rowSums = scratch(threadIndex).allocate<float>(rows * width * N);
+
+    for (size_t r = 0; r < rows; r++) {
+        ptrdiff_t inY = borderIndex((ptrdiff_t)(startY + r) - mCenterY, mSizeY, mBorderMode);
+        auto in = inY < 0 ? nullptr
+                          : reinterpret_cast<const FloatCell<N>*>(mIn + mInStride * inY);
+        loadRow(in, mSizeX, (ptrdiff_t)startX - mCenterX, rowWidth, mBorderMode, row);
+        float* rowSum = rowSums + r * width * N;
+        std::fill_n(rowSum, width * N, 0.f);
+        for (size_t kx = 0; kx < mKernelSizeX; kx++) {
+            if (mRowFp[kx] != 0.f) {
+                multiplyAdd(row[kx].v, mRowFp[kx], width * N, rowSum);
+            }
+        }
+    }
+
+    for (size_t y = startY; y < endY; y++) {
+        float* out = reinterpret_cast<float*>(mOut + mOutStride * y) + startX * N;
+        std::fill_n(out, width * N, 0.f);
+        for (size_t ky = 0; ky < mKernelSizeY; ky++) {
+            if (mColumnFp[ky] != 0.f) {
+                multiplyAdd(rowSums + (y - startY + ky) * width * N, mColumnFp[ky], width * N,
+                            out);
+            }
+        }
+    }
+}
+
+template <size_t N>
+void ConvolveTask::convolveFloats(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                  size_t endY) {
+    if (mSeparable) {
+        convolveFloatsSeparable<N>(threadIndex, startX, startY, endX, endY);
+    } else {
+        convolveFloatsDirect<N>(threadIndex, startX, startY, endX, endY);
+    }
+}
+
+void ConvolveTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                               size_t endY) {
+    if (mElementSize == sizeof(float)) {
+        switch (mVectorSize) {
+            case 1:
+                convolveFloats<1>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 2:
+                convolveFloats<2>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 3:
+                convolveFloats<3>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 4:
+                convolveFloats<4>(threadIndex, startX, startY, endX, endY);
+                break;
+        }
+        return;
+    }
+    switch (mVectorSize) {
+        case 1:
+            convolve<uchar, float, int>(threadIndex, startX, startY, endX, endY);
+            break;
+        case 2:
+            convolve<uchar2, float2, int2>(threadIndex, startX, startY, endX, endY);
+            break;
+        case 3:
+        case 4:
+            convolve<uchar4, float4, int4>(threadIndex, startX, startY, endX, endY);
+            break;
+    }
+}
+
+void RenderScriptToolkit::convolve(const void* in, void* out, size_t vectorSize, size_t sizeX,
+                                   size_t sizeY, const float* coefficients, size_t kernelSizeX,
+                                   size_t kernelSizeY, BorderMode borderMode,
+                                   const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                          sizeX * paddedSize(vectorSize), sizeX * paddedSize(vectorSize))) {
+        return;
+    }
+    if (vectorSize < 1 || vectorSize > 4) {
+        ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+        return;
+    }
+    if (kernelSizeX < 1 || kernelSizeY < 1) {
+        ALOGE("The kernel should be at least 1x1. %zux%zu provided.", kernelSizeX, kernelSizeY);
+        return;
+    }
+    if (borderMode != BorderMode::CLAMP && borderMode != BorderMode::MIRROR &&
+        borderMode != BorderMode::WRAP && borderMode != BorderMode::ZERO) {
+        ALOGE("Unknown border mode %d.", (int)borderMode);
+        return;
+    }
+#endif
+
+    // The 3x3 and 5x5 tasks have their own SIMD kernels, which clamp at the borders.
+    if (borderMode == BorderMode::CLAMP && kernelSizeX == kernelSizeY &&
+        (kernelSizeX == 3 || kernelSizeX == 5)) {
+        if (kernelSizeX == 3) {
+            convolve3x3(in, out, vectorSize, sizeX, sizeY, coefficients, restriction);
+        } else {
+            convolve5x5(in, out, vectorSize, sizeX, sizeY, coefficients, restriction);
+        }
+        return;
+    }
+    // The task borrows the vectors of the separable path.
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+    ConvolveTask task(in, out, vectorSize, 1, sizeX, sizeY, coefficients, kernelSizeX,
+                      kernelSizeY, borderMode, TaskProcessor::callingThreadScratch(), restriction);
+    processor->doTask(&task);
+}
+
+void RenderScriptToolkit::convolve(const float* in, float* out, size_t vectorSize, size_t sizeX,
+                                   size_t sizeY, const float* coefficients, size_t kernelSizeX,
+                                   size_t kernelSizeY, BorderMode borderMode,
+                                   const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * vectorSize * sizeof(float),
+                          sizeX * vectorSize * sizeof(float))) {
+        return;
+    }
+    if (vectorSize < 1 || vectorSize > 4) {
+        ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+        return;
+    }
+    if (kernelSizeX < 1 || kernelSizeY < 1) {
+        ALOGE("The kernel should be at least 1x1. %zux%zu provided.", kernelSizeX, kernelSizeY);
+        return;
+    }
+    if (borderMode != BorderMode::CLAMP && borderMode != BorderMode::MIRROR &&
+        borderMode != BorderMode::WRAP && borderMode != BorderMode::ZERO) {
+        ALOGE("Unknown border mode %d.", (int)borderMode);
+        return;
+    }
+#endif
+
+    // The task borrows the vectors of the separable path.
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+    ConvolveTask task(in, out, vectorSize, sizeof(float), sizeX, sizeY, coefficients,
+                      kernelSizeX, kernelSizeY, borderMode, TaskProcessor::callingThreadScratch(),
+                      restriction);
+    processor->doTask(&task);
+}
+
+}  // namespace renderscript
@@ -30,6 +30,9 @@ extern "C" void rsdIntrinsicConvolve3x3_K(void* dst, const void* y0, const void*
 class Convolve3x3Task : public Task {
     const void* mIn;
     void* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
     // Even though we have exactly 9 coefficients, store them in an array of size 16 so that
     // the SIMD instructions can load them in chunks multiple of 8.
     float mFp[16];
@@ -37,8 +40,9 @@ class Convolve3x3Task : public Task {
 
     void kernelU4(uchar* out, uint32_t xstart, uint32_t xend, const uchar* py0, const uchar* py1,
                   const uchar* py2);
-    void convolveU4(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX, size_t sizeY,
-                    size_t startX, size_t startY, size_t endX, size_t endY);
+    void convolveU4(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                    size_t vectorSize, size_t sizeY, size_t startX, size_t startY, size_t endX,
+                    size_t endY);
 
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
     void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -47,7 +51,11 @@ class Convolve3x3Task : public Task {
    public:
     Convolve3x3Task(const void* in, void* out, size_t vectorSize, size_t sizeX, size_t sizeY,
                     const float* coefficients, const Restriction* restriction)
-        : Task{sizeX, sizeY, vectorSize, false, restriction}, mIn{in}, mOut{out} {
+        : Task{sizeX, sizeY, vectorSize, false, restriction},
+          mIn{in},
+          mOut{out},
+          mInStride{inputStride(sizeX * paddedSize(vectorSize))},
+          mOutStride{outputStride(sizeX * paddedSize(vectorSize))} {
         for (int ct = 0; ct < 9; ct++) {
             mFp[ct] = coefficients[ct];
             if (mFp[ct] >= 0) {
@@ -56,6 +64,8 @@ class Convolve3x3Task : public Task {
                 mIp[ct] = (int16_t)(mFp[ct] * 256.f - 0.5f);
             }
         }
+        setTilingGroup(RenderScriptToolkit::TilingGroup::CONVOLVE);
+        setReach(1);
     }
 };
 
@@ -186,37 +196,34 @@ void RsdCpuScriptIntrinsicConvolve3x3_kernelF(void* in, T* out, uint32_t xstart,
 #endif  // ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
 
 template <typename InputOutputType, typename ComputationType>
-static void convolveU(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX, size_t sizeY,
-                      size_t startX, size_t startY, size_t endX, size_t endY, float* fp) {
-    const size_t stride = vectorSize * sizeX;
+static void convolveU(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                      size_t vectorSize, size_t sizeX, size_t sizeY, size_t startX, size_t startY,
+                      size_t endX, size_t endY, float* fp) {
     for (size_t y = startY; y < endY; y++) {
         uint32_t y1 = std::min((int32_t)y + 1, (int32_t)(sizeY - 1));
         uint32_t y2 = std::max((int32_t)y - 1, 0);
 
-        size_t offset = (y * sizeX + startX) * vectorSize;
-        InputOutputType* px = (InputOutputType*)(pout + offset);
-        InputOutputType* py0 = (InputOutputType*)(pin + stride * y2);
-        InputOutputType* py1 = (InputOutputType*)(pin + stride * y);
-        InputOutputType* py2 = (InputOutputType*)(pin + stride * y1);
+        InputOutputType* px = (InputOutputType*)(pout + outStride * y + startX * vectorSize);
+        InputOutputType* py0 = (InputOutputType*)(pin + inStride * y2);
+        InputOutputType* py1 = (InputOutputType*)(pin + inStride * y);
+        InputOutputType* py2 = (InputOutputType*)(pin + inStride * y1);
         for (uint32_t x = startX; x < endX; x++, px++) {
             convolveOneU<InputOutputType, ComputationType>(x, px, py0, py1, py2, fp, sizeX);
         }
     }
 }
 
-void Convolve3x3Task::convolveU4(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX,
-                                 size_t sizeY, size_t startX, size_t startY, size_t endX,
-                                 size_t endY) {
-    const size_t stride = paddedSize(vectorSize) * sizeX;
+void Convolve3x3Task::convolveU4(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                                 size_t vectorSize, size_t sizeY, size_t startX, size_t startY,
+                                 size_t endX, size_t endY) {
     for (size_t y = startY; y < endY; y++) {
         uint32_t y1 = std::min((int32_t)y + 1, (int32_t)(sizeY - 1));
         uint32_t y2 = std::max((int32_t)y - 1, 0);
 
-        size_t offset = (y * sizeX + startX) * paddedSize(vectorSize);
-        uchar* px = pout + offset;
-        const uchar* py0 = pin + stride * y2;
-        const uchar* py1 = pin + stride * y;
-        const uchar* py2 = pin + stride * y1;
+        uchar* px = pout + outStride * y + startX * paddedSize(vectorSize);
+        const uchar* py0 = pin + inStride * y2;
+        const uchar* py1 = pin + inStride * y;
+        const uchar* py2 = pin + inStride * y1;
         kernelU4(px, startX, endX, py0, py1, py2);
     }
 }
@@ -227,17 +234,18 @@ void Convolve3x3Task::processData(int /* threadIndex */, size_t startX, size_t s
     // endX, endY);
     switch (mVectorSize) {
         case 1:
-            convolveU<uchar, float>((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY,
-                                    startX, startY, endX, endY, mFp);
+            convolveU<uchar, float>((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride,
+                                    mVectorSize, mSizeX, mSizeY, startX, startY, endX, endY, mFp);
             break;
         case 2:
-            convolveU<uchar2, float2>((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY,
-                                      startX, startY, endX, endY, mFp);
+            convolveU<uchar2, float2>((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride,
+                                      mVectorSize, mSizeX, mSizeY, startX, startY, endX, endY,
+                                      mFp);
             break;
         case 3:
         case 4:
-            convolveU4((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY, startX, startY,
-                       endX, endY);
+            convolveU4((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride, mVectorSize, mSizeY,
+                       startX, startY, endX, endY);
             break;
     }
 }
@@ -246,7 +254,8 @@ void RenderScriptToolkit::convolve3x3(const void* in, void* out, size_t vectorSi
                                       size_t sizeY, const float* coefficients,
                                       const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                          sizeX * paddedSize(vectorSize), sizeX * paddedSize(vectorSize))) {
         return;
     }
     if (vectorSize < 1 || vectorSize > 4) {
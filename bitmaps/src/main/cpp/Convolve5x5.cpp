@@ -31,6 +31,9 @@ extern "C" void rsdIntrinsicConvolve5x5_K(void* dst, const void* y0, const void*
 class Convolve5x5Task : public Task {
     const void* mIn;
     void* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
     // Even though we have exactly 25 coefficients, store them in an array of size 28 so that
     // the SIMD instructions can load them in three chunks of 8 and 1 of chunk of 4.
     float mFp[28];
@@ -38,8 +41,9 @@ class Convolve5x5Task : public Task {
 
     void kernelU4(uchar* out, uint32_t xstart, uint32_t xend, const uchar* py0, const uchar* py1,
                   const uchar* py2, const uchar* py3, const uchar* py4);
-    void convolveU4(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX, size_t sizeY,
-                    size_t startX, size_t startY, size_t endX, size_t endY);
+    void convolveU4(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                    size_t vectorSize, size_t sizeY, size_t startX, size_t startY, size_t endX,
+                    size_t endY);
 
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
     void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -48,7 +52,11 @@ class Convolve5x5Task : public Task {
    public:
     Convolve5x5Task(const void* in, void* out, size_t vectorSize, size_t sizeX, size_t sizeY,
                     const float* coefficients, const Restriction* restriction)
-        : Task{sizeX, sizeY, vectorSize, false, restriction}, mIn{in}, mOut{out} {
+        : Task{sizeX, sizeY, vectorSize, false, restriction},
+          mIn{in},
+          mOut{out},
+          mInStride{inputStride(sizeX * paddedSize(vectorSize))},
+          mOutStride{outputStride(sizeX * paddedSize(vectorSize))} {
         for (int ct = 0; ct < 25; ct++) {
             mFp[ct] = coefficients[ct];
             if (mFp[ct] >= 0) {
@@ -57,6 +65,8 @@ class Convolve5x5Task : public Task {
                 mIp[ct] = (int16_t)(mFp[ct] * 256.f - 0.5f);
             }
         }
+        setTilingGroup(RenderScriptToolkit::TilingGroup::CONVOLVE);
+        setReach(2);
     }
 };
 
@@ -163,10 +173,12 @@ void Convolve5x5Task::kernelU4(uchar* pout, uint32_t x1, uint32_t x2, const ucha
     }
 #if defined(ARCH_X86_HAVE_SSSE3)
     // for x86 SIMD, require minimum of 7 elements (4 for SIMD,
-    // 3 for end boundary where x may hit the end boundary)
-    if (mUsesSimd && ((x1 + 6) < x2)) {
+    // 3 for end boundary where x may hit the end boundary). The boundary is the end of the
+    // row: past the end of the tile, the cells of the row can be read.
+    const uint32_t end = std::min(x2 + 3, (uint32_t)mSizeX);
+    if (mUsesSimd && ((x1 + 6) < end) && ((x1 + 4) <= x2)) {
         // subtract 3 for end boundary
-        uint32_t len = (x2 - x1 - 3) >> 2;
+        uint32_t len = std::min((end - x1 - 3) >> 2, (x2 - x1) >> 2);
         rsdIntrinsicConvolve5x5_K(out, py0 + x1 - 2, py1 + x1 - 2, py2 + x1 - 2, py3 + x1 - 2,
                                   py4 + x1 - 2, mIp, len);
         out += len << 2;
@@ -261,9 +273,9 @@ void RsdCpuScriptIntrinsicConvolve5x5_kernelF1(const ConvolveInfo* info, float*
 #endif  // ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
 
 template <typename InputOutputType, typename ComputationType>
-static void convolveU(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX, size_t sizeY,
-                      size_t startX, size_t startY, size_t endX, size_t endY, float* mFp) {
-    const size_t stride = vectorSize * sizeX;
+static void convolveU(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                      size_t vectorSize, size_t sizeX, size_t sizeY, size_t startX, size_t startY,
+                      size_t endX, size_t endY, float* mFp) {
     for (size_t y = startY; y < endY; y++) {
         uint32_t y0 = std::max((int32_t)y - 2, 0);
         uint32_t y1 = std::max((int32_t)y - 1, 0);
@@ -271,13 +283,12 @@ static void convolveU(const uchar* pin, uchar* pout, size_t vectorSize, size_t s
         uint32_t y3 = std::min((int32_t)y + 1, (int32_t)(sizeY - 1));
         uint32_t y4 = std::min((int32_t)y + 2, (int32_t)(sizeY - 1));
 
-        size_t offset = (y * sizeX + startX) * vectorSize;
-        InputOutputType* px = (InputOutputType*)(pout + offset);
-        InputOutputType* py0 = (InputOutputType*)(pin + stride * y0);
-        InputOutputType* py1 = (InputOutputType*)(pin + stride * y1);
-        InputOutputType* py2 = (InputOutputType*)(pin + stride * y2);
-        InputOutputType* py3 = (InputOutputType*)(pin + stride * y3);
-        InputOutputType* py4 = (InputOutputType*)(pin + stride * y4);
+        InputOutputType* px = (InputOutputType*)(pout + outStride * y + startX * vectorSize);
+        InputOutputType* py0 = (InputOutputType*)(pin + inStride * y0);
+        InputOutputType* py1 = (InputOutputType*)(pin + inStride * y1);
+        InputOutputType* py2 = (InputOutputType*)(pin + inStride * y2);
+        InputOutputType* py3 = (InputOutputType*)(pin + inStride * y3);
+        InputOutputType* py4 = (InputOutputType*)(pin + inStride * y4);
         for (uint32_t x = startX; x < endX; x++, px++) {
             ConvolveOneU<InputOutputType, ComputationType>(x, px, py0, py1, py2, py3, py4, mFp,
                                                            sizeX);
@@ -285,10 +296,9 @@ static void convolveU(const uchar* pin, uchar* pout, size_t vectorSize, size_t s
     }
 }
 
-void Convolve5x5Task::convolveU4(const uchar* pin, uchar* pout, size_t vectorSize, size_t sizeX,
-                                 size_t sizeY, size_t startX, size_t startY, size_t endX,
-                                 size_t endY) {
-    const size_t stride = paddedSize(vectorSize) * sizeX;
+void Convolve5x5Task::convolveU4(const uchar* pin, size_t inStride, uchar* pout, size_t outStride,
+                                 size_t vectorSize, size_t sizeY, size_t startX, size_t startY,
+                                 size_t endX, size_t endY) {
     for (size_t y = startY; y < endY; y++) {
         uint32_t y0 = std::max((int32_t)y - 2, 0);
         uint32_t y1 = std::max((int32_t)y - 1, 0);
@@ -296,13 +306,12 @@ void Convolve5x5Task::convolveU4(const uchar* pin, uchar* pout, size_t vectorSiz
         uint32_t y3 = std::min((int32_t)y + 1, (int32_t)(sizeY - 1));
         uint32_t y4 = std::min((int32_t)y + 2, (int32_t)(sizeY - 1));
 
-        size_t offset = (y * sizeX + startX) * paddedSize(vectorSize);
-        uchar* px = pout + offset;
-        const uchar* py0 = pin + stride * y0;
-        const uchar* py1 = pin + stride * y1;
-        const uchar* py2 = pin + stride * y2;
-        const uchar* py3 = pin + stride * y3;
-        const uchar* py4 = pin + stride * y4;
+        uchar* px = pout + outStride * y + startX * paddedSize(vectorSize);
+        const uchar* py0 = pin + inStride * y0;
+        const uchar* py1 = pin + inStride * y1;
+        const uchar* py2 = pin + inStride * y2;
+        const uchar* py3 = pin + inStride * y3;
+        const uchar* py4 = pin + inStride * y4;
         kernelU4(px, startX, endX, py0, py1, py2, py3, py4);
     }
 }
@@ -313,17 +322,18 @@ void Convolve5x5Task::processData(int /* threadIndex */, size_t startX, size_t s
     // endX, endY);
     switch (mVectorSize) {
         case 1:
-            convolveU<uchar, float>((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY,
-                                    startX, startY, endX, endY, mFp);
+            convolveU<uchar, float>((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride,
+                                    mVectorSize, mSizeX, mSizeY, startX, startY, endX, endY, mFp);
             break;
         case 2:
-            convolveU<uchar2, float2>((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY,
-                                      startX, startY, endX, endY, mFp);
+            convolveU<uchar2, float2>((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride,
+                                      mVectorSize, mSizeX, mSizeY, startX, startY, endX, endY,
+                                      mFp);
             break;
         case 3:
         case 4:
-            convolveU4((const uchar*)mIn, (uchar*)mOut, mVectorSize, mSizeX, mSizeY, startX, startY,
-                       endX, endY);
+            convolveU4((const uchar*)mIn, mInStride, (uchar*)mOut, mOutStride, mVectorSize, mSizeY,
+                       startX, startY, endX, endY);
             break;
     }
 }
@@ -332,7 +342,8 @@ void RenderScriptToolkit::convolve5x5(const void* in, void* out, size_t vectorSi
                                       size_t sizeY, const float* coefficients,
                                       const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                          sizeX * paddedSize(vectorSize), sizeX * paddedSize(vectorSize))) {
         return;
     }
     if (vectorSize < 1 || vectorSize > 4) {
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <limits>
+#include <mutex>
 
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
@@ -8,144 +12,485 @@
 
 namespace renderscript {
 
-    class GrayLevelCovarianceMatrixTask : public Task {
-        const uchar4 *mIn;
+    namespace {
+        /**
+         * The number of slots of the hash table of each thread in sparse mode, a power of 2. At
+         * 8 bytes a slot, a table is 64 KB, where 256 levels take 256 KB of dense counters. It
+         * holds the distinct pairs of most photos at short steps without spilling.
+         */
+        constexpr uint32_t kSparseBits = 13;
+        constexpr uint32_t kSparseCapacity = 1 << kSparseBits;
+        // A table is spilled into the 64 bit counters when it's 3/4 full, so that the probe
+        // sequences stay short.
+        constexpr uint32_t kSparseLimit = kSparseCapacity / 4 * 3;
+
+        /**
+         * An open addressing table of the non zero counters.
+         */
+        struct SparseCounts {
+            // The index of the counter in the levels * levels matrix plus 1, 0 for empty slots.
+            uint32_t *keys = nullptr;
+            uint32_t *counts = nullptr;
+            // The capacity is 1 << bits.
+            uint32_t bits = 0;
+            uint32_t capacity = 0;
+            uint32_t size = 0;
+
+            void init(ScratchArena &scratch, uint32_t capacityBits) {
+                bits = capacityBits;
+                capacity = 1u << bits;
+                keys = scratch.allocate<uint32_t>(capacity);
+                counts = scratch.allocate<uint32_t>(capacity);
+                reset();
+            }
+
+            void reset() {
+                std::fill(keys, keys + capacity, 0);
+                size = 0;
+            }
+
+            void add(uint32_t key, uint32_t count) {
+                uint32_t mask = capacity - 1;
+                // Fibonacci hashing, the high bits are the best mixed.
+                uint32_t slot = (key * 2654435761u) >> (32 - bits);
+                while (keys[slot] != 0 && keys[slot] != key) {
+                    slot = (slot + 1) & mask;
+                }
+                if (keys[slot] == 0) {
+                    keys[slot] = key;
+                    counts[slot] = 0;
+                    size++;
+                }
+                counts[slot] += count;
+            }
+        };
+
+        /**
+         * The sums the Haralick features are derived from, over the raw counts.
+         */
+        struct HaralickSums {
+            double total = 0;
+            double contrast = 0;
+            double dissimilarity = 0;
+            double homogeneity = 0;
+            double squares = 0;
+            double countLogCount = 0;
+            double maxCount = 0;
+            double sumI = 0;
+            double sumJ = 0;
+            // Filled by the second pass, once the means are known.
+            double varianceI = 0;
+            double varianceJ = 0;
+            double covariance = 0;
+
+            void add(size_t i, size_t j, double count) {
+                double d = (double) i - (double) j;
+                total += count;
+                contrast += d * d * count;
+                dissimilarity += std::abs(d) * count;
+                homogeneity += count / (1 + d * d);
+                squares += count * count;
+                countLogCount += count * std::log(count);
+                maxCount = std::max(maxCount, count);
+                sumI += (double) i * count;
+                sumJ += (double) j * count;
+            }
+
+            void addCentered(size_t i, size_t j, double count) {
+                double di = (double) i - sumI / total;
+                double dj = (double) j - sumJ / total;
+                varianceI += di * di * count;
+                varianceJ += dj * dj * count;
+                covariance += di * dj * count;
+            }
+
+            void write(float *out) const {
+                if (total == 0) {
+                    std::fill(out, out + RenderScriptToolkit::kGlcmFeatureCount, 0.0f);
+                    return;
+                }
+                double correlation = 1;
+                if (varianceI > 0 && varianceJ > 0) {
+                    correlation = covariance / std::sqrt(varianceI * varianceJ);
+                }
+                double angularSecondMoment = squares / (total * total);
+                out[0] = (float) (contrast / total);
+                out[1] = (float) (dissimilarity / total);
+                out[2] = (float) (homogeneity / total);
+                out[3] = (float) angularSecondMoment;
+                out[4] = (float) std::sqrt(angularSecondMoment);
+                // -sum(p ln p) with p = count / total.
+                out[5] = (float) (std::log(total) - countLogCount / total);
+                out[6] = (float) correlation;
+                out[7] = (float) (maxCount / total);
+            }
+        };
+
+        /**
+         * The level of every cell the pairs are made of, quantized once rather than for every
+         * pair it's part of. It covers the restriction and the neighbors its steps reach, within
+         * the image. The levels are uint16_t when the transparent cells are excluded at 256
+         * levels, since the marker of a transparent cell is the largest value of the type.
+         */
+        struct QuantizedPlane {
+            const void *data = nullptr;
+            bool wide = false;
+            size_t startX = 0;
+            size_t endX = 0;
+            size_t startY = 0;
+            size_t endY = 0;
+
+            size_t stride() const { return endX - startX; }
+        };
+
+        uchar quantize(float value, size_t levels) {
+            if (levels == 256) {
+                return (uchar) round(value);
+            }
+
+            return (uchar) round(value / 255.0f * (float) (levels - 1));
+        }
+    }  // namespace
+
+    /**
+     * Quantizes the channel of the cells into one plane per level count, in a single pass over
+     * the input. A look up table per level count replaces the float math, indexed by the channel
+     * or, for gray, by the sum of R, G and B.
+     */
+    template <typename Level>
+    class GlcmQuantizeTask : public Task {
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
+        const bool mExcludeTransparent;
+        const size_t mPlaneCount;
+        Level *const *mPlanes;
+        const Level *const *mLuts;
+        const size_t mPlaneStartX;
+        const size_t mPlaneStartY;
+        const size_t mPlaneStride;
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        static constexpr Level kTransparent = std::numeric_limits<Level>::max();
+
+        GlcmQuantizeTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
+                         bool excludeTransparent, size_t planeCount, Level *const *planes,
+                         const Level *const *luts, const QuantizedPlane &extent,
+                         const Restriction *restriction)
+                : Task{sizeX, sizeY, 4, false, restriction},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
+                  mChannel{channel},
+                  mExcludeTransparent{excludeTransparent},
+                  mPlaneCount{planeCount},
+                  mPlanes{planes},
+                  mLuts{luts},
+                  mPlaneStartX{extent.startX},
+                  mPlaneStartY{extent.startY},
+                  mPlaneStride{extent.stride()} {
+            setWorkingSetPerCell(4 + planeCount * sizeof(Level));
+        }
+
+        /**
+         * The number of entries of a look up table: a channel value, or the sum of 3 for gray.
+         */
+        static size_t lutSize(uint8_t channel) { return channel < 4 ? 256 : 3 * 255 + 1; }
+
+        static void buildLut(Level *lut, uint8_t channel, size_t levels) {
+            for (size_t i = 0; i < lutSize(channel); i++) {
+                float value = channel < 4 ? (float) i : (float) (i / 3.0);
+                lut[i] = quantize(value, levels);
+            }
+        }
+    };
+
+    template <typename Level>
+    void GlcmQuantizeTask<Level>::processData(int /*threadIndex*/, size_t startX, size_t startY,
+                                              size_t endX, size_t endY) {
+        for (size_t y = startY; y < endY; y++) {
+            const uint8_t *in = mIn + mInStride * y + startX * 4;
+            size_t offset = (y - mPlaneStartY) * mPlaneStride + (startX - mPlaneStartX);
+            for (size_t p = 0; p < mPlaneCount; p++) {
+                const Level *lut = mLuts[p];
+                Level *out = mPlanes[p] + offset;
+                size_t count = endX - startX;
+                if (mChannel < 4) {
+                    const uint8_t *channel = in + mChannel;
+                    for (size_t x = 0; x < count; x++) {
+                        out[x] = lut[channel[x * 4]];
+                    }
+                } else {
+                    for (size_t x = 0; x < count; x++) {
+                        out[x] = lut[in[x * 4] + in[x * 4 + 1] + in[x * 4 + 2]];
+                    }
+                }
+                if (mExcludeTransparent) {
+                    for (size_t x = 0; x < count; x++) {
+                        if (in[x * 4 + 3] == 0) {
+                            out[x] = kTransparent;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    class GrayLevelCovarianceMatrixTask : public Task {
+        const QuantizedPlane mPlane;
         const size_t mLevels;
         const bool mSymmetric;
         const bool mNormalize;
         const bool mExcludeTransparent;
         const uint8_t mStepCount;
         const int *mSteps;
-        std::vector<size_t> mTotals;
-        std::vector<std::vector<size_t>> mGlcm;
+        const bool mSparse;
+        PerThread<size_t> mTotals;
+        // The levels * levels counts of each thread, borrowed from the scratch arena of the
+        // calling thread. A band of the image has at most UINT32_MAX pairs, see bandRows().
+        PerThread<uint32_t *> mGlcm;
+        // In sparse mode, the hash tables that replace mGlcm.
+        PerThread<SparseCounts> mSparseCounts;
+        // The counts of the previous bands and of the spilled hash tables. Only zeroed, and
+        // only read, once mSpilled is set.
+        uint64_t *mSpill;
+        bool mSpilled = false;
+        std::mutex mSpillMutex;
+        ScratchArena &mScratch;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                          size_t endY) override;
 
-        uchar quantize(float value) const;
+        template <typename Count>
+        size_t countPairs(size_t startX, size_t startY, size_t endX, size_t endY, Count count);
+
+        template <typename Level, typename Count>
+        size_t countPairs(size_t startX, size_t startY, size_t endX, size_t endY, Count count);
+
+        // Adds the counts of a thread to mSpill and clears them. mSpillMutex must be held.
+        void spillLocked(size_t threadIndex);
+
+        // Calls f(i, j, count) for every non zero count of the matrix.
+        template <typename F>
+        void forEachCount(F f);
 
     public:
-        GrayLevelCovarianceMatrixTask(const uint8_t *input, size_t sizeX, size_t sizeY,
-                                      size_t levels,
-                                      uint8_t channel, bool symmetric, bool normalize,
+        GrayLevelCovarianceMatrixTask(const QuantizedPlane &plane, size_t sizeX, size_t sizeY,
+                                      size_t levels, bool symmetric, bool normalize,
                                       bool excludeTransparent,
-                                      const int *steps, uint8_t stepCount, uint32_t threadCount,
-                                      const Restriction *restriction)
+                                      const int *steps, uint8_t stepCount, bool sparse,
+                                      uint32_t threadCount,
+                                      ScratchArena &scratch, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, false, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
-                  mChannel{channel},
+                  mPlane{plane},
                   mLevels{levels},
                   mSymmetric{symmetric},
                   mNormalize{normalize},
                   mExcludeTransparent{excludeTransparent},
                   mStepCount{stepCount},
                   mSteps{steps},
+                  mSparse{sparse},
                   mTotals(threadCount),
-                  mGlcm(threadCount) {
+                  mGlcm(threadCount, nullptr),
+                  mSparseCounts(threadCount),
+                  mSpill{scratch.allocate<uint64_t>(levels * levels)},
+                  mScratch{scratch} {
             for (size_t i = 0; i < threadCount; i++) {
-                mGlcm[i].resize(levels * levels);
+                if (sparse) {
+                    mSparseCounts[i].init(scratch, kSparseBits);
+                } else {
+                    mGlcm[i] = scratch.allocate<uint32_t>(levels * levels);
+                    std::fill(mGlcm[i], mGlcm[i] + levels * levels, 0);
+                }
+            }
+        }
+
+        /**
+         * The number of rows of a band of the restriction whose pairs fit in 32 bit counters.
+         */
+        size_t bandRows(size_t columns) const {
+            size_t pairsPerRow = std::max<size_t>(1, columns * mStepCount * (mSymmetric ? 2 : 1));
+            return std::max<size_t>(1, UINT32_MAX / pairsPerRow);
+        }
+
+        /**
+         * Moves the counts of all threads into the 64 bit counters, before counting the next band.
+         */
+        void spill() {
+            std::lock_guard<std::mutex> lock(mSpillMutex);
+            for (size_t t = 0; t < mTotals.size(); t++) {
+                spillLocked(t);
             }
         }
 
         void collate(float *out);
+        void collateFeatures(float *out);
     };
 
-    void
-    GrayLevelCovarianceMatrixTask::processData(int threadIndex, size_t startX, size_t startY,
-                                               size_t endX,
-                                               size_t endY) {
+    template <typename Count>
+    size_t GrayLevelCovarianceMatrixTask::countPairs(size_t startX, size_t startY, size_t endX,
+                                                     size_t endY, Count count) {
+        if (mPlane.wide) {
+            return countPairs<uint16_t>(startX, startY, endX, endY, count);
+        }
+        return countPairs<uint8_t>(startX, startY, endX, endY, count);
+    }
+
+    template <typename Level, typename Count>
+    size_t GrayLevelCovarianceMatrixTask::countPairs(size_t startX, size_t startY, size_t endX,
+                                                     size_t endY, Count count) {
+        const Level kTransparent = GlcmQuantizeTask<Level>::kTransparent;
+        const Level *plane = static_cast<const Level *>(mPlane.data);
+        const size_t stride = mPlane.stride();
+        size_t total = 0;
+        // Every step is evaluated over a whole row of the tile at a time, against the row of
+        // its neighbors.
         for (size_t y = startY; y < endY; y++) {
-            for (size_t x = startX; x < endX; x++) {
-                size_t offset = mSizeX * y + x;
-                const uchar4 *in = mIn + offset;
-                auto v = *in;
-                float value;
-                if (mChannel == 0) {
-                    value = v.r;
-                } else if (mChannel == 1) {
-                    value = v.g;
-                } else if (mChannel == 2) {
-                    value = v.b;
-                } else if (mChannel == 3) {
-                    value = v.a;
-                } else {
-                    value = (float) ((v.r + v.g + v.b) / 3.0);
+            for (size_t i = 0; i < mStepCount; i++) {
+                long dx = mSteps[i * 2];
+                long ny = (long) y + mSteps[i * 2 + 1];
+                if (ny < 0 || ny >= (long) mSizeY) {
+                    continue;
                 }
-
-                if (mExcludeTransparent && v.a == 0) {
+                // The cells whose neighbor is in the image.
+                long x0 = std::max((long) startX, -dx);
+                long x1 = std::min((long) endX, (long) mSizeX - dx);
+                if (x0 >= x1) {
                     continue;
                 }
-
-                auto quantized = quantize(value);
-
-                for (size_t i = 0; i < mStepCount; i++) {
-                    auto dx = mSteps[i * 2];
-                    auto dy = mSteps[i * 2 + 1];
-                    int nx = (int) x + dx;
-                    int ny = (int) y + dy;
-
-                    if (nx < 0 || nx >= (int) mSizeX || ny < 0 || ny >= (int) mSizeY) {
+                const Level *cells = plane + (y - mPlane.startY) * stride + (x0 - mPlane.startX);
+                const Level *neighbors =
+                        plane + (ny - mPlane.startY) * stride + (x0 + dx - mPlane.startX);
+                for (long x = 0; x < x1 - x0; x++) {
+                    uint32_t a = cells[x];
+                    uint32_t b = neighbors[x];
+                    if (mExcludeTransparent && (a == kTransparent || b == kTransparent)) {
                         continue;
                     }
-
-                    size_t newOffset = mSizeX * ny + nx;
-                    const uchar4 *newIn = mIn + newOffset;
-                    auto newV = *newIn;
-                    float newValue;
-                    if (mChannel == 0) {
-                        newValue = newV.r;
-                    } else if (mChannel == 1) {
-                        newValue = newV.g;
-                    } else if (mChannel == 2) {
-                        newValue = newV.b;
-                    } else if (mChannel == 3) {
-                        newValue = newV.a;
-                    } else {
-                        newValue = (float) ((newV.r + newV.g + newV.b) / 3.0);
-                    }
-
-                    if (mExcludeTransparent && newV.a == 0) {
-                        continue;
-                    }
-
-                    auto neighborQuantized = quantize(newValue);
-
-                    size_t index = quantized * mLevels + neighborQuantized;
-                    mGlcm[threadIndex][index]++;
-                    mTotals[threadIndex]++;
-
+                    count((uint32_t) (a * mLevels + b));
+                    total++;
                     if (mSymmetric) {
-                        index = neighborQuantized * mLevels + quantized;
-                        mGlcm[threadIndex][index]++;
-                        mTotals[threadIndex]++;
+                        count((uint32_t) (b * mLevels + a));
+                        total++;
                     }
                 }
             }
         }
+        return total;
     }
 
-    uchar GrayLevelCovarianceMatrixTask::quantize(float value) const {
-        if (mLevels == 256){
-            return (uchar) round(value);
+    void
+    GrayLevelCovarianceMatrixTask::processData(int threadIndex, size_t startX, size_t startY,
+                                               size_t endX,
+                                               size_t endY) {
+        size_t total;
+        if (mSparse) {
+            // A local copy, so that the compiler doesn't reload the fields after every count.
+            SparseCounts table = mSparseCounts[threadIndex];
+            total = countPairs(startX, startY, endX, endY, [&](uint32_t index) {
+                table.add(index + 1, 1);
+                if (table.size >= kSparseLimit) {
+                    std::lock_guard<std::mutex> lock(mSpillMutex);
+                    mSparseCounts[threadIndex] = table;
+                    spillLocked(threadIndex);
+                    table.size = 0;
+                }
+            });
+            mSparseCounts[threadIndex] = table;
+        } else {
+            uint32_t *glcm = mGlcm[threadIndex];
+            total = countPairs(startX, startY, endX, endY,
+                               [glcm](uint32_t index) { glcm[index]++; });
         }
+        mTotals[threadIndex] += total;
+    }
 
-        return (uchar) round(value / 255.0f * (float) (mLevels - 1));
+    void GrayLevelCovarianceMatrixTask::spillLocked(size_t threadIndex) {
+        size_t cells = mLevels * mLevels;
+        if (!mSpilled) {
+            std::fill(mSpill, mSpill + cells, 0);
+            mSpilled = true;
+        }
+        if (mSparse) {
+            SparseCounts &table = mSparseCounts[threadIndex];
+            for (uint32_t s = 0; s < table.capacity; s++) {
+                if (table.keys[s] != 0) {
+                    mSpill[table.keys[s] - 1] += table.counts[s];
+                }
+            }
+            table.reset();
+        } else {
+            uint32_t *glcm = mGlcm[threadIndex];
+            for (size_t j = 0; j < cells; j++) {
+                mSpill[j] += glcm[j];
+            }
+            std::fill(glcm, glcm + cells, 0);
+        }
     }
 
+    template <typename F>
+    void GrayLevelCovarianceMatrixTask::forEachCount(F f) {
+        size_t threadCount = mTotals.size();
+        if (mSpilled) {
+            spill();
+            for (size_t j = 0; j < mLevels * mLevels; j++) {
+                if (mSpill[j] != 0) {
+                    f(j / mLevels, j % mLevels, mSpill[j]);
+                }
+            }
+        } else if (mSparse) {
+            // Nothing was spilled, so there was a single band and the sum of the tables fits
+            // in 32 bits. Merge them in a table large enough for all their entries.
+            uint32_t entries = 0;
+            for (size_t t = 0; t < threadCount; t++) {
+                entries += mSparseCounts[t].size;
+            }
+            uint32_t bits = kSparseBits;
+            while ((1u << bits) < entries * 2) {
+                bits++;
+            }
+            SparseCounts merged;
+            merged.init(mScratch, bits);
+            for (size_t t = 0; t < threadCount; t++) {
+                const SparseCounts &table = mSparseCounts[t];
+                for (uint32_t s = 0; s < table.capacity; s++) {
+                    if (table.keys[s] != 0) {
+                        merged.add(table.keys[s], table.counts[s]);
+                    }
+                }
+            }
+            for (uint32_t s = 0; s < merged.capacity; s++) {
+                if (merged.keys[s] != 0) {
+                    uint32_t j = merged.keys[s] - 1;
+                    f(j / mLevels, j % mLevels, (uint64_t) merged.counts[s]);
+                }
+            }
+        } else {
+            for (size_t j = 0; j < mLevels * mLevels; j++) {
+                uint64_t count = 0;
+                for (size_t t = 0; t < threadCount; t++) {
+                    count += mGlcm[t][j];
+                }
+                if (count != 0) {
+                    f(j / mLevels, j % mLevels, count);
+                }
+            }
+        }
+    }
 
     void GrayLevelCovarianceMatrixTask::collate(float *out) {
         size_t total = 0;
-        for (unsigned int mTotal: mTotals) {
-            total += mTotal;
+        for (size_t t = 0; t < mTotals.size(); t++) {
+            total += mTotals[t];
         }
 
-        for (auto &glcm: mGlcm) {
-            for (size_t j = 0; j < glcm.size(); j++) {
-                out[j] += (float) glcm[j];
-            }
-        }
+        forEachCount([&](size_t i, size_t j, uint64_t count) {
+            out[i * mLevels + j] += (float) count;
+        });
 
         if (mNormalize && total > 0) {
             for (size_t j = 0; j < mLevels * mLevels; j++) {
@@ -154,23 +499,181 @@ namespace renderscript {
         }
     }
 
+    void GrayLevelCovarianceMatrixTask::collateFeatures(float *out) {
+        HaralickSums sums;
+        forEachCount([&](size_t i, size_t j, uint64_t count) {
+            sums.add(i, j, (double) count);
+        });
+        if (sums.total > 0) {
+            // The merged sparse table is in the scratch arena, merging again is cheaper than
+            // keeping a copy of the entries.
+            forEachCount([&](size_t i, size_t j, uint64_t count) {
+                sums.addCentered(i, j, (double) count);
+            });
+        }
+        sums.write(out);
+    }
+
+    namespace {
+        /**
+         * Counts the pairs of the task, one band of rows at a time so that the 32 bit counters
+         * don't overflow. Most images are a single band.
+         */
+        void countBands(TaskProcessor *processor, GrayLevelCovarianceMatrixTask &task,
+                        Restriction &band) {
+            size_t endY = band.endY;
+            size_t rows = task.bandRows(band.endX - band.startX);
+            for (size_t y = band.startY; y < endY; y += rows) {
+                band.startY = y;
+                band.endY = std::min(endY, y + rows);
+                processor->doTask(&task);
+                if (band.endY < endY) {
+                    task.spill();
+                }
+            }
+        }
+
+        /**
+         * Quantizes the restriction once per level count, then counts the pairs of each level
+         * count and passes the task to collate(task, levelIndex).
+         */
+        template <typename Level, typename Collate>
+        void countGlcms(TaskProcessor *processor, const uint8_t *input, size_t sizeX,
+                        size_t sizeY, const int *levels, size_t levelCount, uint8_t channel,
+                        bool symmetric, bool normalize, bool excludeTransparent,
+                        const int *steps, uint8_t stepCount, bool sparse,
+                        const Restriction *restriction, Collate collate) {
+            Restriction band =
+                    restriction != nullptr ? *restriction : Restriction{0, sizeX, 0, sizeY};
+
+            // The restriction and the neighbors its steps reach, within the image.
+            long startX = (long) band.startX;
+            long endX = (long) band.endX;
+            long startY = (long) band.startY;
+            long endY = (long) band.endY;
+            for (size_t i = 0; i < stepCount; i++) {
+                startX = std::min(startX, (long) band.startX + steps[i * 2]);
+                endX = std::max(endX, (long) band.endX + steps[i * 2]);
+                startY = std::min(startY, (long) band.startY + steps[i * 2 + 1]);
+                endY = std::max(endY, (long) band.endY + steps[i * 2 + 1]);
+            }
+            QuantizedPlane extent;
+            extent.wide = sizeof(Level) > 1;
+            extent.startX = (size_t) std::max(0L, startX);
+            extent.endX = (size_t) std::min((long) sizeX, endX);
+            extent.startY = (size_t) std::max(0L, startY);
+            extent.endY = (size_t) std::min((long) sizeY, endY);
+
+            ScratchArena &scratch = TaskProcessor::callingThreadScratch();
+            ScratchArena::Scope scope(scratch);
+            size_t planeSize = extent.stride() * (extent.endY - extent.startY);
+            size_t lutSize = GlcmQuantizeTask<Level>::lutSize(channel);
+            Level **planes = scratch.allocate<Level *>(levelCount);
+            Level **luts = scratch.allocate<Level *>(levelCount);
+            for (size_t l = 0; l < levelCount; l++) {
+                planes[l] = scratch.allocate<Level>(planeSize);
+                luts[l] = scratch.allocate<Level>(lutSize);
+                GlcmQuantizeTask<Level>::buildLut(luts[l], channel, levels[l]);
+            }
+            Restriction planeRestriction{extent.startX, extent.endX, extent.startY, extent.endY,
+                                         band.inputStride};
+            GlcmQuantizeTask<Level> quantize(input, sizeX, sizeY, channel, excludeTransparent,
+                                             levelCount, planes, luts, extent,
+                                             &planeRestriction);
+            processor->doTask(&quantize);
+
+            for (size_t l = 0; l < levelCount; l++) {
+                ScratchArena::Scope levelScope(scratch);
+                extent.data = planes[l];
+                Restriction levelBand = band;
+                GrayLevelCovarianceMatrixTask task(extent, sizeX, sizeY, levels[l], symmetric,
+                                                   normalize, excludeTransparent, steps,
+                                                   stepCount, sparse,
+                                                   processor->getNumberOfThreads(), scratch,
+                                                   &levelBand);
+                countBands(processor, task, levelBand);
+                collate(task, l);
+            }
+        }
+
+        /**
+         * Calls countGlcms with the narrowest type of level that can mark transparent cells.
+         */
+        template <typename Collate>
+        void countGlcms(TaskProcessor *processor, const uint8_t *input, size_t sizeX,
+                        size_t sizeY, const int *levels, size_t levelCount, uint8_t channel,
+                        bool symmetric, bool normalize, bool excludeTransparent,
+                        const int *steps, uint8_t stepCount, bool sparse,
+                        const Restriction *restriction, Collate collate) {
+            bool wide = false;
+            for (size_t l = 0; l < levelCount; l++) {
+                wide = wide || (excludeTransparent && levels[l] >= 256);
+            }
+            if (wide) {
+                countGlcms<uint16_t>(processor, input, sizeX, sizeY, levels, levelCount, channel,
+                                     symmetric, normalize, excludeTransparent, steps, stepCount,
+                                     sparse, restriction, collate);
+            } else {
+                countGlcms<uint8_t>(processor, input, sizeX, sizeY, levels, levelCount, channel,
+                                    symmetric, normalize, excludeTransparent, steps, stepCount,
+                                    sparse, restriction, collate);
+            }
+        }
+    }  // namespace
+
     void RenderScriptToolkit::glcm(const uint8_t *input, float *output,
                                    size_t sizeX, size_t sizeY, size_t levels,
                                    uint8_t channel, bool symmetric, bool normalize,
                                    bool excludeTransparent, const int *steps, uint8_t stepCount,
                                    const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
+            return;
+        }
+#endif
+
+        int level = (int) levels;
+        countGlcms(processor.get(), input, sizeX, sizeY, &level, 1, channel, symmetric,
+                   normalize, excludeTransparent, steps, stepCount, false, restriction,
+                   [output](GrayLevelCovarianceMatrixTask &task, size_t) {
+                       task.collate(output);
+                   });
+    }
+
+    void RenderScriptToolkit::glcmFeatures(const uint8_t *input, float *output,
+                                           size_t sizeX, size_t sizeY, size_t levels,
+                                           uint8_t channel, bool symmetric,
+                                           bool excludeTransparent, const int *steps,
+                                           uint8_t stepCount, bool sparse,
+                                           const Restriction *restriction) {
+        int level = (int) levels;
+        glcmFeatures(input, output, sizeX, sizeY, &level, 1, channel, symmetric,
+                     excludeTransparent, steps, stepCount, sparse, restriction);
+    }
+
+    void RenderScriptToolkit::glcmFeatures(const uint8_t *input, float *output,
+                                           size_t sizeX, size_t sizeY, const int *levels,
+                                           size_t levelCount, uint8_t channel, bool symmetric,
+                                           bool excludeTransparent, const int *steps,
+                                           uint8_t stepCount, bool sparse,
+                                           const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
             return;
         }
+        for (size_t l = 0; l < levelCount; l++) {
+            if (levels[l] < 1 || levels[l] > 256) {
+                ALOGE("The number of levels should be between 1 and 256. %d provided.", levels[l]);
+                return;
+            }
+        }
 #endif
 
-        GrayLevelCovarianceMatrixTask task(input, sizeX, sizeY, levels, channel,
-                                           symmetric, normalize, excludeTransparent, steps,
-                                           stepCount, processor->getNumberOfThreads(),
-                                           restriction);
-        processor->doTask(&task);
-        task.collate(output);
+        countGlcms(processor.get(), input, sizeX, sizeY, levels, levelCount, channel, symmetric,
+                   false, excludeTransparent, steps, stepCount, sparse, restriction,
+                   [output](GrayLevelCovarianceMatrixTask &task, size_t levelIndex) {
+                       task.collateFeatures(output + levelIndex * kGlcmFeatureCount);
+                   });
     }
 
 }  // namespace renderscript
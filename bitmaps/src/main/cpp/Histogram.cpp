@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
@@ -27,7 +30,9 @@ namespace renderscript {
 
 class HistogramTask : public Task {
     const uchar* mIn;
-    std::vector<int> mSums;
+    const size_t mInStride;
+    // The histograms of each thread, borrowed from the scratch arena of the calling thread.
+    int* mSums;
     uint32_t mThreadCount;
 
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
@@ -41,15 +46,17 @@ class HistogramTask : public Task {
 
    public:
     HistogramTask(const uint8_t* in, size_t sizeX, size_t sizeY, size_t vectorSize,
-                  uint32_t threadCount, const Restriction* restriction);
+                  uint32_t threadCount, ScratchArena& scratch, const Restriction* restriction);
     void collateSums(int* out);
 };
 
 class HistogramDotTask : public Task {
     const uchar* mIn;
+    const size_t mInStride;
     float mDot[4];
     int mDotI[4];
-    std::vector<int> mSums;
+    // The histograms of each thread, borrowed from the scratch arena of the calling thread.
+    int* mSums;
     uint32_t mThreadCount;
 
     void kernelP1L4(const uchar* in, int* sums, uint32_t xstart, uint32_t xend);
@@ -59,7 +66,7 @@ class HistogramDotTask : public Task {
 
    public:
     HistogramDotTask(const uint8_t* in, size_t sizeX, size_t sizeY, size_t vectorSize,
-                     uint32_t threadCount, const float* coefficients,
+                     uint32_t threadCount, const float* coefficients, ScratchArena& scratch,
                      const Restriction* restriction);
     void collateSums(int* out);
 
@@ -68,11 +75,14 @@ class HistogramDotTask : public Task {
 };
 
 HistogramTask::HistogramTask(const uchar* in, size_t sizeX, size_t sizeY, size_t vectorSize,
-                             uint32_t threadCount, const Restriction* restriction)
+                             uint32_t threadCount, ScratchArena& scratch,
+                             const Restriction* restriction)
     : Task{sizeX, sizeY, vectorSize, true, restriction},
       mIn{in},
-      mSums(256 * paddedSize(vectorSize) * threadCount) {
+      mInStride{inputStride(sizeX * paddedSize(vectorSize))},
+      mSums{scratch.allocate<int>(256 * paddedSize(vectorSize) * threadCount)} {
     mThreadCount = threadCount;
+    std::fill_n(mSums, 256 * paddedSize(vectorSize) * threadCount, 0);
 }
 
 void HistogramTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -101,7 +111,7 @@ void HistogramTask::processData(int threadIndex, size_t startX, size_t startY, s
     int* sums = &mSums[256 * paddedSize(mVectorSize) * threadIndex];
 
     for (size_t y = startY; y < endY; y++) {
-        const uchar* inPtr = mIn + (mSizeX * y + startX) * paddedSize(mVectorSize);
+        const uchar* inPtr = mIn + mInStride * y + startX * paddedSize(mVectorSize);
         std::invoke(kernel, this, inPtr, sums, startX, endX);
     }
 }
@@ -151,9 +161,13 @@ void HistogramTask::collateSums(int* out) {
 
 HistogramDotTask::HistogramDotTask(const uchar* in, size_t sizeX, size_t sizeY, size_t vectorSize,
                                    uint32_t threadCount, const float* coefficients,
-                                   const Restriction* restriction)
-    : Task{sizeX, sizeY, vectorSize, true, restriction}, mIn{in}, mSums(256 * threadCount, 0) {
+                                   ScratchArena& scratch, const Restriction* restriction)
+    : Task{sizeX, sizeY, vectorSize, true, restriction},
+      mIn{in},
+      mInStride{inputStride(sizeX * paddedSize(vectorSize))},
+      mSums{scratch.allocate<int>(256 * threadCount)} {
     mThreadCount = threadCount;
+    std::fill_n(mSums, 256 * threadCount, 0);
 
     if (coefficients == nullptr) {
         mDot[0] = 0.299f;
@@ -195,7 +209,7 @@ void HistogramDotTask::processData(int threadIndex, size_t startX, size_t startY
     int* sums = &mSums[256 * threadIndex];
 
     for (size_t y = startY; y < endY; y++) {
-        const uchar* inPtr = mIn + (mSizeX * y + startX) * paddedSize(mVectorSize);
+        const uchar* inPtr = mIn + mInStride * y + startX * paddedSize(mVectorSize);
         std::invoke(kernel, this, inPtr, sums, startX, endX);
     }
 }
@@ -246,7 +260,7 @@ void HistogramDotTask::collateSums(int* out) {
 void RenderScriptToolkit::histogram(const uint8_t* in, int32_t* out, size_t sizeX, size_t sizeY,
                                     size_t vectorSize, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * paddedSize(vectorSize), 0)) {
         return;
     }
     if (vectorSize < 1 || vectorSize > 4) {
@@ -255,7 +269,9 @@ void RenderScriptToolkit::histogram(const uint8_t* in, int32_t* out, size_t size
     }
 #endif
 
-    HistogramTask task(in, sizeX, sizeY, vectorSize, processor->getNumberOfThreads(), restriction);
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+    HistogramTask task(in, sizeX, sizeY, vectorSize, processor->getNumberOfThreads(),
+                       TaskProcessor::callingThreadScratch(), restriction);
     processor->doTask(&task);
     task.collateSums(out);
 }
@@ -264,7 +280,7 @@ void RenderScriptToolkit::histogramDot(const uint8_t* in, int32_t* out, size_t s
                                        size_t vectorSize, const float* coefficients,
                                        const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * paddedSize(vectorSize), 0)) {
         return;
     }
     if (vectorSize < 1 || vectorSize > 4) {
@@ -288,8 +304,9 @@ void RenderScriptToolkit::histogramDot(const uint8_t* in, int32_t* out, size_t s
     }
 #endif
 
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
     HistogramDotTask task(in, sizeX, sizeY, vectorSize, processor->getNumberOfThreads(),
-                          coefficients, restriction);
+                          coefficients, TaskProcessor::callingThreadScratch(), restriction);
     processor->doTask(&task);
     task.collateSums(out);
 }
@@ -31,33 +31,91 @@ namespace renderscript {
         return &input[(y * width + x) * channels];
     }
 
-    static bool interpolateBicubic(const float *input, int width, int height, int channels,
-                                    float fx, float fy, float *result) {
-        int xInt = static_cast<int>(std::floor(fx));
-        int yInt = static_cast<int>(std::floor(fy));
-        float fracX = fx - xInt;
-        float fracY = fy - yInt;
-
-        float rowVals[4];
-        for (int c = 0; c < channels; c++) {
+    /**
+     * The taps of the bicubic kernel along one axis, for one column or row of the output: where
+     * it samples the input, the first of the 4 input pixels it reads and their weights.
+     */
+    struct CubicTaps {
+        float position;
+        int first;
+        float weights[4];
+        // Whether the 4 pixels are all within the input.
+        bool inside;
+    };
+
+    static void computeTaps(float start, float end, int outputSize, int inputSize,
+                            CubicTaps *taps) {
+        for (int i = 0; i < outputSize; i++) {
+            CubicTaps &tap = taps[i];
+            tap.position = (outputSize > 1)
+                           ? start + (end - start) * (static_cast<float>(i) / (outputSize - 1))
+                           : start;
+            int whole = static_cast<int>(std::floor(tap.position));
+            float fraction = tap.position - whole;
+            tap.first = whole - 1;
+            for (int j = 0; j < 4; j++) {
+                tap.weights[j] = cubicWeight(fraction - (j - 1));
+            }
+            tap.inside = tap.first >= 0 && whole + 2 < inputSize;
+        }
+    }
+
+    /**
+     * Bicubic interpolation of a pixel whose 4x4 neighborhood is within the input. It's
+     * separable, each row of the neighborhood is weighted by the column taps, then the rows by
+     * the row taps, and all the channels of a pixel are done together.
+     */
+    template <int Channels>
+    static inline void interpolateBicubic(const float *input, int width, const CubicTaps &column,
+                                          const CubicTaps &row, float *result) {
+        const float *first = input + (static_cast<size_t>(row.first) * width + column.first) *
+                                     Channels;
+        const size_t stride = static_cast<size_t>(width) * Channels;
+        if constexpr (Channels == 4) {
+            float4 sum = 0.0f;
             for (int i = 0; i < 4; i++) {
-                float value = 0.0f;
+                const float *pixel = first + i * stride;
+                float4 value = 0.0f;
                 for (int j = 0; j < 4; j++) {
-                    int cx = xInt + j - 1;
-                    int cy = yInt + i - 1;
-                    const float *pixel = getFloatPixel(input, cx, cy, width, height, channels);
-                    if (pixel == nullptr || !isValidFloat(pixel[c])) return false;
-                    value += pixel[c] * cubicWeight(fracX - (j - 1));
+                    value += loadFloat4(pixel + j * 4) * column.weights[j];
                 }
-                rowVals[i] = value;
+                sum += value * row.weights[i];
             }
-            float finalVal = 0.0f;
+            storeFloat4(result, sum);
+        } else {
+            float sum[Channels] = {};
             for (int i = 0; i < 4; i++) {
-                finalVal += rowVals[i] * cubicWeight(fracY - (i - 1));
+                const float *pixel = first + i * stride;
+                float value[Channels] = {};
+                for (int j = 0; j < 4; j++) {
+                    for (int c = 0; c < Channels; c++) {
+                        value[c] += pixel[j * Channels + c] * column.weights[j];
+                    }
+                }
+                for (int c = 0; c < Channels; c++) {
+                    sum[c] += value[c] * row.weights[i];
+                }
+            }
+            for (int c = 0; c < Channels; c++) {
+                result[c] = sum[c];
             }
-            result[c] = finalVal;
         }
-        return true;
+    }
+
+    /**
+     * Whether any of the 4x4 neighborhood of an inside pixel is NaN, in which case bicubic
+     * interpolation doesn't apply.
+     */
+    static bool neighborhoodHasNan(const float *input, int width, int channels,
+                                   const CubicTaps &column, const CubicTaps &row) {
+        for (int i = 0; i < 4; i++) {
+            const float *pixel = input + (static_cast<size_t>(row.first + i) * width +
+                                          column.first) * channels;
+            for (int k = 0; k < 4 * channels; k++) {
+                if (!isValidFloat(pixel[k])) return true;
+            }
+        }
+        return false;
     }
 
     static bool interpolateBilinear(const float *input, int width, int height, int channels,
@@ -91,33 +149,46 @@ namespace renderscript {
         return true;
     }
 
-    static bool interpolateNearest(const float *input, int width, int height, int channels,
-                                    float fx, float fy, int maxSearchRadius, float *result) {
+    /**
+     * The nearest valid pixel, searching rings of pixels around the closest one, out to
+     * maxSearchRadius. Within the first ring that has valid pixels, it's the one closest to
+     * (fx, fy).
+     *
+     * The rings closer than the distance of the nearest valid pixel, see nearestValidDistances,
+     * are skipped since they have none.
+     */
+    static bool interpolateNearest(const float *input, const int32_t *distances, int width,
+                                   int height, int channels, float fx, float fy,
+                                   int maxSearchRadius, float *result) {
         int xInt = static_cast<int>(std::round(fx));
         int yInt = static_cast<int>(std::round(fy));
 
+        // Outside of the input, the rings reach the pixels of the closest one's ring later.
+        int closestX = std::max(0, std::min(width - 1, xInt));
+        int closestY = std::max(0, std::min(height - 1, yInt));
+        int32_t firstRing = std::max({distances[closestY * width + closestX],
+                                      std::abs(xInt - closestX), std::abs(yInt - closestY)});
+
         float bestDist = std::numeric_limits<float>::max();
         bool found = false;
 
         auto process = [&](int cx, int cy) {
-            const float *pixel = getFloatPixel(input, cx, cy, width, height, channels);
-            if (pixel == nullptr) return;
-            for (int c = 0; c < channels; c++) {
-                if (!isValidFloat(pixel[c])) return;
-            }
+            if (cx < 0 || cx >= width || cy < 0 || cy >= height) return;
+            if (distances[cy * width + cx] != 0) return;
             float dx = cx - fx;
             float dy = cy - fy;
             float dist = dx * dx + dy * dy;
             if (dist < bestDist) {
                 bestDist = dist;
                 found = true;
+                const float *pixel = &input[(cy * width + cx) * channels];
                 for (int c = 0; c < channels; c++) {
                     result[c] = pixel[c];
                 }
             }
         };
 
-        for (int r = 0; r <= maxSearchRadius; r++) {
+        for (int32_t r = firstRing; r <= maxSearchRadius; r++) {
             if (r == 0) {
                 process(xInt, yInt);
             } else {
@@ -139,6 +210,165 @@ namespace renderscript {
         return found;
     }
 
+    /**
+     * One pass of the distances of nearestValidDistances. The distance to the nearest valid
+     * pixel along the rows and the columns, the larger of the two, is separable:
+     *  - COLUMNS: the distance to the nearest valid pixel of the same column, from a pass down
+     *    and a pass up each column. The cells are groups of kColumnsPerCell columns, done a row
+     *    at a time.
+     *  - ROWS: for each row, the smallest max(|x - i|, g(i)) over the columns i, g being the
+     *    distances of the COLUMNS pass. It's the lower envelope of these functions, found in
+     *    linear time as in Meijster et al., "A General Algorithm for Computing Distance
+     *    Transforms in Linear Time". The cells are the rows.
+     *
+     * Both passes work in place. Until the end of the ROWS pass, a pixel with no valid one in
+     * its column is at width + height, more than any distance, then at INT32_MAX.
+     */
+    class ValidDistancesTask : public Task {
+    public:
+        enum class Pass {
+            COLUMNS,
+            ROWS,
+        };
+
+        // The columns of a cell of the COLUMNS pass. It's done a row at a time, and reads and
+        // writes rows of at least a few cache lines so that they stream from one row to the next.
+        static constexpr size_t kColumnsPerCell = 256;
+
+    private:
+        const float *mIn;
+        int32_t *mDistances;
+        const size_t mWidth;
+        const size_t mHeight;
+        const size_t mChannels;
+        const Pass mPass;
+        const int32_t mNone;
+
+        void columns(size_t startX, size_t endX);
+
+        void rows(int threadIndex, size_t startY, size_t endY);
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        ValidDistancesTask(const float *input, int32_t *distances, size_t width, size_t height,
+                           size_t channels, Pass pass)
+                : Task{pass == Pass::COLUMNS ? divideRoundingUp(width, kColumnsPerCell) : 1,
+                       pass == Pass::COLUMNS ? 1 : height, 1, false, nullptr},
+                  mIn{input},
+                  mDistances{distances},
+                  mWidth{width},
+                  mHeight{height},
+                  mChannels{channels},
+                  mPass{pass},
+                  mNone{static_cast<int32_t>(width + height)} {
+            if (pass == Pass::COLUMNS) {
+                setWorkingSetPerCell(kColumnsPerCell * height *
+                                     (channels * sizeof(float) + sizeof(int32_t)));
+            } else {
+                // The row, a copy of it and the two stacks of the envelope.
+                setWorkingSetPerCell(4 * width * sizeof(int32_t));
+            }
+        }
+    };
+
+    void ValidDistancesTask::columns(size_t startX, size_t endX) {
+        for (size_t y = 0; y < mHeight; y++) {
+            int32_t *row = mDistances + y * mWidth;
+            const int32_t *above = y > 0 ? row - mWidth : nullptr;
+            for (size_t x = startX; x < endX; x++) {
+                const float *pixel = mIn + (y * mWidth + x) * mChannels;
+                bool valid = true;
+                for (size_t c = 0; c < mChannels; c++) {
+                    valid &= isValidFloat(pixel[c]);
+                }
+                row[x] = valid ? 0 : above != nullptr ? std::min(mNone, above[x] + 1) : mNone;
+            }
+        }
+        for (size_t y = mHeight - 1; y-- > 0;) {
+            int32_t *row = mDistances + y * mWidth;
+            const int32_t *below = row + mWidth;
+            for (size_t x = startX; x < endX; x++) {
+                row[x] = std::min(row[x], below[x] + 1);
+            }
+        }
+    }
+
+    void ValidDistancesTask::rows(int threadIndex, size_t startY, size_t endY) {
+        const int n = static_cast<int>(mWidth);
+        // The distances of the COLUMNS pass, and the columns whose functions make the envelope
+        // with the first x at which each of them is the lowest.
+        int32_t *g = scratch(threadIndex).allocate<int32_t>(mWidth);
+        int32_t *envelope = scratch(threadIndex).allocate<int32_t>(mWidth);
+        int32_t *starts = scratch(threadIndex).allocate<int32_t>(mWidth);
+        auto f = [&](int x, int i) { return std::max(std::abs(x - i), g[i]); };
+        // The first x at which the function of u is lower than that of i < u.
+        auto separation = [&](int i, int u) {
+            return 1 + (g[i] <= g[u] ? std::max(i + g[u], (i + u) / 2)
+                                     : std::min(u - g[i], (i + u) / 2));
+        };
+
+        for (size_t y = startY; y < endY; y++) {
+            int32_t *row = mDistances + y * mWidth;
+            // A row of valid pixels stays at 0.
+            if (std::all_of(row, row + mWidth, [](int32_t d) { return d == 0; })) {
+                continue;
+            }
+            std::copy_n(row, mWidth, g);
+            int q = 0;
+            envelope[0] = 0;
+            starts[0] = 0;
+            for (int u = 1; u < n; u++) {
+                while (q >= 0 && f(starts[q], envelope[q]) > f(starts[q], u)) {
+                    q--;
+                }
+                if (q < 0) {
+                    q = 0;
+                    envelope[0] = u;
+                } else {
+                    int start = separation(envelope[q], u);
+                    if (start < n) {
+                        q++;
+                        envelope[q] = u;
+                        starts[q] = start;
+                    }
+                }
+            }
+            for (int u = n - 1; u >= 0; u--) {
+                int32_t distance = f(u, envelope[q]);
+                row[u] = distance < mNone ? distance : std::numeric_limits<int32_t>::max();
+                if (u == starts[q]) {
+                    q--;
+                }
+            }
+        }
+    }
+
+    void ValidDistancesTask::processData(int threadIndex, size_t startX, size_t startY,
+                                         size_t endX, size_t endY) {
+        if (mPass == Pass::COLUMNS) {
+            columns(startX * kColumnsPerCell, std::min(mWidth, endX * kColumnsPerCell));
+        } else {
+            rows(threadIndex, startY, endY);
+        }
+    }
+
+    /**
+     * Computes the distances of nearestValidDistances with the two passes of ValidDistancesTask.
+     */
+    static void computeValidDistances(TaskProcessor *processor, const float *input,
+                                      int32_t *distances, size_t width, size_t height,
+                                      size_t channels) {
+        ValidDistancesTask columnPass(input, distances, width, height, channels,
+                                      ValidDistancesTask::Pass::COLUMNS);
+        processor->doTask(&columnPass);
+        ValidDistancesTask rowPass(input, distances, width, height, channels,
+                                   ValidDistancesTask::Pass::ROWS);
+        processor->doTask(&rowPass);
+    }
+
     class InterpolateFloatBitmapTask : public Task {
         const float *mIn;
         float *mOut;
@@ -146,12 +376,19 @@ namespace renderscript {
         int mInputHeight;
         int mChannels;
         int mOutputWidth;
-        int mOutputHeight;
-        float mSrcStartX;
-        float mSrcStartY;
-        float mSrcEndX;
-        float mSrcEndY;
         int mMaxSearchRadius;
+        // The taps of each column and row of the output.
+        CubicTaps *mColumns;
+        CubicTaps *mRows;
+        // The distances of nearestValidDistances, given by the caller or built before the task.
+        // Null when maxSearchRadius is 0 or less, as the nearest neighbor fallback then doesn't
+        // search beyond the closest pixel.
+        const int32_t *mDistances;
+
+        template <int Channels>
+        void interpolateRows(size_t startX, size_t startY, size_t endX, size_t endY);
+
+        bool interpolateFallback(float inputX, float inputY, float *result);
 
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                          size_t endY) override;
@@ -162,66 +399,148 @@ namespace renderscript {
                                     int outputWidth, int outputHeight,
                                     float srcStartX, float srcStartY,
                                     float srcEndX, float srcEndY,
-                                    int maxSearchRadius,
-                                    const Restriction *restriction)
+                                    int maxSearchRadius, const int32_t *validDistances,
+                                    ScratchArena &scratch, const Restriction *restriction)
                 : Task{static_cast<size_t>(outputWidth), static_cast<size_t>(outputHeight),
-                       4, false, restriction},
+                       static_cast<size_t>(channels), false, restriction},
                   mIn{input}, mOut{output},
                   mInputWidth{inputWidth}, mInputHeight{inputHeight},
                   mChannels{channels},
-                  mOutputWidth{outputWidth}, mOutputHeight{outputHeight},
-                  mSrcStartX{srcStartX}, mSrcStartY{srcStartY},
-                  mSrcEndX{srcEndX}, mSrcEndY{srcEndY},
-                  mMaxSearchRadius{maxSearchRadius} {}
+                  mOutputWidth{outputWidth},
+                  mMaxSearchRadius{maxSearchRadius},
+                  mColumns{scratch.allocate<CubicTaps>(outputWidth)},
+                  mRows{scratch.allocate<CubicTaps>(outputHeight)},
+                  mDistances{validDistances} {
+            setElementSize(sizeof(float));
+            computeTaps(srcStartX, srcEndX, outputWidth, inputWidth, mColumns);
+            computeTaps(srcStartY, srcEndY, outputHeight, inputHeight, mRows);
+        }
     };
 
-    void InterpolateFloatBitmapTask::processData(int /* threadIndex */, size_t startX,
-                                                  size_t startY, size_t endX, size_t endY) {
+    /**
+     * Bilinear interpolation, then the nearest valid pixel, for the pixels that bicubic
+     * interpolation can't do. Returns false when neither finds enough valid pixels.
+     */
+    bool InterpolateFloatBitmapTask::interpolateFallback(float inputX, float inputY,
+                                                         float *result) {
+        if (interpolateBilinear(mIn, mInputWidth, mInputHeight, mChannels, inputX, inputY,
+                                result)) {
+            return true;
+        }
+        if (mMaxSearchRadius < 0) {
+            return false;
+        }
+        // Most of the time the closest pixel is valid, which doesn't need the distances.
+        int x = static_cast<int>(std::round(inputX));
+        int y = static_cast<int>(std::round(inputY));
+        const float *pixel = getFloatPixel(mIn, x, y, mInputWidth, mInputHeight, mChannels);
+        if (pixel != nullptr) {
+            bool valid = true;
+            for (int c = 0; c < mChannels; c++) {
+                valid &= isValidFloat(pixel[c]);
+            }
+            if (valid) {
+                std::copy_n(pixel, mChannels, result);
+                return true;
+            }
+        }
+        if (mDistances == nullptr) {
+            return false;
+        }
+        return interpolateNearest(mIn, mDistances, mInputWidth, mInputHeight, mChannels,
+                                  inputX, inputY, mMaxSearchRadius, result);
+    }
+
+    template <int Channels>
+    void InterpolateFloatBitmapTask::interpolateRows(size_t startX, size_t startY, size_t endX,
+                                                     size_t endY) {
         float tempPixel[4];
 
         for (size_t y = startY; y < endY; y++) {
-            for (size_t x = startX; x < endX; x++) {
-                float inputX = (mOutputWidth > 1)
-                               ? mSrcStartX + (mSrcEndX - mSrcStartX) *
-                                               (static_cast<float>(x) / (mOutputWidth - 1))
-                               : mSrcStartX;
-                float inputY = (mOutputHeight > 1)
-                               ? mSrcStartY + (mSrcEndY - mSrcStartY) *
-                                               (static_cast<float>(y) / (mOutputHeight - 1))
-                               : mSrcStartY;
-
-                bool success = interpolateBicubic(mIn, mInputWidth, mInputHeight, mChannels,
-                                                  inputX, inputY, tempPixel);
-                if (!success) {
-                    success = interpolateBilinear(mIn, mInputWidth, mInputHeight, mChannels,
-                                                  inputX, inputY, tempPixel);
-                }
-                if (!success) {
-                    success = interpolateNearest(mIn, mInputWidth, mInputHeight, mChannels,
-                                                 inputX, inputY, mMaxSearchRadius, tempPixel);
+            const CubicTaps &row = mRows[y];
+            float *out = mOut + (y * mOutputWidth + startX) * Channels;
+            for (size_t x = startX; x < endX; x++, out += Channels) {
+                const CubicTaps &column = mColumns[x];
+                if (row.inside && column.inside) {
+                    interpolateBicubic<Channels>(mIn, mInputWidth, column, row, out);
+                    // A NaN in the neighborhood makes the result NaN, so the neighborhood is
+                    // only checked then. Infinities can give a NaN too, which is kept.
+                    bool valid = true;
+                    for (int c = 0; c < Channels; c++) {
+                        valid &= isValidFloat(out[c]);
+                    }
+                    if (valid || !neighborhoodHasNan(mIn, mInputWidth, Channels, column, row)) {
+                        continue;
+                    }
                 }
 
-                size_t outIdx = (y * mOutputWidth + x) * mChannels;
-                if (success) {
-                    for (int c = 0; c < mChannels; c++) {
-                        mOut[outIdx + c] = tempPixel[c];
+                if (interpolateFallback(column.position, row.position, tempPixel)) {
+                    for (int c = 0; c < Channels; c++) {
+                        out[c] = tempPixel[c];
                     }
                 } else {
-                    for (int c = 0; c < mChannels; c++) {
-                        mOut[outIdx + c] = std::numeric_limits<float>::quiet_NaN();
+                    for (int c = 0; c < Channels; c++) {
+                        out[c] = std::numeric_limits<float>::quiet_NaN();
                     }
                 }
             }
         }
     }
 
+    void InterpolateFloatBitmapTask::processData(int /* threadIndex */, size_t startX,
+                                                  size_t startY, size_t endX, size_t endY) {
+        switch (mChannels) {
+            case 1:
+                interpolateRows<1>(startX, startY, endX, endY);
+                break;
+            case 2:
+                interpolateRows<2>(startX, startY, endX, endY);
+                break;
+            case 3:
+                interpolateRows<3>(startX, startY, endX, endY);
+                break;
+            case 4:
+                interpolateRows<4>(startX, startY, endX, endY);
+                break;
+        }
+    }
+
     void RenderScriptToolkit::interpolateFloatBitmap(const float *input, float *output,
                                                       size_t inputWidth, size_t inputHeight,
                                                       size_t channels,
                                                       size_t outputWidth, size_t outputHeight,
                                                       float srcStartX, float srcStartY,
                                                       float srcEndX, float srcEndY,
-                                                      int maxSearchRadius) {
+                                                      int maxSearchRadius,
+                                                      const int32_t *validDistances,
+                                                      const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, outputWidth, outputHeight, restriction,
+                              inputWidth * channels * sizeof(float),
+                              outputWidth * channels * sizeof(float))) {
+            return;
+        }
+        if (restriction != nullptr &&
+            (restriction->inputStride != 0 || restriction->outputStride != 0)) {
+            ALOGE("interpolateFloatBitmap doesn't support padded rows.");
+            return;
+        }
+        if (channels < 1 || channels > 4) {
+            ALOGE("The channels should be between 1 and 4. %zu provided.", channels);
+            return;
+        }
+#endif
+
+        // The taps of the columns and rows, and the distances when they're built here, are kept
+        // in the scratch of the calling thread.
+        ScratchArena &scratch = TaskProcessor::callingThreadScratch();
+        ScratchArena::Scope scope(scratch);
+        if (validDistances == nullptr && maxSearchRadius > 0) {
+            int32_t *distances = scratch.allocate<int32_t>(inputWidth * inputHeight);
+            computeValidDistances(processor.get(), input, distances, inputWidth, inputHeight,
+                                  channels);
+            validDistances = distances;
+        }
         InterpolateFloatBitmapTask task(input, output,
                                         static_cast<int>(inputWidth),
                                         static_cast<int>(inputHeight),
@@ -229,8 +548,22 @@ namespace renderscript {
                                         static_cast<int>(outputWidth),
                                         static_cast<int>(outputHeight),
                                         srcStartX, srcStartY, srcEndX, srcEndY,
-                                        maxSearchRadius, nullptr);
+                                        maxSearchRadius, validDistances,
+                                        scratch, restriction);
         processor->doTask(&task);
     }
 
+    void RenderScriptToolkit::nearestValidDistances(const float *input, int32_t *distances,
+                                                     size_t width, size_t height,
+                                                     size_t channels) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (channels < 1 || channels > 4) {
+            ALOGE("The channels should be between 1 and 4. %zu provided.", channels);
+            return;
+        }
+#endif
+
+        computeValidDistances(processor.get(), input, distances, width, height, channels);
+    }
+
 }  // namespace renderscript
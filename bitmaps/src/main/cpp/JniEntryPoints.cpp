@@ -15,8 +15,14 @@
  */
 
 #include <android/bitmap.h>
+#include <android/hardware_buffer.h>
 #include <cassert>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <future>
 #include <jni.h>
+#include <mutex>
+#include <vector>
 
 #include "RenderScriptToolkit.h"
 #include "Utils.h"
@@ -110,6 +116,32 @@ public:
     float *get() { return reinterpret_cast<float *>(data); }
 };
 
+class DoubleArrayGuard {
+private:
+    JNIEnv *env;
+    jdoubleArray array;
+    jdouble *data;
+
+public:
+    DoubleArrayGuard(JNIEnv *env, jdoubleArray array) : env{env}, array{array} {
+#ifdef USE_CRITICAL
+        data = reinterpret_cast<jdouble*>(env->GetPrimitiveArrayCritical(array, nullptr));
+#else
+        data = env->GetDoubleArrayElements(array, nullptr);
+#endif
+    }
+
+    ~DoubleArrayGuard() {
+#ifdef USE_CRITICAL
+        env->ReleasePrimitiveArrayCritical(array, data, 0);
+#else
+        env->ReleaseDoubleArrayElements(array, data, 0);
+#endif
+    }
+
+    double *get() { return reinterpret_cast<double *>(data); }
+};
+
 class BitmapGuard {
 private:
     JNIEnv *env;
@@ -131,11 +163,10 @@ public:
             ALOGE("AndroidBitmap in the wrong format");
             return;
         }
-        bytesPerPixel = info.stride / info.width;
-        if (bytesPerPixel != 1 && bytesPerPixel != 4) {
-            ALOGE("Expected a vector size of 1 or 4. Got %d. Extra padding per line not currently "
-                  "supported",
-                  bytesPerPixel);
+        bytesPerPixel = info.format == ANDROID_BITMAP_FORMAT_RGBA_8888 ? 4 : 1;
+        if (info.stride < info.width * bytesPerPixel) {
+            ALOGE("The stride of the bitmap, %u, is less than its width of %u pixels.",
+                  info.stride, info.width);
             return;
         }
         if (AndroidBitmap_lockPixels(env, bitmap, &bytes) != ANDROID_BITMAP_RESULT_SUCCESS) {
@@ -161,8 +192,308 @@ public:
     int height() const { return info.height; }
 
     int vectorSize() const { return bytesPerPixel; }
+
+    /**
+     * The number of bytes from the start of a row to the start of the next.
+     */
+    size_t stride() const { return info.stride; }
+
+    /**
+     * Whether the rows have padding at their end. The ops then need the stride, see
+     * RestrictionParameter::withStrides.
+     */
+    bool isPadded() const { return info.stride != info.width * bytesPerPixel; }
+};
+
+/**
+ * Rebuilds the stages of a pipeline from the arrays the Kotlin Toolkit packed them into. Each
+ * stage takes its parameters from the front of the arrays, in order:
+ *    COLOR_MATRIX: 20 floats, the matrix then the add vector.
+ *    CONVOLVE_3X3: 9 floats.
+ *    CONVOLVE_5X5: 25 floats.
+ *    LUT: 1024 bytes, the red, green, blue, and alpha tables.
+ *    THRESHOLD: 1 float, the threshold, and 2 ints, binary and channel.
+ */
+class PipelineStagesParameter {
+private:
+    std::vector<RenderScriptToolkit::PipelineStage> stages;
+    bool valid = true;
+
+public:
+    PipelineStagesParameter(const int *types, size_t typeCount, const float *floats,
+                            size_t floatCount, const int *ints, size_t intCount,
+                            const uint8_t *bytes, size_t byteCount) {
+        using Stage = RenderScriptToolkit::PipelineStage;
+        size_t f = 0, i = 0, b = 0;
+        for (size_t s = 0; s < typeCount && valid; s++) {
+            switch (static_cast<Stage::Type>(types[s])) {
+                case Stage::Type::COLOR_MATRIX:
+                    valid = f + 20 <= floatCount;
+                    if (valid) stages.push_back(Stage::colorMatrix(floats + f, floats + f + 16));
+                    f += 20;
+                    break;
+                case Stage::Type::CONVOLVE_3X3:
+                    valid = f + 9 <= floatCount;
+                    if (valid) stages.push_back(Stage::convolve3x3(floats + f));
+                    f += 9;
+                    break;
+                case Stage::Type::CONVOLVE_5X5:
+                    valid = f + 25 <= floatCount;
+                    if (valid) stages.push_back(Stage::convolve5x5(floats + f));
+                    f += 25;
+                    break;
+                case Stage::Type::LUT:
+                    valid = b + 1024 <= byteCount;
+                    if (valid) {
+                        stages.push_back(Stage::lut(bytes + b, bytes + b + 256, bytes + b + 512,
+                                                    bytes + b + 768));
+                    }
+                    b += 1024;
+                    break;
+                case Stage::Type::THRESHOLD:
+                    valid = f + 1 <= floatCount && i + 2 <= intCount;
+                    if (valid) {
+                        stages.push_back(Stage::threshold(floats[f], ints[i] != 0,
+                                                          static_cast<uint8_t>(ints[i + 1])));
+                    }
+                    f += 1;
+                    i += 2;
+                    break;
+                default:
+                    valid = false;
+                    break;
+            }
+        }
+        if (!valid) {
+            ALOGE("RenderScriptToolit. Internal error. The pipeline stages are malformed.");
+        }
+    }
+
+    bool isValid() const { return valid; }
+
+    const RenderScriptToolkit::PipelineStage *data() const { return stages.data(); }
+
+    size_t size() const { return stages.size(); }
+};
+
+/**
+ * The AHardwareBuffer functions. They're looked up at runtime as they only exist from API 26 and
+ * the library also runs on older devices. When they're missing, all the pointers are null.
+ */
+struct HardwareBufferFunctions {
+    AHardwareBuffer *(*fromHardwareBuffer)(JNIEnv *, jobject) = nullptr;
+    void (*describe)(const AHardwareBuffer *, AHardwareBuffer_Desc *) = nullptr;
+    int (*lock)(AHardwareBuffer *, uint64_t, int32_t, const ARect *, void **) = nullptr;
+    int (*unlock)(AHardwareBuffer *, int32_t *) = nullptr;
+    jclass hardwareBufferClass = nullptr;
+
+    static const HardwareBufferFunctions &get(JNIEnv *env) {
+        static const HardwareBufferFunctions functions = load(env);
+        return functions;
+    }
+
+private:
+    static HardwareBufferFunctions load(JNIEnv *env) {
+        HardwareBufferFunctions functions;
+        void *library = dlopen("libnativewindow.so", RTLD_NOW | RTLD_LOCAL);
+        if (library == nullptr) {
+            return functions;
+        }
+        functions.fromHardwareBuffer = reinterpret_cast<decltype(fromHardwareBuffer)>(
+                dlsym(library, "AHardwareBuffer_fromHardwareBuffer"));
+        functions.describe = reinterpret_cast<decltype(describe)>(
+                dlsym(library, "AHardwareBuffer_describe"));
+        functions.lock = reinterpret_cast<decltype(lock)>(dlsym(library, "AHardwareBuffer_lock"));
+        functions.unlock = reinterpret_cast<decltype(unlock)>(
+                dlsym(library, "AHardwareBuffer_unlock"));
+        // A framework class, so FindClass finds it from the pool threads too.
+        jclass hardwareBufferClass = env->FindClass("android/hardware/HardwareBuffer");
+        if (hardwareBufferClass == nullptr) {
+            env->ExceptionClear();
+            return HardwareBufferFunctions{};
+        }
+        functions.hardwareBufferClass =
+                reinterpret_cast<jclass>(env->NewGlobalRef(hardwareBufferClass));
+        env->DeleteLocalRef(hardwareBufferClass);
+        return functions;
+    }
+};
+
+/**
+ * Gives access to the pixels of a direct java.nio buffer, or of a HardwareBuffer on API 26+,
+ * without copying them. The ops see the same layout as with arrays: sizeX * sizeY cells of
+ * vectorSize elements. A direct buffer holds them packed from its start; its position is
+ * ignored. A HardwareBuffer must be RGBA_8888 and at least sizeX by sizeY. Its rows may be
+ * padded, see RestrictionParameter::withStrides. It's locked for CPU reads, and also for writes
+ * when writable is set.
+ */
+class PixelBufferGuard {
+private:
+    const HardwareBufferFunctions *functions = nullptr;
+    AHardwareBuffer *hardwareBuffer = nullptr;
+    uint8_t *bytes = nullptr;
+    size_t sizeX;
+    size_t sizeY;
+    size_t packedRowSize;
+    size_t rowStride;
+
+public:
+    PixelBufferGuard(JNIEnv *env, jobject buffer, size_t sizeX, size_t sizeY, size_t vectorSize,
+                     bool writable = false)
+        : sizeX{sizeX},
+          sizeY{sizeY},
+          packedRowSize{sizeX * vectorSize},
+          rowStride{sizeX * vectorSize} {
+        void *address = env->GetDirectBufferAddress(buffer);
+        if (address != nullptr) {
+            jlong capacity = env->GetDirectBufferCapacity(buffer);
+            if (capacity < 0 || (size_t)capacity < sizeX * sizeY * vectorSize) {
+                ALOGE("The buffer holds %lld elements but %zu are needed.", (long long)capacity,
+                      sizeX * sizeY * vectorSize);
+                return;
+            }
+            bytes = reinterpret_cast<uint8_t *>(address);
+            return;
+        }
+
+        const HardwareBufferFunctions &hardware = HardwareBufferFunctions::get(env);
+        if (hardware.hardwareBufferClass == nullptr ||
+            !env->IsInstanceOf(buffer, hardware.hardwareBufferClass)) {
+            ALOGE("The buffer should be a direct buffer or a HardwareBuffer.");
+            return;
+        }
+        AHardwareBuffer *candidate = hardware.fromHardwareBuffer(env, buffer);
+        AHardwareBuffer_Desc description;
+        hardware.describe(candidate, &description);
+        if (description.format != AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM || vectorSize != 4) {
+            ALOGE("Only RGBA_8888 HardwareBuffers are supported.");
+            return;
+        }
+        if (description.width < sizeX || description.height < sizeY) {
+            ALOGE("The HardwareBuffer is %u x %u but %zu x %zu is needed.", description.width,
+                  description.height, sizeX, sizeY);
+            return;
+        }
+        uint64_t usage = AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN;
+        if (writable) {
+            usage |= AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN;
+        }
+        if (hardware.lock(candidate, usage, -1, nullptr, &address) != 0) {
+            ALOGE("AHardwareBuffer_lock failed");
+            return;
+        }
+        functions = &hardware;
+        hardwareBuffer = candidate;
+        bytes = reinterpret_cast<uint8_t *>(address);
+        rowStride = description.stride * vectorSize;
+    }
+
+    ~PixelBufferGuard() {
+        if (hardwareBuffer != nullptr) {
+            functions->unlock(hardwareBuffer, nullptr);
+        }
+    }
+
+    bool isValid() const { return bytes != nullptr; }
+
+    uint8_t *get() const {
+        assert(isValid());
+        return bytes;
+    }
+
+    int width() const { return sizeX; }
+
+    int height() const { return sizeY; }
+
+    size_t stride() const { return rowStride; }
+
+    bool isPadded() const { return rowStride != packedRowSize; }
+};
+
+/**
+ * Gives a pool thread of the Toolkit access to the Java VM, for the jobs of runAsync. The thread
+ * is attached when the Toolkit is created and detached when it exits. Threads that were already
+ * attached, e.g. the calling thread when the Toolkit has no pool threads, are left as they are.
+ */
+class JavaThreadAttachment {
+private:
+    JavaVM *vm = nullptr;
+    JNIEnv *env = nullptr;
+
+public:
+    ~JavaThreadAttachment() {
+        if (vm != nullptr) {
+            vm->DetachCurrentThread();
+        }
+    }
+
+    JNIEnv *attach(JavaVM *javaVm) {
+        if (env != nullptr) {
+            return env;
+        }
+        if (javaVm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_OK) {
+            return env;
+        }
+        if (javaVm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+            ALOGE("Could not attach the pool thread to the Java VM.");
+            env = nullptr;
+            return nullptr;
+        }
+        vm = javaVm;
+        return env;
+    }
 };
 
+static thread_local JavaThreadAttachment javaThreadAttachment;
+
+/**
+ * Attaches every pool thread of the toolkit to the Java VM, so that the jobs of runAsync can call
+ * back into Kotlin from whichever pool thread runs them. Each thread takes one attaching job,
+ * which waits for the others so that no thread takes two. Returns false if a thread couldn't be
+ * attached.
+ */
+static bool attachPoolThreads(RenderScriptToolkit *toolkit, JavaVM *vm) {
+    const int poolThreads = toolkit->getNumberOfThreads() - 1;
+    std::mutex mutex;
+    std::condition_variable allStarted;
+    int started = 0;
+    bool attached = true;
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < poolThreads; i++) {
+        done.push_back(toolkit->runAsync([&](RenderScriptToolkit & /*toolkit*/) {
+            bool threadAttached = javaThreadAttachment.attach(vm) != nullptr;
+            std::unique_lock<std::mutex> lock(mutex);
+            attached = attached && threadAttached;
+            started++;
+            allStarted.notify_all();
+            allStarted.wait(lock, [&]() { return started == poolThreads; });
+        }));
+    }
+    for (auto &job : done) {
+        job.wait();
+    }
+    return attached;
+}
+
+/**
+ * Returns the address of a direct ByteBuffer, or null after logging why when it isn't direct or
+ * holds fewer than minimumSize bytes.
+ */
+static const uint8_t *directBufferAddress(JNIEnv *env, jobject buffer, size_t minimumSize) {
+    auto address = reinterpret_cast<const uint8_t *>(env->GetDirectBufferAddress(buffer));
+    if (address == nullptr) {
+        ALOGE("The plane buffers must be direct.");
+        return nullptr;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (capacity < 0 || (size_t)capacity < minimumSize) {
+        ALOGE("A plane buffer holds %lld bytes but %zu are needed.", (long long)capacity,
+              minimumSize);
+        return nullptr;
+    }
+    return address;
+}
+
 /**
  * Copies the content of Kotlin Range2d object into the equivalent C++ struct.
  */
@@ -176,15 +507,13 @@ public:
         if (isNull) {
             return;
         }
-        /* TODO Measure how long FindClass and related functions take. Consider passing the
+        /* TODO Measure how long GetObjectClass and related functions take. Consider passing the
          * four values instead. This would also require setting the default when Range2D is null.
+         *
+         * We don't use FindClass, as it would search the system class loader when called from
+         * the pool threads that run Toolkit.runAsync.
          */
-        jclass restrictionClass = env->FindClass("com/kylecorry/andromeda/bitmaps/Range2d");
-        if (restrictionClass == nullptr) {
-            ALOGE("RenderScriptToolit. Internal error. Could not find the Kotlin Range2d class.");
-            isNull = true;
-            return;
-        }
+        jclass restrictionClass = env->GetObjectClass(jRestriction);
         jfieldID startXId = env->GetFieldID(restrictionClass, "startX", "I");
         jfieldID startYId = env->GetFieldID(restrictionClass, "startY", "I");
         jfieldID endXId = env->GetFieldID(restrictionClass, "endX", "I");
@@ -196,11 +525,56 @@ public:
     }
 
     Restriction *get() { return isNull ? nullptr : &restriction; }
+
+    /**
+     * The restriction to pass with bitmaps or pixel buffers. The strides of the padded ones are
+     * set, and without a restriction from Kotlin, one that covers the whole output is made, or
+     * the whole input if there's no output. Buffers without padding leave the restriction as it
+     * is.
+     */
+    template <typename Guard>
+    Restriction *withStrides(const Guard &input, const Guard *output = nullptr) {
+        const Guard &covered = output != nullptr ? *output : input;
+        return withStrides(input.isPadded() ? input.stride() : 0,
+                           output != nullptr && output->isPadded() ? output->stride() : 0,
+                           covered.width(), covered.height());
+    }
+
+    /**
+     * Like above, for ops whose input isn't a bitmap or whose restriction isn't in the
+     * coordinates of their output. The strides are 0 when the rows aren't padded. Without a
+     * restriction from Kotlin, the one that's made covers sizeX by sizeY cells.
+     */
+    Restriction *withStrides(size_t inputStride, size_t outputStride, size_t sizeX,
+                             size_t sizeY) {
+        if (inputStride == 0 && outputStride == 0) {
+            return get();
+        }
+        if (isNull) {
+            restriction.startX = 0;
+            restriction.startY = 0;
+            restriction.endX = sizeX;
+            restriction.endY = sizeY;
+            isNull = false;
+        }
+        restriction.inputStride = inputStride;
+        restriction.outputStride = outputStride;
+        return &restriction;
+    }
 };
 
 extern "C" JNIEXPORT jlong JNICALL
-Java_com_kylecorry_andromeda_bitmaps_Toolkit_createNative(JNIEnv * /*env*/, jobject /*thiz*/) {
-    return reinterpret_cast<jlong>(new RenderScriptToolkit());
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_createNative(JNIEnv *env, jobject /*thiz*/) {
+    auto toolkit = new RenderScriptToolkit();
+    JavaVM *vm = nullptr;
+    if (env->GetJavaVM(&vm) != JNI_OK || !attachPoolThreads(toolkit, vm)) {
+        // Without pool threads, the jobs of runAsync run before nativeRunAsync returns, on the
+        // calling thread, which is attached.
+        ALOGE("Could not attach the pool threads to the Java VM, the Toolkit uses one thread.");
+        delete toolkit;
+        toolkit = new RenderScriptToolkit(1);
+    }
+    return reinterpret_cast<jlong>(toolkit);
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_destroyNative(
@@ -209,6 +583,86 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_d
     delete toolkit;
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeSetCallingThreadPriority(JNIEnv * /*env*/,
+                                                                           jobject /*thiz*/,
+                                                                           jint priority) {
+    RenderScriptToolkit::setCallingThreadPriority(
+            static_cast<RenderScriptToolkit::Priority>(priority));
+}
+
+/**
+ * Runs a job of runAsync, a global reference to a Runnable, and releases the reference.
+ */
+static void runJob(JNIEnv *env, jobject globalJob) {
+    jclass runnableClass = env->GetObjectClass(globalJob);
+    jmethodID runId = env->GetMethodID(runnableClass, "run", "()V");
+    env->CallVoidMethod(globalJob, runId);
+    if (env->ExceptionCheck()) {
+        ALOGE("Toolkit.runAsync job threw an exception.");
+        env->ExceptionClear();
+    }
+    env->DeleteLocalRef(runnableClass);
+    env->DeleteGlobalRef(globalJob);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeRunAsync(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject job) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    JavaVM *vm = nullptr;
+    if (env->GetJavaVM(&vm) != JNI_OK) {
+        ALOGE("Could not get the Java VM, running the Toolkit.runAsync job on the calling thread.");
+        runJob(env, env->NewGlobalRef(job));
+        return;
+    }
+    // The job is a Runnable that makes the Kotlin Toolkit calls. They come back through the
+    // entry points of this file, on the pool thread. createNative attached the pool threads, or
+    // made a Toolkit without any, in which case the job runs here.
+    jobject globalJob = env->NewGlobalRef(job);
+    toolkit->runAsync(
+            [vm, globalJob](RenderScriptToolkit & /*toolkit*/) {
+                runJob(javaThreadAttachment.attach(vm), globalJob);
+            },
+            []() {});
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeCalibrateTiling(JNIEnv * /*env*/,
+                                                                   jobject /*thiz*/,
+                                                                   jlong native_handle) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    toolkit->calibrateTiling();
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGetTilingTarget(JNIEnv * /*env*/,
+                                                                   jobject /*thiz*/,
+                                                                   jlong native_handle,
+                                                                   jint group) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    return static_cast<jint>(
+            toolkit->getTilingTarget(static_cast<RenderScriptToolkit::TilingGroup>(group)));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeSetTilingTarget(JNIEnv * /*env*/,
+                                                                   jobject /*thiz*/,
+                                                                   jlong native_handle,
+                                                                   jint group,
+                                                                   jint bytes) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    toolkit->setTilingTarget(static_cast<RenderScriptToolkit::TilingGroup>(group),
+                             static_cast<size_t>(bytes));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeTrimScratch(JNIEnv * /*env*/,
+                                                               jobject /*thiz*/,
+                                                               jlong native_handle) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    toolkit->trimScratch();
+}
+
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlend(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jint jmode, jbyteArray source_array,
         jbyteArray dest_array, jint size_x, jint size_y, jobject restriction) {
@@ -230,7 +684,24 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     BitmapGuard source{env, source_bitmap};
     BitmapGuard dest{env, dest_bitmap};
 
-    toolkit->blend(mode, source.get(), dest.get(), source.width(), source.height(), restrict.get());
+    toolkit->blend(mode, source.get(), dest.get(), source.width(), source.height(),
+                   restrict.withStrides(source, &dest));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlendBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jint jmode, jobject source_buffer,
+        jobject dest_buffer, jint size_x, jint size_y, jobject restriction) {
+    auto toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    auto mode = static_cast<RenderScriptToolkit::BlendingMode>(jmode);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard source{env, source_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard dest{env, dest_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!source.isValid() || !dest.isValid()) {
+        return;
+    }
+
+    toolkit->blend(mode, source.get(), dest.get(), size_x, size_y,
+                   restrict.withStrides(source, &dest));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlur(
@@ -253,7 +724,23 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     BitmapGuard output{env, output_bitmap};
 
     toolkit->blur(input.get(), output.get(), input.width(), input.height(), input.vectorSize(),
-                  radius, restrict.get());
+                  radius, restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlurBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint vectorSize,
+        jint size_x, jint size_y, jint radius, jobject output_buffer, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, (size_t)vectorSize};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)vectorSize, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->blur(input.get(), output.get(), size_x, size_y, vectorSize, radius,
+                  restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorMatrix(
@@ -283,50 +770,80 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorMatrixBitmap(
     FloatArrayGuard add{env, add_vector};
 
     toolkit->colorMatrix(input.get(), output.get(), input.vectorSize(), output.vectorSize(),
-                         input.width(), input.height(), matrix.get(), add.get(), restrict.get());
+                         input.width(), input.height(), matrix.get(), add.get(),
+                         restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorMatrixBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint input_vector_size, jint size_x, jint size_y, jobject output_buffer,
+        jint output_vector_size, jfloatArray jmatrix, jfloatArray add_vector, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)paddedSize(input_vector_size)};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)paddedSize(output_vector_size), true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    FloatArrayGuard matrix{env, jmatrix};
+    FloatArrayGuard add{env, add_vector};
+
+    toolkit->colorMatrix(input.get(), output.get(), input_vector_size, output_vector_size, size_x,
+                         size_y, matrix.get(), add.get(), restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeConvolve(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array, jint vectorSize,
         jint size_x, jint size_y, jbyteArray output_array, jfloatArray coefficients,
-        jobject restriction) {
+        jint kernel_size_x, jint kernel_size_y, jint border_mode, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     RestrictionParameter restrict{env, restriction};
     ByteArrayGuard input{env, input_array};
     ByteArrayGuard output{env, output_array};
     FloatArrayGuard coeffs{env, coefficients};
 
-    switch (env->GetArrayLength(coefficients)) {
-        case 9:
-            toolkit->convolve3x3(input.get(), output.get(), vectorSize, size_x, size_y,
-                                 coeffs.get(), restrict.get());
-            break;
-        case 25:
-            toolkit->convolve5x5(input.get(), output.get(), vectorSize, size_x, size_y,
-                                 coeffs.get(), restrict.get());
-            break;
-    }
+    toolkit->convolve(input.get(), output.get(), vectorSize, size_x, size_y, coeffs.get(),
+                      kernel_size_x, kernel_size_y,
+                      static_cast<RenderScriptToolkit::BorderMode>(border_mode), restrict.get());
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeConvolveBitmap(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
-        jobject output_bitmap, jfloatArray coefficients, jobject restriction) {
+        jobject output_bitmap, jfloatArray coefficients, jint kernel_size_x, jint kernel_size_y,
+        jint border_mode, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     RestrictionParameter restrict{env, restriction};
     BitmapGuard input{env, input_bitmap};
     BitmapGuard output{env, output_bitmap};
     FloatArrayGuard coeffs{env, coefficients};
 
-    switch (env->GetArrayLength(coefficients)) {
-        case 9:
-            toolkit->convolve3x3(input.get(), output.get(), input.vectorSize(), input.width(),
-                                 input.height(), coeffs.get(), restrict.get());
-            break;
-        case 25:
-            toolkit->convolve5x5(input.get(), output.get(), input.vectorSize(), input.width(),
-                                 input.height(), coeffs.get(), restrict.get());
-            break;
+    toolkit->convolve(input.get(), output.get(), input.vectorSize(), input.width(),
+                      input.height(), coeffs.get(), kernel_size_x, kernel_size_y,
+                      static_cast<RenderScriptToolkit::BorderMode>(border_mode),
+                      restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeConvolveBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint vectorSize,
+        jint size_x, jint size_y, jobject output_buffer, jfloatArray coefficients,
+        jint kernel_size_x, jint kernel_size_y, jint border_mode, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, (size_t)vectorSize};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)vectorSize, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
     }
+    FloatArrayGuard coeffs{env, coefficients};
+
+    toolkit->convolve(input.get(), output.get(), vectorSize, size_x, size_y, coeffs.get(),
+                      kernel_size_x, kernel_size_y,
+                      static_cast<RenderScriptToolkit::BorderMode>(border_mode),
+                      restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogram(
@@ -350,7 +867,24 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogramBitmap(
     IntArrayGuard output{env, output_array};
 
     toolkit->histogram(input.get(), output.get(), input.width(), input.height(), input.vectorSize(),
-                       restrict.get());
+                       restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogramBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint vector_size, jint size_x, jint size_y, jintArray output_array, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    if (!input.isValid()) {
+        return;
+    }
+    IntArrayGuard output{env, output_array};
+
+    toolkit->histogram(input.get(), output.get(), size_x, size_y, vector_size,
+                       restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogramDot(
@@ -378,7 +912,26 @@ void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogramDotBitm
     FloatArrayGuard coeffs{env, coefficients};
 
     toolkit->histogramDot(input.get(), output.get(), input.width(), input.height(),
-                          input.vectorSize(), coeffs.get(), restrict.get());
+                          input.vectorSize(), coeffs.get(), restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeHistogramDotBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint vector_size, jint size_x, jint size_y, jintArray output_array,
+        jfloatArray coefficients, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    if (!input.isValid()) {
+        return;
+    }
+    IntArrayGuard output{env, output_array};
+    FloatArrayGuard coeffs{env, coefficients};
+
+    toolkit->histogramDot(input.get(), output.get(), size_x, size_y, vector_size, coeffs.get(),
+                          restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeLut(
@@ -415,7 +968,28 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     ByteArrayGuard alpha{env, alpha_table};
 
     toolkit->lut(input.get(), output.get(), input.width(), input.height(), red.get(), green.get(),
-                 blue.get(), alpha.get(), restrict.get());
+                 blue.get(), alpha.get(), restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeLutBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jbyteArray red_table,
+        jbyteArray green_table, jbyteArray blue_table, jbyteArray alpha_table,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    ByteArrayGuard red{env, red_table};
+    ByteArrayGuard green{env, green_table};
+    ByteArrayGuard blue{env, blue_table};
+    ByteArrayGuard alpha{env, alpha_table};
+
+    toolkit->lut(input.get(), output.get(), size_x, size_y, red.get(), green.get(), blue.get(),
+                 alpha.get(), restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeLut3d(
@@ -443,7 +1017,24 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     ByteArrayGuard cube{env, cube_values};
 
     toolkit->lut3d(input.get(), output.get(), input.width(), input.height(), cube.get(), cubeSizeX,
-                   cubeSizeY, cubeSizeZ, restrict.get());
+                   cubeSizeY, cubeSizeZ, restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeLut3dBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jbyteArray cube_values, jint cubeSizeX,
+        jint cubeSizeY, jint cubeSizeZ, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    ByteArrayGuard cube{env, cube_values};
+
+    toolkit->lut3d(input.get(), output.get(), size_x, size_y, cube.get(), cubeSizeX, cubeSizeY,
+                   cubeSizeZ, restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeResize(
@@ -468,66 +1059,263 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     BitmapGuard output{env, output_bitmap};
 
     toolkit->resize(input.get(), output.get(), input.width(), input.height(), input.vectorSize(),
-                    output.width(), output.height(), restrict.get());
+                    output.width(), output.height(), restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeResizeBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint vector_size, jint input_size_x, jint input_size_y, jobject output_buffer,
+        jint output_size_x, jint output_size_y, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)input_size_x, (size_t)input_size_y,
+                           (size_t)paddedSize(vector_size)};
+    PixelBufferGuard output{env, output_buffer, (size_t)output_size_x, (size_t)output_size_y,
+                            (size_t)paddedSize(vector_size), true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->resize(input.get(), output.get(), input_size_x, input_size_y, vector_size,
+                    output_size_x, output_size_y, restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeYuvToRgb(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
-        jbyteArray output_array, jint size_x, jint size_y, jint format) {
+        jbyteArray output_array, jint size_x, jint size_y, jint format, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     ByteArrayGuard input{env, input_array};
     ByteArrayGuard output{env, output_array};
+    RestrictionParameter restrict{env, restriction};
 
     toolkit->yuvToRgb(input.get(), output.get(), size_x, size_y,
-                      static_cast<RenderScriptToolkit::YuvFormat>(format));
+                      static_cast<RenderScriptToolkit::YuvFormat>(format), restrict.get());
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeYuvToRgbBitmap(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array, jint size_x,
-        jint size_y, jobject output_bitmap, jint format) {
+        jint size_y, jobject output_bitmap, jint format, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     BitmapGuard output{env, output_bitmap};
     ByteArrayGuard input{env, input_array};
+    RestrictionParameter restrict{env, restriction};
 
     toolkit->yuvToRgb(input.get(), output.get(), size_x, size_y,
-                      static_cast<RenderScriptToolkit::YuvFormat>(format));
+                      static_cast<RenderScriptToolkit::YuvFormat>(format),
+                      restrict.withStrides(0, output.isPadded() ? output.stride() : 0,
+                                           output.width(), output.height()));
 }
 
-extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThreshold(
-        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
-        jbyteArray output_array, jint size_x, jint size_y, jfloat threshold,
-        jboolean binary, jbyte channel, jobject restriction) {
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeYuvPlanesToRgbBitmap(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject y_buffer, jobject u_buffer,
+        jobject v_buffer, jint y_row_stride, jint uv_row_stride, jint uv_pixel_stride,
+        jint size_x, jint size_y, jobject output_bitmap, jint rotation, jobject crop,
+        jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
-    RestrictionParameter restrict{env, restriction};
+    if (size_x < 2 || size_y < 2 || y_row_stride < size_x || uv_pixel_stride < 1) {
+        ALOGE("Invalid YUV plane layout.");
+        return;
+    }
+    // The planes may end right after their last sample, without the padding of the last row.
+    // The chroma planes have (size + 1) / 2 samples per row and column, odd sizes included.
+    size_t ySize = (size_t)y_row_stride * (size_y - 1) + size_x;
+    size_t uvSize = (size_t)uv_row_stride * ((size_y + 1) / 2 - 1) +
+                    (size_t)uv_pixel_stride * ((size_x + 1) / 2 - 1) + 1;
+    const uint8_t *y = directBufferAddress(env, y_buffer, ySize);
+    const uint8_t *u = directBufferAddress(env, u_buffer, uvSize);
+    const uint8_t *v = directBufferAddress(env, v_buffer, uvSize);
+    if (y == nullptr || u == nullptr || v == nullptr) {
+        return;
+    }
 
-    ByteArrayGuard input{env, input_array};
-    ByteArrayGuard output{env, output_array};
+    BitmapGuard output{env, output_bitmap};
+    RestrictionParameter restrict{env, restriction};
 
-    toolkit->threshold(input.get(), output.get(), size_x, size_y, threshold, binary, channel,
-                       restrict.get());
+    // The output bitmap has the size of the rotated and scaled crop.
+    RestrictionParameter cropParameter{env, crop};
+    const Restriction *cropRestriction = cropParameter.get();
+    RenderScriptToolkit::YuvTransform transform;
+    transform.cropStartX = cropRestriction ? cropRestriction->startX : 0;
+    transform.cropEndX = cropRestriction ? cropRestriction->endX : size_x;
+    transform.cropStartY = cropRestriction ? cropRestriction->startY : 0;
+    transform.cropEndY = cropRestriction ? cropRestriction->endY : size_y;
+    transform.rotation = rotation;
+    transform.outputSizeX = output.width();
+    transform.outputSizeY = output.height();
+    toolkit->yuvToRgb(y, u, v, y_row_stride, uv_row_stride, uv_pixel_stride, output.get(),
+                      size_x, size_y, &transform,
+                      restrict.withStrides(0, output.isPadded() ? output.stride() : 0,
+                                           output.width(), output.height()));
 }
 
-extern "C" JNIEXPORT void JNICALL
-Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThresholdBitmap(
-        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
-        jobject output_bitmap, jfloat threshold,
-        jboolean binary, jbyte channel, jobject restriction) {
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeYuvToRgbBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jint format, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    auto yuvFormat = static_cast<RenderScriptToolkit::YuvFormat>(format);
+    // The YUV data is a single plane of bytes. YV12 pads the rows of its planes to 16 bytes.
+    size_t inputSize = yuvFormat == RenderScriptToolkit::YuvFormat::YV12
+                               ? ((size_x + 15) & ~15) * size_y * 3 / 2
+                               : (size_t)size_x * size_y * 3 / 2;
+    PixelBufferGuard input{env, input_buffer, inputSize, 1, 1};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
     RestrictionParameter restrict{env, restriction};
-    BitmapGuard input{env, input_bitmap};
-    BitmapGuard output{env, output_bitmap};
 
-    toolkit->threshold(input.get(), output.get(), input.width(), input.height(), threshold, binary,
-                       channel, restrict.get());
+    toolkit->yuvToRgb(input.get(), output.get(), size_x, size_y, yuvFormat,
+                      restrict.withStrides(0, output.isPadded() ? output.stride() : 0,
+                                           output.width(), output.height()));
 }
 
-extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeWeightedAdd(
-        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array1,
-        jbyteArray input_array2,
-        jbyteArray output_array, jint size_x, jint size_y, jfloat weight1, jfloat weight2,
-        jboolean absolute, jobject restriction) {
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativePipeline(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
+        jbyteArray output_array, jint size_x, jint size_y, jintArray stage_types,
+        jfloatArray stage_floats, jintArray stage_ints, jbyteArray stage_bytes,
+        jintArray histogram_array) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
-    RestrictionParameter restrict{env, restriction};
+    IntArrayGuard types{env, stage_types};
+    FloatArrayGuard floats{env, stage_floats};
+    IntArrayGuard ints{env, stage_ints};
+    ByteArrayGuard bytes{env, stage_bytes};
+    PipelineStagesParameter stages{types.get(), (size_t)env->GetArrayLength(stage_types),
+                                   floats.get(), (size_t)env->GetArrayLength(stage_floats),
+                                   ints.get(), (size_t)env->GetArrayLength(stage_ints),
+                                   bytes.get(), (size_t)env->GetArrayLength(stage_bytes)};
+    if (!stages.isValid()) {
+        return;
+    }
+
+    ByteArrayGuard input{env, input_array};
+    ByteArrayGuard output{env, output_array};
+    if (histogram_array == nullptr) {
+        toolkit->pipeline(input.get(), output.get(), size_x, size_y, stages.data(), stages.size());
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->pipeline(input.get(), output.get(), size_x, size_y, stages.data(), stages.size(),
+                          histogram.get());
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativePipelineBitmap(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
+        jobject output_bitmap, jintArray stage_types, jfloatArray stage_floats,
+        jintArray stage_ints, jbyteArray stage_bytes, jintArray histogram_array) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    IntArrayGuard types{env, stage_types};
+    FloatArrayGuard floats{env, stage_floats};
+    IntArrayGuard ints{env, stage_ints};
+    ByteArrayGuard bytes{env, stage_bytes};
+    PipelineStagesParameter stages{types.get(), (size_t)env->GetArrayLength(stage_types),
+                                   floats.get(), (size_t)env->GetArrayLength(stage_floats),
+                                   ints.get(), (size_t)env->GetArrayLength(stage_ints),
+                                   bytes.get(), (size_t)env->GetArrayLength(stage_bytes)};
+    if (!stages.isValid()) {
+        return;
+    }
+
+    RestrictionParameter restrict{env, nullptr};
+    BitmapGuard input{env, input_bitmap};
+    BitmapGuard output{env, output_bitmap};
+    if (histogram_array == nullptr) {
+        toolkit->pipeline(input.get(), output.get(), input.width(), input.height(), stages.data(),
+                          stages.size(), nullptr, restrict.withStrides(input, &output));
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->pipeline(input.get(), output.get(), input.width(), input.height(), stages.data(),
+                          stages.size(), histogram.get(), restrict.withStrides(input, &output));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativePipelineBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jintArray stage_types,
+        jfloatArray stage_floats, jintArray stage_ints, jbyteArray stage_bytes,
+        jintArray histogram_array) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    IntArrayGuard types{env, stage_types};
+    FloatArrayGuard floats{env, stage_floats};
+    IntArrayGuard ints{env, stage_ints};
+    ByteArrayGuard bytes{env, stage_bytes};
+    PipelineStagesParameter stages{types.get(), (size_t)env->GetArrayLength(stage_types),
+                                   floats.get(), (size_t)env->GetArrayLength(stage_floats),
+                                   ints.get(), (size_t)env->GetArrayLength(stage_ints),
+                                   bytes.get(), (size_t)env->GetArrayLength(stage_bytes)};
+    if (!stages.isValid()) {
+        return;
+    }
+
+    RestrictionParameter restrict{env, nullptr};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    if (histogram_array == nullptr) {
+        toolkit->pipeline(input.get(), output.get(), size_x, size_y, stages.data(), stages.size(),
+                          nullptr, restrict.withStrides(input, &output));
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->pipeline(input.get(), output.get(), size_x, size_y, stages.data(), stages.size(),
+                          histogram.get(), restrict.withStrides(input, &output));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThreshold(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
+        jbyteArray output_array, jint size_x, jint size_y, jfloat threshold,
+        jboolean binary, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+
+    ByteArrayGuard input{env, input_array};
+    ByteArrayGuard output{env, output_array};
+
+    toolkit->threshold(input.get(), output.get(), size_x, size_y, threshold, binary, channel,
+                       restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThresholdBitmap(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
+        jobject output_bitmap, jfloat threshold,
+        jboolean binary, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    BitmapGuard input{env, input_bitmap};
+    BitmapGuard output{env, output_bitmap};
+
+    toolkit->threshold(input.get(), output.get(), input.width(), input.height(), threshold, binary,
+                       channel, restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThresholdBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jfloat threshold,
+        jboolean binary, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->threshold(input.get(), output.get(), size_x, size_y, threshold, binary, channel,
+                       restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeWeightedAdd(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array1,
+        jbyteArray input_array2,
+        jbyteArray output_array, jint size_x, jint size_y, jfloat weight1, jfloat weight2,
+        jboolean absolute, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
 
     ByteArrayGuard input1{env, input_array1};
     ByteArrayGuard input2{env, input_array2};
@@ -548,10 +1336,38 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeWeightedAddBitmap(
     BitmapGuard input1{env, input_bitmap1};
     BitmapGuard input2{env, input_bitmap2};
     BitmapGuard output{env, output_bitmap};
+    if (input1.stride() != input2.stride()) {
+        ALOGE("The two inputs of weightedAdd should have the same stride. %zu and %zu provided.",
+              input1.stride(), input2.stride());
+        return;
+    }
 
     toolkit->weightedAdd(input1.get(), input2.get(), output.get(), input1.width(), input1.height(),
                          weight1, weight2,
-                         absolute, restrict.get());
+                         absolute, restrict.withStrides(input1, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeWeightedAddBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer1,
+        jobject input_buffer2, jobject output_buffer, jint size_x, jint size_y, jfloat weight1,
+        jfloat weight2, jboolean absolute, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input1{env, input_buffer1, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard input2{env, input_buffer2, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input1.isValid() || !input2.isValid() || !output.isValid()) {
+        return;
+    }
+    if (input1.stride() != input2.stride()) {
+        ALOGE("weightedAdd needs both inputs to have the same stride. %zu and %zu provided.",
+              input1.stride(), input2.stride());
+        return;
+    }
+
+    toolkit->weightedAdd(input1.get(), input2.get(), output.get(), size_x, size_y, weight1,
+                         weight2, absolute, restrict.withStrides(input1, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMinMax(
@@ -575,7 +1391,22 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     FloatArrayGuard output{env, output_array};
 
     toolkit->minMax(input.get(), output.get(), input.width(), input.height(), channel,
-                    restrict.get());
+                    restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMinMaxBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jfloatArray output_array, jint size_x, jint size_y, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->minMax(input.get(), output.get(), size_x, size_y, channel,
+                    restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT jdouble JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeAverage(
@@ -596,7 +1427,22 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeAverageBitmap(
     RestrictionParameter restrict{env, restriction};
     BitmapGuard input{env, input_bitmap};
 
-    return toolkit->average(input.get(), input.width(), input.height(), channel, restrict.get());
+    return toolkit->average(input.get(), input.width(), input.height(), channel,
+                            restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeAverageBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint size_x,
+        jint size_y, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return 0;
+    }
+
+    return toolkit->average(input.get(), size_x, size_y, channel, restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT jdouble JNICALL
@@ -620,7 +1466,22 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStandardDeviationBitmap(
     BitmapGuard input{env, input_bitmap};
 
     return toolkit->standardDeviation(input.get(), input.width(), input.height(), channel, average,
-                                      restrict.get());
+                                      restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStandardDeviationBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint size_x,
+        jint size_y, jbyte channel, jdouble average, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return 0;
+    }
+
+    return toolkit->standardDeviation(input.get(), size_x, size_y, channel, average,
+                                      restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMoment(
@@ -644,35 +1505,146 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
     FloatArrayGuard output{env, output_array};
 
     toolkit->moment(input.get(), output.get(), input.width(), input.height(), channel,
-                    restrict.get());
+                    restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMomentBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jfloatArray output_array, jint size_x, jint size_y, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->moment(input.get(), output.get(), size_x, size_y, channel,
+                    restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStatistics(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
+        jdoubleArray output_array, jintArray histogram_array, jint size_x, jint size_y,
+        jbyte channel, jint requested, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    ByteArrayGuard input{env, input_array};
+    DoubleArrayGuard output{env, output_array};
+
+    if (histogram_array == nullptr) {
+        toolkit->statistics(input.get(), output.get(), nullptr, size_x, size_y, channel,
+                            requested, restrict.get());
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->statistics(input.get(), output.get(), histogram.get(), size_x, size_y, channel,
+                            requested, restrict.get());
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStatisticsBitmap(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
+        jdoubleArray output_array, jintArray histogram_array, jbyte channel, jint requested,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    BitmapGuard input{env, input_bitmap};
+    DoubleArrayGuard output{env, output_array};
+
+    if (histogram_array == nullptr) {
+        toolkit->statistics(input.get(), output.get(), nullptr, input.width(), input.height(),
+                            channel, requested, restrict.withStrides(input));
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->statistics(input.get(), output.get(), histogram.get(), input.width(),
+                            input.height(), channel, requested, restrict.withStrides(input));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStatisticsBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jdoubleArray output_array, jintArray histogram_array, jint size_x, jint size_y,
+        jbyte channel, jint requested, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    DoubleArrayGuard output{env, output_array};
+
+    if (histogram_array == nullptr) {
+        toolkit->statistics(input.get(), output.get(), nullptr, size_x, size_y, channel,
+                            requested, restrict.withStrides(input));
+    } else {
+        IntArrayGuard histogram{env, histogram_array};
+        toolkit->statistics(input.get(), output.get(), histogram.get(), size_x, size_y, channel,
+                            requested, restrict.withStrides(input));
+    }
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeFindBlobs(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
-        jintArray output_array, jint maxBlobs, jint size_x,
+        jintArray output_array, jdoubleArray statistics_array, jint maxBlobs, jint size_x,
         jint size_y, jfloat threshold, jbyte channel, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     RestrictionParameter restrict{env, restriction};
     ByteArrayGuard input{env, input_array};
     IntArrayGuard output{env, output_array};
 
-    toolkit->findBlobs(input.get(), output.get(), maxBlobs, size_x, size_y, threshold, channel,
-                       restrict.get());
+    if (statistics_array == nullptr) {
+        toolkit->findBlobs(input.get(), output.get(), nullptr, maxBlobs, size_x, size_y,
+                           threshold, channel, restrict.get());
+    } else {
+        DoubleArrayGuard statistics{env, statistics_array};
+        toolkit->findBlobs(input.get(), output.get(), statistics.get(), maxBlobs, size_x, size_y,
+                           threshold, channel, restrict.get());
+    }
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeFindBlobsBitmap(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
-        jintArray output_array, jint maxBlobs, jfloat threshold, jbyte channel,
-        jobject restriction) {
+        jintArray output_array, jdoubleArray statistics_array, jint maxBlobs, jfloat threshold,
+        jbyte channel, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     RestrictionParameter restrict{env, restriction};
     BitmapGuard input{env, input_bitmap};
     IntArrayGuard output{env, output_array};
 
-    toolkit->findBlobs(input.get(), output.get(), maxBlobs, input.width(), input.height(),
-                       threshold, channel,
-                       restrict.get());
+    if (statistics_array == nullptr) {
+        toolkit->findBlobs(input.get(), output.get(), nullptr, maxBlobs, input.width(),
+                           input.height(), threshold, channel, restrict.withStrides(input));
+    } else {
+        DoubleArrayGuard statistics{env, statistics_array};
+        toolkit->findBlobs(input.get(), output.get(), statistics.get(), maxBlobs, input.width(),
+                           input.height(), threshold, channel, restrict.withStrides(input));
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeFindBlobsBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jintArray output_array, jdoubleArray statistics_array, jint maxBlobs, jint size_x,
+        jint size_y, jfloat threshold, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    IntArrayGuard output{env, output_array};
+
+    if (statistics_array == nullptr) {
+        toolkit->findBlobs(input.get(), output.get(), nullptr, maxBlobs, size_x, size_y,
+                           threshold, channel, restrict.withStrides(input));
+    } else {
+        DoubleArrayGuard statistics{env, statistics_array};
+        toolkit->findBlobs(input.get(), output.get(), statistics.get(), maxBlobs, size_x, size_y,
+                           threshold, channel, restrict.withStrides(input));
+    }
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGlcm(
@@ -703,7 +1675,82 @@ extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_n
 
     toolkit->glcm(input.get(), output.get(), input.width(), input.height(), levels, channel,
                   symmetric,
-                  normalize, excludeTransparent, stepArray.get(), stepCount, restrict.get());
+                  normalize, excludeTransparent, stepArray.get(), stepCount,
+                  restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGlcmBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jfloatArray output_array, jint size_x, jint size_y, jint levels, jbyte channel,
+        jboolean symmetric, jboolean normalize, jboolean excludeTransparent, jintArray steps,
+        jbyte stepCount, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    FloatArrayGuard output{env, output_array};
+    IntArrayGuard stepArray{env, steps};
+
+    toolkit->glcm(input.get(), output.get(), size_x, size_y, levels, channel, symmetric, normalize,
+                  excludeTransparent, stepArray.get(), stepCount, restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGlcmFeatures(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jbyteArray input_array,
+        jfloatArray output_array, jint size_x, jint size_y, jintArray levels, jint levelCount,
+        jbyte channel, jboolean symmetric, jboolean excludeTransparent, jintArray steps,
+        jbyte stepCount, jboolean sparse, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    ByteArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+    IntArrayGuard levelArray{env, levels};
+    IntArrayGuard stepArray{env, steps};
+
+    toolkit->glcmFeatures(input.get(), output.get(), size_x, size_y, levelArray.get(),
+                          levelCount, channel, symmetric, excludeTransparent, stepArray.get(),
+                          stepCount, sparse, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGlcmFeaturesBitmap(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
+        jfloatArray output_array, jintArray levels, jint levelCount, jbyte channel,
+        jboolean symmetric, jboolean excludeTransparent, jintArray steps, jbyte stepCount,
+        jboolean sparse, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    BitmapGuard input{env, input_bitmap};
+    FloatArrayGuard output{env, output_array};
+    IntArrayGuard levelArray{env, levels};
+    IntArrayGuard stepArray{env, steps};
+
+    toolkit->glcmFeatures(input.get(), output.get(), input.width(), input.height(),
+                          levelArray.get(), levelCount, channel, symmetric, excludeTransparent,
+                          stepArray.get(), stepCount, sparse, restrict.withStrides(input));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeGlcmFeaturesBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jfloatArray output_array, jint size_x, jint size_y, jintArray levels, jint levelCount,
+        jbyte channel, jboolean symmetric, jboolean excludeTransparent, jintArray steps,
+        jbyte stepCount, jboolean sparse, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    if (!input.isValid()) {
+        return;
+    }
+    FloatArrayGuard output{env, output_array};
+    IntArrayGuard levelArray{env, levels};
+    IntArrayGuard stepArray{env, steps};
+
+    toolkit->glcmFeatures(input.get(), output.get(), size_x, size_y, levelArray.get(),
+                          levelCount, channel, symmetric, excludeTransparent, stepArray.get(),
+                          stepCount, sparse, restrict.withStrides(input));
 }
 
 extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorReplace(
@@ -735,18 +1782,43 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorReplaceBitmap(
 
     toolkit->colorReplace(input.get(), output.get(), input.width(), input.height(), targetR,
                           targetG, targetB, targetA, replacementR, replacementG, replacementB,
-                          replacementA, tolerance, interpolate, restrict.get());
+                          replacementA, tolerance, interpolate,
+                          restrict.withStrides(input, &output));
 }
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeXbr2xBitmap(
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorReplaceBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jbyte targetR, jbyte targetG,
+        jbyte targetB, jbyte targetA, jbyte replacementR, jbyte replacementG, jbyte replacementB,
+        jbyte replacementA, jfloat tolerance, jboolean interpolate, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, 4};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y, 4, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->colorReplace(input.get(), output.get(), size_x, size_y, targetR, targetG, targetB,
+                          targetA, replacementR, replacementG, replacementB, replacementA,
+                          tolerance, interpolate, restrict.withStrides(input, &output));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeXbrBitmap(
         JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_bitmap,
-        jobject output_bitmap) {
+        jobject output_bitmap, jint scale, jobject restriction) {
     RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     BitmapGuard input{env, input_bitmap};
     BitmapGuard output{env, output_bitmap};
+    RestrictionParameter restrict{env, restriction};
 
-    toolkit->xbr2x(input.get(), output.get(), input.width(), input.height());
+    // The restriction is in pixels of the input.
+    toolkit->xbr(input.get(), output.get(), input.width(), input.height(), scale,
+                 restrict.withStrides(input.isPadded() ? input.stride() : 0,
+                                      output.isPadded() ? output.stride() : 0, input.width(),
+                                      input.height()));
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -757,15 +1829,336 @@ Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeInterpolateFloatBitmap(
         jint output_width, jint output_height,
         jfloat src_start_x, jfloat src_start_y,
         jfloat src_end_x, jfloat src_end_y,
-        jint max_search_radius) {
+        jint max_search_radius, jintArray valid_distances, jobject restriction) {
     auto toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
     FloatArrayGuard input{env, input_array};
     FloatArrayGuard output{env, output_array};
+    RestrictionParameter restrict{env, restriction};
+
+    if (valid_distances == nullptr) {
+        toolkit->interpolateFloatBitmap(input.get(), output.get(),
+                                         input_width, input_height, channels,
+                                         output_width, output_height,
+                                         src_start_x, src_start_y,
+                                         src_end_x, src_end_y,
+                                         max_search_radius, nullptr, restrict.get());
+    } else {
+        IntArrayGuard distances{env, valid_distances};
+        toolkit->interpolateFloatBitmap(input.get(), output.get(),
+                                         input_width, input_height, channels,
+                                         output_width, output_height,
+                                         src_start_x, src_start_y,
+                                         src_end_x, src_end_y,
+                                         max_search_radius, distances.get(), restrict.get());
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeInterpolateFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint input_width, jint input_height, jint channels,
+        jint output_width, jint output_height, jfloat src_start_x, jfloat src_start_y,
+        jfloat src_end_x, jfloat src_end_y, jint max_search_radius, jintArray valid_distances,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    // Direct FloatBuffers, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)input_width, (size_t)input_height,
+                           (size_t)channels};
+    PixelBufferGuard output{env, output_buffer, (size_t)output_width, (size_t)output_height,
+                            (size_t)channels, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    RestrictionParameter restrict{env, restriction};
+
+    if (valid_distances == nullptr) {
+        toolkit->interpolateFloatBitmap(reinterpret_cast<const float *>(input.get()),
+                                        reinterpret_cast<float *>(output.get()), input_width,
+                                        input_height, channels, output_width, output_height,
+                                        src_start_x, src_start_y, src_end_x, src_end_y,
+                                        max_search_radius, nullptr, restrict.get());
+    } else {
+        IntArrayGuard distances{env, valid_distances};
+        toolkit->interpolateFloatBitmap(reinterpret_cast<const float *>(input.get()),
+                                        reinterpret_cast<float *>(output.get()), input_width,
+                                        input_height, channels, output_width, output_height,
+                                        src_start_x, src_start_y, src_end_x, src_end_y,
+                                        max_search_radius, distances.get(), restrict.get());
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeNearestValidDistances(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jintArray output_array, jint width, jint height, jint channels) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    FloatArrayGuard input{env, input_array};
+    IntArrayGuard output{env, output_array};
+
+    toolkit->nearestValidDistances(input.get(), output.get(), width, height, channels);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlurFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jint vectorSize, jint size_x, jint size_y, jint radius, jfloatArray output_array,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->blur(input.get(), output.get(), size_x, size_y, vectorSize, radius, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeBlurFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint vectorSize,
+        jint size_x, jint size_y, jint radius, jobject output_buffer, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    // Direct FloatBuffers, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, (size_t)vectorSize};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)vectorSize, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->blur(reinterpret_cast<const float *>(input.get()),
+                  reinterpret_cast<float *>(output.get()), size_x, size_y, vectorSize, radius,
+                  restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorMatrixFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jint input_vector_size, jint size_x, jint size_y, jfloatArray output_array,
+        jint output_vector_size, jfloatArray jmatrix, jfloatArray add_vector, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+    FloatArrayGuard matrix{env, jmatrix};
+    FloatArrayGuard add{env, add_vector};
+
+    toolkit->colorMatrix(input.get(), output.get(), input_vector_size, output_vector_size, size_x,
+                         size_y, matrix.get(), add.get(), restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeColorMatrixFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint input_vector_size, jint size_x, jint size_y, jobject output_buffer,
+        jint output_vector_size, jfloatArray jmatrix, jfloatArray add_vector, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    // Direct FloatBuffers of packed cells, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)input_vector_size};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)output_vector_size, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    FloatArrayGuard matrix{env, jmatrix};
+    FloatArrayGuard add{env, add_vector};
+
+    toolkit->colorMatrix(reinterpret_cast<const float *>(input.get()),
+                         reinterpret_cast<float *>(output.get()), input_vector_size,
+                         output_vector_size, size_x, size_y, matrix.get(), add.get(),
+                         restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeConvolveFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jint vectorSize, jint size_x, jint size_y, jfloatArray output_array,
+        jfloatArray coefficients, jint kernel_size_x, jint kernel_size_y, jint border_mode,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+    FloatArrayGuard coeffs{env, coefficients};
+
+    toolkit->convolve(input.get(), output.get(), vectorSize, size_x, size_y, coeffs.get(),
+                      kernel_size_x, kernel_size_y,
+                      static_cast<RenderScriptToolkit::BorderMode>(border_mode), restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeConvolveFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint vectorSize,
+        jint size_x, jint size_y, jobject output_buffer, jfloatArray coefficients,
+        jint kernel_size_x, jint kernel_size_y, jint border_mode, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    // Direct FloatBuffers, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y, (size_t)vectorSize};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)vectorSize, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+    FloatArrayGuard coeffs{env, coefficients};
+
+    toolkit->convolve(reinterpret_cast<const float *>(input.get()),
+                      reinterpret_cast<float *>(output.get()), vectorSize, size_x, size_y,
+                      coeffs.get(), kernel_size_x, kernel_size_y,
+                      static_cast<RenderScriptToolkit::BorderMode>(border_mode), restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeResizeFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jint vector_size, jint input_size_x, jint input_size_y, jfloatArray output_array,
+        jint output_size_x, jint output_size_y, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->resize(input.get(), output.get(), input_size_x, input_size_y, vector_size,
+                    output_size_x, output_size_y, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeResizeFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jint vector_size, jint input_size_x, jint input_size_y, jobject output_buffer,
+        jint output_size_x, jint output_size_y, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    // Direct FloatBuffers, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)input_size_x, (size_t)input_size_y,
+                           (size_t)vector_size};
+    PixelBufferGuard output{env, output_buffer, (size_t)output_size_x, (size_t)output_size_y,
+                            (size_t)vector_size, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->resize(reinterpret_cast<const float *>(input.get()),
+                    reinterpret_cast<float *>(output.get()), input_size_x, input_size_y,
+                    vector_size, output_size_x, output_size_y, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThresholdFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jfloatArray output_array, jint size_x, jint size_y, jint vector_size, jfloat threshold,
+        jboolean binary, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->threshold(input.get(), output.get(), size_x, size_y, vector_size, threshold, binary,
+                       channel, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeThresholdFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jobject output_buffer, jint size_x, jint size_y, jint vector_size, jfloat threshold,
+        jboolean binary, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    // Direct FloatBuffers, so the sizes are in floats.
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    PixelBufferGuard output{env, output_buffer, (size_t)size_x, (size_t)size_y,
+                            (size_t)vector_size, true};
+    if (!input.isValid() || !output.isValid()) {
+        return;
+    }
+
+    toolkit->threshold(reinterpret_cast<const float *>(input.get()),
+                       reinterpret_cast<float *>(output.get()), size_x, size_y, vector_size,
+                       threshold, binary, channel, restrict.get());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMinMaxFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array,
+        jfloatArray output_array, jint size_x, jint size_y, jint vector_size, jbyte channel,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->minMax(input.get(), output.get(), size_x, size_y, vector_size, channel,
+                    restrict.get());
+}
 
-    toolkit->interpolateFloatBitmap(input.get(), output.get(),
-                                     input_width, input_height, channels,
-                                     output_width, output_height,
-                                     src_start_x, src_start_y,
-                                     src_end_x, src_end_y,
-                                     max_search_radius);
-}
\ No newline at end of file
+extern "C" JNIEXPORT void JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeMinMaxFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer,
+        jfloatArray output_array, jint size_x, jint size_y, jint vector_size, jbyte channel,
+        jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    if (!input.isValid()) {
+        return;
+    }
+    FloatArrayGuard output{env, output_array};
+
+    toolkit->minMax(reinterpret_cast<const float *>(input.get()), output.get(), size_x, size_y,
+                    vector_size, channel, restrict.get());
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeAverageFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array, jint size_x,
+        jint size_y, jint vector_size, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+
+    return toolkit->average(input.get(), size_x, size_y, vector_size, channel, restrict.get());
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeAverageFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint size_x,
+        jint size_y, jint vector_size, jbyte channel, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    if (!input.isValid()) {
+        return 0;
+    }
+
+    return toolkit->average(reinterpret_cast<const float *>(input.get()), size_x, size_y,
+                            vector_size, channel, restrict.get());
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStandardDeviationFloat(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jfloatArray input_array, jint size_x,
+        jint size_y, jint vector_size, jbyte channel, jdouble average, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    FloatArrayGuard input{env, input_array};
+
+    return toolkit->standardDeviation(input.get(), size_x, size_y, vector_size, channel, average,
+                                      restrict.get());
+}
+
+extern "C" JNIEXPORT jdouble JNICALL
+Java_com_kylecorry_andromeda_bitmaps_Toolkit_nativeStandardDeviationFloatBuffer(
+        JNIEnv *env, jobject /*thiz*/, jlong native_handle, jobject input_buffer, jint size_x,
+        jint size_y, jint vector_size, jbyte channel, jdouble average, jobject restriction) {
+    RenderScriptToolkit *toolkit = reinterpret_cast<RenderScriptToolkit *>(native_handle);
+    RestrictionParameter restrict{env, restriction};
+    PixelBufferGuard input{env, input_buffer, (size_t)size_x, (size_t)size_y,
+                           (size_t)vector_size};
+    if (!input.isValid()) {
+        return 0;
+    }
+
+    return toolkit->standardDeviation(reinterpret_cast<const float *>(input.get()), size_x,
+                                      size_y, vector_size, channel, average, restrict.get());
+}
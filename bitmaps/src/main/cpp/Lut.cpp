@@ -25,8 +25,10 @@
 namespace renderscript {
 
 class LutTask : public Task {
-    const uchar4* mIn;
-    uchar4* mOut;
+    const uint8_t* mIn;
+    uint8_t* mOut;
+    const size_t mInStride;
+    const size_t mOutStride;
     const uchar* mRedTable;
     const uchar* mGreenTable;
     const uchar* mBlueTable;
@@ -41,20 +43,23 @@ class LutTask : public Task {
             const uint8_t* green, const uint8_t* blue, const uint8_t* alpha,
             const Restriction* restriction)
         : Task{sizeX, sizeY, 4, true, restriction},
-          mIn{reinterpret_cast<const uchar4*>(input)},
-          mOut{reinterpret_cast<uchar4*>(output)},
+          mIn{input},
+          mOut{output},
+          mInStride{inputStride(sizeX * sizeof(uchar4))},
+          mOutStride{outputStride(sizeX * sizeof(uchar4))},
           mRedTable{red},
           mGreenTable{green},
           mBlueTable{blue},
-          mAlphaTable{alpha} {}
+          mAlphaTable{alpha} {
+        setTilingGroup(RenderScriptToolkit::TilingGroup::LUT);
+    }
 };
 
 void LutTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                           size_t endY) {
     for (size_t y = startY; y < endY; y++) {
-        size_t offset = mSizeX * y + startX;
-        const uchar4* in = mIn + offset;
-        uchar4* out = mOut + offset;
+        const uchar4* in = reinterpret_cast<const uchar4*>(mIn + mInStride * y) + startX;
+        uchar4* out = reinterpret_cast<uchar4*>(mOut + mOutStride * y) + startX;
         for (size_t x = startX; x < endX; x++) {
             auto v = *in;
             *out = uchar4{mRedTable[v.x], mGreenTable[v.y], mBlueTable[v.z], mAlphaTable[v.w]};
@@ -68,7 +73,7 @@ void RenderScriptToolkit::lut(const uint8_t* input, uint8_t* output, size_t size
                               const uint8_t* red, const uint8_t* green, const uint8_t* blue,
                               const uint8_t* alpha, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
         return;
     }
 #endif
@@ -29,9 +29,12 @@ namespace renderscript {
  */
 class Lut3dTask : public Task {
     // The input array we're transforming.
-    const uchar4* mIn;
+    const uint8_t* mIn;
     // Where we'll store the transformed result.
-    uchar4* mOut;
+    uint8_t* mOut;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
     // The size of each of the three cube dimensions. We don't make use of the last value.
     int4 mCubeDimension;
     // The translation cube, in row major format.
@@ -55,10 +58,14 @@ class Lut3dTask : public Task {
               const uint8_t* cube, int cubeSizeX, int cubeSizeY, int cubeSizeZ,
               const Restriction* restriction)
         : Task{sizeX, sizeY, 4, true, restriction},
-          mIn{reinterpret_cast<const uchar4*>(input)},
-          mOut{reinterpret_cast<uchar4*>(output)},
+          mIn{input},
+          mOut{output},
+          mInStride{inputStride(sizeX * sizeof(uchar4))},
+          mOutStride{outputStride(sizeX * sizeof(uchar4))},
           mCubeDimension{cubeSizeX, cubeSizeY, cubeSizeZ, 0},
-          mCubeTable{cube} {}
+          mCubeTable{cube} {
+        setTilingGroup(RenderScriptToolkit::TilingGroup::LUT);
+    }
 };
 
 extern "C" void rsdIntrinsic3DLUT_K(void* dst, void const* in, size_t count, void const* lut,
@@ -158,8 +165,9 @@ void Lut3dTask::kernel(const uchar4* in, uchar4* out, uint32_t length) {
 void Lut3dTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                             size_t endY) {
     for (size_t y = startY; y < endY; y++) {
-        size_t offset = mSizeX * y + startX;
-        kernel(mIn + offset, mOut + offset, endX - startX);
+        const uchar4* in = reinterpret_cast<const uchar4*>(mIn + mInStride * y);
+        uchar4* out = reinterpret_cast<uchar4*>(mOut + mOutStride * y);
+        kernel(in + startX, out + startX, endX - startX);
     }
 }
 
@@ -167,7 +175,7 @@ void RenderScriptToolkit::lut3d(const uint8_t* input, uint8_t* output, size_t si
                                 const uint8_t* cube, size_t cubeSizeX, size_t cubeSizeY,
                                 size_t cubeSizeZ, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
         return;
     }
 #endif
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
+#include "Reduction.h"
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
 #include "Utils.h"
@@ -9,10 +12,12 @@
 namespace renderscript {
 
     class MinMaxTask : public Task {
-        const uchar4 *mIn;
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
         const uint32_t mThreadCount;
-        std::vector<float> mTotals;
+        PerThread<float> mMins;
+        PerThread<float> mMaxes;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -22,15 +27,12 @@ namespace renderscript {
         MinMaxTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
                    uint32_t threadCount, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
                   mChannel{channel},
                   mThreadCount{threadCount},
-                  mTotals(2 * threadCount) {
-            for (uint32_t t = 0; t < mThreadCount; t++) {
-                mTotals[t * 2] = 255;
-                mTotals[t * 2 + 1] = 0;
-            }
-        }
+                  mMins(threadCount, 255),
+                  mMaxes(threadCount, 0) {}
 
         void collate(float *out);
     };
@@ -38,47 +40,38 @@ namespace renderscript {
     void
     MinMaxTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                             size_t endY) {
+        ReductionSums all;
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-            for (size_t x = startX; x < endX; x++) {
-                auto v = *in;
-                float value;
-                if (mChannel == 0) {
-                    value = v.r;
-                } else if (mChannel == 1) {
-                    value = v.g;
-                } else if (mChannel == 2) {
-                    value = v.b;
-                } else if (mChannel == 3) {
-                    value = v.a;
-                } else {
-                    value = (float) ((v.r + v.g + v.b) / 3.0);
-                }
-
-                if (value < mTotals[threadIndex * 2]) {
-                    mTotals[threadIndex * 2] = value;
-                }
-
-                if (value > mTotals[threadIndex * 2 + 1]) {
-                    mTotals[threadIndex * 2 + 1] = value;
-                }
-
-                in++;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerReductionRun) {
+                ReductionSums run;
+                reduceRun(in + x, std::min(endX - x, kMaxCellsPerReductionRun), mChannel,
+                          mUsesSimd, &run);
+                all.min = std::min(all.min, run.min);
+                all.max = std::max(all.max, run.max);
             }
         }
+        if (all.min > all.max) {
+            return;
+        }
+
+        // For gray, the values are r + g + b. Dividing them as floats gives the same value as
+        // dividing as doubles and then converting to a float.
+        const float scale = mChannel <= 3 ? 1.f : 3.f;
+        mMins[threadIndex] = std::min(mMins[threadIndex], all.min / scale);
+        mMaxes[threadIndex] = std::max(mMaxes[threadIndex], all.max / scale);
     }
 
     void MinMaxTask::collate(float *out) {
         float min = 255;
         float max = 0;
         for (uint32_t t = 0; t < mThreadCount; t++) {
-            if (mTotals[t * 2] < min) {
-                min = mTotals[t * 2];
+            if (mMins[t] < min) {
+                min = mMins[t];
             }
 
-            if (mTotals[t * 2 + 1] > max) {
-                max = mTotals[t * 2 + 1];
+            if (mMaxes[t] > max) {
+                max = mMaxes[t];
             }
         }
         out[0] = min;
@@ -89,7 +82,7 @@ namespace renderscript {
                                      size_t sizeY, uint8_t channel,
                                      const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
             return;
         }
 #endif
@@ -99,4 +92,87 @@ namespace renderscript {
         task.collate(output);
     }
 
+    class FloatMinMaxTask : public Task {
+        const float *mIn;
+        const size_t mInStride;
+        const uint8_t mChannel;
+        const uint32_t mThreadCount;
+        PerThread<float> mMins;
+        PerThread<float> mMaxes;
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        FloatMinMaxTask(const float *input, size_t sizeX, size_t sizeY, size_t vectorSize,
+                        uint8_t channel, uint32_t threadCount, const Restriction *restriction)
+                : Task{sizeX, sizeY, vectorSize, true, restriction},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * vectorSize * sizeof(float))},
+                  mChannel{channel},
+                  mThreadCount{threadCount},
+                  mMins(threadCount, INFINITY),
+                  mMaxes(threadCount, -INFINITY) {
+            setElementSize(sizeof(float));
+        }
+
+        void collate(float *out);
+    };
+
+    void
+    FloatMinMaxTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                 size_t endY) {
+        FloatReductionSums all;
+        for (size_t y = startY; y < endY; y++) {
+            const float *in = reinterpret_cast<const float *>(
+                    reinterpret_cast<const uint8_t *>(mIn) + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerFloatReductionRun) {
+                FloatReductionSums run;
+                reduceRun(in + x * mVectorSize,
+                          std::min(endX - x, kMaxCellsPerFloatReductionRun), mVectorSize,
+                          mChannel, 0.f, &run);
+                all.min = std::min(all.min, run.min);
+                all.max = std::max(all.max, run.max);
+            }
+        }
+        mMins[threadIndex] = std::min(mMins[threadIndex], all.min);
+        mMaxes[threadIndex] = std::max(mMaxes[threadIndex], all.max);
+    }
+
+    void FloatMinMaxTask::collate(float *out) {
+        float min = INFINITY;
+        float max = -INFINITY;
+        for (uint32_t t = 0; t < mThreadCount; t++) {
+            min = std::min(min, mMins[t]);
+            max = std::max(max, mMaxes[t]);
+        }
+        // Only NaN cells.
+        if (min > max) {
+            min = max = NAN;
+        }
+        out[0] = min;
+        out[1] = max;
+    }
+
+    void RenderScriptToolkit::minMax(const float *input, float *output, size_t sizeX,
+                                     size_t sizeY, size_t vectorSize, uint8_t channel,
+                                     const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                              sizeX * vectorSize * sizeof(float), 0)) {
+            return;
+        }
+        if (vectorSize < 1 || vectorSize > 4) {
+            ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+            return;
+        }
+#endif
+
+        FloatMinMaxTask task(input, sizeX, sizeY, vectorSize, channel,
+                             processor->getNumberOfThreads(), restriction);
+        processor->doTask(&task);
+        task.collate(output);
+    }
+
 }  // namespace renderscript
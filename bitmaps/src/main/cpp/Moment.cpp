@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstdint>
 
+#include "Reduction.h"
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
 #include "Utils.h"
@@ -9,10 +11,16 @@
 namespace renderscript {
 
     class MomentTask : public Task {
-        const uchar4 *mIn;
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
         const uint32_t mThreadCount;
-        std::vector<double> mTotals;
+        struct Totals {
+            double momentX = 0;
+            double momentY = 0;
+            double total = 0;
+        };
+        PerThread<Totals> mTotals;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -22,10 +30,11 @@ namespace renderscript {
         MomentTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
                    uint32_t threadCount, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, false, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
                   mChannel{channel},
                   mThreadCount{threadCount},
-                  mTotals(3 * threadCount) {}
+                  mTotals(threadCount) {}
 
         void collate(float *out);
     };
@@ -33,32 +42,32 @@ namespace renderscript {
     void
     MomentTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                             size_t endY) {
+        double momentX = 0;
+        double momentY = 0;
+        uint64_t total = 0;
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-
-            for (size_t x = startX; x < endX; x++) {
-                auto v = *in;
-                double value;
-                if (mChannel == 0) {
-                    value = v.r;
-                } else if (mChannel == 1) {
-                    value = v.g;
-                } else if (mChannel == 2) {
-                    value = v.b;
-                } else if (mChannel == 3) {
-                    value = v.a;
-                } else {
-                    value = (v.r + v.g + v.b) / 3.0;
-                }
-
-                mTotals[threadIndex * 3] += x * value;
-                mTotals[threadIndex * 3 + 1] += y * value;
-                mTotals[threadIndex * 3 + 2] += value;
-
-                in++;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            uint64_t rowMomentX = 0;
+            uint64_t rowTotal = 0;
+            for (size_t x = startX; x < endX; x += kMaxCellsPerReductionRun) {
+                ReductionSums run;
+                reduceRun(in + x, std::min(endX - x, kMaxCellsPerReductionRun), mChannel,
+                          mUsesSimd, &run);
+                // The run's x are relative to its start.
+                rowMomentX += run.sumOfXTimesValue + (uint64_t) x * run.sum;
+                rowTotal += run.sum;
             }
+            momentX += rowMomentX;
+            momentY += (double) y * rowTotal;
+            total += rowTotal;
         }
+
+        // For gray, the values are r + g + b, three times the gray values, which cancels out in
+        // collate.
+        Totals &totals = mTotals[threadIndex];
+        totals.momentX += momentX;
+        totals.momentY += momentY;
+        totals.total += total;
     }
 
     void MomentTask::collate(float *out) {
@@ -66,9 +75,9 @@ namespace renderscript {
         double momentY = 0;
         double total = 0;
         for (uint32_t t = 0; t < mThreadCount; t++) {
-            momentX += mTotals[t * 3];
-            momentY += mTotals[t * 3 + 1];
-            total += mTotals[t * 3 + 2];
+            momentX += mTotals[t].momentX;
+            momentY += mTotals[t].momentY;
+            total += mTotals[t].total;
         }
 
         if (total == 0) {
@@ -87,7 +96,7 @@ namespace renderscript {
                                      size_t sizeY, uint8_t channel,
                                      const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
             return;
         }
 #endif
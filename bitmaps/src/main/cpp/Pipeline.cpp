@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "ColorMatrix.h"
+#include "RenderScriptToolkit.h"
+#include "TaskProcessor.h"
+#include "Utils.h"
+
+#define LOG_TAG "renderscript.toolkit.Pipeline"
+
+namespace renderscript {
+
+extern "C" void rsdIntrinsicConvolve3x3_K(void* dst, const void* y0, const void* y1, const void* y2,
+                                          const int16_t* coef, uint32_t count);
+extern "C" void rsdIntrinsicConvolve5x5_K(void* dst, const void* y0, const void* y1, const void* y2,
+                                          const void* y3, const void* y4, const int16_t* coef,
+                                          uint32_t count);
+
+using Stage = RenderScriptToolkit::PipelineStage;
+
+namespace {
+
+/**
+ * A rectangle of cells of the image, [startX, endX) x [startY, endY), and where its cells are
+ * stored. Cell (x, y) is at data[(y - startY) * stride + x - startX].
+ */
+struct Region {
+    size_t startX;
+    size_t startY;
+    size_t endX;
+    size_t endY;
+    uchar4* data;
+    size_t stride;
+
+    uchar4* at(size_t x, size_t y) const { return data + (y - startY) * stride + x - startX; }
+};
+
+/**
+ * The number of neighboring cells a stage reads on each side.
+ */
+size_t stageRadius(const Stage& stage) {
+    switch (stage.type) {
+        case Stage::Type::CONVOLVE_3X3:
+            return 1;
+        case Stage::Type::CONVOLVE_5X5:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+}  // namespace
+
+class PipelineTask : public Task {
+    const uchar4* mIn;
+    uchar4* mOut;
+    /**
+     * The number of cells between the starts of two rows of mIn and of mOut.
+     */
+    const size_t mInStride;
+    const size_t mOutStride;
+    const Stage* mStages;
+    size_t mStageCount;
+    /**
+     * For each stage, the margin around the tile its output must cover so that the following
+     * stages have all the neighbors they read. Borrowed from the scratch arena of the calling
+     * thread, like the kernels.
+     */
+    size_t* mMargins;
+    /**
+     * The SIMD kernels of the color matrix stages, null for the other stages.
+     */
+    ColorMatrixKernel** mColorMatrixKernels;
+    /**
+     * If not null, where the histogram of the result goes. mSums has 256 * 4 counts per thread,
+     * borrowed from the scratch arena of the calling thread.
+     */
+    int32_t* mHistogram;
+    int32_t* mSums = nullptr;
+    const uint32_t mThreadCount;
+
+    void colorMatrix(const Stage& stage, const ColorMatrixKernel& kernel, const Region& in,
+                     const Region& out);
+    void convolve(const Stage& stage, size_t radius, const Region& in, const Region& out);
+    void lut(const Stage& stage, const Region& in, const Region& out);
+    void threshold(const Stage& stage, const Region& in, const Region& out);
+    void accumulateHistogram(int threadIndex, const Region& region);
+
+    // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+    void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override;
+
+   public:
+    PipelineTask(const uint8_t* in, uint8_t* out, size_t sizeX, size_t sizeY, const Stage* stages,
+                 size_t stageCount, int32_t* histogram, uint32_t threadCount,
+                 ScratchArena& scratch, const Restriction* restriction)
+        : Task{sizeX, sizeY, 4, false, restriction},
+          mIn{reinterpret_cast<const uchar4*>(in)},
+          mOut{reinterpret_cast<uchar4*>(out)},
+          mInStride{inputStride(sizeX * sizeof(uchar4)) / sizeof(uchar4)},
+          mOutStride{outputStride(sizeX * sizeof(uchar4)) / sizeof(uchar4)},
+          mStages{stages},
+          mStageCount{stageCount},
+          mMargins{scratch.allocate<size_t>(stageCount)},
+          mColorMatrixKernels{scratch.allocate<ColorMatrixKernel*>(stageCount)},
+          mHistogram{histogram},
+          mThreadCount{threadCount} {
+        if (histogram != nullptr) {
+            mSums = scratch.allocate<int32_t>(256 * 4 * threadCount);
+            std::fill_n(mSums, 256 * 4 * threadCount, 0);
+        }
+        size_t margin = 0;
+        for (size_t i = stageCount; i-- > 0;) {
+            mMargins[i] = margin;
+            margin += stageRadius(stages[i]);
+            mColorMatrixKernels[i] = nullptr;
+            if (stages[i].type == Stage::Type::COLOR_MATRIX) {
+                mColorMatrixKernels[i] = new (scratch.allocate<ColorMatrixKernel>(1))
+                        ColorMatrixKernel(stages[i].coefficients, stages[i].addVector, scratch);
+            }
+        }
+        // With tiles of 8 times the total margin, the extra rows processed stay below 25%.
+        if (margin > 0) {
+            setMinRowsPerTile(8 * margin);
+            setReach(margin);
+        }
+    }
+
+    ~PipelineTask() {
+        for (size_t i = 0; i < mStageCount; i++) {
+            if (mColorMatrixKernels[i] != nullptr) {
+                mColorMatrixKernels[i]->~ColorMatrixKernel();
+            }
+        }
+    }
+
+    void collateSums();
+};
+
+void PipelineTask::colorMatrix(const Stage& stage, const ColorMatrixKernel& kernel,
+                               const Region& in, const Region& out) {
+    if (mUsesSimd) {
+        for (size_t y = out.startY; y < out.endY; y++) {
+            kernel.run(reinterpret_cast<uint8_t*>(out.at(out.startX, y)),
+                       reinterpret_cast<const uint8_t*>(in.at(out.startX, y)),
+                       out.endX - out.startX);
+        }
+        return;
+    }
+
+    static const float fourZeroes[]{0.0f, 0.0f, 0.0f, 0.0f};
+    // Copied so that the compiler knows the writes to the output don't change them.
+    float m[16];
+    memcpy(m, stage.coefficients, sizeof(m));
+    const float* add = stage.addVector != nullptr ? stage.addVector : fourZeroes;
+    // Like the scalar path of colorMatrix, the add vector is scaled to 0-255 and the result is
+    // truncated.
+    const float4 addScaled = {add[0] * 255.f, add[1] * 255.f, add[2] * 255.f, add[3] * 255.f};
+    for (size_t y = out.startY; y < out.endY; y++) {
+        const uchar4* pin = in.at(out.startX, y);
+        uchar4* pout = out.at(out.startX, y);
+        for (size_t x = out.startX; x < out.endX; x++) {
+            float4 f = convert<float4>(*pin++);
+            float4 sum;
+            sum.x = f.x * m[0] + f.y * m[4] + f.z * m[8] + f.w * m[12];
+            sum.y = f.x * m[1] + f.y * m[5] + f.z * m[9] + f.w * m[13];
+            sum.z = f.x * m[2] + f.y * m[6] + f.z * m[10] + f.w * m[14];
+            sum.w = f.x * m[3] + f.y * m[7] + f.z * m[11] + f.w * m[15];
+            sum += addScaled;
+            *pout++ = convert<uchar4>(clamp(sum, 0.f, 255.f));
+        }
+    }
+}
+
+/**
+ * Convolves the cells [startX, endX) of one row. py points to the rows to read, with py[dy][i]
+ * the cell at column originX + i of the row dy - radius away. Like convolve3x3 and convolve5x5,
+ * the edges of the image are extended.
+ */
+static void convolveRowScalar(uchar4* out, size_t startX, size_t endX, const uchar4* const* py,
+                              size_t originX, int radius, const float* coeff, int sizeX) {
+    const int size = 2 * radius + 1;
+    for (size_t x = startX; x < endX; x++) {
+        float4 sum = 0.f;
+        for (int dy = 0; dy < size; dy++) {
+            for (int dx = 0; dx < size; dx++) {
+                int sx = clamp((int)x + dx - radius, 0, sizeX - 1);
+                sum += convert<float4>(py[dy][sx - originX]) * coeff[dy * size + dx];
+            }
+        }
+        *out++ = convert<uchar4>(clamp(sum + 0.5f, 0.f, 255.f));
+    }
+}
+
+void PipelineTask::convolve(const Stage& stage, size_t radius, const Region& in,
+                            const Region& out) {
+    const int size = 2 * radius + 1;
+    float fp[25];
+    memcpy(fp, stage.coefficients, size * size * sizeof(float));
+#if defined(ARCH_ARM_USE_INTRINSICS) || defined(ARCH_X86_HAVE_SSSE3)
+    // The fixed point coefficients of the SIMD kernels, padded like in Convolve3x3Task and
+    // Convolve5x5Task.
+    int16_t ip[28] = {};
+    for (int i = 0; i < size * size; i++) {
+        ip[i] = (int16_t)(fp[i] * 256.f + (fp[i] >= 0 ? 0.5f : -0.5f));
+    }
+#endif
+
+    // The cells whose neighbors are all in the image, so that no edge needs to be extended.
+    const size_t interiorStart = std::min(std::max(out.startX, radius), out.endX);
+    for (size_t y = out.startY; y < out.endY; y++) {
+        const uchar4* py[5];
+        for (int dy = 0; dy < size; dy++) {
+            size_t row = clamp((int)(y + dy) - (int)radius, 0, (int)mSizeY - 1);
+            py[dy] = in.at(in.startX, row);
+        }
+        uchar4* pout = out.at(out.startX, y);
+        size_t x1 = interiorStart;
+        convolveRowScalar(pout, out.startX, x1, py, in.startX, radius, fp, mSizeX);
+        pout += x1 - out.startX;
+
+#if defined(ARCH_ARM_USE_INTRINSICS) || defined(ARCH_X86_HAVE_SSSE3)
+        if (mUsesSimd) {
+            // Call the kernels with the same bounds as Convolve3x3Task and Convolve5x5Task would,
+            // if the row ended right after the neighbors of the last interior cell, so that they
+            // don't read past the cells the previous stage computed.
+            const size_t interiorEnd = std::max(
+                    std::min(out.endX, mSizeX > radius ? mSizeX - radius : 0), interiorStart);
+            const size_t x2 = interiorEnd + radius;
+            // The offset in py of the leftmost cell the kernels read.
+            const size_t first = x1 - radius - in.startX;
+            size_t done = 0;
+            if (radius == 1) {
+                size_t len = x2 > x1 + 1 ? (x2 - x1 - 1) >> 1 : 0;
+                if (len > 0) {
+                    rsdIntrinsicConvolve3x3_K(pout, py[0] + first, py[1] + first, py[2] + first, ip,
+                                              len);
+                    done = len << 1;
+                }
+            } else {
+#if defined(ARCH_X86_HAVE_SSSE3)
+                if (x1 + 6 < x2) {
+                    size_t len = (x2 - x1 - 3) >> 2;
+                    rsdIntrinsicConvolve5x5_K(pout, py[0] + first, py[1] + first, py[2] + first,
+                                              py[3] + first, py[4] + first, ip, len);
+                    done = len << 2;
+                }
+#else
+                if (x1 + 3 < x2) {
+                    size_t len = (x2 - x1 - 3) >> 1;
+                    rsdIntrinsicConvolve5x5_K(pout, py[0] + first, py[1] + first, py[2] + first,
+                                              py[3] + first, py[4] + first, ip, len);
+                    done = len << 1;
+                }
+#endif
+            }
+            x1 += done;
+            pout += done;
+        }
+#endif
+
+        convolveRowScalar(pout, x1, out.endX, py, in.startX, radius, fp, mSizeX);
+    }
+}
+
+void PipelineTask::lut(const Stage& stage, const Region& in, const Region& out) {
+    const uint8_t* const* tables = stage.tables;
+    for (size_t y = out.startY; y < out.endY; y++) {
+        const uchar4* pin = in.at(out.startX, y);
+        uchar4* pout = out.at(out.startX, y);
+        for (size_t x = out.startX; x < out.endX; x++) {
+            uchar4 v = *pin++;
+            *pout++ = uchar4{tables[0][v.x], tables[1][v.y], tables[2][v.z], tables[3][v.w]};
+        }
+    }
+}
+
+void PipelineTask::threshold(const Stage& stage, const Region& in, const Region& out) {
+    const uint8_t channel = stage.channel;
+    // The values compared are the channel, or the sum of red, green, and blue divided by 3. Find
+    // the smallest one above the threshold once, so that each cell needs only an integer compare.
+    const int maxValue = channel <= 3 ? 255 : 255 * 3;
+    const double divisor = channel <= 3 ? 1.0 : 3.0;
+    int above = 0;
+    while (above <= maxValue && !(above / divisor > stage.thresholdValue)) {
+        above++;
+    }
+    const bool binary = stage.binary;
+    for (size_t y = out.startY; y < out.endY; y++) {
+        const uchar* pin = reinterpret_cast<const uchar*>(in.at(out.startX, y));
+        uchar* pout = reinterpret_cast<uchar*>(out.at(out.startX, y));
+        const size_t count = out.endX - out.startX;
+        if (channel > 3) {
+            for (size_t x = 0; x < count; x++, pin += 4, pout += 4) {
+                int value = pin[0] + pin[1] + pin[2];
+                uchar replacement = value >= above ? 255 : 0;
+                bool keep = value >= above && !binary;
+                pout[0] = keep ? pin[0] : replacement;
+                pout[1] = keep ? pin[1] : replacement;
+                pout[2] = keep ? pin[2] : replacement;
+                pout[3] = pin[3];
+            }
+        } else {
+            if (pout != pin) {
+                memcpy(pout, pin, count * 4);
+            }
+            for (size_t x = 0; x < count; x++, pout += 4) {
+                uchar& value = pout[channel];
+                if (value < above) {
+                    value = 0;
+                } else if (binary) {
+                    value = 255;
+                }
+            }
+        }
+    }
+}
+
+void PipelineTask::accumulateHistogram(int threadIndex, const Region& region) {
+    int32_t* sums = &mSums[256 * 4 * threadIndex];
+    for (size_t y = region.startY; y < region.endY; y++) {
+        const uchar4* p = region.at(region.startX, y);
+        for (size_t x = region.startX; x < region.endX; x++) {
+            uchar4 v = *p++;
+            sums[(v.x << 2)]++;
+            sums[(v.y << 2) + 1]++;
+            sums[(v.z << 2) + 2]++;
+            sums[(v.w << 2) + 3]++;
+        }
+    }
+}
+
+void PipelineTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                               size_t endY) {
+    // The source image is read in place.
+    Region in{0, 0, mSizeX, mSizeY, const_cast<uchar4*>(mIn), mInStride};
+    size_t largestMargin = mStageCount > 0 ? mMargins[0] : 0;
+    size_t scratchSize = (endX - startX + 2 * largestMargin) * (endY - startY + 2 * largestMargin);
+    // Two scratch buffers, used alternately as input and output of the stages.
+    uchar4* buffers[2] = {nullptr, nullptr};
+
+    for (size_t i = 0; i < mStageCount; i++) {
+        const Stage& stage = mStages[i];
+        const size_t margin = mMargins[i];
+        Region out{startX >= margin ? startX - margin : 0,
+                   startY >= margin ? startY - margin : 0,
+                   std::min(endX + margin, mSizeX),
+                   std::min(endY + margin, mSizeY),
+                   nullptr,
+                   0};
+        if (i == mStageCount - 1 && mOut != nullptr) {
+            // The last stage writes straight to the output.
+            out.data = mOut + out.startY * mOutStride + out.startX;
+            out.stride = mOutStride;
+        } else {
+            if (buffers[i % 2] == nullptr) {
+                buffers[i % 2] = scratch(threadIndex).allocate<uchar4>(scratchSize);
+            }
+            out.data = buffers[i % 2];
+            out.stride = out.endX - out.startX;
+        }
+
+        switch (stage.type) {
+            case Stage::Type::COLOR_MATRIX:
+                colorMatrix(stage, *mColorMatrixKernels[i], in, out);
+                break;
+            case Stage::Type::CONVOLVE_3X3:
+            case Stage::Type::CONVOLVE_5X5:
+                convolve(stage, stageRadius(stage), in, out);
+                break;
+            case Stage::Type::LUT:
+                lut(stage, in, out);
+                break;
+            case Stage::Type::THRESHOLD:
+                threshold(stage, in, out);
+                break;
+        }
+        in = out;
+    }
+
+    if (mStageCount == 0 && mOut != nullptr) {
+        for (size_t y = startY; y < endY; y++) {
+            memcpy(mOut + y * mOutStride + startX, mIn + y * mInStride + startX,
+                   (endX - startX) * sizeof(uchar4));
+        }
+    }
+    if (mHistogram != nullptr) {
+        Region tile = in;
+        tile.startX = startX;
+        tile.startY = startY;
+        tile.endX = endX;
+        tile.endY = endY;
+        tile.data = in.at(startX, startY);
+        accumulateHistogram(threadIndex, tile);
+    }
+}
+
+void PipelineTask::collateSums() {
+    for (size_t i = 0; i < 256 * 4; i++) {
+        int32_t sum = 0;
+        for (size_t t = 0; t < mThreadCount; t++) {
+            sum += mSums[t * 256 * 4 + i];
+        }
+        mHistogram[i] = sum;
+    }
+}
+
+void RenderScriptToolkit::pipeline(const uint8_t* in, uint8_t* out, size_t sizeX, size_t sizeY,
+                                   const PipelineStage* stages, size_t stageCount,
+                                   int32_t* histogram, const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4,
+                          out != nullptr ? sizeX * 4 : 0)) {
+        return;
+    }
+    if (out == nullptr && histogram == nullptr) {
+        ALOGE("The pipeline needs an output or a histogram.");
+        return;
+    }
+    for (size_t i = 0; i < stageCount; i++) {
+        if (stageRadius(stages[i]) > 0 && in == out) {
+            ALOGE("The pipeline can't be done in place, stage %zu is a convolution.", i);
+            return;
+        }
+    }
+#endif
+
+    ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+    PipelineTask task(in, out, sizeX, sizeY, stages, stageCount, histogram,
+                      processor->getNumberOfThreads(), TaskProcessor::callingThreadScratch(),
+                      restriction);
+    processor->doTask(&task);
+    if (histogram != nullptr) {
+        task.collateSums();
+    }
+}
+
+}  // namespace renderscript
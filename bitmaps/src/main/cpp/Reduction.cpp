@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Reduction.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace renderscript {
+
+#if defined(ARCH_X86_HAVE_SSSE3)
+extern void rsdIntrinsicReduce_K(void* sums, const void* in, uint32_t channel, uint32_t count4);
+#endif
+
+template <int kChannel>
+static inline uint32_t cellValue(uchar4 v) {
+    if constexpr (kChannel <= 3) {
+        return v[kChannel];
+    } else {
+        return v.r + v.g + v.b;
+    }
+}
+
+/**
+ * Reduces the cells [start, count) of the run. The channel is a template parameter so that the
+ * loop has no branch and the compiler can vectorize it. The sums are 32 bits, which the run
+ * length guarantees won't overflow.
+ */
+template <int kChannel>
+static void reduceCells(const uchar4* in, size_t start, size_t count, ReductionSums* sums) {
+    uint32_t sum = 0;
+    uint32_t sumOfSquares = 0;
+    uint32_t sumOfXTimesValue = 0;
+    uint32_t min = sums->min;
+    uint32_t max = sums->max;
+    for (size_t x = start; x < count; x++) {
+        uint32_t value = cellValue<kChannel>(in[x]);
+        sum += value;
+        sumOfSquares += value * value;
+        sumOfXTimesValue += (uint32_t)x * value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    sums->sum += sum;
+    sums->sumOfSquares += sumOfSquares;
+    sums->sumOfXTimesValue += sumOfXTimesValue;
+    sums->min = min;
+    sums->max = max;
+}
+
+void reduceRun(const uchar4* in, size_t count, uint8_t channel, bool usesSimd,
+               ReductionSums* sums) {
+    size_t start = 0;
+#if defined(ARCH_X86_HAVE_SSSE3)
+    if (usesSimd && count >= 4) {
+        // The kernel processes 4 cells at a time. The leftovers are done below.
+        rsdIntrinsicReduce_K(sums, in, channel, count >> 2);
+        start = count & ~(size_t)3;
+    }
+#else
+    (void)usesSimd;
+#endif
+
+    switch (channel) {
+        case 0:
+            reduceCells<0>(in, start, count, sums);
+            break;
+        case 1:
+            reduceCells<1>(in, start, count, sums);
+            break;
+        case 2:
+            reduceCells<2>(in, start, count, sums);
+            break;
+        case 3:
+            reduceCells<3>(in, start, count, sums);
+            break;
+        default:
+            reduceCells<4>(in, start, count, sums);
+            break;
+    }
+}
+
+template <size_t N, int kChannel>
+static inline float floatCellValue(const float* cell) {
+    if constexpr (kChannel < (int)N) {
+        return cell[kChannel];
+    } else if constexpr (N == 1) {
+        return cell[0];
+    } else if constexpr (N == 2) {
+        return (cell[0] + cell[1]) / 2.f;
+    } else {
+        return (cell[0] + cell[1] + cell[2]) / 3.f;
+    }
+}
+
+/**
+ * Reduces a run of float cells. Four cells are summed at a time, one per lane of the float4
+ * sums. The NaN values are rare, so a group of four that has one is done one cell at a time.
+ */
+template <size_t N, int kChannel>
+static void reduceFloatCells(const float* in, size_t count, float center,
+                             FloatReductionSums* sums) {
+    float4 sum = 0.f;
+    float4 sumOfSquares = 0.f;
+    float4 min = INFINITY;
+    float4 max = -INFINITY;
+    size_t valid = 0;
+    float cellSum = 0.f;
+    float cellSumOfSquares = 0.f;
+    float cellMin = INFINITY;
+    float cellMax = -INFINITY;
+    auto addCell = [&](float value) {
+        if (std::isnan(value)) {
+            return;
+        }
+        const float difference = value - center;
+        cellSum += value;
+        cellSumOfSquares += difference * difference;
+        cellMin = std::min(cellMin, value);
+        cellMax = std::max(cellMax, value);
+        valid++;
+    };
+
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        const float* cell = in + x * N;
+        const float4 value{floatCellValue<N, kChannel>(cell),
+                           floatCellValue<N, kChannel>(cell + N),
+                           floatCellValue<N, kChannel>(cell + 2 * N),
+                           floatCellValue<N, kChannel>(cell + 3 * N)};
+        const int4 isNan = value != value;
+        if (isNan.x | isNan.y | isNan.z | isNan.w) {
+            for (int i = 0; i < 4; i++) {
+                addCell(value[i]);
+            }
+            continue;
+        }
+        const float4 difference = value - center;
+        sum += value;
+        sumOfSquares += difference * difference;
+        for (int i = 0; i < 4; i++) {
+            min[i] = std::min(min[i], value[i]);
+            max[i] = std::max(max[i], value[i]);
+        }
+        valid += 4;
+    }
+    for (; x < count; x++) {
+        addCell(floatCellValue<N, kChannel>(in + x * N));
+    }
+
+    sums->count += valid;
+    sums->sum += (double)sum.x + sum.y + sum.z + sum.w + cellSum;
+    sums->sumOfSquares += (double)sumOfSquares.x + sumOfSquares.y + sumOfSquares.z +
+                          sumOfSquares.w + cellSumOfSquares;
+    sums->min = std::min({sums->min, min.x, min.y, min.z, min.w, cellMin});
+    sums->max = std::max({sums->max, max.x, max.y, max.z, max.w, cellMax});
+}
+
+template <size_t N>
+static void reduceFloatRun(const float* in, size_t count, uint8_t channel, float center,
+                           FloatReductionSums* sums) {
+    // The channels past the cell are gray.
+    switch (channel < N ? channel : 4) {
+        case 0:
+            reduceFloatCells<N, 0>(in, count, center, sums);
+            break;
+        case 1:
+            reduceFloatCells<N, 1>(in, count, center, sums);
+            break;
+        case 2:
+            reduceFloatCells<N, 2>(in, count, center, sums);
+            break;
+        case 3:
+            reduceFloatCells<N, 3>(in, count, center, sums);
+            break;
+        default:
+            reduceFloatCells<N, 4>(in, count, center, sums);
+            break;
+    }
+}
+
+void reduceRun(const float* in, size_t count, size_t vectorSize, uint8_t channel, float center,
+               FloatReductionSums* sums) {
+    switch (vectorSize) {
+        case 1:
+            reduceFloatRun<1>(in, count, channel, center, sums);
+            break;
+        case 2:
+            reduceFloatRun<2>(in, count, channel, center, sums);
+            break;
+        case 3:
+            reduceFloatRun<3>(in, count, channel, center, sums);
+            break;
+        case 4:
+            reduceFloatRun<4>(in, count, channel, center, sums);
+            break;
+    }
+}
+
+}  // namespace renderscript
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_RENDERSCRIPT_TOOLKIT_REDUCTION_H
+#define ANDROID_RENDERSCRIPT_TOOLKIT_REDUCTION_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Utils.h"
+
+namespace renderscript {
+
+/**
+ * The largest number of cells reduceRun accepts. It keeps every sum of a run within 32 bits.
+ */
+constexpr size_t kMaxCellsPerReductionRun = 2048;
+
+/**
+ * The sums of a run of cells of one row, for the reduction ops like average and minMax.
+ *
+ * The value of a cell is the selected channel, or r + g + b for gray, i.e. three times the gray
+ * value so that it stays an integer. The x used for sumOfXTimesValue is relative to the start
+ * of the run.
+ *
+ * The layout is read by the SIMD kernels.
+ */
+struct ReductionSums {
+    uint32_t sum = 0;
+    uint32_t sumOfSquares = 0;
+    uint32_t sumOfXTimesValue = 0;
+    uint32_t min = 255 * 3;
+    uint32_t max = 0;
+};
+
+/**
+ * Sums a run of at most kMaxCellsPerReductionRun cells into sums.
+ *
+ * @param in The first cell of the run.
+ * @param count The number of cells.
+ * @param channel The channel to reduce (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+ * @param usesSimd Whether the SIMD kernel can be used.
+ * @param sums The sums, which should be freshly constructed.
+ */
+void reduceRun(const uchar4* in, size_t count, uint8_t channel, bool usesSimd,
+               ReductionSums* sums);
+
+/**
+ * The largest number of cells the float reduceRun accepts. A run is summed in floats, which
+ * would lose precision over longer runs, then added to the doubles of FloatReductionSums.
+ */
+constexpr size_t kMaxCellsPerFloatReductionRun = 1024;
+
+/**
+ * The sums of a run of cells of packed floats, for the float reduction ops.
+ *
+ * The value of a cell is the selected channel, or for gray, the mean of the first three channels,
+ * or of all of them when there are fewer. The cells whose value is NaN are skipped. count is the
+ * number of the other ones, and sumOfSquares the sum of their squared differences from the
+ * center given to reduceRun.
+ */
+struct FloatReductionSums {
+    size_t count = 0;
+    double sum = 0;
+    double sumOfSquares = 0;
+    float min = INFINITY;
+    float max = -INFINITY;
+};
+
+/**
+ * Sums a run of at most kMaxCellsPerFloatReductionRun cells of vectorSize floats into sums.
+ *
+ * @param in The first cell of the run.
+ * @param count The number of cells.
+ * @param vectorSize The number of floats of a cell, from 1 to 4.
+ * @param channel The channel to reduce (0 to vectorSize - 1, anything else = Gray).
+ * @param center The value sumOfSquares measures the differences from.
+ * @param sums The sums, which should be freshly constructed.
+ */
+void reduceRun(const float* in, size_t count, size_t vectorSize, uint8_t channel, float center,
+               FloatReductionSums* sums);
+
+}  // namespace renderscript
+
+#endif  // ANDROID_RENDERSCRIPT_TOOLKIT_REDUCTION_H
@@ -16,7 +16,13 @@
 
 #include "RenderScriptToolkit.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <vector>
+
 #include "TaskProcessor.h"
+#include "Utils.h"
 
 #define LOG_TAG "renderscript.toolkit.RenderScriptToolkit"
 
@@ -31,6 +37,174 @@ RenderScriptToolkit::RenderScriptToolkit(int numberOfThreads)
 RenderScriptToolkit::~RenderScriptToolkit() {
     // By defining the destructor here, we don't need to include TaskProcessor.h
     // in RenderScriptToolkit.h.
+
+    // The jobs of runAsync call back into this instance, so they must complete while the
+    // processor is still reachable.
+    processor->waitForPostedJobs();
+}
+
+void RenderScriptToolkit::setCallingThreadPriority(Priority priority) {
+    TaskProcessor::setCallingThreadPriority(static_cast<int>(priority));
+}
+
+std::future<void> RenderScriptToolkit::runAsync(std::function<void(RenderScriptToolkit&)> calls) {
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> future = done->get_future();
+    runAsync(std::move(calls), [done]() { done->set_value(); });
+    return future;
+}
+
+void RenderScriptToolkit::runAsync(std::function<void(RenderScriptToolkit&)> calls,
+                                   std::function<void()> onComplete) {
+    processor->post([this, calls = std::move(calls), onComplete = std::move(onComplete)]() {
+        calls(*this);
+        onComplete();
+    });
+}
+
+namespace {
+
+/**
+ * The size of the synthetic image calibrateTiling() runs the ops on. At 1.2 MB, it doesn't fit
+ * the L2 cache of most mobile CPUs, like the images the Toolkit is typically used on.
+ */
+constexpr size_t kCalibrationSizeX = 640;
+constexpr size_t kCalibrationSizeY = 480;
+
+/**
+ * Runs a typical op of the group on the RGBA image in. out has room for an RGBA image of the
+ * same size.
+ */
+void runCalibrationOp(RenderScriptToolkit& toolkit, RenderScriptToolkit::TilingGroup group,
+                      const uint8_t* in, uint8_t* out, const uint8_t* table) {
+    using TilingGroup = RenderScriptToolkit::TilingGroup;
+    static const float kGrayMatrix[16] = {0.299f, 0.299f, 0.299f, 0.f, 0.587f, 0.587f,
+                                          0.587f, 0.f,    0.114f, 0.114f, 0.114f, 0.f,
+                                          0.f,    0.f,    0.f,    1.f};
+    static const float kBoxKernel[25] = {0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f,
+                                         0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f,
+                                         0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f, 0.04f,
+                                         0.04f, 0.04f, 0.04f, 0.04f};
+    switch (group) {
+        case TilingGroup::OTHER:
+            toolkit.blend(RenderScriptToolkit::BlendingMode::SRC_OVER, in, out, kCalibrationSizeX,
+                          kCalibrationSizeY);
+            break;
+        case TilingGroup::LUT:
+            toolkit.lut(in, out, kCalibrationSizeX, kCalibrationSizeY, table, table, table, table);
+            break;
+        case TilingGroup::COLOR_MATRIX:
+            toolkit.colorMatrix(in, out, 4, 4, kCalibrationSizeX, kCalibrationSizeY, kGrayMatrix);
+            break;
+        case TilingGroup::BLUR:
+            toolkit.blur(in, out, kCalibrationSizeX, kCalibrationSizeY, 4, 8);
+            break;
+        case TilingGroup::CONVOLVE:
+            toolkit.convolve5x5(in, out, 4, kCalibrationSizeX, kCalibrationSizeY, kBoxKernel);
+            break;
+        case TilingGroup::RESIZE:
+            // Enlarges two thirds of the image to the full size.
+            toolkit.resize(in, out, kCalibrationSizeX * 2 / 3, kCalibrationSizeY * 2 / 3, 4,
+                           kCalibrationSizeX, kCalibrationSizeY);
+            break;
+        case TilingGroup::XBR:
+            toolkit.xbr2x(in, out, kCalibrationSizeX / 2, kCalibrationSizeY / 2);
+            break;
+    }
+}
+
+}  // namespace
+
+void RenderScriptToolkit::calibrateTiling() {
+    using Clock = std::chrono::steady_clock;
+    // The runs timed per candidate, after one to warm up the caches. The fastest is kept, as
+    // the others were slowed down by something else.
+    constexpr int kTimedRuns = 2;
+    // A candidate replaces the current target only if it's that much faster, so that noise
+    // doesn't move the targets around.
+    constexpr double kMinGain = 0.97;
+
+    size_t l1Size;
+    size_t l2Size;
+    cpuDataCacheSizes(&l1Size, &l2Size);
+    // Which fraction of the caches a tile should fill depends on how the op reuses what it
+    // reads, and on what else shares them, hence the measures.
+    std::vector<uint32_t> candidates{static_cast<uint32_t>(l1Size / 2),
+                                     static_cast<uint32_t>(l1Size),
+                                     static_cast<uint32_t>(2 * l1Size),
+                                     static_cast<uint32_t>(l2Size / 4),
+                                     static_cast<uint32_t>(l2Size / 2)};
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    const size_t size = kCalibrationSizeX * kCalibrationSizeY * 4;
+    std::vector<uint8_t> in(size);
+    std::vector<uint8_t> out(size);
+    // Noise rather than a flat color, so that the ops can't take shortcuts.
+    uint32_t seed = 1;
+    for (uint8_t& value : in) {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(seed >> 24);
+    }
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++) {
+        table[i] = static_cast<uint8_t>(255 - i);
+    }
+
+    for (size_t g = 0; g < kTilingGroupCount; g++) {
+        const auto group = static_cast<TilingGroup>(g);
+        auto timeOp = [&](uint32_t target) {
+            processor->setTilingTarget(group, target);
+            runCalibrationOp(*this, group, in.data(), out.data(), table);
+            auto best = Clock::duration::max();
+            for (int run = 0; run < kTimedRuns; run++) {
+                const auto start = Clock::now();
+                runCalibrationOp(*this, group, in.data(), out.data(), table);
+                best = std::min(best, Clock::now() - start);
+            }
+            return std::chrono::duration<double>(best).count();
+        };
+
+        uint32_t bestTarget = processor->getTilingTarget(group);
+        double bestTime = timeOp(bestTarget);
+        for (uint32_t target : candidates) {
+            if (target == bestTarget) {
+                continue;
+            }
+            const double time = timeOp(target);
+            if (time < bestTime * kMinGain) {
+                bestTarget = target;
+                bestTime = time;
+            }
+        }
+        processor->setTilingTarget(group, bestTarget);
+    }
+}
+
+size_t RenderScriptToolkit::getTilingTarget(TilingGroup group) const {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (static_cast<size_t>(group) >= kTilingGroupCount) {
+        ALOGE("Unknown tiling group %d.", static_cast<int>(group));
+        return 0;
+    }
+#endif
+    return processor->getTilingTarget(group);
+}
+
+void RenderScriptToolkit::setTilingTarget(TilingGroup group, size_t bytes) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (static_cast<size_t>(group) >= kTilingGroupCount) {
+        ALOGE("Unknown tiling group %d.", static_cast<int>(group));
+        return;
+    }
+#endif
+    processor->setTilingTarget(group, static_cast<uint32_t>(std::min<size_t>(bytes, UINT_MAX)));
+}
+
+void RenderScriptToolkit::trimScratch() { processor->trimScratch(); }
+
+int RenderScriptToolkit::getNumberOfThreads() const {
+    return static_cast<int>(processor->getNumberOfThreads());
 }
 
 }  // namespace renderscript
@@ -18,6 +18,8 @@
 #define ANDROID_RENDERSCRIPT_TOOLKIT_TOOLKIT_H
 
 #include <cstdint>
+#include <functional>
+#include <future>
 #include <memory>
 
 namespace renderscript {
@@ -34,12 +36,22 @@ namespace renderscript {
  * @property endX The index after the last value to be included on the X axis.
  * @property startY The index of the first value to be included on the Y axis.
  * @property endY The index after the last value to be included on the Y axis.
+ * @property inputStride The number of bytes from the start of a row of the input to the start of
+ * the next, for padded buffers. 0 means the rows are packed.
+ * @property outputStride The same for the output.
+ *
+ * The strides let an op work in place on buffers whose rows are padded, e.g. hardware-aligned
+ * bitmaps or camera planes. They should be multiples of the size of a cell. The rows of a padded
+ * buffer are not contiguous, so the op can't treat the data as one long row; with large tiles
+ * that costs little.
  */
     struct Restriction {
         size_t startX;
         size_t endX;
         size_t startY;
         size_t endY;
+        size_t inputStride = 0;
+        size_t outputStride = 0;
     };
 
 /**
@@ -58,8 +70,9 @@ namespace renderscript {
  * You can limit the number of pool threads used by the Toolkit via the constructor. The pool
  * threads are destroyed once the Toolkit is destroyed, after any pending work is done.
  *
- * This library is thread safe. You can call methods from different pool threads. The functions will
- * execute sequentially.
+ * This library is thread safe. You can call methods from different threads. The calls execute
+ * concurrently and share the pool threads. See setCallingThreadPriority() to favor the calls of
+ * a latency sensitive thread, e.g. one processing camera frames.
  *
  * A Java/Kotlin Toolkit is available. It calls this library through JNI.
  *
@@ -85,9 +98,126 @@ namespace renderscript {
          * other pool threads will return without having completed the work. Because of the undefined
          * state of the output buffers, an application should avoid destroying the Toolkit if other pool
          * threads are executing Toolkit methods.
+         *
+         * The calls passed to runAsync() are completed first.
          */
         ~RenderScriptToolkit();
 
+        /**
+         * The priority of the Toolkit calls made from a thread.
+         *
+         * When calls from several threads are in flight, the pool threads help the calls of
+         * highest priority first. A call always progresses on its calling thread, so calls of
+         * low priority are slowed down but never stalled.
+         */
+        enum class Priority {
+            BACKGROUND = -1,
+            NORMAL = 0,
+            URGENT = 1,
+        };
+
+        /**
+         * Sets the priority of the Toolkit calls made from the calling thread. It applies to
+         * all the Toolkit instances and lasts until changed. The default is NORMAL.
+         *
+         * @param priority The priority of the subsequent calls of this thread.
+         */
+        static void setCallingThreadPriority(Priority priority);
+
+        /**
+         * Makes Toolkit calls without blocking the calling thread.
+         *
+         * The calls are made from a pool thread, which processes their tiles as the calling
+         * thread would, helped by the other pool threads. Any Toolkit method can be called, e.g.
+         *    auto done = toolkit.runAsync([=](RenderScriptToolkit& t) {
+         *        t.blur(in, out, sizeX, sizeY, 4, 5);
+         *    });
+         *
+         * The buffers used by the calls must stay valid until they complete. The calls have the
+         * priority of the thread calling runAsync. Results, like the one of average(), can be
+         * captured by reference. If the Toolkit was created with a single thread, the calls
+         * are made before runAsync returns.
+         *
+         * @param calls The Toolkit calls to make.
+         * @return A future that's ready once the calls have completed.
+         */
+        std::future<void> runAsync(std::function<void(RenderScriptToolkit&)> calls);
+
+        /**
+         * Same as the variant above, but calls onComplete on the pool thread once the calls
+         * have completed, rather than returning a future.
+         *
+         * @param calls The Toolkit calls to make.
+         * @param onComplete Called once the calls have completed.
+         */
+        void runAsync(std::function<void(RenderScriptToolkit&)> calls,
+                      std::function<void()> onComplete);
+
+        /**
+         * The groups of ops whose work is tiled alike. The ops of a group touch memory in the
+         * same way, so the best size of their tiles depends on the caches of the CPU in the same
+         * way. See calibrateTiling().
+         */
+        enum class TilingGroup {
+            /** The ops not in another group, e.g. blend or histogram. */
+            OTHER = 0,
+            /** lut and lut3d. */
+            LUT = 1,
+            /** colorMatrix. */
+            COLOR_MATRIX = 2,
+            /** blur. */
+            BLUR = 3,
+            /** convolve, convolve3x3 and convolve5x5. */
+            CONVOLVE = 4,
+            /** resize. */
+            RESIZE = 5,
+            /** xbr and xbr2x. */
+            XBR = 6,
+        };
+
+        /** The number of values of TilingGroup. */
+        static constexpr size_t kTilingGroupCount = 7;
+
+        /**
+         * Measures, on the running CPU, how large the tiles of each TilingGroup should be, and
+         * uses the fastest size for the subsequent calls. Each group runs a typical op on a
+         * synthetic image once per candidate size, the candidates being derived from the sizes
+         * of the L1 and L2 data caches.
+         *
+         * It takes from a fraction of a second to a few seconds, which is best spent once, e.g.
+         * when the application is first run, keeping the result with getTilingTarget() and
+         * restoring it with setTilingTarget() afterwards. The measures are only meaningful when
+         * the Toolkit is otherwise idle. Until calibrated, every group uses a target of 32 KB,
+         * which gives the 16 KB tiles RenderScript used for most ops.
+         */
+        void calibrateTiling();
+
+        /**
+         * The working set, in bytes, that the tiles of the group are sized for, i.e. the memory
+         * a tile reads and writes. See calibrateTiling().
+         */
+        size_t getTilingTarget(TilingGroup group) const;
+
+        /**
+         * Sets the working set, in bytes, that the tiles of the group are sized for. Values
+         * below 2000 are treated as 2000. See calibrateTiling().
+         */
+        void setTilingTarget(TilingGroup group, size_t bytes);
+
+        /**
+         * Frees the temporary memory the threads keep from one call to the next, e.g. after
+         * processing a large image or when the application is asked to release memory. The
+         * calling thread frees its memory right away, the pool threads once they are idle.
+         * Without it, each thread keeps at most 16 MB.
+         */
+        void trimScratch();
+
+        /**
+         * The number of threads that process the calls, i.e. the calling thread and the pool
+         * threads.
+         */
+        int getNumberOfThreads() const;
+
         /**
          * Determines how a source buffer is blended into a destination buffer.
          *
@@ -198,9 +328,11 @@ namespace renderscript {
          * Performs a Gaussian blur of the input image and stores the result in the out buffer.
          *
          * The radius determines which pixels are used to compute each blurred pixels. This Toolkit
-         * accepts values between 1 and 25. Larger values create a more blurred effect but also
-         * take longer to compute. When the radius extends past the edge, the edge pixel will
-         * be used as replacement for the pixel that's out off boundary.
+         * accepts values between 1 and 1000. Larger values create a more blurred effect. Up to 25,
+         * the Gaussian is computed directly and takes longer as the radius grows. Above 25, it's
+         * approximated by three stacked box blurs whose cost doesn't depend on the radius, at the
+         * price of a temporary copy of the blurred area. When the radius extends past the edge,
+         * the edge pixel will be used as replacement for the pixel that's out off boundary.
          *
          * Each input pixel can either be represented by four bytes (RGBA format) or one byte
          * for the less common blurring of alpha channel only image.
@@ -224,6 +356,24 @@ namespace renderscript {
                   size_t vectorSize, int radius,
                   const Restriction *_Nullable restriction = nullptr);
 
+        /**
+         * Blur a float image.
+         *
+         * Like the blur of bytes, but for cells of 1 to 4 floats packed one after the other, like
+         * the data of a FloatBitmap. The values aren't clamped or rounded.
+         *
+         * @param in The buffer of the image to be blurred.
+         * @param out The buffer that receives the blurred image.
+         * @param sizeX The width of both buffers, as a number of cells.
+         * @param sizeY The height of both buffers, as a number of cells.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param radius The radius of the pixels used to blur, a value from 1 to 1000.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void blur(const float *_Nonnull in, float *_Nonnull out, size_t sizeX, size_t sizeY,
+                  size_t vectorSize, int radius,
+                  const Restriction *_Nullable restriction = nullptr);
+
         /**
          * Identity matrix that can be passed to the {@link RenderScriptToolkit::colorMatrix} method.
          *
@@ -318,6 +468,27 @@ namespace renderscript {
                          const float *_Nonnull matrix, const float *_Nullable addVector = nullptr,
                          const Restriction *_Nullable restriction = nullptr);
 
+        /**
+         * Transform a float image using a color matrix.
+         *
+         * Like the colorMatrix of bytes, but for cells of 1 to 4 floats packed one after the
+         * other. The values are neither scaled nor clamped: the output is matrix * in + addVector.
+         *
+         * @param in The buffer of the image to be converted.
+         * @param out The buffer that receives the converted image.
+         * @param inputVectorSize The number of floats in each input cell, a value from 1 to 4.
+         * @param outputVectorSize The number of floats in each output cell, a value from 1 to 4.
+         * @param sizeX The width of both buffers, as a number of cells.
+         * @param sizeY The height of both buffers, as a number of cells.
+         * @param matrix The 4x4 matrix to multiply, in row major format.
+         * @param addVector A vector of four floats that's added to the result of the multiplication.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void colorMatrix(const float *_Nonnull in, float *_Nonnull out, size_t inputVectorSize,
+                         size_t outputVectorSize, size_t sizeX, size_t sizeY,
+                         const float *_Nonnull matrix, const float *_Nullable addVector = nullptr,
+                         const Restriction *_Nullable restriction = nullptr);
+
         /**
          * Convolve a ByteArray.
          *
@@ -357,6 +528,74 @@ namespace renderscript {
                     size_t sizeY, const float *_Nonnull coefficients,
                     const Restriction *_Nullable restriction = nullptr);
 
+        /**
+         * How convolve() reads the cells past the edges of the image.
+         */
+        enum class BorderMode {
+            /** The edge cell is repeated: aaa|abcd|ddd. Like convolve3x3 and convolve5x5. */
+            CLAMP = 0,
+            /** The image is reflected, without repeating the edge cell: dcb|abcd|cba. */
+            MIRROR = 1,
+            /** The image is tiled: bcd|abcd|abc. */
+            WRAP = 2,
+            /** Zeros are read: 000|abcd|000. */
+            ZERO = 3,
+        };
+
+        /**
+         * Convolve with a kernel of any size.
+         *
+         * Like convolve3x3 and convolve5x5, but for a kernel of kernelSizeX by kernelSizeY
+         * coefficients, in row-major format. The kernel cell ((kernelSizeX - 1) / 2,
+         * (kernelSizeY - 1) / 2) is over the cell being computed.
+         *
+         * Separable kernels, i.e. the product of a column and a row vector like a Gaussian or a
+         * box, are detected and applied as two 1D passes in fixed point. Their cost grows with
+         * kernelSizeX + kernelSizeY rather than kernelSizeX * kernelSizeY. Separable kernels
+         * whose absolute values add up to 7 or more, and the kernels that aren't separable, are
+         * applied directly in floating point. 3x3 and 5x5 kernels with the CLAMP border mode use
+         * convolve3x3 and convolve5x5.
+         *
+         * @param in The buffer of the image to be convolved.
+         * @param out The buffer that receives the convolved image.
+         * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+         * @param sizeX The width of both buffers, as a number of 1 to 4 byte cells.
+         * @param sizeY The height of both buffers, as a number of 1 to 4 byte cells.
+         * @param coefficients kernelSizeX * kernelSizeY multipliers.
+         * @param kernelSizeX The width of the kernel.
+         * @param kernelSizeY The height of the kernel.
+         * @param borderMode How the cells past the edges are read.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void convolve(const void *_Nonnull in, void *_Nonnull out, size_t vectorSize, size_t sizeX,
+                      size_t sizeY, const float *_Nonnull coefficients, size_t kernelSizeX,
+                      size_t kernelSizeY, BorderMode borderMode = BorderMode::CLAMP,
+                      const Restriction *_Nullable restriction = nullptr);
+
+        /**
+         * Convolve a float image with a kernel of any size.
+         *
+         * Like the convolve of bytes, but for cells of 1 to 4 floats packed one after the other.
+         * Separable kernels are applied as two 1D passes whatever their sum, and the results
+         * aren't clamped or rounded.
+         *
+         * @param in The buffer of the image to be convolved.
+         * @param out The buffer that receives the convolved image.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param sizeX The width of both buffers, as a number of cells.
+         * @param sizeY The height of both buffers, as a number of cells.
+         * @param coefficients kernelSizeX * kernelSizeY multipliers.
+         * @param kernelSizeX The width of the kernel.
+         * @param kernelSizeY The height of the kernel.
+         * @param borderMode How the cells past the edges are read.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void convolve(const float *_Nonnull in, float *_Nonnull out, size_t vectorSize,
+                      size_t sizeX, size_t sizeY, const float *_Nonnull coefficients,
+                      size_t kernelSizeX, size_t kernelSizeY,
+                      BorderMode borderMode = BorderMode::CLAMP,
+                      const Restriction *_Nullable restriction = nullptr);
+
         /**
          * Compute the histogram of an image.
          *
@@ -464,6 +703,27 @@ namespace renderscript {
                        float threshold, bool binary, uint8_t channel,
                        const Restriction *_Nullable restriction);
 
+        /**
+         * Threshold a float image.
+         *
+         * Like the threshold of bytes, but for cells of 1 to 4 floats packed one after the other.
+         * Gray is the average of the first three channels, or of all of them when there are
+         * fewer, and the channels past the vector size also mean gray.
+         *
+         * @param input The buffer of the image to be thresholded.
+         * @param output The buffer that receives the thresholded image.
+         * @param sizeX The width of both buffers, as a number of cells.
+         * @param sizeY The height of both buffers, as a number of cells.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param threshold The value used to determine if a pixel is black or white.
+         * @param binary If true, the output will be 0 or 1. Otherwise, the pixel will remain the same.
+         * @param channel The channel to threshold (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void threshold(const float *_Nonnull input, float *_Nonnull output, size_t sizeX,
+                       size_t sizeY, size_t vectorSize, float threshold, bool binary,
+                       uint8_t channel, const Restriction *_Nullable restriction);
+
         /**
          * Add two images together with a weight.
          * @param input1 The buffer of the first image.
@@ -492,6 +752,26 @@ namespace renderscript {
         void minMax(const uint8_t *_Nonnull input, float *_Nonnull output, size_t sizeX,
                     size_t sizeY, uint8_t channel, const Restriction *_Nullable restriction);
 
+        /**
+         * Find the minimum and maximum value of a float image.
+         *
+         * The cells are 1 to 4 floats packed one after the other. Gray is the average of the
+         * first three channels, or of all of them when there are fewer, and the channels past the
+         * vector size also mean gray. NaN values are skipped. If every value is NaN, both the
+         * minimum and the maximum are NaN.
+         *
+         * @param input The buffer of the image.
+         * @param output The buffer that receives the min and the max.
+         * @param sizeX The width of the buffer, as a number of cells.
+         * @param sizeY The height of the buffer, as a number of cells.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param channel The channel to aggregate (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void minMax(const float *_Nonnull input, float *_Nonnull output, size_t sizeX,
+                    size_t sizeY, size_t vectorSize, uint8_t channel,
+                    const Restriction *_Nullable restriction);
+
         /**
          * Find the average value of an image.
          * @param input The buffer of the image.
@@ -504,6 +784,23 @@ namespace renderscript {
         double average(const uint8_t *_Nonnull input, size_t sizeX,
                        size_t sizeY, uint8_t channel, const Restriction *_Nullable restriction);
 
+        /**
+         * Find the average value of a float image.
+         *
+         * The cells and the channels are those of the float minMax. NaN values are skipped.
+         *
+         * @param input The buffer of the image.
+         * @param sizeX The width of the buffer, as a number of cells.
+         * @param sizeY The height of the buffer, as a number of cells.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param channel The channel to aggregate (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         * @return The average value of the image, NaN if every value is NaN.
+         */
+        double average(const float *_Nonnull input, size_t sizeX, size_t sizeY,
+                       size_t vectorSize, uint8_t channel,
+                       const Restriction *_Nullable restriction);
+
         /**
          * Find the standard deviation of an image.
          * @param input The buffer of the image.
@@ -518,6 +815,24 @@ namespace renderscript {
                                  size_t sizeY, uint8_t channel, double average,
                                  const Restriction *_Nullable restriction);
 
+        /**
+         * Find the standard deviation of a float image.
+         *
+         * The cells and the channels are those of the float minMax. NaN values are skipped.
+         *
+         * @param input The buffer of the image.
+         * @param sizeX The width of the buffer, as a number of cells.
+         * @param sizeY The height of the buffer, as a number of cells.
+         * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+         * @param channel The channel to aggregate (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param average The average value of the image.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         * @return The standard deviation of the image, NaN if every value is NaN.
+         */
+        double standardDeviation(const float *_Nonnull input, size_t sizeX, size_t sizeY,
+                                 size_t vectorSize, uint8_t channel, double average,
+                                 const Restriction *_Nullable restriction);
+
         /**
          * Find the moment of an image.
          * @param input The buffer of the image.
@@ -531,20 +846,73 @@ namespace renderscript {
                     size_t sizeY, uint8_t channel,
                     const Restriction *_Nullable restriction);
 
+        /**
+         * The statistics that statistics() can compute. Combine them with | to request several.
+         */
+        enum class Statistic : uint32_t {
+            MIN_MAX = 1 << 0,
+            AVERAGE = 1 << 1,
+            STANDARD_DEVIATION = 1 << 2,
+            MOMENT = 1 << 3,
+            HISTOGRAM = 1 << 4,
+        };
+
+        /**
+         * Compute several statistics of an image in a single pass.
+         *
+         * Replaces separate calls to minMax, average, standardDeviation, moment, and histogram.
+         * The standard deviation doesn't need the average beforehand. The sums are kept as
+         * integers and the per-thread results are combined with the parallel form of Welford's
+         * algorithm, so the variance doesn't lose precision on large images.
+         *
+         * The results are placed in output:
+         *    output[0] and output[1]: The minimum and maximum values (MIN_MAX).
+         *    output[2]: The average value (AVERAGE).
+         *    output[3]: The standard deviation (STANDARD_DEVIATION).
+         *    output[4] and output[5]: The X and Y moment (MOMENT).
+         * The entries of the statistics that are not requested are left unchanged. Unlike
+         * average and standardDeviation, the average and standard deviation are those of the
+         * cells in the restriction.
+         *
+         * @param input The buffer of the image.
+         * @param output The buffer that receives the statistics, of 6 values.
+         * @param histogram When HISTOGRAM is requested, an array of 256 * 4 values that receives
+         * the histogram of the four channels, like {@link RenderScriptToolkit::histogram} with a
+         * vectorSize of 4. Can be null otherwise.
+         * @param sizeX The width of the buffer, as a number of 4 byte cells.
+         * @param sizeY The height of the buffer, as a number of 4 byte cells.
+         * @param channel The channel to aggregate (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param requested The statistics to compute, a combination of Statistic values.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void statistics(const uint8_t *_Nonnull input, double *_Nonnull output,
+                        int32_t *_Nullable histogram, size_t sizeX, size_t sizeY, uint8_t channel,
+                        uint32_t requested, const Restriction *_Nullable restriction);
+
         /**
          * Find blobs in an image.
+         *
+         * A blob is a group of pixels at or above the threshold that touch horizontally or
+         * vertically. The blobs are sorted by the area of their bounding box, largest first.
+         *
          * @param input The buffer of the image.
          * @param output The buffer that receives the blobs (must be 4 times the max number of blobs).
+         * Each blob is its bounding box as left, top, right and bottom, the last two excluded.
+         * The entries past the last blob are 0.
+         * @param statistics When not null, the buffer that receives the statistics of the blobs
+         * (must be 4 times the max number of blobs): the area of the bounding box, the number of
+         * pixels, and the x and y of the centroid of the pixels.
          * @param maxBlobs The maximum number of blobs to find.
          * @param sizeX The width of both buffers, as a number of 4 byte cells.
          * @param sizeY The height of both buffers, as a number of 4 byte cells.
          * @param threshold The value used to determine if a pixel is black or white.
          * @param channel The channel to threshold (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
-         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels. The
+         * blobs are cut at its edges.
          */
-        void findBlobs(const uint8_t *_Nonnull input, int *_Nonnull output, size_t maxBlobs,
-                       size_t sizeX, size_t sizeY, float threshold,
-                       uint8_t channel, const Restriction *_Nullable restriction);
+        void findBlobs(const uint8_t *_Nonnull input, int *_Nonnull output,
+                       double *_Nullable statistics, size_t maxBlobs, size_t sizeX, size_t sizeY,
+                       float threshold, uint8_t channel, const Restriction *_Nullable restriction);
 
         /**
          * Calculate the GLCM of an image.
@@ -567,6 +935,64 @@ namespace renderscript {
              bool excludeTransparent, const int *_Nonnull steps, uint8_t stepCount,
              const Restriction *_Nullable restriction);
 
+        /**
+         * The number of values glcmFeatures() places in its output.
+         */
+        static constexpr size_t kGlcmFeatureCount = 8;
+
+        /**
+         * Calculate the Haralick texture features of the GLCM of an image, without returning
+         * the GLCM.
+         *
+         * The pairs are counted like glcm() does. With p(i, j) the normalized GLCM, the results
+         * are placed in output:
+         *    output[0]: The contrast, the sum of (i - j)^2 p(i, j).
+         *    output[1]: The dissimilarity, the sum of |i - j| p(i, j).
+         *    output[2]: The homogeneity, the sum of p(i, j) / (1 + (i - j)^2).
+         *    output[3]: The angular second moment, the sum of p(i, j)^2.
+         *    output[4]: The energy, the square root of the angular second moment.
+         *    output[5]: The entropy, minus the sum of p(i, j) ln(p(i, j)).
+         *    output[6]: The correlation of i and j, 1 when either has no variance.
+         *    output[7]: The largest p(i, j).
+         * When no pair is counted, e.g. every pixel is transparent and excluded, they are all 0.
+         *
+         * @param input The buffer of the image.
+         * @param output The buffer that receives the features, of kGlcmFeatureCount values.
+         * @param sizeX The width of the buffer, as a number of 4 byte cells.
+         * @param sizeY The height of the buffer, as a number of 4 byte cells.
+         * @param levels The number of levels to use in the GLCM, from 1 to 256.
+         * @param channel The channel to use (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+         * @param symmetric Whether to make the GLCM symmetric.
+         * @param excludeTransparent Whether to exclude transparent pixels.
+         * @param steps The steps to use in the GLCM. Must be stepCount * 2 in size.
+         * @param stepCount The number of steps to use.
+         * @param sparse Whether each thread counts the pairs in a 64 KB hash table rather than in
+         * levels * levels counters, 256 KB at 256 levels. Counting is slower, but it keeps the
+         * memory of each thread small for high level counts when there are many threads. The
+         * features are the same.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void glcmFeatures(const uint8_t *_Nonnull input, float *_Nonnull output,
+                          size_t sizeX, size_t sizeY, size_t levels,
+                          uint8_t channel, bool symmetric, bool excludeTransparent,
+                          const int *_Nonnull steps, uint8_t stepCount, bool sparse,
+                          const Restriction *_Nullable restriction);
+
+        /**
+         * Same as the variant above, but for several level counts in one call. The channel is
+         * read once, into a plane of quantized cells per level count.
+         *
+         * @param output The buffer that receives the features of each level count, in the order
+         * of levels. Must be levelCount * kGlcmFeatureCount in size.
+         * @param levels The level counts, each from 1 to 256.
+         * @param levelCount The number of level counts.
+         */
+        void glcmFeatures(const uint8_t *_Nonnull input, float *_Nonnull output,
+                          size_t sizeX, size_t sizeY, const int *_Nonnull levels,
+                          size_t levelCount, uint8_t channel, bool symmetric,
+                          bool excludeTransparent, const int *_Nonnull steps, uint8_t stepCount,
+                          bool sparse, const Restriction *_Nullable restriction);
+
         /**
          * Transform an image using a 3D look up table
          *
@@ -629,6 +1055,26 @@ namespace renderscript {
                     size_t inputSizeY, size_t vectorSize, size_t outputSizeX, size_t outputSizeY,
                     const Restriction *_Nullable restriction = nullptr);
 
+        /**
+         * Resize a float image.
+         *
+         * Like the resize of bytes, but for cells of 1 to 4 floats packed one after the other.
+         * The interpolated values aren't clamped, so they can overshoot near sharp edges. Unlike
+         * interpolateFloatBitmap, NaN values aren't replaced.
+         *
+         * @param in The buffer of the image to be resized.
+         * @param out The buffer that receives the resized image.
+         * @param inputSizeX The width of the input buffer, as a number of cells.
+         * @param inputSizeY The height of the input buffer, as a number of cells.
+         * @param vectorSize The number of floats in each cell of both buffers, from 1 to 4.
+         * @param outputSizeX The width of the output buffer, as a number of cells.
+         * @param outputSizeY The height of the output buffer, as a number of cells.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void resize(const float *_Nonnull in, float *_Nonnull out, size_t inputSizeX,
+                    size_t inputSizeY, size_t vectorSize, size_t outputSizeX, size_t outputSizeY,
+                    const Restriction *_Nullable restriction = nullptr);
+
         /**
          * Replace one color with another in an image.
          *
@@ -666,18 +1112,49 @@ namespace renderscript {
          * Doubles the image dimensions using the xBR 2x algorithm, which uses a 5x5
          * neighborhood and weighted YUV color distance to detect edges and determine
          * interpolation direction. Only source palette colors are used in the output,
-         * so no new colors are introduced.
+         * so no new colors are introduced. Same as xbr with a scale of 2.
          *
          * Only works on 4 byte RGBA data. The output buffer must be sized for
          * (sizeX * 2) * (sizeY * 2) * 4 bytes.
          *
+         * An optional range parameter can be set to restrict the operation to a rectangular subset
+         * of the input. Only the 2x2 output blocks of those pixels are written. The neighbors
+         * outside of the range are still read.
+         *
          * @param input The buffer of the image to be upscaled.
          * @param output The buffer that receives the 2x upscaled image.
          * @param sizeX The width of the input buffer.
          * @param sizeY The height of the input buffer.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels of
+         * the input.
          */
         void xbr2x(const uint8_t *_Nonnull input, uint8_t *_Nonnull output,
-                    size_t sizeX, size_t sizeY);
+                    size_t sizeX, size_t sizeY, const Restriction *_Nullable restriction = nullptr);
+
+        /**
+         * Upscale an image 2x, 3x or 4x using xBR with palette preservation.
+         *
+         * The edges are detected as in xbr2x. At 3x and 4x, the cells of the block of a pixel
+         * that take the color across an edge follow the lines of xBR more closely than chained
+         * 2x calls do. Only source palette colors are used in the output.
+         *
+         * Only works on 4 byte RGBA data. The output buffer must be sized for
+         * (sizeX * scale) * (sizeY * scale) * 4 bytes.
+         *
+         * An optional range parameter can be set to restrict the operation to a rectangular subset
+         * of the input. Only the scale x scale output blocks of those pixels are written. The
+         * neighbors outside of the range are still read.
+         *
+         * @param input The buffer of the image to be upscaled.
+         * @param output The buffer that receives the upscaled image.
+         * @param sizeX The width of the input buffer.
+         * @param sizeY The height of the input buffer.
+         * @param scale The factor to upscale by, 2, 3 or 4.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels of
+         * the input.
+         */
+        void xbr(const uint8_t *_Nonnull input, uint8_t *_Nonnull output, size_t sizeX,
+                 size_t sizeY, size_t scale, const Restriction *_Nullable restriction = nullptr);
 
         /**
          * Interpolate a float bitmap to a new size.
@@ -701,13 +1178,157 @@ namespace renderscript {
          * @param srcEndX The X coordinate of the end of the source region.
          * @param srcEndY The Y coordinate of the end of the source region.
          * @param maxSearchRadius The maximum search radius for nearest neighbor fallback.
+         * @param validDistances When not null, the nearestValidDistances of the input, to reuse
+         * them for several outputs of the same input. Otherwise they're computed before the
+         * interpolation when maxSearchRadius is above 0.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels of
+         * the output. The rest of the output is left as it is.
          */
         void interpolateFloatBitmap(const float *_Nonnull input, float *_Nonnull output,
                                      size_t inputWidth, size_t inputHeight, size_t channels,
                                      size_t outputWidth, size_t outputHeight,
                                      float srcStartX, float srcStartY,
                                      float srcEndX, float srcEndY,
-                                     int maxSearchRadius);
+                                     int maxSearchRadius,
+                                     const int32_t *_Nullable validDistances = nullptr,
+                                     const Restriction *_Nullable restriction = nullptr);
+
+        /**
+         * The distance of each pixel of a float bitmap to the nearest valid one, i.e. with no
+         * NaN channel, for the nearest neighbor fallback of interpolateFloatBitmap.
+         *
+         * The distance is the larger of the distances along the rows and along the columns, so
+         * the nearest valid pixels are on the ring of pixels at that distance. Valid pixels are
+         * at 0. When none is valid, all the distances are INT32_MAX.
+         *
+         * @param input The float bitmap data (width * height * channels floats).
+         * @param distances The width * height distances.
+         * @param width The width of the bitmap.
+         * @param height The height of the bitmap.
+         * @param channels The number of channels per pixel (1-4).
+         */
+        void nearestValidDistances(const float *_Nonnull input, int32_t *_Nonnull distances,
+                                   size_t width, size_t height, size_t channels);
+
+        /**
+         * One step of a pipeline. See {@link RenderScriptToolkit::pipeline}.
+         *
+         * Create the stages with the static methods. The stages only keep pointers to the
+         * arrays they're given, which must remain valid until the pipeline call returns.
+         */
+        struct PipelineStage {
+            enum class Type {
+                COLOR_MATRIX,
+                CONVOLVE_3X3,
+                CONVOLVE_5X5,
+                LUT,
+                THRESHOLD,
+            };
+            Type type;
+            /**
+             * The 4x4 matrix of COLOR_MATRIX, or the 9 or 25 coefficients of the convolutions.
+             */
+            const float *_Nullable coefficients = nullptr;
+            /**
+             * The add vector of COLOR_MATRIX. May be null.
+             */
+            const float *_Nullable addVector = nullptr;
+            /**
+             * The four tables of LUT, in RGBA order.
+             */
+            const uint8_t *_Nullable tables[4] = {nullptr, nullptr, nullptr, nullptr};
+            /**
+             * The parameters of THRESHOLD.
+             */
+            float thresholdValue = 0.f;
+            bool binary = true;
+            uint8_t channel = 0;
+
+            /** Same as {@link RenderScriptToolkit::colorMatrix} for 4 byte cells. */
+            static PipelineStage colorMatrix(const float *_Nonnull matrix,
+                                             const float *_Nullable addVector = nullptr) {
+                PipelineStage stage{Type::COLOR_MATRIX};
+                stage.coefficients = matrix;
+                stage.addVector = addVector;
+                return stage;
+            }
+
+            /** Same as {@link RenderScriptToolkit::convolve3x3} for 4 byte cells. */
+            static PipelineStage convolve3x3(const float *_Nonnull coefficients) {
+                PipelineStage stage{Type::CONVOLVE_3X3};
+                stage.coefficients = coefficients;
+                return stage;
+            }
+
+            /** Same as {@link RenderScriptToolkit::convolve5x5} for 4 byte cells. */
+            static PipelineStage convolve5x5(const float *_Nonnull coefficients) {
+                PipelineStage stage{Type::CONVOLVE_5X5};
+                stage.coefficients = coefficients;
+                return stage;
+            }
+
+            /** Same as {@link RenderScriptToolkit::lut}. */
+            static PipelineStage lut(const uint8_t *_Nonnull red, const uint8_t *_Nonnull green,
+                                     const uint8_t *_Nonnull blue,
+                                     const uint8_t *_Nonnull alpha) {
+                PipelineStage stage{Type::LUT};
+                stage.tables[0] = red;
+                stage.tables[1] = green;
+                stage.tables[2] = blue;
+                stage.tables[3] = alpha;
+                return stage;
+            }
+
+            /** Same as {@link RenderScriptToolkit::threshold}. */
+            static PipelineStage threshold(float threshold, bool binary, uint8_t channel) {
+                PipelineStage stage{Type::THRESHOLD};
+                stage.thresholdValue = threshold;
+                stage.binary = binary;
+                stage.channel = channel;
+                return stage;
+            }
+        };
+
+        /**
+         * Runs several operations over an RGBA image in one pass.
+         *
+         * The result is the same as calling the methods of the stages one after the other, each
+         * taking as input the output of the previous one, but without writing the intermediate
+         * images to memory. The image is processed tile by tile, each tile going through all the
+         * stages in per-thread scratch buffers that fit in the cache. The convolution stages
+         * read their neighbors, so a margin around each tile is processed too. For example, a
+         * 5x5 convolution followed by a 3x3 one needs a margin of 3 cells.
+         *
+         * The stages use the same code as the corresponding methods. Where the image is split
+         * in tiles decides which cells the SIMD code handles, and it rounds differently than the
+         * scalar code, so a few values may differ slightly from the unfused calls.
+         *
+         * If histogram is not null, it receives the histogram of the final image, like
+         * {@link RenderScriptToolkit::histogram} with a vectorSize of 4. The output can then be
+         * null if the image itself is not needed.
+         *
+         * Operations that change the dimensions of the image, like resize, can't be stages. Run
+         * them before the pipeline.
+         *
+         * With a restriction, only the cells inside it are written and counted in the
+         * histogram. The convolutions still read the neighbors outside of it. Its strides should
+         * be multiples of 4 bytes.
+         *
+         * @param in The buffer of the RGBA image to process.
+         * @param out The buffer that receives the result. Can be the same as in only if no stage
+         * is a convolution. May be null if histogram is not.
+         * @param sizeX The width of both buffers, as a number of 4 byte cells.
+         * @param sizeY The height of both buffers, as a number of 4 byte cells.
+         * @param stages The operations to do, in order.
+         * @param stageCount The number of stages.
+         * @param histogram When not null, an array of 256 * 4 values that receives the histogram
+         * of the result.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
+         */
+        void pipeline(const uint8_t *_Nonnull in, uint8_t *_Nullable out, size_t sizeX,
+                      size_t sizeY, const PipelineStage *_Nonnull stages, size_t stageCount,
+                      int32_t *_Nullable histogram = nullptr,
+                      const Restriction *_Nullable restriction = nullptr);
 
         /**
          * The YUV formats supported by yuvToRgb.
@@ -733,9 +1354,66 @@ namespace renderscript {
          * @param sizeX The width in pixels of the image. Must be even.
          * @param sizeY The height in pixels of the image.
          * @param format Either YV12 or NV21.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels.
          */
         void yuvToRgb(const uint8_t *_Nonnull in, uint8_t *_Nonnull out, size_t sizeX, size_t sizeY,
-                      YuvFormat format);
+                      YuvFormat format, const Restriction *_Nullable restriction = nullptr);
+
+        /**
+         * How the planes overload of yuvToRgb crops, scales and rotates the image while it
+         * converts it. The conversion then writes only the final pixels, instead of a full size
+         * image that is transformed afterwards.
+         */
+        struct YuvTransform {
+            /**
+             * The part of the image to convert, in pixels of the input. The end is exclusive.
+             */
+            size_t cropStartX;
+            size_t cropEndX;
+            size_t cropStartY;
+            size_t cropEndY;
+            /**
+             * The clockwise rotation in degrees, one of 0, 90, 180 and 270.
+             */
+            int rotation = 0;
+            /**
+             * The size of the output, after the rotation. When the crop is an integer multiple of
+             * it, each output pixel is the average of the block it covers. Otherwise the output is
+             * sampled bilinearly.
+             */
+            size_t outputSizeX;
+            size_t outputSizeY;
+        };
+
+        /**
+         * Convert an image from YUV to RGB, reading the planes in place.
+         *
+         * The planes are laid out like those of an Android YUV_420_888 Image: the U and V planes
+         * are subsampled by 2 in both directions and share their strides. A pixel stride of 2 with
+         * interleaved U and V planes covers NV21 and NV12. This avoids having to repack the
+         * planes of a camera frame before converting it.
+         *
+         * The output is RGBA; the alpha channel will be set to 255.
+         *
+         * @param inY The Y plane.
+         * @param inU The U plane.
+         * @param inV The V plane.
+         * @param yRowStride The distance in bytes between two rows of the Y plane.
+         * @param uvRowStride The distance in bytes between two rows of the U and V planes.
+         * @param uvPixelStride The distance in bytes between two samples of the U and V planes.
+         * @param out The buffer that receives the converted image. Its size is the output size of
+         * the transform if there is one, else the size of the image.
+         * @param sizeX The width in pixels of the image. Must be even.
+         * @param sizeY The height in pixels of the image.
+         * @param transform When not null, crops, scales and rotates the image. See YuvTransform.
+         * @param restriction When not null, restricts the operation to a 2D range of pixels of
+         * the output.
+         */
+        void yuvToRgb(const uint8_t *_Nonnull inY, const uint8_t *_Nonnull inU,
+                      const uint8_t *_Nonnull inV, size_t yRowStride, size_t uvRowStride,
+                      size_t uvPixelStride, uint8_t *_Nonnull out, size_t sizeX, size_t sizeY,
+                      const YuvTransform *_Nullable transform = nullptr,
+                      const Restriction *_Nullable restriction = nullptr);
     };
 
 }  // namespace renderscript
@@ -16,7 +16,9 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
@@ -39,36 +41,69 @@ class ResizeTask : public Task {
     float mScaleY;
     size_t mInputSizeX;
     size_t mInputSizeY;
+    // The number of bytes between the starts of two rows of mIn and of mOut.
+    const size_t mInStride;
+    const size_t mOutStride;
 
     void kernelU1(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
     void kernelU2(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
     void kernelU4(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
-#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
-    void kernelF1(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
-    void kernelF2(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
-    void kernelF4(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY);
-#endif  // ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
+    template <size_t N>
+    void kernelF(float* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY,
+                 size_t firstColumn, size_t columnCount, float* line);
+    template <size_t N>
+    void processFloats(int threadIndex, size_t startX, size_t startY, size_t endX, size_t endY);
 
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
     void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                      size_t endY) override;
 
    public:
+    // Byte cells of 3 are padded to 4. Float cells, when elementSize is sizeof(float), are packed.
     ResizeTask(const uchar* input, uchar* output, size_t inputSizeX, size_t inputSizeY,
-               size_t vectorSize, size_t outputSizeX, size_t outputSizeY,
+               size_t vectorSize, size_t elementSize, size_t outputSizeX, size_t outputSizeY,
                const Restriction* restriction)
         : Task{outputSizeX, outputSizeY, vectorSize, false, restriction},
           mIn{input},
           mOut{output},
           mInputSizeX{inputSizeX},
-          mInputSizeY{inputSizeY} {
+          mInputSizeY{inputSizeY},
+          mInStride{inputStride(inputSizeX * (elementSize == 1 ? paddedSize(vectorSize)
+                                                               : vectorSize * elementSize))},
+          mOutStride{outputStride(outputSizeX * (elementSize == 1 ? paddedSize(vectorSize)
+                                                                  : vectorSize * elementSize))} {
         mScaleX = static_cast<float>(inputSizeX) / outputSizeX;
         mScaleY = static_cast<float>(inputSizeY) / outputSizeY;
+        setElementSize(elementSize);
+        // An output cell is interpolated from 4x4 input cells. Neighboring output cells share
+        // them when enlarging, less and less as the input gets larger than the output.
+        const float inputCellsPerCell = std::min(mScaleX, 4.f) * std::min(mScaleY, 4.f);
+        setWorkingSetPerCell(vectorSize * elementSize * (1 + inputCellsPerCell));
+        setReach(static_cast<size_t>(ceilf(2 / mScaleY)));
+        setTilingGroup(RenderScriptToolkit::TilingGroup::RESIZE);
     }
 };
 
-void ResizeTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
+void ResizeTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                              size_t endY) {
+    if (mElementSize == sizeof(float)) {
+        switch (mVectorSize) {
+            case 1:
+                processFloats<1>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 2:
+                processFloats<2>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 3:
+                processFloats<3>(threadIndex, startX, startY, endX, endY);
+                break;
+            case 4:
+                processFloats<4>(threadIndex, startX, startY, endX, endY);
+                break;
+        }
+        return;
+    }
+
     typedef void (ResizeTask::*KernelFunction)(uchar*, uint32_t, uint32_t, uint32_t);
 
     KernelFunction kernel;
@@ -90,8 +125,7 @@ void ResizeTask::processData(int /* threadIndex */, size_t startX, size_t startY
     }
 
     for (size_t y = startY; y < endY; y++) {
-        size_t offset = (mSizeX * y + startX) * paddedSize(mVectorSize);
-        uchar* out = mOut + offset;
+        uchar* out = mOut + mOutStride * y + startX * paddedSize(mVectorSize);
         std::invoke(kernel, this, out, startX, endX, y);
     }
 }
@@ -262,6 +296,15 @@ extern "C" void rsdIntrinsicResizeB1_K(
             uint64_t osc_ctl,
             int32_t const *yr);
 
+/**
+ * The weights cubicInterpolate gives to p0, p1, p2 and p3. It's linear in them, so a float cell
+ * is interpolated as a weighted sum of four cells.
+ */
+static float4 cubicWeights(float x) {
+    return float4{0.5f * x * (-1.f + x * (2.f - x)), 1.f + 0.5f * x * x * (-5.f + 3.f * x),
+                  0.5f * x * (1.f + x * (4.f - 3.f * x)), 0.5f * x * x * (x - 1.f)};
+}
+
 #if defined(ARCH_ARM_USE_INTRINSICS)
 static void mkYCoeff(int32_t *yr, float yf) {
     int32_t yf1 = rint(yf * 0x10000);
@@ -275,82 +318,11 @@ static void mkYCoeff(int32_t *yr, float yf) {
 }
 #endif
 
-#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
-static float4 OneBiCubic(const float4 *yp0, const float4 *yp1, const float4 *yp2, const float4 *yp3,
-                         float xf, float yf, int width) {
-    int startx = (int) floor(xf - 1);
-    xf = xf - floor(xf);
-    int maxx = width - 1;
-    int xs0 = std::max(0, startx + 0);
-    int xs1 = std::max(0, startx + 1);
-    int xs2 = std::min(maxx, startx + 2);
-    int xs3 = std::min(maxx, startx + 3);
-
-    float4 p0  = cubicInterpolate(yp0[xs0], yp0[xs1],
-                                  yp0[xs2], yp0[xs3], xf);
-    float4 p1  = cubicInterpolate(yp1[xs0], yp1[xs1],
-                                  yp1[xs2], yp1[xs3], xf);
-    float4 p2  = cubicInterpolate(yp2[xs0], yp2[xs1],
-                                  yp2[xs2], yp2[xs3], xf);
-    float4 p3  = cubicInterpolate(yp3[xs0], yp3[xs1],
-                                  yp3[xs2], yp3[xs3], xf);
-
-    float4 p  = cubicInterpolate(p0, p1, p2, p3, yf);
-    return p;
-}
-
-static float2 OneBiCubic(const float2 *yp0, const float2 *yp1, const float2 *yp2, const float2 *yp3,
-                         float xf, float yf, int width) {
-    int startx = (int) floor(xf - 1);
-    xf = xf - floor(xf);
-    int maxx = width - 1;
-    int xs0 = std::max(0, startx + 0);
-    int xs1 = std::max(0, startx + 1);
-    int xs2 = std::min(maxx, startx + 2);
-    int xs3 = std::min(maxx, startx + 3);
-
-    float2 p0  = cubicInterpolate(yp0[xs0], yp0[xs1],
-                                  yp0[xs2], yp0[xs3], xf);
-    float2 p1  = cubicInterpolate(yp1[xs0], yp1[xs1],
-                                  yp1[xs2], yp1[xs3], xf);
-    float2 p2  = cubicInterpolate(yp2[xs0], yp2[xs1],
-                                  yp2[xs2], yp2[xs3], xf);
-    float2 p3  = cubicInterpolate(yp3[xs0], yp3[xs1],
-                                  yp3[xs2], yp3[xs3], xf);
-
-    float2 p  = cubicInterpolate(p0, p1, p2, p3, yf);
-    return p;
-}
-
-static float OneBiCubic(const float *yp0, const float *yp1, const float *yp2, const float *yp3,
-                        float xf, float yf, int width) {
-    int startx = (int) floor(xf - 1);
-    xf = xf - floor(xf);
-    int maxx = width - 1;
-    int xs0 = std::max(0, startx + 0);
-    int xs1 = std::max(0, startx + 1);
-    int xs2 = std::min(maxx, startx + 2);
-    int xs3 = std::min(maxx, startx + 3);
-
-    float p0  = cubicInterpolate(yp0[xs0], yp0[xs1],
-                                 yp0[xs2], yp0[xs3], xf);
-    float p1  = cubicInterpolate(yp1[xs0], yp1[xs1],
-                                 yp1[xs2], yp1[xs3], xf);
-    float p2  = cubicInterpolate(yp2[xs0], yp2[xs1],
-                                 yp2[xs2], yp2[xs3], xf);
-    float p3  = cubicInterpolate(yp3[xs0], yp3[xs1],
-                                 yp3[xs2], yp3[xs3], xf);
-
-    float p  = cubicInterpolate(p0, p1, p2, p3, yf);
-    return p;
-}
-#endif
-
 void ResizeTask::kernelU4(uchar *outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY) {
     const uchar *pin = mIn;
     const int srcHeight = mInputSizeY;
     const int srcWidth = mInputSizeX;
-    const size_t stride = mInputSizeX * paddedSize(mVectorSize);
+    const size_t stride = mInStride;
 
 
 #if defined(ARCH_X86_HAVE_AVX2)
@@ -422,7 +394,7 @@ void ResizeTask::kernelU2(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_
     const uchar *pin = mIn;
     const int srcHeight = mInputSizeY;
     const int srcWidth = mInputSizeX;
-    const size_t stride = mInputSizeX * mVectorSize;
+    const size_t stride = mInStride;
 
 
 #if defined(ARCH_X86_HAVE_AVX2)
@@ -495,7 +467,7 @@ void ResizeTask::kernelU1(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_
     const uchar *pin = mIn;
     const int srcHeight = mInputSizeY;
     const int srcWidth = mInputSizeX;
-    const size_t stride = mInputSizeX * mVectorSize;
+    const size_t stride = mInStride;
 
     // ALOGI("Toolkit   ResizeU1 (%ux%u) by (%f,%f), xstart:%u to %u, stride %zu, out %p", srcWidth,
     // srcHeight, scaleX, scaleY, xstart, xend, stride, outPtr);
@@ -574,183 +546,100 @@ void ResizeTask::kernelU1(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_
     }
 }
 
-#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
-void ResizeTask::kernelF4(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY) {
-    const uchar *pin = mIn;
-    const int srcHeight = inputSizeY;
-    const int srcWidth = inputSizeX;
-    const size_t stride = sizeX * vectorSize;
-
-#if defined(ARCH_X86_HAVE_AVX2)
-    float yf = _mm_cvtss_f32(
-            _mm_fmsub_ss(_mm_set1_ps(currentY + 0.5f), _mm_set1_ps(scaleY), _mm_set1_ps(0.5f)));
-#else
-    float yf = (currentY + 0.5f) * scaleY - 0.5f;
-#endif
+/**
+ * Resizes a row of cells of N packed floats.
+ *
+ * Interpolates the four input rows around currentY into line first, four floats at a time, then
+ * each output cell from four cells of line.
+ *
+ * @param outPtr Where to store the cells [xstart, xend) of the output row.
+ * @param firstColumn The first input column the output cells read.
+ * @param columnCount The number of input columns the output cells read.
+ * @param line A working area of columnCount cells.
+ */
+template <size_t N>
+void ResizeTask::kernelF(float* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY,
+                         size_t firstColumn, size_t columnCount, float* line) {
+    const int srcWidth = mInputSizeX;
+    const int maxx = srcWidth - 1;
+    const int maxy = mInputSizeY - 1;
 
+    float yf = (currentY + 0.5f) * mScaleY - 0.5f;
     int starty = (int) floor(yf - 1);
     yf = yf - floor(yf);
-    int maxy = srcHeight - 1;
-    int ys0 = std::max(0, starty + 0);
-    int ys1 = std::max(0, starty + 1);
-    int ys2 = std::min(maxy, starty + 2);
-    int ys3 = std::min(maxy, starty + 3);
-
-    const float4 *yp0 = (const float4 *)(pin + stride * ys0);
-    const float4 *yp1 = (const float4 *)(pin + stride * ys1);
-    const float4 *yp2 = (const float4 *)(pin + stride * ys2);
-    const float4 *yp3 = (const float4 *)(pin + stride * ys3);
-
-    float4 *out = ((float4 *)outPtr);
-    uint32_t x1 = xstart;
-    uint32_t x2 = xend;
-
-    while(x1 < x2) {
-
-#if defined(ARCH_X86_HAVE_AVX2)
-        float xf = _mm_cvtss_f32(_mm_fmsub_ss(_mm_set1_ps(x1 + 0.5f) , _mm_set1_ps(scaleX) ,
-                                              _mm_set1_ps(0.5f)));
-#else
-        float xf = (x1 + 0.5f) * scaleX - 0.5f;
-#endif
-
-        *out = OneBiCubic(yp0, yp1, yp2, yp3, xf, yf, srcWidth);
-        out++;
-        x1++;
+    const float4 yWeights = cubicWeights(yf);
+    const float weights[4] = {yWeights.x, yWeights.y, yWeights.z, yWeights.w};
+    const float* rows[4];
+    for (int k = 0; k < 4; k++) {
+        const int ys = std::min(maxy, std::max(0, starty + k));
+        rows[k] = reinterpret_cast<const float*>(mIn + mInStride * ys) + firstColumn * N;
     }
-}
-
-void ResizeTask::kernelF2(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY) {
-    const uchar *pin = mIn;
-    const int srcHeight = inputSizeY;
-    const int srcWidth = inputSizeX;
-    const size_t stride = sizeX * vectorSize;
-
-
-#if defined(ARCH_X86_HAVE_AVX2)
-    float yf = _mm_cvtss_f32(_mm_fmsub_ss(_mm_set1_ps(currentY + 0.5f),
-                                          _mm_set1_ps(scaleY), _mm_set1_ps(0.5f)));
-#else
-    float yf = (currentY + 0.5f) * scaleY - 0.5f;
-#endif
-
-    int starty = (int) floor(yf - 1);
-    yf = yf - floor(yf);
-    int maxy = srcHeight - 1;
-    int ys0 = std::max(0, starty + 0);
-    int ys1 = std::max(0, starty + 1);
-    int ys2 = std::min(maxy, starty + 2);
-    int ys3 = std::min(maxy, starty + 3);
-
-    const float2 *yp0 = (const float2 *)(pin + stride * ys0);
-    const float2 *yp1 = (const float2 *)(pin + stride * ys1);
-    const float2 *yp2 = (const float2 *)(pin + stride * ys2);
-    const float2 *yp3 = (const float2 *)(pin + stride * ys3);
-
-    float2 *out = ((float2 *)outPtr);
-    uint32_t x1 = xstart;
-    uint32_t x2 = xend;
-
-    while(x1 < x2) {
-
-#if defined(ARCH_X86_HAVE_AVX2)
-        float xf = _mm_cvtss_f32(_mm_fmsub_ss(_mm_set1_ps(x1 + 0.5f) , _mm_set1_ps(scaleX) ,
-                                              _mm_set1_ps(0.5f)));
-#else
-        float xf = (x1 + 0.5f) * scaleX - 0.5f;
-#endif
-
-        *out = OneBiCubic(yp0, yp1, yp2, yp3, xf, yf, srcWidth);
-        out++;
-        x1++;
+    weightedSum(rows, weights, 4, columnCount * N, line);
+
+    float* out = outPtr;
+    for (uint32_t x = xstart; x < xend; x++) {
+        float xf = (x + 0.5f) * mScaleX - 0.5f;
+        int startx = (int) floor(xf - 1);
+        xf = xf - floor(xf);
+        const float4 xWeights = cubicWeights(xf);
+        const float* cells[4];
+        for (int k = 0; k < 4; k++) {
+            const int xs = std::min(maxx, std::max(0, startx + k));
+            cells[k] = line + (xs - firstColumn) * N;
+        }
+        for (size_t c = 0; c < N; c++) {
+            out[c] = cells[0][c] * xWeights.x + cells[1][c] * xWeights.y +
+                     cells[2][c] * xWeights.z + cells[3][c] * xWeights.w;
+        }
+        out += N;
     }
 }
 
-void ResizeTask::kernelF1(uchar* outPtr, uint32_t xstart, uint32_t xend, uint32_t currentY) {
-    const uchar *pin = mIn;
-    const int srcHeight = inputSizeY;
-    const int srcWidth = inputSizeX;
-    const size_t stride = sizeX * vectorSize;
-
-
-#if defined(ARCH_X86_HAVE_AVX2)
-    float yf = _mm_cvtss_f32(_mm_fmsub_ss(_mm_set1_ps(currentY + 0.5f),
-                                          _mm_set1_ps(scaleY), _mm_set1_ps(0.5f)));
-#else
-    float yf = (currentY + 0.5f) * scaleY - 0.5f;
-#endif
-
-    int starty = (int) floor(yf - 1);
-    yf = yf - floor(yf);
-    int maxy = srcHeight - 1;
-    int ys0 = std::max(0, starty + 0);
-    int ys1 = std::max(0, starty + 1);
-    int ys2 = std::min(maxy, starty + 2);
-    int ys3 = std::min(maxy, starty + 3);
-
-    const float *yp0 = (const float *)(pin + stride * ys0);
-    const float *yp1 = (const float *)(pin + stride * ys1);
-    const float *yp2 = (const float *)(pin + stride * ys2);
-    const float *yp3 = (const float *)(pin + stride * ys3);
-
-    float *out = ((float *)outPtr);
-    uint32_t x1 = xstart;
-    uint32_t x2 = xend;
-
-    while(x1 < x2) {
-
-#if defined(ARCH_X86_HAVE_AVX2)
-        float xf = _mm_cvtss_f32(_mm_fmsub_ss(_mm_set1_ps(x1 + 0.5f) , _mm_set1_ps(scaleX) ,
-                                              _mm_set1_ps(0.5f)));
-#else
-        float xf = (x1 + 0.5f) * scaleX - 0.5f;
-#endif
+template <size_t N>
+void ResizeTask::processFloats(int threadIndex, size_t startX, size_t startY, size_t endX,
+                               size_t endY) {
+    // The input columns the cells [startX, endX) read, the same for all the rows.
+    const float xFirst = (startX + 0.5f) * mScaleX - 0.5f;
+    const float xLast = (endX - 1 + 0.5f) * mScaleX - 0.5f;
+    const int maxx = mInputSizeX - 1;
+    const size_t firstColumn = std::min(maxx, std::max(0, (int) floor(xFirst - 1)));
+    const size_t lastColumn = std::min(maxx, (int) floor(xLast - 1) + 3);
+    const size_t columnCount = lastColumn - firstColumn + 1;
+    float* line = scratch(threadIndex).allocate<float>(columnCount * N);
 
-        *out = OneBiCubic(yp0, yp1, yp2, yp3, xf, yf, srcWidth);
-        out++;
-        x1++;
+    for (size_t y = startY; y < endY; y++) {
+        float* out = reinterpret_cast<float*>(mOut + mOutStride * y) + startX * N;
+        kernelF<N>(out, startX, endX, y, firstColumn, columnCount, line);
     }
 }
 
-void ResizeTask::preLaunch(uint32_t slot, const RsScriptCall *sc)
-{
-
-    //check the data type to determine F or U.
-    if (mAlloc->getType()->getElement()->getType() == RS_TYPE_UNSIGNED_8) {
-        switch(mAlloc->getType()->getElement()->getVectorSize()) {
-        case 1:
-            mRootPtr = &kernelU1;
-            break;
-        case 2:
-            mRootPtr = &kernelU2;
-            break;
-        case 3:
-        case 4:
-            mRootPtr = &kernelU4;
-            break;
-        }
-    } else {
-        switch(mAlloc->getType()->getElement()->getVectorSize()) {
-        case 1:
-            mRootPtr = &kernelF1;
-            break;
-        case 2:
-            mRootPtr = &kernelF2;
-            break;
-        case 3:
-        case 4:
-            mRootPtr = &kernelF4;
-            break;
-        }
+void RenderScriptToolkit::resize(const uint8_t* input, uint8_t* output, size_t inputSizeX,
+                                 size_t inputSizeY, size_t vectorSize, size_t outputSizeX,
+                                 size_t outputSizeY, const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, outputSizeX, outputSizeY, restriction,
+                          inputSizeX * paddedSize(vectorSize),
+                          outputSizeX * paddedSize(vectorSize))) {
+        return;
+    }
+    if (vectorSize < 1 || vectorSize > 4) {
+        ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+        return;
     }
+#endif
+
+    ResizeTask task((const uchar*)input, (uchar*)output, inputSizeX, inputSizeY, vectorSize, 1,
+                    outputSizeX, outputSizeY, restriction);
+    processor->doTask(&task);
 }
-#endif  // ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT
 
-void RenderScriptToolkit::resize(const uint8_t* input, uint8_t* output, size_t inputSizeX,
+void RenderScriptToolkit::resize(const float* input, float* output, size_t inputSizeX,
                                  size_t inputSizeY, size_t vectorSize, size_t outputSizeX,
                                  size_t outputSizeY, const Restriction* restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-    if (!validRestriction(LOG_TAG, outputSizeX, outputSizeY, restriction)) {
+    if (!validRestriction(LOG_TAG, outputSizeX, outputSizeY, restriction,
+                          inputSizeX * vectorSize * sizeof(float),
+                          outputSizeX * vectorSize * sizeof(float))) {
         return;
     }
     if (vectorSize < 1 || vectorSize > 4) {
@@ -760,7 +649,7 @@ void RenderScriptToolkit::resize(const uint8_t* input, uint8_t* output, size_t i
 #endif
 
     ResizeTask task((const uchar*)input, (uchar*)output, inputSizeX, inputSizeY, vectorSize,
-                    outputSizeX, outputSizeY, restriction);
+                    sizeof(float), outputSizeX, outputSizeY, restriction);
     processor->doTask(&task);
 }
 
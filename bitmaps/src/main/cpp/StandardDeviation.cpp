@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
+#include "Reduction.h"
 #include "RenderScriptToolkit.h"
 #include "TaskProcessor.h"
 #include "Utils.h"
@@ -9,11 +12,12 @@
 namespace renderscript {
 
     class StandardDeviationTask : public Task {
-        const uchar4 *mIn;
+        const uint8_t *mIn;
+        const size_t mInStride;
         const uint8_t mChannel;
         const uint32_t mThreadCount;
         const double mAverage;
-        std::vector<double> mTotals;
+        PerThread<double> mTotals;
 
         // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
         void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
@@ -23,7 +27,8 @@ namespace renderscript {
         StandardDeviationTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
                               double average, uint32_t threadCount, const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
                   mChannel{channel},
                   mThreadCount{threadCount},
                   mAverage{average},
@@ -35,32 +40,29 @@ namespace renderscript {
     void
     StandardDeviationTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                                        size_t endY) {
-
+        // For gray, the values are r + g + b, so they are compared to three times the average.
+        const double scale = mChannel <= 3 ? 1.0 : 3.0;
+        const double average = mAverage * scale;
+        double total = 0;
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-            for (size_t x = startX; x < endX; x++) {
-                auto v = *in;
-                double value;
-                if (mChannel == 0) {
-                    value = v.r;
-                } else if (mChannel == 1) {
-                    value = v.g;
-                } else if (mChannel == 2) {
-                    value = v.b;
-                } else if (mChannel == 3) {
-                    value = v.a;
-                } else {
-                    value = (v.r + v.g + v.b) / 3.0;
-                }
-
-                double diff = value - mAverage;
-
-                mTotals[threadIndex] += diff * diff;
-
-                in++;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerReductionRun) {
+                const size_t count = std::min(endX - x, kMaxCellsPerReductionRun);
+                ReductionSums run;
+                reduceRun(in + x, count, mChannel, mUsesSimd, &run);
+
+                // The sum of the squared differences from the average is the sum of the squared
+                // differences from the run's mean, which count * sumOfSquares - sum * sum gives
+                // exactly, plus count times the squared difference of the mean and the average.
+                // The product needs 64 bits, size_t is 32 on the 32-bit ABIs.
+                const uint64_t sum = run.sum;
+                const double mean = (double) sum / count;
+                const double diff = mean - average;
+                total += (double) ((uint64_t) count * run.sumOfSquares - sum * sum) / count +
+                         count * diff * diff;
             }
         }
+        mTotals[threadIndex] += total / (scale * scale);
     }
 
     double StandardDeviationTask::collate() {
@@ -75,7 +77,7 @@ namespace renderscript {
                                                   size_t sizeY, uint8_t channel, double average,
                                                   const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
             return 0;
         }
 #endif
@@ -86,4 +88,85 @@ namespace renderscript {
         return task.collate();
     }
 
+    class FloatStandardDeviationTask : public Task {
+        const float *mIn;
+        const size_t mInStride;
+        const uint8_t mChannel;
+        const uint32_t mThreadCount;
+        const float mAverage;
+        // The sums of the squared differences from the average of each thread, and how many
+        // cells weren't NaN.
+        PerThread<double> mTotals;
+        PerThread<size_t> mCounts;
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        FloatStandardDeviationTask(const float *input, size_t sizeX, size_t sizeY,
+                                   size_t vectorSize, uint8_t channel, double average,
+                                   uint32_t threadCount, const Restriction *restriction)
+                : Task{sizeX, sizeY, vectorSize, true, restriction},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * vectorSize * sizeof(float))},
+                  mChannel{channel},
+                  mThreadCount{threadCount},
+                  mAverage{(float) average},
+                  mTotals(threadCount),
+                  mCounts(threadCount) {
+            setElementSize(sizeof(float));
+        }
+
+        double collate();
+    };
+
+    void
+    FloatStandardDeviationTask::processData(int threadIndex, size_t startX, size_t startY,
+                                            size_t endX, size_t endY) {
+        FloatReductionSums all;
+        for (size_t y = startY; y < endY; y++) {
+            const float *in = reinterpret_cast<const float *>(
+                    reinterpret_cast<const uint8_t *>(mIn) + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerFloatReductionRun) {
+                reduceRun(in + x * mVectorSize,
+                          std::min(endX - x, kMaxCellsPerFloatReductionRun), mVectorSize,
+                          mChannel, mAverage, &all);
+            }
+        }
+        mTotals[threadIndex] += all.sumOfSquares;
+        mCounts[threadIndex] += all.count;
+    }
+
+    double FloatStandardDeviationTask::collate() {
+        double sum = 0;
+        size_t count = 0;
+        for (uint32_t t = 0; t < mThreadCount; t++) {
+            sum += mTotals[t];
+            count += mCounts[t];
+        }
+        return count == 0 ? NAN : sqrt(sum / count);
+    }
+
+    double RenderScriptToolkit::standardDeviation(const float *input, size_t sizeX,
+                                                  size_t sizeY, size_t vectorSize,
+                                                  uint8_t channel, double average,
+                                                  const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction,
+                              sizeX * vectorSize * sizeof(float), 0)) {
+            return 0;
+        }
+        if (vectorSize < 1 || vectorSize > 4) {
+            ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+            return 0;
+        }
+#endif
+
+        FloatStandardDeviationTask task(input, sizeX, sizeY, vectorSize, channel, average,
+                                        processor->getNumberOfThreads(), restriction);
+        processor->doTask(&task);
+        return task.collate();
+    }
+
 }  // namespace renderscript
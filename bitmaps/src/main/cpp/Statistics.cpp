@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Reduction.h"
+#include "RenderScriptToolkit.h"
+#include "TaskProcessor.h"
+#include "Utils.h"
+
+#define LOG_TAG "renderscript.toolkit.Statistics"
+
+namespace renderscript {
+
+    using Statistic = RenderScriptToolkit::Statistic;
+
+    namespace {
+
+        /**
+         * The statistics of the cells a thread has processed so far.
+         */
+        struct ThreadStatistics {
+            uint64_t count = 0;
+            double mean = 0;
+            // The sum of the squared differences from the mean.
+            double m2 = 0;
+            uint64_t sum = 0;
+            double momentX = 0;
+            double momentY = 0;
+            int min = 255 * 3;
+            int max = 0;
+
+            /**
+             * Adds the statistics of another set of cells, using the parallel form of Welford's
+             * algorithm.
+             */
+            void merge(uint64_t otherCount, double otherMean, double otherM2) {
+                if (otherCount == 0) {
+                    return;
+                }
+                uint64_t total = count + otherCount;
+                double delta = otherMean - mean;
+                mean += delta * otherCount / total;
+                m2 += otherM2 + delta * delta * ((double) count * otherCount / total);
+                count = total;
+            }
+        };
+    }  // namespace
+
+    class StatisticsTask : public Task {
+        const uint8_t *mIn;
+        const size_t mInStride;
+        const uint8_t mChannel;
+        const uint32_t mRequested;
+        PerThread<ThreadStatistics> mThreads;
+        // The histograms of each thread, 256 * 4 counts per thread, borrowed from the scratch
+        // arena of the calling thread. Null if no histogram was requested.
+        int32_t *mSums = nullptr;
+
+        void accumulateHistogram(int32_t *sums, const uchar4 *in, size_t count);
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        StatisticsTask(const uint8_t *input, size_t sizeX, size_t sizeY, uint8_t channel,
+                       uint32_t requested, uint32_t threadCount, ScratchArena &scratch,
+                       const Restriction *restriction)
+                : Task{sizeX, sizeY, 4, false, restriction},
+                  mIn{input},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
+                  mChannel{channel},
+                  mRequested{requested},
+                  mThreads(threadCount) {
+            if (requested & (uint32_t) Statistic::HISTOGRAM) {
+                mSums = scratch.allocate<int32_t>(256 * 4 * threadCount);
+                std::fill_n(mSums, 256 * 4 * threadCount, 0);
+            }
+        }
+
+        void collate(double *out, int32_t *histogram);
+    };
+
+    void StatisticsTask::accumulateHistogram(int32_t *sums, const uchar4 *in, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            uchar4 v = in[i];
+            sums[(v.x << 2)]++;
+            sums[(v.y << 2) + 1]++;
+            sums[(v.z << 2) + 2]++;
+            sums[(v.w << 2) + 3]++;
+        }
+    }
+
+    void
+    StatisticsTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                                size_t endY) {
+        ThreadStatistics *stats = &mThreads[threadIndex];
+        for (size_t y = startY; y < endY; y++) {
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+            for (size_t x = startX; x < endX; x += kMaxCellsPerReductionRun) {
+                const size_t count = std::min(endX - x, kMaxCellsPerReductionRun);
+                ReductionSums run;
+                reduceRun(in + x, count, mChannel, mUsesSimd, &run);
+
+                // count * sumOfSquares - sum * sum is the exact count * m2 of the run. The product
+                // needs 64 bits, size_t is 32 on the 32-bit ABIs.
+                const uint64_t sum = run.sum;
+                stats->merge(count, (double) sum / count,
+                             (double) ((uint64_t) count * run.sumOfSquares - sum * sum) / count);
+                stats->sum += sum;
+                // The run's x are relative to its start.
+                stats->momentX += run.sumOfXTimesValue + (double) x * sum;
+                stats->momentY += (double) y * sum;
+                stats->min = std::min(stats->min, (int) run.min);
+                stats->max = std::max(stats->max, (int) run.max);
+            }
+        }
+
+        if (mSums != nullptr) {
+            int32_t *sums = &mSums[256 * 4 * threadIndex];
+            for (size_t y = startY; y < endY; y++) {
+                const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y);
+                accumulateHistogram(sums, in + startX, endX - startX);
+            }
+        }
+    }
+
+    void StatisticsTask::collate(double *out, int32_t *histogram) {
+        ThreadStatistics all;
+        for (size_t t = 0; t < mThreads.size(); t++) {
+            const ThreadStatistics &stats = mThreads[t];
+            all.merge(stats.count, stats.mean, stats.m2);
+            all.sum += stats.sum;
+            all.momentX += stats.momentX;
+            all.momentY += stats.momentY;
+            all.min = std::min(all.min, stats.min);
+            all.max = std::max(all.max, stats.max);
+        }
+
+        // The values summed for the gray channel are three times the gray value.
+        const double scale = mChannel <= 3 ? 1.0 : 3.0;
+        if (mRequested & (uint32_t) Statistic::MIN_MAX) {
+            // Like minMax, the extremes are floats and default to 255 and 0 if there are no cells.
+            // For the integers summed, dividing as floats gives the same value as minMax.
+            out[0] = all.count == 0 ? 255.f : all.min / (float) scale;
+            out[1] = all.count == 0 ? 0.f : all.max / (float) scale;
+        }
+        if (mRequested & (uint32_t) Statistic::AVERAGE) {
+            out[2] = all.mean / scale;
+        }
+        if (mRequested & (uint32_t) Statistic::STANDARD_DEVIATION) {
+            out[3] = all.count == 0 ? 0 : sqrt(all.m2 / all.count) / scale;
+        }
+        if (mRequested & (uint32_t) Statistic::MOMENT) {
+            // Like moment, the moment is computed as floats and is 0 for an all black image.
+            out[4] = all.sum == 0 ? 0.f : (float) (all.momentX / all.sum);
+            out[5] = all.sum == 0 ? 0.f : (float) (all.momentY / all.sum);
+        }
+
+        if (mSums != nullptr) {
+            const size_t threadCount = mThreads.size();
+            for (size_t i = 0; i < 256 * 4; i++) {
+                int32_t sum = 0;
+                for (size_t t = 0; t < threadCount; t++) {
+                    sum += mSums[t * 256 * 4 + i];
+                }
+                histogram[i] = sum;
+            }
+        }
+    }
+
+    void RenderScriptToolkit::statistics(const uint8_t *input, double *output, int32_t *histogram,
+                                         size_t sizeX, size_t sizeY, uint8_t channel,
+                                         uint32_t requested, const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, 0)) {
+            return;
+        }
+        if ((requested & (uint32_t) Statistic::HISTOGRAM) && histogram == nullptr) {
+            ALOGE("The histogram was requested but no histogram buffer was provided.");
+            return;
+        }
+#endif
+
+        ScratchArena::Scope scope(TaskProcessor::callingThreadScratch());
+        StatisticsTask task(input, sizeX, sizeY, channel, requested,
+                            processor->getNumberOfThreads(), TaskProcessor::callingThreadScratch(),
+                            restriction);
+        processor->doTask(&task);
+        task.collate(output, histogram);
+    }
+
+}  // namespace renderscript
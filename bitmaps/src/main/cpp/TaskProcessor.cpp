@@ -16,7 +16,12 @@
 
 #include "TaskProcessor.h"
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <functional>
+#include <memory>
+#include <new>
 #include <sys/prctl.h>
 
 #include "RenderScriptToolkit.h"
@@ -26,13 +31,89 @@
 
 namespace renderscript {
 
-int Task::setTiling(unsigned int targetTileSizeInBytes) {
-    // Empirically, values smaller than 1000 are unlikely to give good performance.
-    targetTileSizeInBytes = std::max(1000u, targetTileSizeInBytes);
-    const size_t cellSizeInBytes =
-            mVectorSize;  // If we add float support, vectorSize * 4 for that.
-    const size_t targetCellsPerTile = targetTileSizeInBytes / cellSizeInBytes;
-    assert(targetCellsPerTile > 0);
+namespace {
+
+/**
+ * The number of heap blocks allocated by the scratch arenas.
+ */
+std::atomic<uint64_t> scratchHeapAllocations{0};
+
+uint8_t* allocateScratchBlock(size_t size) {
+    scratchHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<uint8_t*>(::operator new(size, std::align_val_t{kCacheLineSize}));
+}
+
+void freeScratchBlock(void* block) { ::operator delete(block, std::align_val_t{kCacheLineSize}); }
+
+}  // namespace
+
+struct ScratchArena::Overflow {
+    Overflow* next;
+    /**
+     * The value of mUsed when the block was borrowed.
+     */
+    size_t mark;
+};
+
+ScratchArena::~ScratchArena() {
+    release(0);
+    freeScratchBlock(mBuffer);
+}
+
+void* ScratchArena::allocate(size_t size) {
+    size = divideRoundingUp(std::max<size_t>(size, 1), kCacheLineSize) * kCacheLineSize;
+    const size_t mark = mUsed;
+    mUsed += size;
+    mPeak = std::max(mPeak, mUsed);
+    if (mOverflows == nullptr && mUsed <= mCapacity) {
+        return mBuffer + mark;
+    }
+    // Once an allocation did not fit, the following ones go to the heap too, until the buffer
+    // can be grown. The Overflow header takes a cache line so that the memory after it stays
+    // aligned.
+    uint8_t* block = allocateScratchBlock(kCacheLineSize + size);
+    mOverflows = new (block) Overflow{mOverflows, mark};
+    return block + kCacheLineSize;
+}
+
+void ScratchArena::release(size_t mark) {
+    while (mOverflows != nullptr && mOverflows->mark >= mark) {
+        Overflow* next = mOverflows->next;
+        freeScratchBlock(mOverflows);
+        mOverflows = next;
+    }
+    mUsed = mark;
+    if (mUsed == 0 && mPeak > mCapacity && mCapacity < kMaxRetainedBytes) {
+        // Doubling at least keeps the number of times we grow small when the needs creep up.
+        freeScratchBlock(mBuffer);
+        mCapacity = std::min(std::max(mPeak, 2 * mCapacity), kMaxRetainedBytes);
+        mBuffer = allocateScratchBlock(mCapacity);
+        mPeak = 0;
+    }
+}
+
+void ScratchArena::trim() {
+    if (mUsed != 0) {
+        return;
+    }
+    freeScratchBlock(mBuffer);
+    mBuffer = nullptr;
+    mCapacity = 0;
+    mPeak = 0;
+}
+
+uint64_t ScratchArena::getHeapAllocationCount() {
+    return scratchHeapAllocations.load(std::memory_order_relaxed);
+}
+
+int Task::setTiling(unsigned int targetWorkingSetInBytes, unsigned int minTileCount) {
+    // Empirically, values smaller than 2000 are unlikely to give good performance.
+    targetWorkingSetInBytes = std::max(2000u, targetWorkingSetInBytes);
+    const size_t cellSizeInBytes = mVectorSize * mElementSize;
+    const size_t workingSetPerCell =
+            mWorkingSetPerCell != 0 ? mWorkingSetPerCell : 2 * cellSizeInBytes;
+    const size_t targetCellsPerTile =
+            std::max<size_t>(1, targetWorkingSetInBytes / workingSetPerCell);
 
     size_t cellsToProcessY;
     size_t cellsToProcessX;
@@ -46,19 +127,57 @@ int Task::setTiling(unsigned int targetTileSizeInBytes) {
         cellsToProcessY = mRestriction->endY - mRestriction->startY;
     }
 
-    // We want rows as large as possible, as the SIMD code we have is more efficient with
-    // large rows.
-    mTilesPerRow = divideRoundingUp(cellsToProcessX, targetCellsPerTile);
+    setTileShape(cellsToProcessX, cellsToProcessY, targetCellsPerTile, mReach);
+    if (mTilesPerRow * mTilesPerColumn < minTileCount) {
+        // Tall tiles leave threads idle on small data. Wide ones keep them busy.
+        setTileShape(cellsToProcessX, cellsToProcessY, targetCellsPerTile, 0);
+    }
+    return mTilesPerRow * mTilesPerColumn;
+}
+
+void Task::setTileShape(size_t cellsToProcessX, size_t cellsToProcessY,
+                        size_t targetCellsPerTile, size_t reach) {
+    // A tile reads reach rows above and below it. Tiles at least four times as high as the
+    // reach keep these extra rows to half of the rows processed.
+    const size_t extraRows = 2 * reach;
+    const size_t minRowsPerTile = std::max(mMinRowsPerTile, 2 * extraRows);
+    if (reach == 0) {
+        // We want rows as large as possible, as the SIMD code we have is more efficient with
+        // large rows.
+        mTilesPerRow = divideRoundingUp(cellsToProcessX, targetCellsPerTile);
+    } else {
+        // The tile is made narrow enough for all the rows it reads to fit the target, so that
+        // they stay in the cache from one of its rows to the next. It stays 8 times wider than
+        // the reach so that the cells read left and right of it are a small part too.
+        const size_t minCellsPerRow = std::max<size_t>(64, 8 * reach);
+        const size_t targetCellsPerRow =
+                std::max(minCellsPerRow, targetCellsPerTile / (minRowsPerTile + extraRows));
+        mTilesPerRow = divideRoundingUp(cellsToProcessX, targetCellsPerRow);
+    }
     // Once we know the number of tiles per row, we divide that row evenly. We round up to make
     // sure all cells are included in the last tile of the row.
     mCellsPerTileX = divideRoundingUp(cellsToProcessX, mTilesPerRow);
 
-    // We do the same thing for the Y direction.
-    size_t targetRowsPerTile = divideRoundingUp(targetCellsPerTile, mCellsPerTileX);
+    // We do the same thing for the Y direction, leaving room for the extra rows.
+    const size_t rowsRead = divideRoundingUp(targetCellsPerTile, mCellsPerTileX);
+    size_t targetRowsPerTile =
+            std::max(rowsRead > extraRows ? rowsRead - extraRows : 0, minRowsPerTile);
     mTilesPerColumn = divideRoundingUp(cellsToProcessY, targetRowsPerTile);
     mCellsPerTileY = divideRoundingUp(cellsToProcessY, mTilesPerColumn);
+}
 
-    return mTilesPerRow * mTilesPerColumn;
+size_t Task::inputStride(size_t packedRowSize) const {
+    if (mRestriction != nullptr && mRestriction->inputStride != 0) {
+        return mRestriction->inputStride;
+    }
+    return packedRowSize;
+}
+
+size_t Task::outputStride(size_t packedRowSize) const {
+    if (mRestriction != nullptr && mRestriction->outputStride != 0) {
+        return mRestriction->outputStride;
+    }
+    return packedRowSize;
 }
 
 void Task::processTile(unsigned int threadIndex, size_t tileIndex) {
@@ -89,7 +208,12 @@ void Task::processTile(unsigned int threadIndex, size_t tileIndex) {
     size_t endCellY = std::min(startCellY + mCellsPerTileY, endWorkY);
 
     // Call the derived class to do the specific work.
-    if (mPrefersDataAsOneRow && startCellX == 0 && endCellX == mSizeX) {
+    // Rows that are padded don't follow each other in memory.
+    const bool rowsArePacked = mRestriction == nullptr ||
+                               (mRestriction->inputStride == 0 && mRestriction->outputStride == 0);
+    // What the tile borrows from the scratch arena is given back when it's done.
+    ScratchArena::Scope scope(scratch(threadIndex));
+    if (mPrefersDataAsOneRow && rowsArePacked && startCellX == 0 && endCellX == mSizeX) {
         // When the tile covers entire rows, we can take advantage that some ops are not 2D.
         processData(threadIndex, 0, startCellY, mSizeX * (endCellY - startCellY), startCellY + 1);
     } else {
@@ -97,6 +221,51 @@ void Task::processTile(unsigned int threadIndex, size_t tileIndex) {
     }
 }
 
+namespace {
+
+uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+
+uint32_t rangeBegin(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+
+uint32_t rangeEnd(uint64_t range) { return static_cast<uint32_t>(range); }
+
+/**
+ * The priority given to the tasks started from this thread.
+ */
+thread_local int callingThreadPriority = 0;
+
+/**
+ * The scratch arena of this thread when it calls doTask.
+ */
+thread_local ScratchArena callingThreadScratchArena;
+
+}  // namespace
+
+/**
+ * The scheduling state of one call to doTask. It lives on the stack of doTask, which does not
+ * return before every pool thread that joined the work has left it.
+ */
+struct TaskProcessor::Work {
+    Task* task;
+    int priority;
+    /**
+     * One TileRange per thread, indexed by the thread index. Borrowed from the scratch arena of
+     * the calling thread.
+     */
+    TileRange* tileRanges;
+    /**
+     * The number of pool threads currently claiming or processing tiles of this work.
+     */
+    int activeWorkers /*GUARDED_BY(mQueueMutex)*/ = 0;
+    /**
+     * Cleared once a thread found no tile left to claim. Pool threads don't join the work
+     * after that.
+     */
+    bool hasTilesToClaim /*GUARDED_BY(mQueueMutex)*/ = true;
+};
+
 TaskProcessor::TaskProcessor(unsigned int numThreads)
     : mUsesSimd{cpuSupportsSimd()},
       /* If the requested number of threads is 0, we'll decide based on the number of cores.
@@ -108,10 +277,14 @@ TaskProcessor::TaskProcessor(unsigned int numThreads)
        * worker pool thread than the total number of threads.
        */
       mNumberOfPoolThreads{numThreads ? numThreads - 1
-                                      : std::min(6u, std::thread::hardware_concurrency() - 1)} {
-    for (size_t i = 0; i < mNumberOfPoolThreads; i++) {
-        mPoolThreads.emplace_back(
-                std::bind(&TaskProcessor::processTilesOfWork, this, i + 1, false));
+                                      : std::min(6u, std::thread::hardware_concurrency() - 1)},
+      mPoolScratch{new ScratchArena[mNumberOfPoolThreads]},
+      mHighestPriority{INT_MIN} {
+    for (auto& target : mTilingTargets) {
+        target.store(kDefaultTilingTarget, std::memory_order_relaxed);
+    }
+    for (unsigned int i = 0; i < mNumberOfPoolThreads; i++) {
+        mPoolThreads.emplace_back(std::bind(&TaskProcessor::poolThreadLoop, this, i + 1));
     }
 }
 
@@ -127,93 +300,213 @@ TaskProcessor::~TaskProcessor() {
     }
 }
 
-void TaskProcessor::processTilesOfWork(int threadIndex, bool returnWhenNoWork) {
-    if (threadIndex != 0) {
-        // Set the name of the thread, except for thread 0, which is not part of the pool.
-        // PR_SET_NAME takes a maximum of 16 characters, including the terminating null.
-        char name[16]{"RenderScToolkit"};
-        prctl(PR_SET_NAME, name, 0, 0, 0);
-        // ALOGI("Starting thread%d", threadIndex);
-    }
+void TaskProcessor::setCallingThreadPriority(int priority) { callingThreadPriority = priority; }
+
+ScratchArena& TaskProcessor::callingThreadScratch() { return callingThreadScratchArena; }
+
+void TaskProcessor::trimScratch() {
+    callingThreadScratchArena.trim();
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mTrimGeneration++;
+    mWorkAvailableOrStop.notify_all();
+}
+
+void TaskProcessor::poolThreadLoop(unsigned int threadIndex) {
+    // Set the name of the thread. PR_SET_NAME takes a maximum of 16 characters, including the
+    // terminating null.
+    char name[16]{"RenderScToolkit"};
+    prctl(PR_SET_NAME, name, 0, 0, 0);
 
     std::unique_lock<std::mutex> lock(mQueueMutex);
+    uint64_t trimmedGeneration = mTrimGeneration;
     while (true) {
-        mWorkAvailableOrStop.wait(lock, [this, returnWhenNoWork]() /*REQUIRES(mQueueMutex)*/ {
-            return mStopThreads || (mTilesNotYetStarted > 0) ||
-                   (returnWhenNoWork && (mTilesNotYetStarted == 0));
+        Work* work = nullptr;
+        mWorkAvailableOrStop.wait(lock, [this, &work, trimmedGeneration]()
+                                  /*REQUIRES(mQueueMutex)*/ {
+            return mStopThreads || (work = pickWork()) != nullptr || !mJobs.empty() ||
+                   trimmedGeneration != mTrimGeneration;
         });
-        // ALOGI("Woke thread%d", threadIndex);
-
-        // This ScopedLockAssertion is to help the compiler when it checks thread annotations
-        // to realize that we have the lock. It's however not completely true; we don't
-        // hold the lock while processing the tile.
-        // TODO Figure out how to fix that.
-        // android::base::ScopedLockAssertion lockAssert(mQueueMutex);
-        if (mStopThreads || (returnWhenNoWork && mTilesNotYetStarted == 0)) {
-            break;
-        }
-
-        while (mTilesNotYetStarted > 0 && !mStopThreads) {
-            // This picks the tiles in decreasing order but that does not matter.
-            int myTile = --mTilesNotYetStarted;
-            mTilesInProcess++;
+        if (work != nullptr) {
+            // While we're counted as active, doTask won't return and the work stays valid.
+            work->activeWorkers++;
             lock.unlock();
-            {
-                // We won't be executing this code unless the main thread is
-                // holding the mTaskMutex lock, which guards mCurrentTask.
-                // The compiler can't figure this out.
-                // android::base::ScopedLockAssertion lockAssert(mTaskMutex);
-                mCurrentTask->processTile(threadIndex, myTile);
+            bool allClaimed = processTilesOfWork(work, threadIndex, true);
+            lock.lock();
+            if (allClaimed && work->hasTilesToClaim) {
+                retireWork(work);
+            }
+            if (--work->activeWorkers == 0 && !work->hasTilesToClaim) {
+                mWorkIsFinished.notify_all();
             }
+        } else if (!mJobs.empty()) {
+            auto job = std::move(mJobs.front());
+            mJobs.pop_front();
+            mJobsInProgress++;
+            lock.unlock();
+            callingThreadPriority = job.second;
+            job.first();
             lock.lock();
-            mTilesInProcess--;
-            if (mTilesInProcess == 0 && mTilesNotYetStarted == 0) {
-                mWorkIsFinished.notify_one();
+            if (--mJobsInProgress == 0 && mJobs.empty()) {
+                mWorkIsFinished.notify_all();
+            }
+        } else if (trimmedGeneration != mTrimGeneration) {
+            // Nothing is borrowed from the arenas between tiles and jobs.
+            trimmedGeneration = mTrimGeneration;
+            lock.unlock();
+            mPoolScratch[threadIndex - 1].trim();
+            callingThreadScratchArena.trim();
+            lock.lock();
+        } else {
+            // mStopThreads is set and there's nothing left to do.
+            break;
+        }
+    }
+}
+
+void TaskProcessor::post(std::function<void()> job) {
+    if (mNumberOfPoolThreads == 0) {
+        job();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mJobs.emplace_back(std::move(job), callingThreadPriority);
+    mWorkAvailableOrStop.notify_one();
+}
+
+void TaskProcessor::waitForPostedJobs() {
+    std::unique_lock<std::mutex> lock(mQueueMutex);
+    mWorkIsFinished.wait(lock, [this]() /*REQUIRES(mQueueMutex)*/ {
+        return mJobs.empty() && mJobsInProgress == 0;
+    });
+}
+
+TaskProcessor::Work* TaskProcessor::pickWork() {
+    Work* best = nullptr;
+    for (Work* work : mWork) {
+        if (!work->hasTilesToClaim) {
+            continue;
+        }
+        // Prefer the highest priority, then the fewest helpers, then the oldest.
+        if (best == nullptr || work->priority > best->priority ||
+            (work->priority == best->priority && work->activeWorkers < best->activeWorkers)) {
+            best = work;
+        }
+    }
+    return best;
+}
+
+void TaskProcessor::retireWork(Work* work) {
+    work->hasTilesToClaim = false;
+    int highest = INT_MIN;
+    for (Work* other : mWork) {
+        if (other->hasTilesToClaim) {
+            highest = std::max(highest, other->priority);
+        }
+    }
+    mHighestPriority.store(highest, std::memory_order_relaxed);
+}
+
+bool TaskProcessor::processTilesOfWork(Work* work, unsigned int threadIndex,
+                                       bool yieldToHigherPriority) {
+    size_t tileIndex;
+    while (!yieldToHigherPriority ||
+           mHighestPriority.load(std::memory_order_relaxed) <= work->priority) {
+        if (!claimTile(work, threadIndex, &tileIndex)) {
+            return true;
+        }
+        work->task->processTile(threadIndex, tileIndex);
+    }
+    return false;
+}
+
+bool TaskProcessor::claimTile(Work* work, unsigned int threadIndex, size_t* tileIndex) {
+    // Take the first tile of our own range.
+    std::atomic<uint64_t>& own = work->tileRanges[threadIndex].range;
+    uint64_t range = own.load(std::memory_order_relaxed);
+    while (rangeBegin(range) < rangeEnd(range)) {
+        if (own.compare_exchange_weak(range, packRange(rangeBegin(range) + 1, rangeEnd(range)),
+                                      std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            *tileIndex = rangeBegin(range);
+            return true;
+        }
+    }
+
+    // Our range is empty. Steal the back half of the range of the next thread that has work.
+    const unsigned int numberOfThreads = getNumberOfThreads();
+    for (unsigned int i = 1; i < numberOfThreads; i++) {
+        std::atomic<uint64_t>& victim =
+                work->tileRanges[(threadIndex + i) % numberOfThreads].range;
+        range = victim.load(std::memory_order_relaxed);
+        while (rangeBegin(range) < rangeEnd(range)) {
+            const uint32_t begin = rangeBegin(range);
+            const uint32_t end = rangeEnd(range);
+            const uint32_t middle = end - (end - begin + 1) / 2;
+            if (victim.compare_exchange_weak(range, packRange(begin, middle),
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed)) {
+                // Process the first stolen tile now and keep the rest in our own range. Other
+                // threads only modify non-empty ranges, so a plain store is safe here.
+                own.store(packRange(middle + 1, end), std::memory_order_release);
+                *tileIndex = middle;
+                return true;
             }
         }
     }
-    // if (threadIndex != 0) {
-    //     ALOGI("Ending thread%d", threadIndex);
-    // }
+    return false;
 }
 
 void TaskProcessor::doTask(Task* task) {
-    std::lock_guard<std::mutex> lockGuard(mTaskMutex);
+    ScratchArena& scratch = callingThreadScratch();
+    ScratchArena::Scope scope(scratch);
     task->setUsesSimd(mUsesSimd);
-    mCurrentTask = task;
+    task->setScratch(&scratch, mPoolScratch.get());
+    TileRange* tileRanges = scratch.allocate<TileRange>(getNumberOfThreads());
+    for (unsigned int i = 0; i < getNumberOfThreads(); i++) {
+        new (&tileRanges[i]) TileRange();
+    }
+    Work work{task, callingThreadPriority, tileRanges};
     // Notify the thread pool of available work.
-    startWork(task);
-    // Start processing some of the tiles on the calling thread.
-    processTilesOfWork(0, true);
+    startWork(&work);
+    // Process tiles on the calling thread too. We don't yield to other tasks: a low priority
+    // task still progresses at the pace of its own thread.
+    processTilesOfWork(&work, 0, false);
     // Wait for all the pool workers to complete.
-    waitForPoolWorkersToComplete();
-    mCurrentTask = nullptr;
+    waitForPoolWorkersToComplete(&work);
 }
 
-void TaskProcessor::startWork(Task* task) {
-    /**
-     * The size in bytes that we're hoping each tile will be. If this value is too small,
-     * we'll spend too much time in synchronization. If it's too large, some cores may be
-     * idle while others still have a lot of work to do. Ideally, it would depend on the
-     * device we're running. 16k is the same value used by RenderScript and seems reasonable
-     * from ad-hoc tests.
-     */
-    const size_t targetTileSize = 16 * 1024;
+void TaskProcessor::startWork(Work* work) {
+    const uint32_t numberOfThreads = getNumberOfThreads();
+    const uint32_t numberOfTiles =
+            work->task->setTiling(getTilingTarget(work->task->tilingGroup()), numberOfThreads);
+    // Give each thread an equal share of consecutive tiles. Neighboring tiles are usually
+    // neighboring memory, so this also helps the caches.
+    for (uint32_t i = 0; i < numberOfThreads; i++) {
+        const uint32_t begin = static_cast<uint64_t>(numberOfTiles) * i / numberOfThreads;
+        const uint32_t end = static_cast<uint64_t>(numberOfTiles) * (i + 1) / numberOfThreads;
+        work->tileRanges[i].range.store(packRange(begin, end), std::memory_order_relaxed);
+    }
 
+    // The mutex publishes the ranges and the task to the pool threads.
     std::lock_guard<std::mutex> lock(mQueueMutex);
-    assert(mTilesInProcess == 0);
-    mTilesNotYetStarted = task->setTiling(targetTileSize);
+    mWork.push_back(work);
+    if (work->priority > mHighestPriority.load(std::memory_order_relaxed)) {
+        mHighestPriority.store(work->priority, std::memory_order_relaxed);
+    }
     mWorkAvailableOrStop.notify_all();
 }
 
-void TaskProcessor::waitForPoolWorkersToComplete() {
+void TaskProcessor::waitForPoolWorkersToComplete(Work* work) {
     std::unique_lock<std::mutex> lock(mQueueMutex);
-    // The predicate, i.e. the lambda, will make sure that
-    // we terminate even if the main thread calls this after
-    // mWorkIsFinished is signaled.
-    mWorkIsFinished.wait(lock, [this]() /*REQUIRES(mQueueMutex)*/ {
-        return mTilesNotYetStarted == 0 && mTilesInProcess == 0;
+    // All the tiles have been claimed once the calling thread runs out of work. We only need
+    // to wait for the pool threads still processing the tiles they claimed.
+    if (work->hasTilesToClaim) {
+        retireWork(work);
+    }
+    mWorkIsFinished.wait(lock, [work]() /*REQUIRES(mQueueMutex)*/ {
+        return work->activeWorkers == 0;
     });
+    // Removing the work while holding the lock ensures no late pool thread picks it up.
+    mWork.erase(std::find(mWork.begin(), mWork.end(), work));
 }
 
 }  // namespace renderscript
@@ -22,18 +22,134 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "RenderScriptToolkit.h"
+
 namespace renderscript {
 
+/**
+ * The size of a cache line. Data written by different threads should be at least this far apart
+ * so that the threads don't invalidate each other's caches, i.e. to avoid false sharing.
+ */
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * Temporary memory for one thread, e.g. the rows a tile is blurred through. The memory is kept
+ * from one task to the next so that, once the arena is as large as the tasks need, borrowing
+ * from it doesn't allocate. Video processing that does the same ops on every frame does no heap
+ * allocation after the first frames.
+ *
+ * Memory is borrowed with allocate() and given back when the innermost Scope ends, like a stack:
+ *    ScratchArena::Scope scope(arena);
+ *    float* line = arena.allocate<float>(count);  // Valid until scope ends.
+ *
+ * The TaskProcessor opens a scope around each tile, see Task::scratch(). Memory that has to
+ * outlive the tiles, e.g. per thread accumulators, is borrowed from the arena of the calling
+ * thread before doTask, see TaskProcessor::callingThreadScratch().
+ *
+ * The buffer kept between tasks is capped at kMaxRetainedBytes. Larger needs are met from heap
+ * blocks that are freed when the outermost scope ends, so a single very large image doesn't pin
+ * its scratch memory for the life of the thread. trim() frees the buffer.
+ *
+ * Every allocation is aligned on a cache line. An arena is used by a single thread.
+ */
+class alignas(kCacheLineSize) ScratchArena {
+    /**
+     * A block allocated because the buffer was too small. See allocate().
+     */
+    struct Overflow;
+
+    /**
+     * The memory allocations are taken from.
+     */
+    uint8_t* mBuffer = nullptr;
+    size_t mCapacity = 0;
+    /**
+     * The number of bytes borrowed, including the ones in overflow blocks.
+     */
+    size_t mUsed = 0;
+    /**
+     * The largest mUsed since the buffer was last grown.
+     */
+    size_t mPeak = 0;
+    /**
+     * The overflow blocks still borrowed, the most recent first.
+     */
+    Overflow* mOverflows = nullptr;
+
+    /**
+     * Gives back everything borrowed after mark. Once nothing is borrowed, grows the buffer to
+     * what was needed at the peak, up to kMaxRetainedBytes, so that the same requests fit next
+     * time.
+     */
+    void release(size_t mark);
+
+   public:
+    /**
+     * The largest buffer an arena keeps between tasks. It covers the per-call needs of the ops
+     * on frames of a few megapixels.
+     */
+    static constexpr size_t kMaxRetainedBytes = 16 * 1024 * 1024;
+
+    /**
+     * Gives back what was borrowed from the arena during its lifetime.
+     */
+    class Scope {
+        ScratchArena& mArena;
+        const size_t mMark;
+
+       public:
+        explicit Scope(ScratchArena& arena) : mArena{arena}, mMark{arena.mUsed} {}
+        ~Scope() { mArena.release(mMark); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    ScratchArena() = default;
+    ~ScratchArena();
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * Borrows size bytes, aligned on a cache line. The content is not initialized. Should be
+     * called within a Scope.
+     *
+     * If the buffer is too small, the memory comes from a new heap block until the outermost
+     * scope ends.
+     */
+    void* allocate(size_t size);
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    /**
+     * Frees the buffer, if nothing is borrowed. The next tasks grow it again as they need.
+     */
+    void trim();
+
+    /**
+     * The number of heap blocks allocated by all the arenas since the process started. Once
+     * the arenas are large enough for the work being repeated, it stays the same.
+     */
+    static uint64_t getHeapAllocationCount();
+};
+
 /**
  * Description of the data to be processed for one Toolkit method call, e.g. one blur or one
  * blend operation.
  *
- * The data to be processed is a 2D array of cells. Each cell is a vector of 1 to 4 unsigned bytes.
- * The most typical configuration is a 2D array of uchar4 used to represent RGBA images.
+ * The data to be processed is a 2D array of cells. Each cell is a vector of 1 to 4 unsigned bytes,
+ * or of 1 to 4 floats for the float ops. The most typical configuration is a 2D array of uchar4
+ * used to represent RGBA images.
  *
  * This is a base class. There will be a subclass for each Toolkit op.
  *
@@ -41,8 +157,8 @@ namespace renderscript {
  *    BlurTask task(in, out, sizeX, sizeY, vectorSize, etc);
  *    processor->doTask(&task);
  *
- * The TaskProcessor should call setTiling() and setUsesSimd() once, before calling processTile().
- * Other classes should not call setTiling(), setUsesSimd(), and processTile().
+ * The TaskProcessor should call setTiling(), setUsesSimd() and setScratch() once, before calling
+ * processTile(). Other classes should not call these methods.
  */
 class Task {
    protected:
@@ -55,9 +171,14 @@ class Task {
      */
     const size_t mSizeY;
     /**
-     * Number of elements in a vector (cell). From 1-4.
+     * Number of elements in a vector (cell). From 1-4. The elements are bytes, or floats for
+     * the float ops.
      */
     const size_t mVectorSize;
+    /**
+     * Number of bytes of an element of a cell. See setElementSize().
+     */
+    size_t mElementSize = 1;
     /**
      * Whether the task prefers the processData call to represent the work to be done as
      * one line rather than a rectangle. This would be the case for work that don't involve
@@ -73,6 +194,62 @@ class Task {
      */
     bool mUsesSimd = false;
 
+    /**
+     * Makes the tiles at least that many rows high, unless the data is smaller. Tasks that read
+     * neighboring rows use it so that the extra rows they read are a small part of a tile.
+     * Should be called before setTiling().
+     */
+    void setMinRowsPerTile(size_t rows) { mMinRowsPerTile = rows; }
+
+    /**
+     * Sets the size in bytes of an element of a cell, e.g. sizeof(float) for the float ops, so
+     * that the tiles are sized in bytes whatever the type. Should be called before setTiling().
+     */
+    void setElementSize(size_t bytes) { mElementSize = bytes; }
+
+    /**
+     * Sets the number of bytes a tile reads and writes per cell, so that the tiles fit the
+     * working set targeted by setTiling(). The default is twice the size of a cell, a cell of
+     * input and one of output. E.g. a resize counts the input cells an output cell is computed
+     * from. Should be called before setTiling().
+     */
+    void setWorkingSetPerCell(size_t bytes) { mWorkingSetPerCell = bytes; }
+
+    /**
+     * Sets how many rows above and below a cell, and cells left and right of it, are read to
+     * compute it, e.g. the radius of a blur. The tiles of such tasks are tall and narrow rather
+     * than as wide as possible, so that the rows a tile reads stay in the cache from one of its
+     * rows to the next. Should be called before setTiling().
+     */
+    void setReach(size_t cells) { mReach = cells; }
+
+    /**
+     * Sets the group of ops that the tiles of this task are sized like. The default is
+     * TilingGroup::OTHER. See RenderScriptToolkit::calibrateTiling().
+     */
+    void setTilingGroup(RenderScriptToolkit::TilingGroup group) { mTilingGroup = group; }
+
+    /**
+     * The scratch arena of the thread processing a tile. What processData borrows from it is
+     * given back when processData returns.
+     *
+     * @param threadIndex The index of the thread, as given to processData.
+     */
+    ScratchArena& scratch(int threadIndex) const {
+        return threadIndex == 0 ? *mCallerScratch : mPoolScratch[threadIndex - 1];
+    }
+
+    /**
+     * The number of bytes from the start of a row of the input to the start of the next. It's the
+     * inputStride of the restriction if it has one, else packedRowSize, the size in bytes of a row
+     * without padding.
+     */
+    size_t inputStride(size_t packedRowSize) const;
+    /**
+     * Like inputStride(), for the output.
+     */
+    size_t outputStride(size_t packedRowSize) const;
+
    private:
     /**
      * If not null, we'll process a subset of the whole 2D array. This specifies the restriction.
@@ -99,6 +276,28 @@ class Task {
      * Number of tiles per column of the restricted area we're working on.
      */
     size_t mTilesPerColumn = 0;
+    /**
+     * The minimum height of a tile, as a number of cells. See setMinRowsPerTile().
+     */
+    size_t mMinRowsPerTile = 1;
+    /**
+     * The bytes read and written per cell, or 0 for twice the cell size. See
+     * setWorkingSetPerCell().
+     */
+    size_t mWorkingSetPerCell = 0;
+    /**
+     * How far around a cell is read to compute it. See setReach().
+     */
+    size_t mReach = 0;
+    /**
+     * See setTilingGroup().
+     */
+    RenderScriptToolkit::TilingGroup mTilingGroup = RenderScriptToolkit::TilingGroup::OTHER;
+    /**
+     * The scratch arenas of the thread that called doTask and of the pool threads. See scratch().
+     */
+    ScratchArena* mCallerScratch = nullptr;
+    ScratchArena* mPoolScratch = nullptr;
 
    public:
     /**
@@ -119,20 +318,32 @@ class Task {
 
     void setUsesSimd(bool uses) { mUsesSimd = uses; }
 
+    void setScratch(ScratchArena* callerScratch, ScratchArena* poolScratch) {
+        mCallerScratch = callerScratch;
+        mPoolScratch = poolScratch;
+    }
+
+    RenderScriptToolkit::TilingGroup tilingGroup() const { return mTilingGroup; }
+
     /**
      * Divide the work into a number of tiles that can be distributed to the various threads.
      * A tile will be a rectangular region. To be robust, we'll want to handle regular cases
      * like 400x300 but also unusual ones like 1x120000, 120000x1, 1x1.
      *
-     * We have a target size for the tiles, which corresponds roughly to how much data a thread
-     * will want to process before checking for more work. If the target is set too low, we'll spend
-     * more time in synchronization. If it's too large, some cores may not be used as efficiently.
+     * We have a target for the memory a tile reads and writes, which corresponds roughly to how
+     * much data a thread will want to process before checking for more work. If the target is
+     * set too low, we'll spend more time in synchronization. If it's too large, the tile no
+     * longer fits the caches and some cores may not be used as efficiently. The shape of the
+     * tiles follows setReach().
      *
      * This method returns the number of tiles.
      *
-     * @param targetTileSizeInBytes Target size. Values less than 1000 will be treated as 1000.
+     * @param targetWorkingSetInBytes Target working set. Values less than 2000 will be treated
+     * as 2000.
+     * @param minTileCount If the tiles shaped for the reach are fewer than this, e.g. fewer
+     * than the threads, the tiles are made as wide as possible instead.
      */
-    int setTiling(unsigned int targetTileSizeInBytes);
+    int setTiling(unsigned int targetWorkingSetInBytes, unsigned int minTileCount = 1);
 
     /**
      * This is called by the TaskProcessor to instruct the task to process a tile.
@@ -143,6 +354,12 @@ class Task {
     void processTile(unsigned int threadIndex, size_t tileIndex);
 
    private:
+    /**
+     * Sets the tile sizes and counts for the given reach. See setTiling().
+     */
+    void setTileShape(size_t cellsToProcessX, size_t cellsToProcessY, size_t targetCellsPerTile,
+                      size_t reach);
+
     /**
      * Call to the derived class to process the data bounded by the rectangle specified
      * by (startX, startY) and (endX, endY). The end values are EXCLUDED. This rectangle
@@ -152,9 +369,58 @@ class Task {
                              size_t endY) = 0;
 };
 
+/**
+ * One value per thread, for the tasks that reduce the data to a few values, e.g. minMax or
+ * average. Each value is on cache lines of its own.
+ *
+ * A task should accumulate a tile in local variables and add them to the value of its thread
+ * once per tile, then combine the values of all the threads after doTask:
+ *    PerThread<double> mTotals;  // Constructed with processor->getNumberOfThreads().
+ *    mTotals[threadIndex] += tileTotal;  // In processData.
+ *    for (size_t t = 0; t < mTotals.size(); t++) sum += mTotals[t];  // After doTask.
+ */
+template <typename T>
+class PerThread {
+    struct alignas(kCacheLineSize) Slot {
+        T value;
+    };
+    /**
+     * Enough slots for the default number of threads, in the object itself so that creating a
+     * task doesn't allocate. More threads use mHeapSlots.
+     */
+    static constexpr size_t kInlineSlots = 8;
+    Slot mInlineSlots[kInlineSlots];
+    std::vector<Slot> mHeapSlots;
+    Slot* mSlots;
+    const size_t mSize;
+
+   public:
+    explicit PerThread(size_t threadCount, const T& initialValue = T())
+        : mSize{threadCount} {
+        if (threadCount > kInlineSlots) {
+            mHeapSlots.assign(threadCount, Slot{initialValue});
+            mSlots = mHeapSlots.data();
+        } else {
+            for (size_t i = 0; i < threadCount; i++) mInlineSlots[i].value = initialValue;
+            mSlots = mInlineSlots;
+        }
+    }
+    PerThread(const PerThread&) = delete;
+    PerThread& operator=(const PerThread&) = delete;
+
+    T& operator[](size_t threadIndex) { return mSlots[threadIndex].value; }
+    const T& operator[](size_t threadIndex) const { return mSlots[threadIndex].value; }
+    size_t size() const { return mSize; }
+};
+
 /**
  * There's one instance of the task processor for the Toolkit. This class owns the thread pool,
  * and dispatches the tiles of work to the threads.
+ *
+ * Several tasks can be in flight at once, e.g. when two application threads call the Toolkit.
+ * The calling thread of doTask always works on its own task. The pool threads help the task with
+ * the highest priority that still has tiles to claim. Between tasks of equal priority, a pool
+ * thread joins the one with the fewest helpers, so that the pool is shared evenly.
  */
 class TaskProcessor {
     /**
@@ -166,10 +432,6 @@ class TaskProcessor {
      * do the work as the client thread that starts the work will also be used.
      */
     const unsigned int mNumberOfPoolThreads;
-    /**
-     * Ensures that only one task is done at a time.
-     */
-    std::mutex mTaskMutex;
     /**
      * Ensures consistent access to the shared queue state.
      */
@@ -179,60 +441,125 @@ class TaskProcessor {
      */
     std::vector<std::thread> mPoolThreads;
     /**
-     * The task being processed, if any. We only do one task at a time. We could create a queue
-     * of tasks but using a mTaskMutex is sufficient for now.
+     * The scratch arenas of the pool threads, indexed by the thread index minus one. The calling
+     * threads use callingThreadScratch(), as several of them can share index 0.
+     */
+    std::unique_ptr<ScratchArena[]> mPoolScratch;
+    /**
+     * The jobs posted with post() that no pool thread has started yet. Each job carries the
+     * priority of the thread that posted it.
+     */
+    std::deque<std::pair<std::function<void()>, int>> mJobs /*GUARDED_BY(mQueueMutex)*/;
+    /**
+     * The number of jobs being run by the pool threads.
      */
-    Task* mCurrentTask /*GUARDED_BY(mTaskMutex)*/ = nullptr;
+    int mJobsInProgress /*GUARDED_BY(mQueueMutex)*/ = 0;
     /**
      * Signals that the mPoolThreads should terminate.
      */
     bool mStopThreads /*GUARDED_BY(mQueueMutex)*/ = false;
     /**
-     * Signaled when work is available or the mPoolThreads need to shut down. mStopThreads is used
-     * to distinguish between the two.
+     * Incremented by trimScratch(). Each pool thread trims its arenas when it next finds it
+     * different from the value it last trimmed for.
+     */
+    uint64_t mTrimGeneration /*GUARDED_BY(mQueueMutex)*/ = 0;
+    /**
+     * Signaled when work or a job is available or the mPoolThreads need to shut down.
      */
     std::condition_variable mWorkAvailableOrStop;
     /**
-     * Signaled when the work for the task is finished.
+     * Signaled when a pool thread stops working on a task whose tiles have all been claimed, and
+     * when the last posted job completes.
      */
     std::condition_variable mWorkIsFinished;
     /**
-     * A user task, e.g. a blend or a blur, is split into a number of tiles. When a thread starts
-     * working on a new tile, it uses this count to identify which tile to work on. The tile
-     * number is sufficient to determine the boundaries of the data to process.
+     * A user task, e.g. a blend or a blur, is split into a number of tiles. The tile number is
+     * sufficient to determine the boundaries of the data to process.
      *
-     * The number of tiles left to process.
+     * When a task starts, the tiles are divided into one contiguous range per thread. A thread
+     * claims the tiles of its own range from the front. Once its range is empty, it steals the
+     * back half of the range of another thread. The range is packed in one 64 bit word, begin
+     * in the high half and end (excluded) in the low half, so that every claim is a single
+     * compare and swap. No lock is taken per tile.
+     *
+     * Each range is on its own cache line so that threads claiming their own tiles don't
+     * contend.
+     */
+    struct alignas(kCacheLineSize) TileRange {
+        std::atomic<uint64_t> range{0};
+    };
+    /**
+     * The scheduling state of one call to doTask. See TaskProcessor.cpp.
+     */
+    struct Work;
+    /**
+     * The tasks in flight, in the order they were started.
      */
-    int mTilesNotYetStarted /*GUARDED_BY(mQueueMutex)*/ = 0;
+    std::vector<Work*> mWork /*GUARDED_BY(mQueueMutex)*/;
     /**
-     * The number of tiles currently being processed. Must not be greater than
-     * mNumberOfPoolThreads + 1.
+     * The highest priority of the tasks in mWork that still have tiles to claim. Pool threads
+     * check it between tiles to switch to a more urgent task. It's only written while holding
+     * mQueueMutex.
      */
-    int mTilesInProcess /*GUARDED_BY(mQueueMutex)*/ = 0;
+    std::atomic<int> mHighestPriority;
+    /**
+     * The working set targeted by the tiles of each RenderScriptToolkit::TilingGroup, indexed
+     * by the group. See Task::setTiling().
+     */
+    std::atomic<uint32_t> mTilingTargets[RenderScriptToolkit::kTilingGroupCount];
 
     /**
      * Determines how we'll tile the work and signals the thread pool of available work.
      *
-     * @param task The task to be performed.
+     * @param work The work to be performed.
      */
-    void startWork(Task* task) /*REQUIRES(mTaskMutex)*/;
+    void startWork(Work* work);
 
     /**
-     * Tells the thread to start processing work off the queue.
+     * The main loop of the pool threads. Waits for a task to be started or a job to be posted,
+     * helps process the tiles of the task or runs the job, and repeats until mStopThreads is set
+     * and no job is left.
      *
-     * The flag is used for prevent the main thread from blocking forever if the work is
-     * so trivial that the worker threads complete the work before the main thread calls this
-     * method.
+     * @param threadIndex The index number (1..mNumberOfPoolThreads) of this thread.
+     */
+    void poolThreadLoop(unsigned int threadIndex);
+
+    /**
+     * Selects the task a pool thread should help with, or nullptr if there's none.
+     */
+    Work* pickWork() /*REQUIRES(mQueueMutex)*/;
+
+    /**
+     * Marks the work as having no tiles left to claim and updates mHighestPriority.
+     */
+    void retireWork(Work* work) /*REQUIRES(mQueueMutex)*/;
+
+    /**
+     * Claims and processes tiles of the work until none are left.
      *
-     * @param threadIndex The index number (0..mNumberOfPoolThreads) this thread will referred by.
-     * @param returnWhenNoWork If there's no work, return immediately.
+     * @param work The work being processed.
+     * @param threadIndex The index number (0..mNumberOfPoolThreads) of the calling thread.
+     * @param yieldToHigherPriority If true, return as soon as a task of higher priority has
+     * tiles to claim.
+     * @return true if all the tiles have been claimed, false if we returned to yield.
      */
-    void processTilesOfWork(int threadIndex, bool returnWhenNoWork);
+    bool processTilesOfWork(Work* work, unsigned int threadIndex, bool yieldToHigherPriority);
 
     /**
-     * Wait for the pool workers to complete the work on the current task.
+     * Claims one tile, first from the range of the calling thread, then by stealing from the
+     * other threads.
+     *
+     * @param work The work to claim from.
+     * @param threadIndex The index number (0..mNumberOfPoolThreads) of the calling thread.
+     * @param tileIndex Set to the claimed tile.
+     * @return false if there are no tiles left to claim.
      */
-    void waitForPoolWorkersToComplete();
+    bool claimTile(Work* work, unsigned int threadIndex, size_t* tileIndex);
+
+    /**
+     * Wait for the pool workers to complete their tiles of the work.
+     */
+    void waitForPoolWorkersToComplete(Work* work);
 
    public:
     /**
@@ -247,14 +574,76 @@ class TaskProcessor {
 
     /**
      * Do the specified task. Returns only after the task has been completed.
+     *
+     * Can be called from several threads at once. The task gets the priority of the calling
+     * thread, see setCallingThreadPriority().
      */
     void doTask(Task* task);
 
+    /**
+     * Runs the job on a pool thread and returns without waiting for it. The job typically
+     * calls doTask, in which case the pool thread works on the task as its calling thread. The
+     * pool threads first help the tasks in flight, then run the jobs in the order they were
+     * posted. Jobs posted before the processor is destroyed are run before the pool threads
+     * exit.
+     *
+     * The job has the priority of the posting thread. If there are no pool threads, the job is
+     * run before post returns.
+     */
+    void post(std::function<void()> job);
+
+    /**
+     * Waits until all the jobs posted so far have completed.
+     */
+    void waitForPostedJobs();
+
+    /**
+     * Sets the priority of the tasks started from the calling thread, for all the processors.
+     * Tasks with a higher value are helped by the pool threads first. The default is 0.
+     */
+    static void setCallingThreadPriority(int priority);
+
+    /**
+     * The scratch arena of the calling thread, shared by all the processors. Ops borrow from it
+     * what lives across tiles or across several calls to doTask. The tiles the calling thread
+     * processes borrow from it too, in nested scopes.
+     */
+    static ScratchArena& callingThreadScratch();
+
+    /**
+     * Frees the scratch memory kept by the calling thread and by the pool threads. The pool
+     * threads free theirs when they are next idle, which is right away if no task or job is in
+     * flight. The arenas grow again as the following tasks need.
+     */
+    void trimScratch();
+
     /**
      * Some Tasks need to allocate temporary storage for each worker thread.
      * This provides the number of threads.
      */
     unsigned int getNumberOfThreads() const { return mNumberOfPoolThreads + 1; }
+
+    /**
+     * The working set targeted by the tiles of the tasks of the group when it's not set. With
+     * the default working set per cell, it gives the 16 KB tiles used by RenderScript, which
+     * seemed reasonable from ad-hoc tests.
+     */
+    static constexpr uint32_t kDefaultTilingTarget = 32 * 1024;
+
+    /**
+     * The working set, in bytes, that the tiles of the tasks of the group are sized for.
+     */
+    uint32_t getTilingTarget(RenderScriptToolkit::TilingGroup group) const {
+        return mTilingTargets[static_cast<size_t>(group)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the working set, in bytes, that the tiles of the tasks of the group are sized for.
+     * Applies to the tasks started afterwards.
+     */
+    void setTilingTarget(RenderScriptToolkit::TilingGroup group, uint32_t bytes) {
+        mTilingTargets[static_cast<size_t>(group)].store(bytes, std::memory_order_relaxed);
+    }
 };
 
 }  // namespace renderscript
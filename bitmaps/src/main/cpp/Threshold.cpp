@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstdint>
 
 #include "RenderScriptToolkit.h"
@@ -25,8 +26,10 @@
 namespace renderscript {
 
     class ThresholdTask : public Task {
-        const uchar4 *mIn;
-        uchar4 *mOut;
+        const uint8_t *mIn;
+        uint8_t *mOut;
+        const size_t mInStride;
+        const size_t mOutStride;
         float mThreshold;
         uint8_t mChannel;
         bool mBinary;
@@ -40,8 +43,10 @@ namespace renderscript {
                       float threshold, bool binary, uint8_t channel,
                       const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn{reinterpret_cast<const uchar4 *>(input)},
-                  mOut{reinterpret_cast<uchar4 *>(output)},
+                  mIn{input},
+                  mOut{output},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
+                  mOutStride{outputStride(sizeX * sizeof(uchar4))},
                   mThreshold{threshold},
                   mChannel{channel},
                   mBinary{binary} {}
@@ -51,9 +56,8 @@ namespace renderscript {
     ThresholdTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                                size_t endY) {
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in = mIn + offset;
-            uchar4 *out = mOut + offset;
+            const uchar4 *in = reinterpret_cast<const uchar4 *>(mIn + mInStride * y) + startX;
+            uchar4 *out = reinterpret_cast<uchar4 *>(mOut + mOutStride * y) + startX;
             for (size_t x = startX; x < endX; x++) {
                 auto v = *in;
                 double value;
@@ -90,7 +94,7 @@ namespace renderscript {
                                         float threshold, bool binary, uint8_t channel,
                                         const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
             return;
         }
 #endif
@@ -99,4 +103,95 @@ namespace renderscript {
         processor->doTask(&task);
     }
 
+    class FloatThresholdTask : public Task {
+        const float *mIn;
+        float *mOut;
+        const size_t mInStride;
+        const size_t mOutStride;
+        float mThreshold;
+        uint8_t mChannel;
+        bool mBinary;
+
+        // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        FloatThresholdTask(const float *input, float *output, size_t sizeX, size_t sizeY,
+                           size_t vectorSize, float threshold, bool binary, uint8_t channel,
+                           const Restriction *restriction)
+                : Task{sizeX, sizeY, vectorSize, true, restriction},
+                  mIn{input},
+                  mOut{output},
+                  mInStride{inputStride(sizeX * vectorSize * sizeof(float))},
+                  mOutStride{outputStride(sizeX * vectorSize * sizeof(float))},
+                  mThreshold{threshold},
+                  // The channels past the vector size mean gray, like the channels past 3 do.
+                  mChannel{channel < vectorSize ? channel : (uint8_t) 4},
+                  mBinary{binary} {
+            setElementSize(sizeof(float));
+        }
+    };
+
+    void
+    FloatThresholdTask::processData(int /* threadIndex */, size_t startX, size_t startY,
+                                    size_t endX, size_t endY) {
+        const size_t vectorSize = mVectorSize;
+        const size_t grayChannels = std::min(vectorSize, (size_t) 3);
+        for (size_t y = startY; y < endY; y++) {
+            const float *in = reinterpret_cast<const float *>(
+                    reinterpret_cast<const uint8_t *>(mIn) + mInStride * y) + startX * vectorSize;
+            float *out = reinterpret_cast<float *>(
+                    reinterpret_cast<uint8_t *>(mOut) + mOutStride * y) + startX * vectorSize;
+            for (size_t x = startX; x < endX; x++) {
+                float value;
+                if (mChannel < 4) {
+                    value = in[mChannel];
+                } else {
+                    value = in[0];
+                    for (size_t c = 1; c < grayChannels; c++) {
+                        value += in[c];
+                    }
+                    value /= grayChannels;
+                }
+
+                for (size_t c = 0; c < vectorSize; c++) {
+                    out[c] = in[c];
+                }
+                if (!(value > mThreshold && !mBinary)) {
+                    const float replacement = value > mThreshold ? 1.f : 0.f;
+                    if (mChannel < 4) {
+                        out[mChannel] = replacement;
+                    } else {
+                        for (size_t c = 0; c < grayChannels; c++) {
+                            out[c] = replacement;
+                        }
+                    }
+                }
+                in += vectorSize;
+                out += vectorSize;
+            }
+        }
+    }
+
+    void RenderScriptToolkit::threshold(const float *input, float *output, size_t sizeX,
+                                        size_t sizeY, size_t vectorSize, float threshold,
+                                        bool binary, uint8_t channel,
+                                        const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        const size_t stride = sizeX * vectorSize * sizeof(float);
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, stride, stride)) {
+            return;
+        }
+        if (vectorSize < 1 || vectorSize > 4) {
+            ALOGE("The vectorSize should be between 1 and 4. %zu provided.", vectorSize);
+            return;
+        }
+#endif
+
+        FloatThresholdTask task(input, output, sizeX, sizeY, vectorSize, threshold, binary,
+                                channel, restriction);
+        processor->doTask(&task);
+    }
+
 }  // namespace renderscript
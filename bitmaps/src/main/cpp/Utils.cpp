@@ -16,7 +16,13 @@
 
 #include "Utils.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __ANDROID__
 #include <cpu-features.h>
+#endif
 
 #include "RenderScriptToolkit.h"
 
@@ -25,6 +31,7 @@ namespace renderscript {
 #define LOG_TAG "renderscript.toolkit.Utils"
 
 bool cpuSupportsSimd() {
+#ifdef __ANDROID__
     AndroidCpuFamily family = android_getCpuFamily();
     uint64_t features = android_getCpuFeatures();
 
@@ -41,10 +48,78 @@ bool cpuSupportsSimd() {
     }
     // ALOGI("Not simd");
     return false;
+#else
+    // Host builds. The cpufeatures library is only available through the NDK.
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("ssse3");
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    return true;
+#else
+    return false;
+#endif
+#endif
+}
+
+/**
+ * Reads the first line of a small text file, without the line feed. Returns false if the file
+ * can't be read.
+ */
+static bool readLine(const char* path, char* line, size_t lineSize) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool read = fgets(line, static_cast<int>(lineSize), file) != nullptr;
+    fclose(file);
+    if (read) {
+        line[strcspn(line, "\n")] = '\0';
+    }
+    return read;
+}
+
+void cpuDataCacheSizes(size_t* l1Size, size_t* l2Size) {
+    *l1Size = 32 * 1024;
+    *l2Size = 512 * 1024;
+    // Linux, and so Android, describes the caches of each core in sysfs, e.g. level "1", type
+    // "Data" and size "32K". An L2 shared by a cluster of cores is listed for each of them.
+    for (int index = 0; index < 8; index++) {
+        char path[64];
+        char level[8];
+        char type[16];
+        char size[16];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        if (!readLine(path, level, sizeof(level))) {
+            break;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        if (!readLine(path, type, sizeof(type)) || strcmp(type, "Instruction") == 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        if (!readLine(path, size, sizeof(size))) {
+            continue;
+        }
+        char* unit = nullptr;
+        size_t bytes = strtoul(size, &unit, 10);
+        if (*unit == 'K') {
+            bytes *= 1024;
+        } else if (*unit == 'M') {
+            bytes *= 1024 * 1024;
+        }
+        if (bytes == 0) {
+            continue;
+        }
+        if (strcmp(level, "1") == 0) {
+            *l1Size = bytes;
+        } else if (strcmp(level, "2") == 0) {
+            *l2Size = bytes;
+        }
+    }
 }
 
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restriction* restriction) {
+bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restriction* restriction,
+                      size_t inputRowSize, size_t outputRowSize) {
     if (restriction == nullptr) {
         return true;
     }
@@ -72,6 +147,18 @@ bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restric
               tag, restriction->startY, restriction->endY);
         return false;
     }
+    if (restriction->inputStride != 0 && restriction->inputStride < inputRowSize) {
+        ALOGE("%s. Restriction inputStride should be 0 or at least the size of a row, %zu. "
+              "%zu was provided.",
+              tag, inputRowSize, restriction->inputStride);
+        return false;
+    }
+    if (restriction->outputStride != 0 && restriction->outputStride < outputRowSize) {
+        ALOGE("%s. Restriction outputStride should be 0 or at least the size of a row, %zu. "
+              "%zu was provided.",
+              tag, outputRowSize, restriction->outputStride);
+        return false;
+    }
     return true;
 }
 #endif
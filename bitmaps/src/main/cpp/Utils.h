@@ -17,13 +17,19 @@
 #ifndef ANDROID_RENDERSCRIPT_TOOLKIT_UTILS_H
 #define ANDROID_RENDERSCRIPT_TOOLKIT_UTILS_H
 
+#ifdef __ANDROID__
 #include <android/log.h>
+#else
+#include <cstdio>
+#endif
 #include <stddef.h>
+#include <string.h>
 
 namespace renderscript {
 
-/* The Toolkit does not support floating point buffers but the original RenderScript Intrinsics
- * did for some operations. That code was preserved and protected by
+/* The float ops of the Toolkit, e.g. the float blur, have kernels of their own that work on
+ * packed float cells. The original RenderScript Intrinsics also supported floating point buffers
+ * in some of their byte kernels. That code was preserved and protected by
  * ANDROID_RENDERSCRIPT_TOOLKIT_SUPPORTS_FLOAT.
  */
 // TODO: On final packaging, decide whether this should be define in the build file, and for which
@@ -38,9 +44,18 @@ namespace renderscript {
  */
 #define ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
 
+#ifdef __ANDROID__
 #define ALOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define ALOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define ALOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+// Host builds (tests and benchmarks) don't have logcat. Write to stderr instead.
+#define ALOG_HOST(level, ...) \
+    (fprintf(stderr, level "/%s: ", LOG_TAG), fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+#define ALOGI(...) ALOG_HOST("I", __VA_ARGS__)
+#define ALOGW(...) ALOG_HOST("W", __VA_ARGS__)
+#define ALOGE(...) ALOG_HOST("E", __VA_ARGS__)
+#endif
 
 using uchar = unsigned char;
 using uint = unsigned int;
@@ -90,6 +105,16 @@ inline float convert(uchar i) {
     return (float)i;
 }
 
+template <>
+inline uchar convert(int i) {
+    return (uchar)i;
+}
+
+template <>
+inline int convert(uchar i) {
+    return (int)i;
+}
+
 inline int4 clamp(int4 amount, int low, int high) {
     int4 r;
     r.x = amount.x < low ? low : (amount.x > high ? high : amount.x);
@@ -133,7 +158,13 @@ inline float clamp(float amount, float low, float high) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
 struct Restriction;
 
-bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restriction* restriction);
+/**
+ * Checks that the restriction fits in a sizeX * sizeY buffer, and that its strides are at least
+ * the size of a packed row. inputRowSize and outputRowSize are the sizes in bytes of packed rows
+ * of the input and of the output. A row size of 0 means the op has no such buffer.
+ */
+bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restriction* restriction,
+                      size_t inputRowSize, size_t outputRowSize);
 #endif
 
 /**
@@ -142,6 +173,12 @@ bool validRestriction(const char* tag, size_t sizeX, size_t sizeY, const Restric
  */
 bool cpuSupportsSimd();
 
+/**
+ * Sets l1Size and l2Size to the sizes in bytes of the L1 data cache and of the L2 cache of the
+ * first core, or to typical sizes when the system doesn't tell.
+ */
+void cpuDataCacheSizes(size_t* l1Size, size_t* l2Size);
+
 inline size_t divideRoundingUp(size_t a, size_t b) {
     return a / b + (a % b == 0 ? 0 : 1);
 }
@@ -150,6 +187,64 @@ inline size_t paddedSize(size_t size) {
     return size == 3 ? 4 : size;
 }
 
+/**
+ * A cell of N packed floats, the way the float ops store them.
+ */
+template <size_t N>
+struct FloatCell {
+    float v[N];
+};
+
+/**
+ * Reads four consecutive floats. The float ops keep their cells packed, e.g. three floats for a
+ * cell of three channels, so their float4 can start at any float.
+ */
+inline float4 loadFloat4(const float* p) {
+    float4 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void storeFloat4(float* p, float4 v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * Sets out[i] to the sum of weights[k] * rows[k][i] over the rowCount rows, for the count floats,
+ * four at a time.
+ */
+inline void weightedSum(const float* const* rows, const float* weights, size_t rowCount,
+                        size_t count, float* out) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float4 sum = 0.f;
+        for (size_t k = 0; k < rowCount; k++) {
+            sum += loadFloat4(rows[k] + i) * weights[k];
+        }
+        storeFloat4(out + i, sum);
+    }
+    for (; i < count; i++) {
+        float sum = 0.f;
+        for (size_t k = 0; k < rowCount; k++) {
+            sum += rows[k][i] * weights[k];
+        }
+        out[i] = sum;
+    }
+}
+
+/**
+ * Adds in[i] * factor to out[i] for the count floats, four at a time.
+ */
+inline void multiplyAdd(const float* in, float factor, size_t count, float* out) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        storeFloat4(out + i, loadFloat4(out + i) + loadFloat4(in + i) * factor);
+    }
+    for (; i < count; i++) {
+        out[i] += in[i] * factor;
+    }
+}
+
 }  // namespace renderscript
 
 #endif  // ANDROID_RENDERSCRIPT_TOOLKIT_UTILS_H
@@ -9,9 +9,12 @@
 namespace renderscript {
 
     class WeightedAddTask : public Task {
-        const uchar4 *mIn1;
-        const uchar4 *mIn2;
-        uchar4 *mOut;
+        const uint8_t *mIn1;
+        const uint8_t *mIn2;
+        uint8_t *mOut;
+        // Both inputs have the same layout.
+        const size_t mInStride;
+        const size_t mOutStride;
         float mWeight1;
         float mWeight2;
         bool mAbsolute;
@@ -26,9 +29,11 @@ namespace renderscript {
                         float weight1, float weight2, bool absolute,
                         const Restriction *restriction)
                 : Task{sizeX, sizeY, 4, true, restriction},
-                  mIn1{reinterpret_cast<const uchar4 *>(input1)},
-                  mIn2{reinterpret_cast<const uchar4 *>(input2)},
-                  mOut{reinterpret_cast<uchar4 *>(output)},
+                  mIn1{input1},
+                  mIn2{input2},
+                  mOut{output},
+                  mInStride{inputStride(sizeX * sizeof(uchar4))},
+                  mOutStride{outputStride(sizeX * sizeof(uchar4))},
                   mWeight1{weight1},
                   mWeight2{weight2},
                   mAbsolute{absolute} {}
@@ -38,10 +43,9 @@ namespace renderscript {
     WeightedAddTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                                  size_t endY) {
         for (size_t y = startY; y < endY; y++) {
-            size_t offset = mSizeX * y + startX;
-            const uchar4 *in1 = mIn1 + offset;
-            const uchar4 *in2 = mIn2 + offset;
-            uchar4 *out = mOut + offset;
+            const uchar4 *in1 = reinterpret_cast<const uchar4 *>(mIn1 + mInStride * y) + startX;
+            const uchar4 *in2 = reinterpret_cast<const uchar4 *>(mIn2 + mInStride * y) + startX;
+            uchar4 *out = reinterpret_cast<uchar4 *>(mOut + mOutStride * y) + startX;
             for (size_t x = startX; x < endX; x++) {
                 auto v1 = *in1;
                 double r1 = v1.r;
@@ -109,7 +113,7 @@ namespace renderscript {
                                      float weight1, float weight2, bool absolute,
                                      const Restriction *restriction) {
 #ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
-        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction)) {
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4, sizeX * 4)) {
             return;
         }
 #endif
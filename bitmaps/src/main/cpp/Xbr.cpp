@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "RenderScriptToolkit.h"
+#include "TaskProcessor.h"
+#include "Utils.h"
+
+#define LOG_TAG "renderscript.toolkit.Xbr"
+
+namespace renderscript {
+
+    static inline int channelR(uint32_t p) { return static_cast<int>(p & 0xFF); }
+
+    static inline int channelG(uint32_t p) { return static_cast<int>((p >> 8) & 0xFF); }
+
+    static inline int channelB(uint32_t p) { return static_cast<int>((p >> 16) & 0xFF); }
+
+    static inline int channelA(uint32_t p) { return static_cast<int>((p >> 24) & 0xFF); }
+
+    static inline float colorDist(uint32_t c1, uint32_t c2) {
+        int r = std::abs(channelR(c1) - channelR(c2));
+        int g = std::abs(channelG(c1) - channelG(c2));
+        int b = std::abs(channelB(c1) - channelB(c2));
+        int a = std::abs(channelA(c1) - channelA(c2));
+
+        double y = std::fabs(0.299 * r + 0.587 * g + 0.114 * b);
+        double u = std::fabs(-0.169 * r - 0.331 * g + 0.500 * b);
+        double v = std::fabs(0.500 * r - 0.419 * g - 0.081 * b);
+
+        return static_cast<float>(48.0 * y + 7.0 * u + 6.0 * v + 48.0 * a);
+    }
+
+    /**
+     * The cells of the scale x scale block of a pixel that take the color across an edge at one
+     * of its corners, one bit per cell in row major order.
+     *
+     * They rasterize the lines of xBR, in the frame of a pixel of size 1 whose corner is at
+     * (1, 1): x + y = 1.5 for an edge at 45 degrees, x + 2y = 1.75 when the edge is shallow
+     * (the colors across it run horizontally) and 2x + y = 1.75 when it's steep. A cell takes
+     * the color when its center is on the line or on the side of the corner. At 2x, that's the
+     * corner cell, plus the cell next to it in the row when shallow and in the column when steep.
+     */
+    struct XbrCornerCells {
+        uint16_t diagonal = 0;
+        uint16_t shallow = 0;
+        uint16_t steep = 0;
+    };
+
+    /**
+     * The corners of a pixel, in the order their edges are applied. The later ones win where
+     * their cells overlap.
+     */
+    enum XbrCorner { BOTTOM_RIGHT, TOP_RIGHT, TOP_LEFT, BOTTOM_LEFT, kXbrCornerCount };
+
+    static XbrCornerCells cornerCells(size_t scale, XbrCorner corner) {
+        const bool left = corner == TOP_LEFT || corner == BOTTOM_LEFT;
+        const bool top = corner == TOP_LEFT || corner == TOP_RIGHT;
+        const int n = static_cast<int>(scale);
+        XbrCornerCells cells;
+        for (int row = 0; row < n; row++) {
+            for (int column = 0; column < n; column++) {
+                // Twice the center of the cell, toward the corner of the pixel, in cells.
+                int u = 2 * (left ? n - 1 - column : column) + 1;
+                int v = 2 * (top ? n - 1 - row : row) + 1;
+                uint16_t bit = static_cast<uint16_t>(1 << (row * n + column));
+                if (2 * (u + v) >= 6 * n) cells.diagonal |= bit;
+                if (4 * (u + 2 * v) >= 14 * n) cells.shallow |= bit;
+                if (4 * (2 * u + v) >= 14 * n) cells.steep |= bit;
+            }
+        }
+        return cells;
+    }
+
+// xBR tutorial: https://forums.libretro.com/t/xbr-algorithm-tutorial/123
+    class XbrTask : public Task {
+        const uint8_t *mIn;
+        uint8_t *mOut;
+        const size_t mInStride;
+        const size_t mOutStride;
+        size_t mInputSizeX;
+        size_t mInputSizeY;
+        const size_t mScale;
+        XbrCornerCells mCorners[kXbrCornerCount];
+
+        /**
+         * The rows of a tile that a row of output is computed from. The rows are kept in rings,
+         * so that each input row is read, and each distance computed, once per tile.
+         *
+         * The pixels of a row are those of the tile plus 2 on each side, clamped to the image.
+         * The distances are indexed by their leftmost pixel. Between rows r and r + 1:
+         *    diagonal[x]: between (x, r) and (x + 1, r + 1).
+         *    antiDiagonal[x]: between (x + 1, r) and (x, r + 1).
+         *    vertical[x]: between (x, r) and (x, r + 1).
+         * Within row r, horizontal[x] is between (x, r) and (x + 1, r).
+         */
+        struct Rows {
+            static constexpr size_t kPixelRows = 5;
+            static constexpr size_t kDistanceRows = 4;
+            uint32_t *pixels[kPixelRows];
+            float *diagonal[kDistanceRows];
+            float *antiDiagonal[kDistanceRows];
+            float *vertical[kDistanceRows];
+            float *horizontal;
+            // The edges found for each pixel of the row, see processData.
+            uint8_t *edges;
+
+            // The slot of row r in a ring of size n. r is at least -2.
+            static size_t slot(long r, size_t n) { return static_cast<size_t>(r + 4) % n; }
+        };
+
+        const uint32_t *inputRow(size_t y) const {
+            return reinterpret_cast<const uint32_t *>(mIn + mInStride * y);
+        }
+
+        uint32_t *outputRow(size_t y) const {
+            return reinterpret_cast<uint32_t *>(mOut + mOutStride * y);
+        }
+
+        void loadRow(Rows &rows, long r, size_t startX, size_t width) const;
+
+        void computeDistances(Rows &rows, long r, size_t width) const;
+
+        void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                         size_t endY) override;
+
+    public:
+        XbrTask(const uint8_t *input, uint8_t *output,
+                size_t inputSizeX, size_t inputSizeY, size_t scale,
+                const Restriction *restriction)
+                : Task{inputSizeX, inputSizeY, 4, false, restriction},
+                  mIn{input},
+                  mOut{output},
+                  mInStride{inputStride(inputSizeX * sizeof(uint32_t))},
+                  mOutStride{outputStride(inputSizeX * scale * sizeof(uint32_t))},
+                  mInputSizeX{inputSizeX},
+                  mInputSizeY{inputSizeY},
+                  mScale{scale} {
+            for (int corner = 0; corner < kXbrCornerCount; corner++) {
+                mCorners[corner] = cornerCells(scale, static_cast<XbrCorner>(corner));
+            }
+            // A cell reads one input cell, the 5 rows around it being shared with its
+            // neighbors, keeps 5 rows of pixels and 10 of distances, and writes scale x scale
+            // output cells.
+            setWorkingSetPerCell((4 + 15 + scale * scale) * sizeof(uint32_t));
+            setReach(2);
+            setTilingGroup(RenderScriptToolkit::TilingGroup::XBR);
+        }
+    };
+
+    void XbrTask::loadRow(Rows &rows, long r, size_t startX, size_t width) const {
+        const long lastY = static_cast<long>(mInputSizeY) - 1;
+        const uint32_t *in = inputRow(static_cast<size_t>(std::max(0L, std::min(lastY, r))));
+        uint32_t *out = rows.pixels[Rows::slot(r, Rows::kPixelRows)];
+        const long lastX = static_cast<long>(mInputSizeX) - 1;
+        for (size_t x = 0; x < width; x++) {
+            long ix = static_cast<long>(startX + x) - 2;
+            out[x] = in[std::max(0L, std::min(lastX, ix))];
+        }
+    }
+
+    void XbrTask::computeDistances(Rows &rows, long r, size_t width) const {
+        const uint32_t *above = rows.pixels[Rows::slot(r, Rows::kPixelRows)];
+        const uint32_t *below = rows.pixels[Rows::slot(r + 1, Rows::kPixelRows)];
+        float *diagonal = rows.diagonal[Rows::slot(r, Rows::kDistanceRows)];
+        float *antiDiagonal = rows.antiDiagonal[Rows::slot(r, Rows::kDistanceRows)];
+        float *vertical = rows.vertical[Rows::slot(r, Rows::kDistanceRows)];
+        for (size_t x = 0; x + 1 < width; x++) {
+            diagonal[x] = colorDist(above[x], below[x + 1]);
+            antiDiagonal[x] = colorDist(above[x + 1], below[x]);
+            vertical[x] = colorDist(above[x], below[x]);
+        }
+        vertical[width - 1] = colorDist(above[width - 1], below[width - 1]);
+    }
+
+    void XbrTask::processData(int threadIndex, size_t startX, size_t startY, size_t endX,
+                              size_t endY) {
+        const size_t width = endX - startX + 4;
+        ScratchArena &arena = scratch(threadIndex);
+        Rows rows;
+        for (auto &row : rows.pixels) row = arena.allocate<uint32_t>(width);
+        for (auto &row : rows.diagonal) row = arena.allocate<float>(width);
+        for (auto &row : rows.antiDiagonal) row = arena.allocate<float>(width);
+        for (auto &row : rows.vertical) row = arena.allocate<float>(width);
+        rows.horizontal = arena.allocate<float>(width);
+        rows.edges = arena.allocate<uint8_t>(width);
+
+        const long top = static_cast<long>(startY);
+        for (long r = top - 2; r <= top + 1; r++) {
+            loadRow(rows, r, startX, width);
+        }
+        for (long r = top - 2; r <= top; r++) {
+            computeDistances(rows, r, width);
+        }
+
+        const size_t n = mScale;
+        for (size_t y = startY; y < endY; y++) {
+            const long iy = static_cast<long>(y);
+            loadRow(rows, iy + 2, startX, width);
+            computeDistances(rows, iy + 1, width);
+
+            // 5x5 neighborhood (clamped at edges):
+            //     A1 B1 C1
+            // A0  A  B  C  C4
+            // D0  D  E  F  F4
+            // G0  G  H  I  I4
+            //     G5 H5 I5
+            const uint32_t *p1 = rows.pixels[Rows::slot(iy - 1, Rows::kPixelRows)];
+            const uint32_t *p2 = rows.pixels[Rows::slot(iy, Rows::kPixelRows)];
+            const uint32_t *p3 = rows.pixels[Rows::slot(iy + 1, Rows::kPixelRows)];
+            const float *d0 = rows.diagonal[Rows::slot(iy - 2, Rows::kDistanceRows)];
+            const float *d1 = rows.diagonal[Rows::slot(iy - 1, Rows::kDistanceRows)];
+            const float *d2 = rows.diagonal[Rows::slot(iy, Rows::kDistanceRows)];
+            const float *d3 = rows.diagonal[Rows::slot(iy + 1, Rows::kDistanceRows)];
+            const float *a0 = rows.antiDiagonal[Rows::slot(iy - 2, Rows::kDistanceRows)];
+            const float *a1 = rows.antiDiagonal[Rows::slot(iy - 1, Rows::kDistanceRows)];
+            const float *a2 = rows.antiDiagonal[Rows::slot(iy, Rows::kDistanceRows)];
+            const float *a3 = rows.antiDiagonal[Rows::slot(iy + 1, Rows::kDistanceRows)];
+            const float *up = rows.vertical[Rows::slot(iy - 1, Rows::kDistanceRows)];
+            const float *down = rows.vertical[Rows::slot(iy, Rows::kDistanceRows)];
+            float *horizontal = rows.horizontal;
+            for (size_t x = 0; x + 1 < width; x++) {
+                horizontal[x] = colorDist(p2[x], p2[x + 1]);
+            }
+
+            // The edge tests of the row, over the cached distances only, so that the compiler
+            // can vectorize them. Bit k of edges is set when there's an edge at corner k, and
+            // bit 4 + k when the color across it is the first of the two candidates. The sums
+            // keep the order of the original formulas, so that the results are the same.
+            uint8_t *edges = rows.edges;
+            for (size_t x = 2; x < width - 2; x++) {
+                float wd1, wd2;
+                int bits = 0;
+
+                // Bottom right, edge between H and F.
+                wd1 = a1[x] + a2[x - 1] + a2[x + 1] + a3[x] + 4 * a2[x];
+                wd2 = d2[x - 1] + d3[x] + d2[x + 1] + d1[x] + 4 * d2[x];
+                bits |= (wd1 < wd2) << BOTTOM_RIGHT;
+                bits |= (horizontal[x] <= down[x]) << (4 + BOTTOM_RIGHT);
+
+                // Top right, edge between B and F.
+                wd1 = d2[x] + d1[x - 1] + d1[x + 1] + d0[x] + 4 * d1[x];
+                wd2 = a1[x - 1] + a0[x] + a2[x] + a1[x + 1] + 4 * a1[x];
+                bits |= (wd1 < wd2) << TOP_RIGHT;
+                bits |= (horizontal[x] <= up[x]) << (4 + TOP_RIGHT);
+
+                // Top left, edge between B and D.
+                wd1 = a2[x - 1] + a1[x] + a1[x - 2] + a0[x - 1] + 4 * a1[x - 1];
+                wd2 = d1[x] + d0[x - 1] + d2[x - 1] + d1[x - 2] + 4 * d1[x - 1];
+                bits |= (wd1 < wd2) << TOP_LEFT;
+                bits |= (horizontal[x - 1] <= up[x]) << (4 + TOP_LEFT);
+
+                // Bottom left, edge between D and H.
+                wd1 = d2[x] + d1[x - 1] + d2[x - 2] + d3[x - 1] + 4 * d2[x - 1];
+                wd2 = a2[x] + a3[x - 1] + a1[x - 1] + a2[x - 2] + 4 * a2[x - 1];
+                bits |= (wd1 < wd2) << BOTTOM_LEFT;
+                bits |= (horizontal[x - 1] <= down[x]) << (4 + BOTTOM_LEFT);
+
+                edges[x] = static_cast<uint8_t>(bits);
+            }
+
+            uint32_t block[16];
+            for (size_t x = 2; x < width - 2; x++) {
+                const uint32_t e = p2[x];
+                const int bits = edges[x];
+                std::fill(block, block + n * n, e);
+                if (bits & 0xF) {
+                    const uint32_t a = p1[x - 1];
+                    const uint32_t b = p1[x];
+                    const uint32_t c = p1[x + 1];
+                    const uint32_t d = p2[x - 1];
+                    const uint32_t f = p2[x + 1];
+                    const uint32_t g = p3[x - 1];
+                    const uint32_t h = p3[x];
+                    const uint32_t i = p3[x + 1];
+                    // The colors on each side of the corners, and whether they run
+                    // horizontally and vertically.
+                    const uint32_t first[kXbrCornerCount] = {f, f, d, d};
+                    const uint32_t second[kXbrCornerCount] = {h, b, b, h};
+                    const bool shallow[kXbrCornerCount] = {f == g, f == a, d == c, d == i};
+                    const bool steep[kXbrCornerCount] = {h == c, b == i, b == g, h == a};
+                    for (int corner = 0; corner < kXbrCornerCount; corner++) {
+                        if (!(bits & (1 << corner))) {
+                            continue;
+                        }
+                        const XbrCornerCells &cells = mCorners[corner];
+                        uint32_t color = (bits & (16 << corner)) ? first[corner] : second[corner];
+                        uint32_t mask = cells.diagonal;
+                        if (shallow[corner]) mask |= cells.shallow;
+                        if (steep[corner]) mask |= cells.steep;
+                        for (size_t cell = 0; cell < n * n; cell++) {
+                            if (mask & (1u << cell)) {
+                                block[cell] = color;
+                            }
+                        }
+                    }
+                }
+
+                const size_t outX = (startX + x - 2) * n;
+                for (size_t row = 0; row < n; row++) {
+                    memcpy(outputRow(y * n + row) + outX, block + row * n,
+                           n * sizeof(uint32_t));
+                }
+            }
+        }
+    }
+
+    void RenderScriptToolkit::xbr(const uint8_t *input, uint8_t *output, size_t sizeX,
+                                  size_t sizeY, size_t scale, const Restriction *restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+        if (scale < 2 || scale > 4) {
+            ALOGE("The scale of xbr should be 2, 3 or 4. %zu provided.", scale);
+            return;
+        }
+        if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, sizeX * 4,
+                              sizeX * scale * 4)) {
+            return;
+        }
+#endif
+
+        XbrTask task(input, output, sizeX, sizeY, scale, restriction);
+        processor->doTask(&task);
+    }
+
+    void RenderScriptToolkit::xbr2x(const uint8_t *input, uint8_t *output,
+                                    size_t sizeX, size_t sizeY, const Restriction *restriction) {
+        xbr(input, output, sizeX, sizeY, 2, restriction);
+    }
+
+}  // namespace renderscript
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
 #include "RenderScriptToolkit.h"
@@ -28,8 +30,12 @@ inline size_t roundUpTo16(size_t val) {
     return (val + 15u) & ~15u;
 }
 
+// The size in pixels of the square blocks in which rotated and scaled outputs are written.
+constexpr size_t kBlockSize = 32;
+
 class YuvToRgbTask : public Task {
-    uchar4* mOut;
+    uint8_t* mOut;
+    size_t mOutStride;
     size_t mCstep;
     size_t mStrideY;
     size_t mStrideU;
@@ -37,16 +43,45 @@ class YuvToRgbTask : public Task {
     const uchar* mInY;
     const uchar* mInU;
     const uchar* mInV;
+    // The part of the input that is converted. It's the whole image unless there's a transform.
+    size_t mCropX = 0;
+    size_t mCropY = 0;
+    size_t mCropSizeX;
+    size_t mCropSizeY;
+    // The clockwise rotation of the output, in degrees.
+    int mRotation = 0;
+    // The size of the output before it's rotated.
+    size_t mScaledSizeX;
+    size_t mScaledSizeY;
+    // The number of input pixels that an output pixel averages in each direction, or 0 when the
+    // output is sampled bilinearly.
+    size_t mFactor = 1;
 
     void kernel(uchar4* out, uint32_t xstart, uint32_t xend, uint32_t currentY);
+    // Converts a block of a rotated or scaled output. See kBlockSize.
+    void processBlock(size_t startX, size_t startY, size_t endX, size_t endY);
+    // Converts the pixel x, y of the input.
+    uchar4 pixelAt(size_t x, size_t y) const;
+    // Returns the pixel x, y of the scaled output, before the rotation.
+    uchar4 sample(size_t x, size_t y) const;
+    // Maps a pixel of the output to where it is in the scaled output before the rotation.
+    void unrotate(size_t outX, size_t outY, size_t* x, size_t* y) const;
+    // Returns the row y of the output.
+    uchar4* outputRow(size_t y) const { return reinterpret_cast<uchar4*>(mOut + mOutStride * y); }
     // Process a 2D tile of the overall work. threadIndex identifies which thread does the work.
     void processData(int threadIndex, size_t startX, size_t startY, size_t endX,
                      size_t endY) override;
 
    public:
     YuvToRgbTask(const uint8_t* input, uint8_t* output, size_t sizeX, size_t sizeY,
-                 RenderScriptToolkit::YuvFormat format)
-        : Task{sizeX, sizeY, 4, false, nullptr}, mOut{reinterpret_cast<uchar4*>(output)} {
+                 RenderScriptToolkit::YuvFormat format, const Restriction* restriction)
+        : Task{sizeX, sizeY, 4, false, restriction},
+          mOut{output},
+          mOutStride{outputStride(sizeX * sizeof(uchar4))},
+          mCropSizeX{sizeX},
+          mCropSizeY{sizeY},
+          mScaledSizeX{sizeX},
+          mScaledSizeY{sizeY} {
         switch (format) {
             case RenderScriptToolkit::YuvFormat::NV21:
                 mCstep = 2;
@@ -68,14 +103,61 @@ class YuvToRgbTask : public Task {
                 break;
         }
     }
+
+    YuvToRgbTask(const uint8_t* inputY, const uint8_t* inputU, const uint8_t* inputV,
+                 size_t yRowStride, size_t uvRowStride, size_t uvPixelStride, uint8_t* output,
+                 size_t sizeX, size_t sizeY, const RenderScriptToolkit::YuvTransform* transform,
+                 const Restriction* restriction)
+        : Task{transform ? transform->outputSizeX : sizeX,
+               transform ? transform->outputSizeY : sizeY, 4, false, restriction},
+          mOut{output},
+          mOutStride{outputStride(mSizeX * sizeof(uchar4))},
+          mCstep{uvPixelStride},
+          mStrideY{yRowStride},
+          mStrideU{uvRowStride},
+          mStrideV{uvRowStride},
+          mInY{reinterpret_cast<const uchar*>(inputY)},
+          mInU{reinterpret_cast<const uchar*>(inputU)},
+          mInV{reinterpret_cast<const uchar*>(inputV)},
+          mCropSizeX{sizeX},
+          mCropSizeY{sizeY},
+          mScaledSizeX{sizeX},
+          mScaledSizeY{sizeY} {
+        if (transform == nullptr) {
+            return;
+        }
+        mCropX = transform->cropStartX;
+        mCropY = transform->cropStartY;
+        mCropSizeX = transform->cropEndX - transform->cropStartX;
+        mCropSizeY = transform->cropEndY - transform->cropStartY;
+        mRotation = transform->rotation;
+        bool transposed = mRotation == 90 || mRotation == 270;
+        mScaledSizeX = transposed ? mSizeY : mSizeX;
+        mScaledSizeY = transposed ? mSizeX : mSizeY;
+        size_t factor = mCropSizeX / mScaledSizeX;
+        bool isMultiple = factor * mScaledSizeX == mCropSizeX &&
+                          factor * mScaledSizeY == mCropSizeY;
+        mFactor = isMultiple ? factor : 0;
+    }
 };
 
 void YuvToRgbTask::processData(int /* threadIndex */, size_t startX, size_t startY, size_t endX,
                                size_t endY) {
-    for (size_t y = startY; y < endY; y++) {
-        size_t offset = mSizeX * y + startX;
-        uchar4* out = mOut + offset;
-        kernel(out, startX, endX, y);
+    if (mRotation == 0 && mFactor == 1) {
+        for (size_t y = startY; y < endY; y++) {
+            uchar4* out = outputRow(y) + startX;
+            kernel(out, mCropX + startX, mCropX + endX, mCropY + y);
+        }
+        return;
+    }
+
+    // A rotated output walks the input across its rows. Working in small blocks keeps both the
+    // input read and the output written in the cache.
+    for (size_t blockY = startY; blockY < endY; blockY += kBlockSize) {
+        for (size_t blockX = startX; blockX < endX; blockX += kBlockSize) {
+            processBlock(blockX, blockY, std::min(blockX + kBlockSize, endX),
+                         std::min(blockY + kBlockSize, endY));
+        }
     }
 }
 
@@ -112,12 +194,134 @@ static uchar4 rsYuvToRGBA_uchar4(uchar y, uchar u, uchar v) {
                     static_cast<uchar>(p.z), static_cast<uchar>(p.w)};
 }
 
+uchar4 YuvToRgbTask::pixelAt(size_t x, size_t y) const {
+    size_t cx = (x >> 1) * mCstep;
+    return rsYuvToRGBA_uchar4(mInY[y * mStrideY + x], mInU[(y >> 1) * mStrideU + cx],
+                              mInV[(y >> 1) * mStrideV + cx]);
+}
+
+uchar4 YuvToRgbTask::sample(size_t x, size_t y) const {
+    if (mFactor > 0) {
+        const size_t startX = mCropX + x * mFactor;
+        const size_t startY = mCropY + y * mFactor;
+        uint4 sum = 0;
+        for (size_t j = startY; j < startY + mFactor; j++) {
+            for (size_t i = startX; i < startX + mFactor; i++) {
+                sum += convert<uint4>(pixelAt(i, j));
+            }
+        }
+        const uint count = mFactor * mFactor;
+        return convert<uchar4>((sum + count / 2) / count);
+    }
+
+    // Map the center of the output pixel to the input, like resize does.
+    float inX = ((float)x + 0.5f) * (float)mCropSizeX / (float)mScaledSizeX - 0.5f;
+    float inY = ((float)y + 0.5f) * (float)mCropSizeY / (float)mScaledSizeY - 0.5f;
+    inX = std::clamp(inX, 0.f, (float)(mCropSizeX - 1));
+    inY = std::clamp(inY, 0.f, (float)(mCropSizeY - 1));
+    const size_t x0 = (size_t)inX;
+    const size_t y0 = (size_t)inY;
+    const size_t x1 = std::min(x0 + 1, mCropSizeX - 1);
+    const size_t y1 = std::min(y0 + 1, mCropSizeY - 1);
+    const float fx = inX - (float)x0;
+    const float fy = inY - (float)y0;
+
+    float4 p00 = convert<float4>(pixelAt(mCropX + x0, mCropY + y0));
+    float4 p10 = convert<float4>(pixelAt(mCropX + x1, mCropY + y0));
+    float4 p01 = convert<float4>(pixelAt(mCropX + x0, mCropY + y1));
+    float4 p11 = convert<float4>(pixelAt(mCropX + x1, mCropY + y1));
+    float4 top = p00 + (p10 - p00) * fx;
+    float4 bottom = p01 + (p11 - p01) * fx;
+    float4 p = top + (bottom - top) * fy;
+    p = clamp(p + 0.5f, 0.f, 255.f);
+    return convert<uchar4>(p);
+}
+
+void YuvToRgbTask::unrotate(size_t outX, size_t outY, size_t* x, size_t* y) const {
+    switch (mRotation) {
+        case 90:
+            *x = outY;
+            *y = mScaledSizeY - 1 - outX;
+            break;
+        case 180:
+            *x = mScaledSizeX - 1 - outX;
+            *y = mScaledSizeY - 1 - outY;
+            break;
+        case 270:
+            *x = mScaledSizeX - 1 - outY;
+            *y = outX;
+            break;
+        default:
+            *x = outX;
+            *y = outY;
+            break;
+    }
+}
+
+void YuvToRgbTask::processBlock(size_t startX, size_t startY, size_t endX, size_t endY) {
+    if (mFactor != 1) {
+        for (size_t outY = startY; outY < endY; outY++) {
+            uchar4* out = outputRow(outY);
+            for (size_t outX = startX; outX < endX; outX++) {
+                size_t x, y;
+                unrotate(outX, outY, &x, &y);
+                out[outX] = sample(x, y);
+            }
+        }
+        return;
+    }
+
+    // Convert the input pixels of the block a row at a time, then write them rotated.
+    size_t cornerX0, cornerY0, cornerX1, cornerY1;
+    unrotate(startX, startY, &cornerX0, &cornerY0);
+    unrotate(endX - 1, endY - 1, &cornerX1, &cornerY1);
+    const size_t inStartX = std::min(cornerX0, cornerX1);
+    const size_t inEndX = std::max(cornerX0, cornerX1) + 1;
+    const size_t inStartY = std::min(cornerY0, cornerY1);
+    const size_t inEndY = std::max(cornerY0, cornerY1) + 1;
+    const size_t width = inEndX - inStartX;
+
+    uchar4 block[kBlockSize * kBlockSize];
+    for (size_t y = inStartY; y < inEndY; y++) {
+        kernel(block + (y - inStartY) * width, mCropX + inStartX, mCropX + inEndX, mCropY + y);
+    }
+    for (size_t outY = startY; outY < endY; outY++) {
+        uchar4* out = outputRow(outY);
+        for (size_t outX = startX; outX < endX; outX++) {
+            size_t x, y;
+            unrotate(outX, outY, &x, &y);
+            out[outX] = block[(y - inStartY) * width + (x - inStartX)];
+        }
+    }
+}
+
+#if defined(ARCH_ARM_USE_INTRINSICS)
 extern "C" void rsdIntrinsicYuv_K(void *dst, const uchar *Y, const uchar *uv, uint32_t xstart,
                                   size_t xend);
 extern "C" void rsdIntrinsicYuvR_K(void *dst, const uchar *Y, const uchar *uv, uint32_t xstart,
                                    size_t xend);
 extern "C" void rsdIntrinsicYuv2_K(void *dst, const uchar *Y, const uchar *u, const uchar *v,
                                    size_t xstart, size_t xend);
+#endif
+
+#if defined(ARCH_X86_HAVE_SSSE3)
+// The x86 kernels convert blocks of 8 pixels. count is the number of blocks.
+extern void rsdIntrinsicYuv_K(void *dst, const unsigned char *pY, const unsigned char *pUV,
+                              uint32_t count, const short *param);
+extern void rsdIntrinsicYuvR_K(void *dst, const unsigned char *pY, const unsigned char *pUV,
+                               uint32_t count, const short *param);
+extern void rsdIntrinsicYuv2_K(void *dst, const unsigned char *pY, const unsigned char *pU,
+                               const unsigned char *pV, uint32_t count, const short *param);
+
+// Same coefficients as rsYuvToRGBA_uchar4, laid out the way the x86 kernels load them.
+static const short YuvCoeff[] = {
+    298, 409, -100, 516,   -208, 255, 0, 0,
+    16, 16, 16, 16,        16, 16, 16, 16,
+    128, 128, 128, 128, 128, 128, 128, 128,
+    298, 298, 298, 298, 298, 298, 298, 298,
+    255, 255, 255, 255, 255, 255, 255, 255
+};
+#endif
 
 void YuvToRgbTask::kernel(uchar4 *out, uint32_t xstart, uint32_t xend, uint32_t currentY) {
     //ALOGI("kernel out %p, xstart=%u, xend=%u, currentY=%u", out, xstart, xend, currentY);
@@ -216,23 +420,115 @@ void YuvToRgbTask::kernel(uchar4 *out, uint32_t xstart, uint32_t xend, uint32_t
     }
 #endif
 
+#if defined(ARCH_X86_HAVE_SSSE3)
+    if((x2 > x1) && mUsesSimd) {
+        uint32_t len = (x2 - x1) >> 3;
+        if (len > 0) {
+            const uchar *yx = y + x1;
+            bool converted = true;
+            if (mCstep == 1) {
+                rsdIntrinsicYuv2_K(out, yx, u + (x1 >> 1), v + (x1 >> 1), len, YuvCoeff);
+            } else if (mCstep == 2) {
+                // Check for proper interleave
+                intptr_t ipu = (intptr_t)u;
+                intptr_t ipv = (intptr_t)v;
+
+                if (ipu == (ipv + 1)) {
+                    rsdIntrinsicYuv_K(out, yx, v + x1, len, YuvCoeff);
+                } else if (ipu == (ipv - 1)) {
+                    rsdIntrinsicYuvR_K(out, yx, u + x1, len, YuvCoeff);
+                } else {
+                    converted = false;
+                }
+            } else {
+                converted = false;
+            }
+            if (converted) {
+                x1 += len << 3;
+                out += len << 3;
+            }
+        }
+    }
+#endif
+
     if(x2 > x1) {
        // ALOGE("y %i  %i  %i", currentY, x1, x2);
+        // One pixel at a time, as a crop can end on an odd pixel.
         while(x1 < x2) {
             int cx = (x1 >> 1) * mCstep;
             *out = rsYuvToRGBA_uchar4(y[x1], u[cx], v[cx]);
             out++;
             x1++;
-            *out = rsYuvToRGBA_uchar4(y[x1], u[cx], v[cx]);
-            out++;
-            x1++;
         }
     }
 }
 
 void RenderScriptToolkit::yuvToRgb(const uint8_t* input, uint8_t* output, size_t sizeX,
-                                   size_t sizeY, YuvFormat format) {
-    YuvToRgbTask task(input, output, sizeX, sizeY, format);
+                                   size_t sizeY, YuvFormat format,
+                                   const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (!validRestriction(LOG_TAG, sizeX, sizeY, restriction, 0, sizeX * sizeof(uchar4))) {
+        return;
+    }
+#endif
+
+    YuvToRgbTask task(input, output, sizeX, sizeY, format, restriction);
+    processor->doTask(&task);
+}
+
+void RenderScriptToolkit::yuvToRgb(const uint8_t* inputY, const uint8_t* inputU,
+                                   const uint8_t* inputV, size_t yRowStride, size_t uvRowStride,
+                                   size_t uvPixelStride, uint8_t* output, size_t sizeX,
+                                   size_t sizeY, const YuvTransform* transform,
+                                   const Restriction* restriction) {
+#ifdef ANDROID_RENDERSCRIPT_TOOLKIT_VALIDATE
+    if (uvPixelStride == 0) {
+        ALOGE("The U and V pixel stride should be at least 1.");
+        return;
+    }
+    if (yRowStride < sizeX) {
+        ALOGE("The Y row stride %zu is smaller than the width %zu.", yRowStride, sizeX);
+        return;
+    }
+    if (sizeX == 0 || sizeY == 0) {
+        ALOGE("The image should not be empty.");
+        return;
+    }
+    // A row of the U and V planes holds (sizeX + 1) / 2 samples, uvPixelStride apart.
+    if (uvRowStride < ((sizeX + 1) / 2 - 1) * uvPixelStride + 1) {
+        ALOGE("The U and V row stride %zu is too small for a width of %zu.", uvRowStride, sizeX);
+        return;
+    }
+    if (transform != nullptr) {
+        if (transform->cropStartX >= transform->cropEndX ||
+            transform->cropStartY >= transform->cropEndY || transform->cropEndX > sizeX ||
+            transform->cropEndY > sizeY) {
+            ALOGE("The crop (%zu, %zu) to (%zu, %zu) is not within the %zu x %zu image.",
+                  transform->cropStartX, transform->cropStartY, transform->cropEndX,
+                  transform->cropEndY, sizeX, sizeY);
+            return;
+        }
+        if (transform->rotation != 0 && transform->rotation != 90 &&
+            transform->rotation != 180 && transform->rotation != 270) {
+            ALOGE("The rotation should be 0, 90, 180 or 270 degrees. %d was provided.",
+                  transform->rotation);
+            return;
+        }
+        if (transform->outputSizeX == 0 || transform->outputSizeY == 0) {
+            ALOGE("The output size should not be empty.");
+            return;
+        }
+    }
+    const size_t outputSizeX = transform ? transform->outputSizeX : sizeX;
+    const size_t outputSizeY = transform ? transform->outputSizeY : sizeY;
+    if (!validRestriction(LOG_TAG, outputSizeX, outputSizeY, restriction, 0,
+                          outputSizeX * sizeof(uchar4))) {
+        return;
+    }
+#endif
+
+    YuvToRgbTask task(inputY, inputU, inputV, yRowStride, uvRowStride, uvPixelStride, output,
+                      sizeX, sizeY, transform, restriction);
     processor->doTask(&task);
 }
 
@@ -83,7 +83,6 @@ extern "C" void rsdIntrinsicConvolve3x3_K(void *dst, const void *y0,
                                           const short *coef, uint32_t count) {
     __m128i x;
     __m128i c0, c2, c4, c6, c8;
-    __m128i r0, r1, r2;
     __m128i p0, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11;
     __m128i o0, o1;
     uint32_t i;
@@ -165,7 +164,7 @@ void rsdIntrinsicColorMatrix4x4_K(void *dst, const void *src,
     c2 = _mm_unpacklo_epi16(c2, c3);
 
     for (i = 0; i < count; ++i) {
-        i4 = _mm_load_si128((const __m128i *)src);
+        i4 = _mm_loadu_si128((const __m128i *)src);
         xy = _mm_shuffle_epi8(i4, Mxy);
         zw = _mm_shuffle_epi8(i4, Mzw);
 
@@ -378,6 +377,7 @@ void rsdIntrinsicBlurHFU1_K(void *dst,
     const __m128i Mu8 = _mm_set_epi32(0xffffffff, 0xffffffff, 0xffffffff, 0x0c080400);
     const float *pi;
     __m128 pf, g0, g1, g2, g3, gx, p0, p1;
+    __m128i q0, q1;
     __m128i o;
     int r;
 
@@ -392,15 +392,17 @@ void rsdIntrinsicBlurHFU1_K(void *dst,
             gx = _mm_loadu_ps((const float *)gptr + r);
             p0 = _mm_loadu_ps(pi + r);
             p1 = _mm_loadu_ps(pi + r + 4);
+            q0 = _mm_castps_si128(p0);
+            q1 = _mm_castps_si128(p1);
 
             g0 = _mm_shuffle_ps(gx, gx, _MM_SHUFFLE(0, 0, 0, 0));
             pf = _mm_add_ps(pf, _mm_mul_ps(g0, p0));
             g1 = _mm_shuffle_ps(gx, gx, _MM_SHUFFLE(1, 1, 1, 1));
-            pf = _mm_add_ps(pf, _mm_mul_ps(g1, _mm_alignr_epi8(p1, p0, 4)));
+            pf = _mm_add_ps(pf, _mm_mul_ps(g1, _mm_castsi128_ps(_mm_alignr_epi8(q1, q0, 4))));
             g2 = _mm_shuffle_ps(gx, gx, _MM_SHUFFLE(2, 2, 2, 2));
-            pf = _mm_add_ps(pf, _mm_mul_ps(g2, _mm_alignr_epi8(p1, p0, 8)));
+            pf = _mm_add_ps(pf, _mm_mul_ps(g2, _mm_castsi128_ps(_mm_alignr_epi8(q1, q0, 8))));
             g3 = _mm_shuffle_ps(gx, gx, _MM_SHUFFLE(3, 3, 3, 3));
-            pf = _mm_add_ps(pf, _mm_mul_ps(g3, _mm_alignr_epi8(p1, p0, 12)));
+            pf = _mm_add_ps(pf, _mm_mul_ps(g3, _mm_castsi128_ps(_mm_alignr_epi8(q1, q0, 12))));
         }
 
         o = _mm_cvtps_epi32(pf);
@@ -555,12 +557,15 @@ void rsdIntrinsicYuv2_K(void *dst,
 
     for (i = 0; i < (count << 1); ++i) {
         Y = cvtepu8_epi32(_mm_set1_epi32(*(const int *)pY));
-        U = cvtepu8_epi32(_mm_set1_epi32(*(const int *)pU));
-		V = cvtepu8_epi32(_mm_set1_epi32(*(const int *)pV));
+        /* One chroma sample covers two pixels, so widen U0 U1 to U0 U0 U1 U1. */
+        U = _mm_cvtsi32_si128(*(const uint16_t *)pU);
+        V = _mm_cvtsi32_si128(*(const uint16_t *)pV);
+        U = cvtepu8_epi32(_mm_unpacklo_epi8(U, U));
+        V = cvtepu8_epi32(_mm_unpacklo_epi8(V, V));
 
         Y = _mm_sub_epi32(Y, biasY);
         U = _mm_sub_epi32(U, biasUV);
-		V = _mm_sub_epi32(V, biasUV);
+        V = _mm_sub_epi32(V, biasUV);
 
         Y = mullo_epi32(Y, c0);
 
@@ -589,8 +594,8 @@ void rsdIntrinsicYuv2_K(void *dst,
         y4 = _mm_shuffle_epi8(y3, T4x4);
         _mm_storeu_si128((__m128i *)dst, y4);
         pY += 4;
-        pU += 4;
-		pV += 4;
+        pU += 2;
+        pV += 2;
         dst = (__m128i *)dst + 1;
     }
 }
@@ -602,7 +607,6 @@ extern "C" void rsdIntrinsicConvolve5x5_K(void *dst, const void *y0,
     __m128i x;
     __m128i c0, c2, c4, c6, c8, c10, c12;
     __m128i c14, c16, c18, c20, c22, c24;
-    __m128i r0, r1, r2, r3, r4, r5, r6, r7, r8, r9;
     __m128i p0,  p1,  p2,  p3,  p4,  p5,  p6,  p7;
     __m128i p8,  p9, p10, p11, p12, p13, p14, p15;
     __m128i p16, p17, p18, p19, p20, p21, p22, p23;
@@ -1318,4 +1322,58 @@ void rsdIntrinsicBlendSub_K(void *dst, const void *src, uint32_t count8) {
     }
 }
 
+/*
+ * Reduces count4 * 4 cells of one channel into sums, which has the layout of ReductionSums:
+ * sum, sum of squares, sum of x times value, min and max. The channel is 0 to 3, or gray for
+ * anything else, which sums r + g + b. The sums are added to, with x counted from 0.
+ */
+void rsdIntrinsicReduce_K(void *sums, const void *in, uint32_t channel, uint32_t count4) {
+    uint32_t *out = (uint32_t *)sums;
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i shift = _mm_cvtsi32_si128(channel <= 3 ? channel * 8 : 0);
+    const __m128i four = _mm_set1_epi32(4);
+    __m128i x = _mm_set_epi32(3, 2, 1, 0);
+    __m128i sum = _mm_setzero_si128();
+    __m128i squares = _mm_setzero_si128();
+    __m128i moment = _mm_setzero_si128();
+    __m128i mn = _mm_set1_epi32(out[3]);
+    __m128i mx = _mm_set1_epi32(out[4]);
+    uint32_t i;
+
+    for (i = 0; i < count4; ++i) {
+        __m128i p = _mm_loadu_si128((const __m128i *)in + i);
+        __m128i v;
+        if (channel <= 3) {
+            v = _mm_and_si128(_mm_srl_epi32(p, shift), mask);
+        } else {
+            v = _mm_add_epi32(_mm_and_si128(p, mask),
+                              _mm_and_si128(_mm_srli_epi32(p, 8), mask));
+            v = _mm_add_epi32(v, _mm_and_si128(_mm_srli_epi32(p, 16), mask));
+        }
+
+        // The values are at most 765, so the upper halves of the lanes are 0 and the 16 bit
+        // multiply adds and min / max give the 32 bit results.
+        sum = _mm_add_epi32(sum, v);
+        squares = _mm_add_epi32(squares, _mm_madd_epi16(v, v));
+        moment = _mm_add_epi32(moment, _mm_madd_epi16(v, x));
+        mn = _mm_min_epi16(mn, v);
+        mx = _mm_max_epi16(mx, v);
+        x = _mm_add_epi32(x, four);
+    }
+
+    uint32_t s[4], q[4], m[4], lo[4], hi[4];
+    _mm_storeu_si128((__m128i *)s, sum);
+    _mm_storeu_si128((__m128i *)q, squares);
+    _mm_storeu_si128((__m128i *)m, moment);
+    _mm_storeu_si128((__m128i *)lo, mn);
+    _mm_storeu_si128((__m128i *)hi, mx);
+    for (i = 0; i < 4; ++i) {
+        out[0] += s[i];
+        out[1] += q[i];
+        out[2] += m[i];
+        out[3] = lo[i] < out[3] ? lo[i] : out[3];
+        out[4] = hi[i] > out[4] ? hi[i] : out[4];
+    }
+}
+
 }  // namespace renderscript
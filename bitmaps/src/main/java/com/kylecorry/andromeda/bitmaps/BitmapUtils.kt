@@ -151,27 +151,55 @@ object BitmapUtils {
         return inSampleSize
     }
 
-    fun Image.toBitmap(rotation: Float = 90f): Bitmap {
-        val bmp = if (format == YUV_420_888) {
-            val yuvBuffer = YuvByteBuffer(this, null)
-            val bytes = ByteArray(yuvBuffer.buffer.capacity())
-            yuvBuffer.buffer.get(bytes)
-            Toolkit.yuvToRgbBitmap(bytes, width, height, YuvFormat.NV21)
-        } else {
-            // From https://stackoverflow.com/questions/69151779/how-to-create-bitmap-from-android-mediaimage-in-output-image-format-rgba-8888-fo
-            val buffer = planes[0].buffer
-            val pixelStride = planes[0].pixelStride
-            val rowStride = planes[0].rowStride
-            val rowPadding = rowStride - pixelStride * width
-            val bitmap = createBitmap(width + rowPadding / pixelStride, height)
-            bitmap.copyPixelsFromBuffer(buffer)
-            bitmap
+    /**
+     * Converts the image to a bitmap. YUV images can also be cropped and scaled.
+     * @param rotation The clockwise rotation of the bitmap in degrees
+     * @param crop The part of a YUV image to convert, in pixels of the image
+     * @param size The size of the bitmap converted from a YUV image, after a right angle rotation.
+     * Defaults to the size of the rotated crop.
+     */
+    fun Image.toBitmap(rotation: Float = 90f, crop: Rect? = null, size: Size? = null): Bitmap {
+        val quarterTurns = rotation / 90f
+        val isQuarterTurn = quarterTurns == quarterTurns.toInt().toFloat()
+        if (format == YUV_420_888) {
+            // The plane buffers are direct, so they are converted in place. Right angle rotations,
+            // the crop and the scaling are done in the same pass.
+            val (y, u, v) = planes
+            val fusedRotation = if (isQuarterTurn) ((quarterTurns.toInt() % 4 + 4) % 4) * 90 else 0
+            val bmp = Toolkit.yuvToRgbBitmap(
+                y.buffer,
+                u.buffer,
+                v.buffer,
+                y.rowStride,
+                u.rowStride,
+                u.pixelStride,
+                width,
+                height,
+                fusedRotation,
+                crop?.let { Range2d(it.left, it.right, it.top, it.bottom) },
+                size?.width,
+                size?.height
+            )
+            if (isQuarterTurn) {
+                return bmp
+            }
+            val rotated = bmp.rotate(rotation)
+            bmp.recycle()
+            return rotated
         }
 
+        // From https://stackoverflow.com/questions/69151779/how-to-create-bitmap-from-android-mediaimage-in-output-image-format-rgba-8888-fo
+        val buffer = planes[0].buffer
+        val pixelStride = planes[0].pixelStride
+        val rowStride = planes[0].rowStride
+        val rowPadding = rowStride - pixelStride * width
+        val bmp = createBitmap(width + rowPadding / pixelStride, height)
+        bmp.copyPixelsFromBuffer(buffer)
+
         return if (rotation != 0f) {
             val rotated = bmp.rotate(rotation)
             bmp.recycle()
-            return rotated
+            rotated
         } else {
             bmp
         }
@@ -233,6 +261,17 @@ object BitmapUtils {
         )
     }
 
+    /**
+     * Run the stages one after the other in a single pass over the bitmap. See [Toolkit.pipeline].
+     */
+    fun Bitmap.pipeline(
+        stages: List<PipelineStage>,
+        histogram: IntArray? = null,
+        inPlace: Boolean = false
+    ): Bitmap {
+        return Toolkit.pipeline(this, stages, histogram, inPlace)
+    }
+
     fun Bitmap.rotate(degrees: Float): Bitmap {
         val matrix = Matrix().apply { postRotate(degrees) }
         return Bitmap.createBitmap(this, 0, 0, width, height, matrix, true)
@@ -249,6 +288,13 @@ object BitmapUtils {
         return Toolkit.xbr2x(this)
     }
 
+    /**
+     * Upscale (2x, 3x or 4x) the bitmap to preserve the pixel-art palette (xBR algorithm)
+     */
+    fun Bitmap.xbrUpscale(scale: Int): Bitmap {
+        return Toolkit.xbr(this, scale)
+    }
+
     fun getExactRegion(rect: Rect, imageSize: Size, blockSize: Int = 16): Rect {
         val left = rect.left.coerceIn(0, imageSize.width)
         val top = rect.top.coerceIn(0, imageSize.height)
@@ -446,6 +492,22 @@ object BitmapUtils {
         }
     }
 
+    /**
+     * Compute several statistics in a single pass over the bitmap. See [Toolkit.statistics].
+     */
+    fun Bitmap.statistics(
+        statistics: Set<Statistic>,
+        channel: ColorChannel? = null,
+        rect: Rect? = null
+    ): ImageStatistics {
+        return Toolkit.statistics(
+            this,
+            (channel?.index ?: -1).toByte(),
+            statistics,
+            rect?.toRange2d()
+        )
+    }
+
     fun Bitmap.blobs(
         threshold: Float,
         channel: ColorChannel? = null,
@@ -461,6 +523,24 @@ object BitmapUtils {
         )
     }
 
+    /**
+     * Like [blobs], but also returns the area, pixel count and centroid of each blob.
+     */
+    fun Bitmap.blobsWithStatistics(
+        threshold: Float,
+        channel: ColorChannel? = null,
+        maxBlobs: Int = 100,
+        rect: Rect? = null
+    ): List<Blob> {
+        return Toolkit.findBlobsWithStatistics(
+            this,
+            (channel?.index ?: -1).toByte(),
+            threshold,
+            maxBlobs,
+            rect?.toRange2d()
+        )
+    }
+
     fun Bitmap.add(
         bitmap: Bitmap,
         selfWeight: Float = 1f,
@@ -534,6 +614,37 @@ object BitmapUtils {
         return com.kylecorry.sol.math.algebra.Matrix.create(levels, levels, glcm)
     }
 
+    /**
+     * Calculate the Haralick texture features of the GLCM of a bitmap, without building the GLCM
+     * in Kotlin. For best results, convert the image to grayscale.
+     * @param steps the step size and direction (X, Y pixels) to calculate the GLCM for
+     * @param channel the color channel to calculate the GLCM for
+     * @param excludeTransparent if true, transparent pixels will be excluded from the GLCM
+     * @param symmetric if true, when (i, j) is found, (j, i) will also be incremented
+     * @param levels the levels of gray for each pixel, defaults to 256
+     * @param sparse if true, the pairs are counted in small hash tables, which use less memory
+     */
+    fun Bitmap.glcmFeatures(
+        steps: List<Pair<Int, Int>>,
+        channel: ColorChannel? = null,
+        excludeTransparent: Boolean = false,
+        symmetric: Boolean = false,
+        levels: Int = 256,
+        sparse: Boolean = false,
+        region: Rect? = null
+    ): GlcmFeatures {
+        return Toolkit.glcmFeatures(
+            this,
+            levels,
+            (channel?.index ?: 4).toByte(),
+            symmetric,
+            excludeTransparent,
+            steps.flatMap { listOf(it.first, it.second) }.toIntArray(),
+            sparse,
+            region?.toRange2d()
+        )
+    }
+
     fun Bitmap.replaceColor(
         oldColor: Int,
         newColor: Int,
@@ -33,7 +33,8 @@ class FloatBitmap(val width: Int, val height: Int, val channels: Int) {
         endX: Float = (width - 1).toFloat(),
         startY: Float = 0f,
         endY: Float = (height - 1).toFloat(),
-        maxSearchRadius: Int = 10
+        maxSearchRadius: Int = 10,
+        validDistances: IntArray? = null
     ): FloatBitmap {
         val output = FloatBitmap(newWidth, newHeight, channels)
         val result = Toolkit.interpolateFloatBitmap(
@@ -47,9 +48,83 @@ class FloatBitmap(val width: Int, val height: Int, val channels: Int) {
             srcStartY = startY,
             srcEndX = endX,
             srcEndY = endY,
-            maxSearchRadius = maxSearchRadius
+            maxSearchRadius = maxSearchRadius,
+            validDistances = validDistances
         )
         result.copyInto(output.data)
         return output
     }
+
+    /**
+     * The distance of each pixel to the nearest one with no NaN channel, to pass to upscale when
+     * upscaling the same bitmap several times.
+     */
+    fun nearestValidDistances(): IntArray {
+        return Toolkit.nearestValidDistances(data, width, height, channels)
+    }
+
+    fun blur(radius: Int = 5): FloatBitmap {
+        return wrap(width, height, channels, Toolkit.blur(data, channels, width, height, radius))
+    }
+
+    fun convolve(
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP
+    ): FloatBitmap {
+        val result = Toolkit.convolve(
+            data, channels, width, height, coefficients, kernelSizeX, kernelSizeY, borderMode
+        )
+        return wrap(width, height, channels, result)
+    }
+
+    /**
+     * Bicubic resize, without the NaN handling of upscale.
+     */
+    fun resize(newWidth: Int, newHeight: Int): FloatBitmap {
+        val result = Toolkit.resize(data, channels, width, height, newWidth, newHeight)
+        return wrap(newWidth, newHeight, channels, result)
+    }
+
+    fun colorMatrix(
+        matrix: FloatArray,
+        addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f),
+        outputChannels: Int = channels
+    ): FloatBitmap {
+        val result = Toolkit.colorMatrix(
+            data, channels, width, height, outputChannels, matrix, addVector
+        )
+        return wrap(width, height, outputChannels, result)
+    }
+
+    fun threshold(threshold: Float, binary: Boolean = true, channel: Int = 0): FloatBitmap {
+        val result = Toolkit.threshold(
+            data, width, height, channels, threshold, binary, channel.toByte()
+        )
+        return wrap(width, height, channels, result)
+    }
+
+    /**
+     * The minimum and maximum value of a channel, skipping NaN values. A channel past the last
+     * one is the gray value.
+     */
+    fun minMax(channel: Int = 0): Pair<Float, Float> {
+        val result = Toolkit.minMax(data, width, height, channels, channel.toByte())
+        return result[0] to result[1]
+    }
+
+    fun average(channel: Int = 0): Double {
+        return Toolkit.average(data, width, height, channels, channel.toByte())
+    }
+
+    fun standardDeviation(channel: Int = 0, average: Double? = null): Double {
+        return Toolkit.standardDeviation(data, width, height, channels, channel.toByte(), average)
+    }
+
+    private fun wrap(width: Int, height: Int, channels: Int, values: FloatArray): FloatBitmap {
+        val output = FloatBitmap(width, height, channels)
+        values.copyInto(output.data)
+        return output
+    }
 }
\ No newline at end of file
@@ -18,11 +18,24 @@ package com.kylecorry.andromeda.bitmaps
 
 import android.graphics.Bitmap
 import android.graphics.Rect
+import android.hardware.HardwareBuffer
+import android.os.Build
+import androidx.annotation.RequiresApi
 import androidx.core.graphics.alpha
 import androidx.core.graphics.blue
 import androidx.core.graphics.green
 import androidx.core.graphics.red
 import androidx.core.graphics.createBitmap
+import java.nio.Buffer
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.CharBuffer
+import java.nio.DoubleBuffer
+import java.nio.FloatBuffer
+import java.nio.IntBuffer
+import java.nio.LongBuffer
+import java.nio.ShortBuffer
+import kotlin.coroutines.suspendCoroutine
 
 // This string is used for error messages.
 private const val externalName = "RenderScript Toolkit"
@@ -38,11 +51,16 @@ private const val externalName = "RenderScript Toolkit"
  * For ByteArrays, you need to specify the width and height of the data to be processed, as
  * well as the number of bytes per pixel. For most use cases, this will be 4.
  *
+ * The functions also accept direct ByteBuffers and, on API 26 and up, RGBA_8888 HardwareBuffers.
+ * Their pixels are read in place, without a copy through the Java heap. The float functions
+ * accept direct FloatBuffers, which must be in the native byte order.
+ *
  * The Toolkit creates a thread pool that's used for processing the functions. The threads live
  * for the duration of the application. They can be destroyed by calling the method shutdown().
  *
- * This library is thread safe. You can call methods from different poolThreads. The functions will
- * execute sequentially.
+ * This library is thread safe. You can call methods from different threads. The calls execute
+ * concurrently and share the pool threads. See setCallingThreadPriority() to favor the calls of
+ * a latency sensitive thread, e.g. one processing camera frames.
  *
  * A native C++ version of this Toolkit is available. Check the RenderScriptToolkit.h file in the
  * cpp directory.
@@ -110,7 +128,7 @@ internal object Toolkit {
      * A variant of this method is available to blend ByteArrays.
      *
      * The bitmaps should have identical width and height, and have a config of ARGB_8888.
-     * Bitmaps with a stride different than width * vectorSize are not currently supported.
+     * Bitmaps with padded rows are processed in place.
      *
      * An optional range parameter can be set to restrict the operation to a rectangular subset
      * of each bitmap. If provided, the range must be wholly contained with the dimensions
@@ -147,6 +165,68 @@ internal object Toolkit {
         nativeBlendBitmap(nativeHandle, mode.value, sourceBitmap, destBitmap, restriction)
     }
 
+    /**
+     * Blends a source buffer with a destination buffer, like the ByteArray variant, but on direct
+     * ByteBuffers. The pixels are read and written in place, from the start of the buffers.
+     *
+     * @param mode The specific blending operation to do.
+     * @param sourceBuffer The RGBA input buffer.
+     * @param destBuffer The destination buffer. Used for input and output.
+     * @param sizeX The width of both buffers, as a number of RGBA values.
+     * @param sizeY The height of both buffers, as a number of RGBA values.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     */
+    @JvmOverloads
+    fun blend(
+        mode: BlendingMode,
+        sourceBuffer: ByteBuffer,
+        destBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        restriction: Range2d? = null
+    ) {
+        validateDirectBuffer("blend", sourceBuffer, sizeX * sizeY * 4)
+        validateDirectBuffer("blend", destBuffer, sizeX * sizeY * 4)
+        validateRestriction("blend", sizeX, sizeY, restriction)
+        nativeBlendBuffer(
+            nativeHandle, mode.value, sourceBuffer, destBuffer, sizeX, sizeY, restriction
+        )
+    }
+
+    /**
+     * Blends a source HardwareBuffer with a destination HardwareBuffer, like the Bitmap variant.
+     * Both must be RGBA_8888 and of the same size. The destination must also be writable by the
+     * CPU.
+     *
+     * @param mode The specific blending operation to do.
+     * @param sourceBuffer The RGBA input buffer.
+     * @param destBuffer The destination buffer. Used for input and output.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun blend(
+        mode: BlendingMode,
+        sourceBuffer: HardwareBuffer,
+        destBuffer: HardwareBuffer,
+        restriction: Range2d? = null
+    ) {
+        validateHardwareBuffer("blend", sourceBuffer)
+        validateHardwareBuffer("blend", destBuffer)
+        require(
+            sourceBuffer.width == destBuffer.width && sourceBuffer.height == destBuffer.height
+        ) {
+            "$externalName blend. Source and destination buffers should be the same size. " +
+                    "${sourceBuffer.width}x${sourceBuffer.height} and " +
+                    "${destBuffer.width}x${destBuffer.height} provided."
+        }
+        validateRestriction("blend", sourceBuffer.width, sourceBuffer.height, restriction)
+        nativeBlendBuffer(
+            nativeHandle, mode.value, sourceBuffer, destBuffer, sourceBuffer.width,
+            sourceBuffer.height, restriction
+        )
+    }
+
     /**
      * Blurs an image.
      *
@@ -154,9 +234,11 @@ internal object Toolkit {
      * this method is available to blur Bitmaps.
      *
      * The radius determines which pixels are used to compute each blurred pixels. This Toolkit
-     * accepts values between 1 and 25. Larger values create a more blurred effect but also
-     * take longer to compute. When the radius extends past the edge, the edge pixel will
-     * be used as replacement for the pixel that's out off boundary.
+     * accepts values between 1 and 1000. Larger values create a more blurred effect. Up to 25,
+     * the Gaussian is computed directly and takes longer as the radius grows. Above 25, it's
+     * approximated by three stacked box blurs whose cost doesn't depend on the radius. When the
+     * radius extends past the edge, the edge pixel will be used as replacement for the pixel
+     * that's out off boundary.
      *
      * Each input pixel can either be represented by four bytes (RGBA format) or one byte
      * for the less common blurring of alpha channel only image.
@@ -173,7 +255,7 @@ internal object Toolkit {
      * @param vectorSize Either 1 or 4, the number of bytes in each cell, i.e. A vs. RGBA.
      * @param sizeX The width of both buffers, as a number of 1 or 4 byte cells.
      * @param sizeY The height of both buffers, as a number of 1 or 4 byte cells.
-     * @param radius The radius of the pixels used to blur, a value from 1 to 25.
+     * @param radius The radius of the pixels used to blur, a value from 1 to 1000.
      * @param restriction When not null, restricts the operation to a 2D range of pixels.
      * @return The blurred pixels, a ByteArray of size.
      */
@@ -193,8 +275,8 @@ internal object Toolkit {
             "$externalName blur. inputArray is too small for the given dimensions. " +
                     "$sizeX*$sizeY*$vectorSize < ${inputArray.size}."
         }
-        require(radius in 1..25) {
-            "$externalName blur. The radius should be between 1 and 25. $radius provided."
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
         }
         validateRestriction("blur", sizeX, sizeY, restriction)
 
@@ -212,13 +294,14 @@ internal object Toolkit {
      * this method is available to blur ByteArrays.
      *
      * The radius determines which pixels are used to compute each blurred pixels. This Toolkit
-     * accepts values between 1 and 25. Larger values create a more blurred effect but also
-     * take longer to compute. When the radius extends past the edge, the edge pixel will
-     * be used as replacement for the pixel that's out off boundary.
+     * accepts values between 1 and 1000. Larger values create a more blurred effect. Up to 25,
+     * the Gaussian is computed directly and takes longer as the radius grows. Above 25, it's
+     * approximated by three stacked box blurs whose cost doesn't depend on the radius. When the
+     * radius extends past the edge, the edge pixel will be used as replacement for the pixel
+     * that's out off boundary.
      *
-     * This method supports input Bitmap of config ARGB_8888 and ALPHA_8. Bitmaps with a stride
-     * different than width * vectorSize are not currently supported. The returned Bitmap has the
-     * same config.
+     * This method supports input Bitmap of config ARGB_8888 and ALPHA_8, including bitmaps with
+     * padded rows. The returned Bitmap has the same config.
      *
      * An optional range parameter can be set to restrict the operation to a rectangular subset
      * of each buffer. If provided, the range must be wholly contained with the dimensions
@@ -226,15 +309,15 @@ internal object Toolkit {
      * section that's not blurred all set to 0. This is to stay compatible with RenderScript.
      *
      * @param inputBitmap The buffer of the image to be blurred.
-     * @param radius The radius of the pixels used to blur, a value from 1 to 25. Default is 5.
+     * @param radius The radius of the pixels used to blur, a value from 1 to 1000. Default is 5.
      * @param restriction When not null, restricts the operation to a 2D range of pixels.
      * @return The blurred Bitmap.
      */
     @JvmOverloads
     fun blur(inputBitmap: Bitmap, radius: Int = 5, restriction: Range2d? = null): Bitmap {
         validateBitmap("blur", inputBitmap)
-        require(radius in 1..25) {
-            "$externalName blur. The radius should be between 1 and 25. $radius provided."
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
         }
         validateRestriction("blur", inputBitmap.width, inputBitmap.height, restriction)
 
@@ -243,6 +326,73 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    /**
+     * Blurs an image, like the ByteArray variant, but on a direct ByteBuffer. The pixels are read
+     * in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be blurred.
+     * @param vectorSize Either 1 or 4, the number of bytes in each cell, i.e. A vs. RGBA.
+     * @param sizeX The width of both buffers, as a number of 1 or 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 1 or 4 byte cells.
+     * @param radius The radius of the pixels used to blur, a value from 1 to 1000.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The blurred pixels, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun blur(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        radius: Int = 5,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        require(vectorSize == 1 || vectorSize == 4) {
+            "$externalName blur. The vectorSize should be 1 or 4. $vectorSize provided."
+        }
+        validateDirectBuffer("blur", inputBuffer, sizeX * sizeY * vectorSize)
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
+        }
+        validateRestriction("blur", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * vectorSize)
+        nativeBlurBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, radius, outputBuffer, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Blurs an image, like the Bitmap variant, but on a RGBA_8888 HardwareBuffer that the CPU can
+     * read. Rows with padding are supported.
+     *
+     * @param inputBuffer The buffer of the image to be blurred.
+     * @param radius The radius of the pixels used to blur, a value from 1 to 1000. Default is 5.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The blurred image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun blur(
+        inputBuffer: HardwareBuffer,
+        radius: Int = 5,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("blur", inputBuffer)
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
+        }
+        validateRestriction("blur", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeBlurBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, radius,
+            outputBuffer, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Identity matrix that can be passed to the {@link RenderScriptToolkit::colorMatrix} method.
      *
@@ -393,7 +543,7 @@ internal object Toolkit {
      * Each byte of the RGBA is converted from 0-255 to 0.0-1.0 floats before the multiplication
      * is done.
      *
-     * Bitmaps with a stride different than width * vectorSize are not currently supported.
+     * Bitmaps with padded rows are processed in place.
      *
      * The resulting value is normalized from 0.0-1.0 to a 0-255 value and stored in the output.
      *
@@ -437,11 +587,100 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    /**
+     * Transform an image using a color matrix, like the ByteArray variant, but on a direct
+     * ByteBuffer. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be converted.
+     * @param inputVectorSize The number of bytes in each input cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 1 to 4 byte cells.
+     * @param outputVectorSize The number of bytes in each output cell, a value from 1 to 4.
+     * @param matrix The 4x4 matrix to multiply, in row major format.
+     * @param addVector A vector of four floats that's added to the result of the multiplication.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The converted buffer, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun colorMatrix(
+        inputBuffer: ByteBuffer,
+        inputVectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f),
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        require(inputVectorSize in 1..4) {
+            "$externalName colorMatrix. The inputVectorSize should be between 1 and 4. " +
+                    "$inputVectorSize provided."
+        }
+        require(outputVectorSize in 1..4) {
+            "$externalName colorMatrix. The outputVectorSize should be between 1 and 4. " +
+                    "$outputVectorSize provided."
+        }
+        validateDirectBuffer(
+            "colorMatrix", inputBuffer, sizeX * sizeY * paddedSize(inputVectorSize)
+        )
+        require(matrix.size == 16) {
+            "$externalName colorMatrix. matrix should have 16 entries. ${matrix.size} provided."
+        }
+        require(addVector.size == 4) {
+            "$externalName colorMatrix. addVector should have 4 entries. " +
+                    "${addVector.size} provided."
+        }
+        validateRestriction("colorMatrix", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * paddedSize(outputVectorSize))
+        nativeColorMatrixBuffer(
+            nativeHandle, inputBuffer, inputVectorSize, sizeX, sizeY, outputBuffer,
+            outputVectorSize, matrix, addVector, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Transform an image using a color matrix, like the Bitmap variant, but on a RGBA_8888
+     * HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be converted.
+     * @param matrix The 4x4 matrix to multiply, in row major format.
+     * @param addVector A vector of four floats that's added to the result of the multiplication.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The converted image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun colorMatrix(
+        inputBuffer: HardwareBuffer,
+        matrix: FloatArray,
+        addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f),
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("colorMatrix", inputBuffer)
+        require(matrix.size == 16) {
+            "$externalName colorMatrix. matrix should have 16 entries. ${matrix.size} provided."
+        }
+        require(addVector.size == 4) {
+            "$externalName colorMatrix. addVector should have 4 entries."
+        }
+        validateRestriction("colorMatrix", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeColorMatrixBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, outputBuffer, 4,
+            matrix, addVector, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Convolve a ByteArray.
      *
      * Applies a 3x3 or 5x5 convolution to the input array using the provided coefficients.
-     * A variant of this method is available to convolve Bitmaps.
+     * A variant of this method is available to convolve Bitmaps, and another one takes kernels of
+     * any size.
      *
      * For 3x3 convolutions, 9 coefficients must be provided. For 5x5, 25 coefficients are needed.
      * The coefficients should be provided in row-major format.
@@ -478,6 +717,54 @@ internal object Toolkit {
         sizeY: Int,
         coefficients: FloatArray,
         restriction: Range2d? = null
+    ): ByteArray {
+        val kernelSize = squareKernelSize(coefficients)
+        return convolve(
+            inputArray,
+            vectorSize,
+            sizeX,
+            sizeY,
+            coefficients,
+            kernelSize,
+            kernelSize,
+            BorderMode.CLAMP,
+            restriction
+        )
+    }
+
+    /**
+     * Convolve a ByteArray with a kernel of any size.
+     *
+     * Like the 3x3 and 5x5 variant, but the kernel has kernelSizeX * kernelSizeY coefficients in
+     * row-major format, and borderMode tells how the cells past the edges are read. The kernel
+     * cell ((kernelSizeX - 1) / 2, (kernelSizeY - 1) / 2) is over the cell being computed.
+     *
+     * Separable kernels, i.e. the product of a column and a row like a Gaussian or a box, are
+     * detected and applied as two 1D passes. Their cost grows with kernelSizeX + kernelSizeY
+     * rather than kernelSizeX * kernelSizeY, so there's no need to split them in two calls.
+     *
+     * @param inputArray The buffer of the image to be convolved.
+     * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 1 to 4 byte cells.
+     * @param coefficients The kernelSizeX * kernelSizeY multipliers.
+     * @param kernelSizeX The width of the kernel.
+     * @param kernelSizeY The height of the kernel.
+     * @param borderMode How the cells past the edges are read. Default is [BorderMode.CLAMP].
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved array.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputArray: ByteArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
     ): ByteArray {
         require(vectorSize in 1..4) {
             "$externalName convolve. The vectorSize should be between 1 and 4. " +
@@ -487,10 +774,7 @@ internal object Toolkit {
             "$externalName convolve. inputArray is too small for the given dimensions. " +
                     "$sizeX*$sizeY*$vectorSize < ${inputArray.size}."
         }
-        require(coefficients.size == 9 || coefficients.size == 25) {
-            "$externalName convolve. Only 3x3 or 5x5 convolutions are supported. " +
-                    "${coefficients.size} coefficients provided."
-        }
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
         validateRestriction("convolve", sizeX, sizeY, restriction)
 
         val outputArray = ByteArray(inputArray.size)
@@ -502,6 +786,9 @@ internal object Toolkit {
             sizeY,
             outputArray,
             coefficients,
+            kernelSizeX,
+            kernelSizeY,
+            borderMode.value,
             restriction
         )
         return outputArray
@@ -511,8 +798,8 @@ internal object Toolkit {
      * Convolve a Bitmap.
      *
      * Applies a 3x3 or 5x5 convolution to the input Bitmap using the provided coefficients.
-     * A variant of this method is available to convolve ByteArrays. Bitmaps with a stride different
-     * than width * vectorSize are not currently supported.
+     * A variant of this method is available to convolve ByteArrays, and another one takes kernels
+     * of any size. Bitmaps with padded rows are processed in place.
      *
      * For 3x3 convolutions, 9 coefficients must be provided. For 5x5, 25 coefficients are needed.
      * The coefficients should be provided in row-major format.
@@ -535,19 +822,179 @@ internal object Toolkit {
         inputBitmap: Bitmap,
         coefficients: FloatArray,
         restriction: Range2d? = null
+    ): Bitmap {
+        val kernelSize = squareKernelSize(coefficients)
+        return convolve(
+            inputBitmap, coefficients, kernelSize, kernelSize, BorderMode.CLAMP, restriction
+        )
+    }
+
+    /**
+     * Convolve a Bitmap with a kernel of any size, like the ByteArray variant.
+     *
+     * @param inputBitmap The image to be convolved.
+     * @param coefficients The kernelSizeX * kernelSizeY multipliers.
+     * @param kernelSizeX The width of the kernel.
+     * @param kernelSizeY The height of the kernel.
+     * @param borderMode How the cells past the edges are read. Default is [BorderMode.CLAMP].
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved Bitmap.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputBitmap: Bitmap,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
     ): Bitmap {
         validateBitmap("convolve", inputBitmap)
-        require(coefficients.size == 9 || coefficients.size == 25) {
-            "$externalName convolve. Only 3x3 or 5x5 convolutions are supported. " +
-                    "${coefficients.size} coefficients provided."
-        }
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
         validateRestriction("convolve", inputBitmap, restriction)
 
         val outputBitmap = createCompatibleBitmap(inputBitmap)
-        nativeConvolveBitmap(nativeHandle, inputBitmap, outputBitmap, coefficients, restriction)
+        nativeConvolveBitmap(
+            nativeHandle, inputBitmap, outputBitmap, coefficients, kernelSizeX, kernelSizeY,
+            borderMode.value, restriction
+        )
         return outputBitmap
     }
 
+    /**
+     * Convolve an image, like the ByteArray variant, but on a direct ByteBuffer. The pixels are
+     * read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be convolved.
+     * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 1 to 4 byte cells.
+     * @param coefficients A FloatArray of size 9 or 25, containing the multipliers.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved pixels, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        val kernelSize = squareKernelSize(coefficients)
+        return convolve(
+            inputBuffer,
+            vectorSize,
+            sizeX,
+            sizeY,
+            coefficients,
+            kernelSize,
+            kernelSize,
+            BorderMode.CLAMP,
+            restriction
+        )
+    }
+
+    /**
+     * Convolve an image with a kernel of any size, like the ByteArray variant, but on a direct
+     * ByteBuffer. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be convolved.
+     * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 1 to 4 byte cells.
+     * @param coefficients The kernelSizeX * kernelSizeY multipliers.
+     * @param kernelSizeX The width of the kernel.
+     * @param kernelSizeY The height of the kernel.
+     * @param borderMode How the cells past the edges are read. Default is [BorderMode.CLAMP].
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved pixels, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName convolve. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        validateDirectBuffer("convolve", inputBuffer, sizeX * sizeY * vectorSize)
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
+        validateRestriction("convolve", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * vectorSize)
+        nativeConvolveBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, outputBuffer, coefficients,
+            kernelSizeX, kernelSizeY, borderMode.value, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Convolve an image, like the Bitmap variant, but on a RGBA_8888 HardwareBuffer that the CPU
+     * can read.
+     *
+     * @param inputBuffer The buffer of the image to be convolved.
+     * @param coefficients A FloatArray of size 9 or 25, containing the multipliers.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun convolve(
+        inputBuffer: HardwareBuffer,
+        coefficients: FloatArray,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        val kernelSize = squareKernelSize(coefficients)
+        return convolve(
+            inputBuffer, coefficients, kernelSize, kernelSize, BorderMode.CLAMP, restriction
+        )
+    }
+
+    /**
+     * Convolve an image with a kernel of any size, like the Bitmap variant, but on a RGBA_8888
+     * HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be convolved.
+     * @param coefficients The kernelSizeX * kernelSizeY multipliers.
+     * @param kernelSizeX The width of the kernel.
+     * @param kernelSizeY The height of the kernel.
+     * @param borderMode How the cells past the edges are read. Default is [BorderMode.CLAMP].
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun convolve(
+        inputBuffer: HardwareBuffer,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("convolve", inputBuffer)
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
+        validateRestriction("convolve", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeConvolveBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, outputBuffer,
+            coefficients, kernelSizeX, kernelSizeY, borderMode.value, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Compute the histogram of an image.
      *
@@ -618,7 +1065,7 @@ internal object Toolkit {
      *
      * For ALPHA_8, an IntArray of size 256 is returned.
      *
-     * Bitmaps with a stride different than width * vectorSize are not currently supported.
+     * Bitmaps with padded rows are processed in place.
      *
      * A variant of this method is available to do the histogram of a ByteArray.
      *
@@ -644,16 +1091,74 @@ internal object Toolkit {
     }
 
     /**
-     * Compute the histogram of the dot product of an image.
+     * Compute the histogram of an image, like the ByteArray variant, but on a direct ByteBuffer.
+     * The pixels are read in place, from the start of the buffer.
      *
-     * This method supports cells of 1 to 4 bytes in length. For each cell of the array,
-     * the dot product of its bytes with the provided coefficients is computed. The resulting
-     * floating point value is converted to an unsigned byte and tallied in the histogram.
-     *
-     * If coefficients is null, the coefficients used for RGBA luminosity calculation will be used,
-     * i.e. the values [0.299f, 0.587f, 0.114f, 0.f].
-     *
-     * Each coefficients must be >= 0 and their sum must be 1.0 or less. There must be the same
+     * @param inputBuffer The buffer of the image to be analyzed.
+     * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+     * @param sizeX The width of the input buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of the input buffers, as a number of 1 to 4 byte cells.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resulting array of counts.
+     */
+    @JvmOverloads
+    fun histogram(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        restriction: Range2d? = null
+    ): IntArray {
+        require(vectorSize in 1..4) {
+            "$externalName histogram. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        validateDirectBuffer("histogram", inputBuffer, sizeX * sizeY * vectorSize)
+        validateRestriction("histogram", sizeX, sizeY, restriction)
+
+        val outputArray = IntArray(256 * paddedSize(vectorSize))
+        nativeHistogramBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, outputArray, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Compute the histogram of an image, like the Bitmap variant, but on a RGBA_8888
+     * HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be analyzed.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resulting array of counts.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun histogram(
+        inputBuffer: HardwareBuffer,
+        restriction: Range2d? = null
+    ): IntArray {
+        validateHardwareBuffer("histogram", inputBuffer)
+        validateRestriction("histogram", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = IntArray(256 * 4)
+        nativeHistogramBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, outputArray,
+            restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Compute the histogram of the dot product of an image.
+     *
+     * This method supports cells of 1 to 4 bytes in length. For each cell of the array,
+     * the dot product of its bytes with the provided coefficients is computed. The resulting
+     * floating point value is converted to an unsigned byte and tallied in the histogram.
+     *
+     * If coefficients is null, the coefficients used for RGBA luminosity calculation will be used,
+     * i.e. the values [0.299f, 0.587f, 0.114f, 0.f].
+     *
+     * Each coefficients must be >= 0 and their sum must be 1.0 or less. There must be the same
      * number of coefficients as vectorSize.
      *
      * A variant of this method is available to do the histogram of a Bitmap.
@@ -723,7 +1228,7 @@ internal object Toolkit {
      * Each coefficients must be >= 0 and their sum must be 1.0 or less. For ARGB_8888, four values
      * must be provided; for ALPHA_8, one.
      *
-     * Bitmaps with a stride different than width * vectorSize are not currently supported.
+     * Bitmaps with padded rows are processed in place.
      *
      * A variant of this method is available to do the histogram of a ByteArray.
      *
@@ -756,6 +1261,73 @@ internal object Toolkit {
         return outputArray
     }
 
+    /**
+     * Compute the histogram of the dot product of an image, like the ByteArray variant, but on a
+     * direct ByteBuffer. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be analyzed.
+     * @param vectorSize The number of bytes in each cell, a value from 1 to 4.
+     * @param sizeX The width of the input buffers, as a number of 1 to 4 byte cells.
+     * @param sizeY The height of the input buffers, as a number of 1 to 4 byte cells.
+     * @param coefficients The dot product multipliers. Size should equal vectorSize. Can be null.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resulting vector of counts.
+     */
+    @JvmOverloads
+    fun histogramDot(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray? = null,
+        restriction: Range2d? = null
+    ): IntArray {
+        require(vectorSize in 1..4) {
+            "$externalName histogramDot. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        validateDirectBuffer("histogramDot", inputBuffer, sizeX * sizeY * vectorSize)
+        validateHistogramDotCoefficients(coefficients, vectorSize)
+        validateRestriction("histogramDot", sizeX, sizeY, restriction)
+
+        val outputArray = IntArray(256)
+        val actualCoefficients = coefficients ?: floatArrayOf(0.299f, 0.587f, 0.114f, 0f)
+        nativeHistogramDotBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, outputArray, actualCoefficients,
+            restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Compute the histogram of the dot product of an image, like the Bitmap variant, but on a
+     * RGBA_8888 HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be analyzed.
+     * @param coefficients The four dot product multipliers. Can be null.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resulting vector of counts.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun histogramDot(
+        inputBuffer: HardwareBuffer,
+        coefficients: FloatArray? = null,
+        restriction: Range2d? = null
+    ): IntArray {
+        validateHardwareBuffer("histogramDot", inputBuffer)
+        validateHistogramDotCoefficients(coefficients, 4)
+        validateRestriction("histogramDot", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = IntArray(256)
+        val actualCoefficients = coefficients ?: floatArrayOf(0.299f, 0.587f, 0.114f, 0f)
+        nativeHistogramDotBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, outputArray,
+            actualCoefficients, restriction
+        )
+        return outputArray
+    }
+
     /**
      * Transform an image using a look up table
      *
@@ -819,8 +1391,7 @@ internal object Toolkit {
      * range of a byte.
      *
      * The input Bitmap should be in config ARGB_8888. A variant of this method is available to
-     * transform a ByteArray. Bitmaps with a stride different than width * vectorSize are not
-     * currently supported.
+     * transform a ByteArray. Bitmaps with padded rows are processed in place.
      *
      * An optional range parameter can be set to restrict the operation to a rectangular subset
      * of each buffer. If provided, the range must be wholly contained with the dimensions
@@ -855,6 +1426,63 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    /**
+     * Transform an image using a look up table, like the ByteArray variant, but on a direct
+     * ByteBuffer. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be transformed.
+     * @param sizeX The width of both buffers, as a number of 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 4 byte cells.
+     * @param table The four arrays of 256 values that's used to convert each channel.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The transformed image, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun lut(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        table: LookupTable,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        validateDirectBuffer("lut", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("lut", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeLutBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, table.red, table.green,
+            table.blue, table.alpha, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Transform an image using a look up table, like the Bitmap variant, but on a RGBA_8888
+     * HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be transformed.
+     * @param table The four arrays of 256 values that's used to convert each channel.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The transformed image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun lut(
+        inputBuffer: HardwareBuffer,
+        table: LookupTable,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("lut", inputBuffer)
+        validateRestriction("lut", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeLutBuffer(
+            nativeHandle, inputBuffer, outputBuffer, inputBuffer.width, inputBuffer.height,
+            table.red, table.green, table.blue, table.alpha, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Transform an image using a 3D look up table
      *
@@ -920,8 +1548,8 @@ internal object Toolkit {
      * is returned in the output array.
      *
      * The input bitmap should be in RGBA_8888 format. The A channel is preserved. A variant of this
-     * method is also available to transform ByteArray. Bitmaps with a stride different than
-     * width * vectorSize are not currently supported.
+     * method is also available to transform ByteArray. Bitmaps with padded rows are processed in
+     * place.
      *
      * An optional range parameter can be set to restrict the operation to a rectangular subset
      * of each buffer. If provided, the range must be wholly contained with the dimensions
@@ -953,6 +1581,77 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    /**
+     * Transform an image using a 3D look up table, like the ByteArray variant, but on a direct
+     * ByteBuffer. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be transformed.
+     * @param sizeX The width of both buffers, as a number of 4 byte cells.
+     * @param sizeY The height of both buffers, as a number of 4 byte cells.
+     * @param cube The translation cube.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The transformed image, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun lut3d(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        cube: Rgba3dArray,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        validateDirectBuffer("lut3d", inputBuffer, sizeX * sizeY * 4)
+        require(
+            cube.sizeX >= 2 && cube.sizeY >= 2 && cube.sizeZ >= 2 &&
+                    cube.sizeX <= 256 && cube.sizeY <= 256 && cube.sizeZ <= 256
+        ) {
+            "$externalName lut3d. The dimensions of the cube should be between 2 and 256. " +
+                    "(${cube.sizeX}, ${cube.sizeY}, ${cube.sizeZ}) provided."
+        }
+        validateRestriction("lut3d", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeLut3dBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, cube.values, cube.sizeX,
+            cube.sizeY, cube.sizeZ, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Transform an image using a 3D look up table, like the Bitmap variant, but on a RGBA_8888
+     * HardwareBuffer that the CPU can read.
+     *
+     * @param inputBuffer The buffer of the image to be transformed.
+     * @param cube The translation cube.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The transformed image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun lut3d(
+        inputBuffer: HardwareBuffer,
+        cube: Rgba3dArray,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("lut3d", inputBuffer)
+        require(
+            cube.sizeX >= 2 && cube.sizeY >= 2 && cube.sizeZ >= 2 &&
+                    cube.sizeX <= 256 && cube.sizeY <= 256 && cube.sizeZ <= 256
+        ) {
+            "$externalName lut3d. The dimensions of the cube should be between 2 and 256. " +
+                    "(${cube.sizeX}, ${cube.sizeY}, ${cube.sizeZ}) provided."
+        }
+        validateRestriction("lut3d", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeLut3dBuffer(
+            nativeHandle, inputBuffer, outputBuffer, inputBuffer.width, inputBuffer.height,
+            cube.values, cube.sizeX, cube.sizeY, cube.sizeZ, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Resize an image.
      *
@@ -1020,8 +1719,7 @@ internal object Toolkit {
      * Resizes an image using bicubic interpolation.
      *
      * This method supports input Bitmap of config ARGB_8888 and ALPHA_8. The returned Bitmap
-     * has the same config. Bitmaps with a stride different than width * vectorSize are not
-     * currently supported.
+     * has the same config. Bitmaps with padded rows are processed in place.
      *
      * An optional range parameter can be set to restrict the operation to a rectangular subset
      * of the output buffer. The corresponding scaled range of the input will be used. If provided,
@@ -1049,6 +1747,74 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    /**
+     * Resize an image, like the ByteArray variant, but on a direct ByteBuffer. The pixels are read
+     * in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be resized.
+     * @param vectorSize The number of bytes in each cell of both buffers. A value from 1 to 4.
+     * @param inputSizeX The width of the input buffer, as a number of 1-4 byte cells.
+     * @param inputSizeY The height of the input buffer, as a number of 1-4 byte cells.
+     * @param outputSizeX The width of the output buffer, as a number of 1-4 byte cells.
+     * @param outputSizeY The height of the output buffer, as a number of 1-4 byte cells.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resized image, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun resize(
+        inputBuffer: ByteBuffer,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName resize. The vectorSize should be between 1 and 4. $vectorSize provided."
+        }
+        validateDirectBuffer(
+            "resize", inputBuffer, inputSizeX * inputSizeY * paddedSize(vectorSize)
+        )
+        validateRestriction("resize", outputSizeX, outputSizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(outputSizeX * outputSizeY * paddedSize(vectorSize))
+        nativeResizeBuffer(
+            nativeHandle, inputBuffer, vectorSize, inputSizeX, inputSizeY, outputBuffer,
+            outputSizeX, outputSizeY, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Resize an image, like the Bitmap variant, but on a RGBA_8888 HardwareBuffer that the CPU
+     * can read.
+     *
+     * @param inputBuffer The buffer of the image to be resized.
+     * @param outputSizeX The width of the output buffer, as a number of 1-4 byte cells.
+     * @param outputSizeY The height of the output buffer, as a number of 1-4 byte cells.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resized image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun resize(
+        inputBuffer: HardwareBuffer,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("resize", inputBuffer)
+        validateRestriction("resize", outputSizeX, outputSizeY, restriction)
+
+        val outputBuffer = createHardwareBuffer(outputSizeX, outputSizeY)
+        nativeResizeBuffer(
+            nativeHandle, inputBuffer, 4, inputBuffer.width, inputBuffer.height, outputBuffer,
+            outputSizeX, outputSizeY, restriction
+        )
+        return outputBuffer
+    }
+
     /**
      * Convert an image from YUV to RGB.
      *
@@ -1062,16 +1828,27 @@ internal object Toolkit {
      * @param sizeX The width in pixels of the image.
      * @param sizeY The height in pixels of the image.
      * @param format Either YV12 or NV21.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
      * @return The converted image as a byte array.
      */
-    fun yuvToRgb(inputArray: ByteArray, sizeX: Int, sizeY: Int, format: YuvFormat): ByteArray {
+    @JvmOverloads
+    fun yuvToRgb(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        format: YuvFormat,
+        restriction: Range2d? = null
+    ): ByteArray {
         require(sizeX % 2 == 0 && sizeY % 2 == 0) {
             "$externalName yuvToRgb. Non-even dimensions are not supported. " +
                     "$sizeX and $sizeY were provided."
         }
+        validateRestriction("yuvToRgb", sizeX, sizeY, restriction)
 
         val outputArray = ByteArray(sizeX * sizeY * 4)
-        nativeYuvToRgb(nativeHandle, inputArray, outputArray, sizeX, sizeY, format.value)
+        nativeYuvToRgb(
+            nativeHandle, inputArray, outputArray, sizeX, sizeY, format.value, restriction
+        )
         return outputArray
     }
 
@@ -1088,45 +1865,221 @@ internal object Toolkit {
      * @param sizeX The width in pixels of the image.
      * @param sizeY The height in pixels of the image.
      * @param format Either YV12 or NV21.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
      * @return The converted image.
      */
-    fun yuvToRgbBitmap(inputArray: ByteArray, sizeX: Int, sizeY: Int, format: YuvFormat): Bitmap {
+    @JvmOverloads
+    fun yuvToRgbBitmap(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        format: YuvFormat,
+        restriction: Range2d? = null
+    ): Bitmap {
         require(sizeX % 2 == 0 && sizeY % 2 == 0) {
             "$externalName yuvToRgbBitmap. Non-even dimensions are not supported. " +
                     "$sizeX and $sizeY were provided."
         }
+        validateRestriction("yuvToRgbBitmap", sizeX, sizeY, restriction)
 
         val outputBitmap = createBitmap(sizeX, sizeY)
-        nativeYuvToRgbBitmap(nativeHandle, inputArray, sizeX, sizeY, outputBitmap, format.value)
+        nativeYuvToRgbBitmap(
+            nativeHandle, inputArray, sizeX, sizeY, outputBitmap, format.value, restriction
+        )
         return outputBitmap
     }
 
+    /**
+     * Convert an image from YUV to RGB, like the ByteArray variant, but on a direct ByteBuffer.
+     * The YUV data is read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the image to be converted.
+     * @param sizeX The width in pixels of the image.
+     * @param sizeY The height in pixels of the image.
+     * @param format Either YV12 or NV21.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The converted image, in a new direct buffer.
+     */
     @JvmOverloads
-    fun threshold(
-        inputArray: ByteArray,
+    fun yuvToRgb(
+        inputBuffer: ByteBuffer,
         sizeX: Int,
         sizeY: Int,
-        threshold: Float,
-        binary: Boolean,
-        channel: Byte,
+        format: YuvFormat,
         restriction: Range2d? = null
-    ): ByteArray {
-        require(inputArray.size >= sizeX * sizeY * 4) {
-            "$externalName threshold. inputArray is too small for the given dimensions. " +
-                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+    ): ByteBuffer {
+        require(sizeX % 2 == 0 && sizeY % 2 == 0) {
+            "$externalName yuvToRgb. Non-even dimensions are not supported. " +
+                    "$sizeX and $sizeY were provided."
         }
-        validateRestriction("threshold", sizeX, sizeY, restriction)
+        require(inputBuffer.isDirect) {
+            "$externalName yuvToRgb. inputBuffer should be a direct buffer."
+        }
+        validateRestriction("yuvToRgb", sizeX, sizeY, restriction)
 
-        val outputArray = ByteArray(inputArray.size)
-        nativeThreshold(
-            nativeHandle,
-            inputArray,
-            outputArray,
-            sizeX,
-            sizeY,
-            threshold,
-            binary,
-            channel,
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeYuvToRgbBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, format.value, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Convert an image from YUV to RGB, like the ByteArray variant, but from a direct ByteBuffer
+     * to a RGBA_8888 HardwareBuffer.
+     *
+     * @param inputBuffer The buffer of the image to be converted.
+     * @param sizeX The width in pixels of the image.
+     * @param sizeY The height in pixels of the image.
+     * @param format Either YV12 or NV21.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The converted image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun yuvToRgbHardwareBuffer(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        format: YuvFormat,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        require(sizeX % 2 == 0 && sizeY % 2 == 0) {
+            "$externalName yuvToRgbHardwareBuffer. Non-even dimensions are not supported. " +
+                    "$sizeX and $sizeY were provided."
+        }
+        require(inputBuffer.isDirect) {
+            "$externalName yuvToRgbHardwareBuffer. inputBuffer should be a direct buffer."
+        }
+        validateRestriction("yuvToRgbHardwareBuffer", sizeX, sizeY, restriction)
+
+        val outputBuffer = createHardwareBuffer(sizeX, sizeY)
+        nativeYuvToRgbBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, format.value, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Convert the planes of a YUV image to an RGB Bitmap.
+     *
+     * The planes are read in place, with their strides, so the planes of a YUV_420_888 camera
+     * frame can be converted without first copying them into a packed buffer. The U and V planes
+     * are subsampled by 2 in both directions and share their strides. The output is RGBA; the
+     * alpha channel will be set to 255.
+     *
+     * The image can also be cropped, scaled and rotated in the same pass, which only writes the
+     * final pixels. When the crop is an integer multiple of the output size, each output pixel
+     * is the average of the block of pixels it covers. Otherwise the output is sampled
+     * bilinearly.
+     *
+     * @param yPlane The direct buffer of the Y plane.
+     * @param uPlane The direct buffer of the U plane.
+     * @param vPlane The direct buffer of the V plane.
+     * @param yRowStride The distance in bytes between two rows of the Y plane.
+     * @param uvRowStride The distance in bytes between two rows of the U and V planes.
+     * @param uvPixelStride The distance in bytes between two samples of the U and V planes.
+     * @param sizeX The width in pixels of the image.
+     * @param sizeY The height in pixels of the image.
+     * @param rotation The clockwise rotation of the output in degrees: 0, 90, 180 or 270.
+     * @param crop The part of the image to convert, in pixels of the image. The whole image if
+     * null.
+     * @param outputSizeX The width of the output, after the rotation. Defaults to that of the
+     * rotated crop.
+     * @param outputSizeY The height of the output, after the rotation. Defaults to that of the
+     * rotated crop.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels of the
+     * output.
+     * @return The converted image.
+     */
+    @JvmOverloads
+    fun yuvToRgbBitmap(
+        yPlane: ByteBuffer,
+        uPlane: ByteBuffer,
+        vPlane: ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        sizeX: Int,
+        sizeY: Int,
+        rotation: Int = 0,
+        crop: Range2d? = null,
+        outputSizeX: Int? = null,
+        outputSizeY: Int? = null,
+        restriction: Range2d? = null
+    ): Bitmap {
+        require(sizeX % 2 == 0 && sizeY % 2 == 0) {
+            "$externalName yuvToRgbBitmap. Non-even dimensions are not supported. " +
+                    "$sizeX and $sizeY were provided."
+        }
+        require(yPlane.isDirect && uPlane.isDirect && vPlane.isDirect) {
+            "$externalName yuvToRgbBitmap. The plane buffers must be direct."
+        }
+        require(
+            yRowStride >= sizeX && uvPixelStride >= 1 &&
+                    uvRowStride >= ((sizeX + 1) / 2 - 1) * uvPixelStride + 1
+        ) {
+            "$externalName yuvToRgbBitmap. Invalid strides: $yRowStride for Y, " +
+                    "$uvRowStride and $uvPixelStride for U and V."
+        }
+        require(rotation == 0 || rotation == 90 || rotation == 180 || rotation == 270) {
+            "$externalName yuvToRgbBitmap. The rotation should be 0, 90, 180 or 270. " +
+                    "$rotation was provided."
+        }
+        validateRestriction("yuvToRgbBitmap", sizeX, sizeY, crop)
+
+        val cropSizeX = if (crop == null) sizeX else crop.endX - crop.startX
+        val cropSizeY = if (crop == null) sizeY else crop.endY - crop.startY
+        val transposed = rotation == 90 || rotation == 270
+        val outputBitmap = createBitmap(
+            outputSizeX ?: if (transposed) cropSizeY else cropSizeX,
+            outputSizeY ?: if (transposed) cropSizeX else cropSizeY
+        )
+        validateRestriction("yuvToRgbBitmap", outputBitmap, restriction)
+        nativeYuvPlanesToRgbBitmap(
+            nativeHandle,
+            yPlane,
+            uPlane,
+            vPlane,
+            yRowStride,
+            uvRowStride,
+            uvPixelStride,
+            sizeX,
+            sizeY,
+            outputBitmap,
+            rotation,
+            crop,
+            restriction
+        )
+        return outputBitmap
+    }
+
+    @JvmOverloads
+    fun threshold(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): ByteArray {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName threshold. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        validateRestriction("threshold", sizeX, sizeY, restriction)
+
+        val outputArray = ByteArray(inputArray.size)
+        nativeThreshold(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            sizeX,
+            sizeY,
+            threshold,
+            binary,
+            channel,
             restriction
         )
         return outputArray
@@ -1157,6 +2110,209 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    @JvmOverloads
+    fun threshold(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        validateDirectBuffer("threshold", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("threshold", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeThresholdBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, threshold, binary, channel,
+            restriction
+        )
+        return outputBuffer
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun threshold(
+        inputBuffer: HardwareBuffer,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("threshold", inputBuffer)
+        validateRestriction("threshold", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeThresholdBuffer(
+            nativeHandle, inputBuffer, outputBuffer, inputBuffer.width, inputBuffer.height,
+            threshold, binary, channel, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Run several operations over an RGBA ByteArray in one pass.
+     *
+     * The result is the same as calling colorMatrix, convolve, lut, and threshold one after the
+     * other, but the intermediate images are never written to memory. The image is processed
+     * tile by tile, each tile going through all the stages while it's in the cache.
+     *
+     * The stages use the same code as the corresponding methods, but a few values may differ
+     * slightly from the separate calls, as the SIMD code rounds differently near tile edges.
+     *
+     * Operations that change the dimensions of the image, like resize, can't be stages. Run
+     * them before the pipeline.
+     *
+     * @param inputArray The buffer of the RGBA image to process.
+     * @param sizeX The width of the buffer, as a number of 4 byte cells.
+     * @param sizeY The height of the buffer, as a number of 4 byte cells.
+     * @param stages The operations to do, in order.
+     * @param histogram When not null, an IntArray of 256 * 4 values that receives the histogram of
+     * the result, like [histogram].
+     * @return The processed array.
+     */
+    @JvmOverloads
+    fun pipeline(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        stages: List<PipelineStage>,
+        histogram: IntArray? = null
+    ): ByteArray {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName pipeline. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        require(histogram == null || histogram.size >= 256 * 4) {
+            "$externalName pipeline. histogram should have at least 1024 entries."
+        }
+        val packed = PackedPipelineStages(stages)
+
+        val outputArray = ByteArray(inputArray.size)
+        nativePipeline(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            sizeX,
+            sizeY,
+            packed.types,
+            packed.floats,
+            packed.ints,
+            packed.bytes,
+            histogram
+        )
+        return outputArray
+    }
+
+    /**
+     * Run several operations over a Bitmap in one pass.
+     *
+     * See the ByteArray variant for details. The Bitmap must be ARGB_8888.
+     *
+     * @param inputBitmap The image to process.
+     * @param stages The operations to do, in order.
+     * @param histogram When not null, an IntArray of 256 * 4 values that receives the histogram of
+     * the result.
+     * @param inPlace If true, the result is written to inputBitmap. Not allowed if a stage is a
+     * convolution.
+     * @return The processed image.
+     */
+    @JvmOverloads
+    fun pipeline(
+        inputBitmap: Bitmap,
+        stages: List<PipelineStage>,
+        histogram: IntArray? = null,
+        inPlace: Boolean = false
+    ): Bitmap {
+        validateBitmap("pipeline", inputBitmap)
+        require(!inPlace || stages.none { it is PipelineStage.Convolve }) {
+            "$externalName pipeline. A pipeline with a convolution can't run in place."
+        }
+        require(histogram == null || histogram.size >= 256 * 4) {
+            "$externalName pipeline. histogram should have at least 1024 entries."
+        }
+        val packed = PackedPipelineStages(stages)
+
+        val outputBitmap = createCompatibleBitmap(inputBitmap, inPlace)
+        nativePipelineBitmap(
+            nativeHandle,
+            inputBitmap,
+            outputBitmap,
+            packed.types,
+            packed.floats,
+            packed.ints,
+            packed.bytes,
+            histogram
+        )
+        return outputBitmap
+    }
+
+    /**
+     * Run several operations over an RGBA direct ByteBuffer in one pass. See the ByteArray
+     * variant for details. The pixels are read in place, from the start of the buffer.
+     *
+     * @param inputBuffer The buffer of the RGBA image to process.
+     * @param sizeX The width of the buffer, as a number of 4 byte cells.
+     * @param sizeY The height of the buffer, as a number of 4 byte cells.
+     * @param stages The operations to do, in order.
+     * @param histogram When not null, an IntArray of 256 * 4 values that receives the histogram of
+     * the result.
+     * @return The processed image, in a new direct buffer.
+     */
+    @JvmOverloads
+    fun pipeline(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        stages: List<PipelineStage>,
+        histogram: IntArray? = null
+    ): ByteBuffer {
+        validateDirectBuffer("pipeline", inputBuffer, sizeX * sizeY * 4)
+        require(histogram == null || histogram.size >= 256 * 4) {
+            "$externalName pipeline. histogram should have at least 1024 entries."
+        }
+        val packed = PackedPipelineStages(stages)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativePipelineBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, packed.types, packed.floats,
+            packed.ints, packed.bytes, histogram
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Run several operations over a RGBA_8888 HardwareBuffer in one pass. See the ByteArray
+     * variant for details.
+     *
+     * @param inputBuffer The image to process.
+     * @param stages The operations to do, in order.
+     * @param histogram When not null, an IntArray of 256 * 4 values that receives the histogram of
+     * the result.
+     * @return The processed image, in a new HardwareBuffer.
+     */
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun pipeline(
+        inputBuffer: HardwareBuffer,
+        stages: List<PipelineStage>,
+        histogram: IntArray? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("pipeline", inputBuffer)
+        require(histogram == null || histogram.size >= 256 * 4) {
+            "$externalName pipeline. histogram should have at least 1024 entries."
+        }
+        val packed = PackedPipelineStages(stages)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativePipelineBuffer(
+            nativeHandle, inputBuffer, outputBuffer, inputBuffer.width, inputBuffer.height,
+            packed.types, packed.floats, packed.ints, packed.bytes, histogram
+        )
+        return outputBuffer
+    }
+
     @JvmOverloads
     fun replaceColor(
         inputArray: ByteArray,
@@ -1229,6 +2385,77 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    @JvmOverloads
+    fun replaceColor(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        targetColor: Int,
+        replacementColor: Int,
+        tolerance: Float = 0f,
+        interpolate: Boolean = false,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        validateDirectBuffer("replaceColor", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("replaceColor", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeColorReplaceBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputBuffer,
+            sizeX,
+            sizeY,
+            targetColor.red.toByte(),
+            targetColor.green.toByte(),
+            targetColor.blue.toByte(),
+            targetColor.alpha.toByte(),
+            replacementColor.red.toByte(),
+            replacementColor.green.toByte(),
+            replacementColor.blue.toByte(),
+            replacementColor.alpha.toByte(),
+            tolerance,
+            interpolate,
+            restriction
+        )
+        return outputBuffer
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun replaceColor(
+        inputBuffer: HardwareBuffer,
+        targetColor: Int,
+        replacementColor: Int,
+        tolerance: Float = 0f,
+        interpolate: Boolean = false,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("replaceColor", inputBuffer)
+        validateRestriction("replaceColor", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer.width, inputBuffer.height)
+        nativeColorReplaceBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputBuffer,
+            inputBuffer.width,
+            inputBuffer.height,
+            targetColor.red.toByte(),
+            targetColor.green.toByte(),
+            targetColor.blue.toByte(),
+            targetColor.alpha.toByte(),
+            replacementColor.red.toByte(),
+            replacementColor.green.toByte(),
+            replacementColor.blue.toByte(),
+            replacementColor.alpha.toByte(),
+            tolerance,
+            interpolate,
+            restriction
+        )
+        return outputBuffer
+    }
+
     @JvmOverloads
     fun weightedAdd(
         inputArray1: ByteArray,
@@ -1304,6 +2531,58 @@ internal object Toolkit {
         return outputBitmap
     }
 
+    @JvmOverloads
+    fun weightedAdd(
+        inputBuffer1: ByteBuffer,
+        inputBuffer2: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        weight1: Float,
+        weight2: Float,
+        absolute: Boolean,
+        restriction: Range2d? = null
+    ): ByteBuffer {
+        validateDirectBuffer("weightedAdd", inputBuffer1, sizeX * sizeY * 4)
+        validateDirectBuffer("weightedAdd", inputBuffer2, sizeX * sizeY * 4)
+        validateRestriction("weightedAdd", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * 4)
+        nativeWeightedAddBuffer(
+            nativeHandle, inputBuffer1, inputBuffer2, outputBuffer, sizeX, sizeY, weight1,
+            weight2, absolute, restriction
+        )
+        return outputBuffer
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun weightedAdd(
+        inputBuffer1: HardwareBuffer,
+        inputBuffer2: HardwareBuffer,
+        weight1: Float,
+        weight2: Float,
+        absolute: Boolean,
+        restriction: Range2d? = null
+    ): HardwareBuffer {
+        validateHardwareBuffer("weightedAdd", inputBuffer1)
+        validateHardwareBuffer("weightedAdd", inputBuffer2)
+        require(
+            inputBuffer1.width == inputBuffer2.width && inputBuffer1.height == inputBuffer2.height
+        ) {
+            "$externalName weightedAdd. inputBuffer1 and inputBuffer2 should have the same size. " +
+                    "${inputBuffer1.width}*${inputBuffer1.height} != " +
+                    "${inputBuffer2.width}*${inputBuffer2.height}."
+        }
+        validateRestriction("weightedAdd", inputBuffer1.width, inputBuffer1.height, restriction)
+
+        val outputBuffer = createHardwareBuffer(inputBuffer1.width, inputBuffer1.height)
+        nativeWeightedAddBuffer(
+            nativeHandle, inputBuffer1, inputBuffer2, outputBuffer, inputBuffer1.width,
+            inputBuffer1.height, weight1, weight2, absolute, restriction
+        )
+        return outputBuffer
+    }
+
     @JvmOverloads
     fun minMax(
         inputArray: ByteArray,
@@ -1352,21 +2631,57 @@ internal object Toolkit {
     }
 
     @JvmOverloads
-    fun average(
-        inputArray: ByteArray,
+    fun minMax(
+        inputBuffer: ByteBuffer,
         sizeX: Int,
         sizeY: Int,
         channel: Byte,
         restriction: Range2d? = null
-    ): Double {
-        require(inputArray.size >= sizeX * sizeY * 4) {
-            "$externalName average. inputArray is too small for the given dimensions. " +
-                    "$sizeX*$sizeY*4 < ${inputArray.size}."
-        }
-        validateRestriction("average", sizeX, sizeY, restriction)
+    ): FloatArray {
+        validateDirectBuffer("minMax", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("minMax", sizeX, sizeY, restriction)
 
-        return nativeAverage(
-            nativeHandle,
+        val outputArray = FloatArray(2)
+        nativeMinMaxBuffer(
+            nativeHandle, inputBuffer, outputArray, sizeX, sizeY, channel, restriction
+        )
+        return outputArray
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun minMax(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateHardwareBuffer("minMax", inputBuffer)
+        validateRestriction("minMax", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = FloatArray(2)
+        nativeMinMaxBuffer(
+            nativeHandle, inputBuffer, outputArray, inputBuffer.width, inputBuffer.height,
+            channel, restriction
+        )
+        return outputArray
+    }
+
+    @JvmOverloads
+    fun average(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): Double {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName average. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        validateRestriction("average", sizeX, sizeY, restriction)
+
+        return nativeAverage(
+            nativeHandle,
             inputArray,
             sizeX,
             sizeY,
@@ -1392,6 +2707,35 @@ internal object Toolkit {
         )
     }
 
+    @JvmOverloads
+    fun average(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): Double {
+        validateDirectBuffer("average", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("average", sizeX, sizeY, restriction)
+
+        return nativeAverageBuffer(nativeHandle, inputBuffer, sizeX, sizeY, channel, restriction)
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun average(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): Double {
+        validateHardwareBuffer("average", inputBuffer)
+        validateRestriction("average", inputBuffer.width, inputBuffer.height, restriction)
+
+        return nativeAverageBuffer(
+            nativeHandle, inputBuffer, inputBuffer.width, inputBuffer.height, channel, restriction
+        )
+    }
+
     @JvmOverloads
     fun standardDeviation(
         inputArray: ByteArray,
@@ -1437,6 +2781,53 @@ internal object Toolkit {
         )
     }
 
+    @JvmOverloads
+    fun standardDeviation(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        average: Double? = null,
+        restriction: Range2d? = null
+    ): Double {
+        validateDirectBuffer("standardDeviation", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("standardDeviation", sizeX, sizeY, restriction)
+
+        return nativeStandardDeviationBuffer(
+            nativeHandle,
+            inputBuffer,
+            sizeX,
+            sizeY,
+            channel,
+            average ?: average(inputBuffer, sizeX, sizeY, channel, restriction),
+            restriction
+        )
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun standardDeviation(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        average: Double? = null,
+        restriction: Range2d? = null
+    ): Double {
+        validateHardwareBuffer("standardDeviation", inputBuffer)
+        validateRestriction(
+            "standardDeviation", inputBuffer.width, inputBuffer.height, restriction
+        )
+
+        return nativeStandardDeviationBuffer(
+            nativeHandle,
+            inputBuffer,
+            inputBuffer.width,
+            inputBuffer.height,
+            channel,
+            average ?: average(inputBuffer, channel, restriction),
+            restriction
+        )
+    }
+
     @JvmOverloads
     fun moment(
         inputArray: ByteArray,
@@ -1485,659 +2876,2738 @@ internal object Toolkit {
     }
 
     @JvmOverloads
-    fun findBlobs(
+    fun moment(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateDirectBuffer("moment", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("moment", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(2)
+        nativeMomentBuffer(
+            nativeHandle, inputBuffer, outputArray, sizeX, sizeY, channel, restriction
+        )
+        return outputArray
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun moment(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateHardwareBuffer("moment", inputBuffer)
+        validateRestriction("moment", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = FloatArray(2)
+        nativeMomentBuffer(
+            nativeHandle, inputBuffer, outputArray, inputBuffer.width, inputBuffer.height,
+            channel, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Compute several statistics of an image in a single pass over the data.
+     *
+     * Replaces separate calls to minMax, average, standardDeviation, moment, and histogram.
+     * Unlike average and standardDeviation, the average and standard deviation are those of the
+     * pixels in the restriction.
+     *
+     * @param inputArray The buffer of the RGBA image.
+     * @param sizeX The width of the buffer, as a number of 4 byte cells.
+     * @param sizeY The height of the buffer, as a number of 4 byte cells.
+     * @param channel The channel to aggregate (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+     * The histogram always covers the four channels.
+     * @param statistics The statistics to compute.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The statistics. Those not requested are null.
+     */
+    @JvmOverloads
+    fun statistics(
         inputArray: ByteArray,
         sizeX: Int,
         sizeY: Int,
         channel: Byte,
-        threshold: Float,
-        maxBlobs: Int,
+        statistics: Set<Statistic>,
         restriction: Range2d? = null
-    ): List<Rect> {
+    ): ImageStatistics {
         require(inputArray.size >= sizeX * sizeY * 4) {
-            "$externalName findBlobs. inputArray is too small for the given dimensions. " +
+            "$externalName statistics. inputArray is too small for the given dimensions. " +
                     "$sizeX*$sizeY*4 < ${inputArray.size}."
         }
-        validateRestriction("findBlobs", sizeX, sizeY, restriction)
-
-        val outputArray = IntArray(maxBlobs * 4)
+        validateRestriction("statistics", sizeX, sizeY, restriction)
 
-        nativeFindBlobs(
+        val outputArray = DoubleArray(6)
+        val histogram = if (Statistic.Histogram in statistics) IntArray(256 * 4) else null
+        nativeStatistics(
             nativeHandle,
             inputArray,
             outputArray,
-            maxBlobs,
+            histogram,
             sizeX,
             sizeY,
-            threshold,
             channel,
+            statistics.fold(0) { mask, statistic -> mask or statistic.value },
             restriction
         )
-
-        val blobs = mutableListOf<Rect>()
-        for (i in 0 until maxBlobs) {
-            val left = outputArray[i * 4]
-            val top = outputArray[i * 4 + 1]
-            val right = outputArray[i * 4 + 2]
-            val bottom = outputArray[i * 4 + 3]
-            if (left == 0 && top == 0 && right == 0 && bottom == 0) {
-                break
-            }
-            blobs.add(Rect(left, top, right, bottom))
-        }
-
-        return blobs
+        return ImageStatistics.from(outputArray, histogram, statistics)
     }
 
     @JvmOverloads
-    fun findBlobs(
+    fun statistics(
         inputBitmap: Bitmap,
         channel: Byte,
-        threshold: Float,
-        maxBlobs: Int,
+        statistics: Set<Statistic>,
         restriction: Range2d? = null
-    ): List<Rect> {
-        validateBitmap("findBlobs", inputBitmap)
-        validateRestriction("findBlobs", inputBitmap, restriction)
+    ): ImageStatistics {
+        validateBitmap("statistics", inputBitmap)
+        validateRestriction("statistics", inputBitmap, restriction)
 
-        val outputArray = IntArray(maxBlobs * 4)
-
-        nativeFindBlobsBitmap(
+        val outputArray = DoubleArray(6)
+        val histogram = if (Statistic.Histogram in statistics) IntArray(256 * 4) else null
+        nativeStatisticsBitmap(
             nativeHandle,
             inputBitmap,
             outputArray,
-            maxBlobs,
-            threshold,
+            histogram,
             channel,
+            statistics.fold(0) { mask, statistic -> mask or statistic.value },
             restriction
         )
-
-        val blobs = mutableListOf<Rect>()
-        for (i in 0 until maxBlobs) {
-            val left = outputArray[i * 4]
-            val top = outputArray[i * 4 + 1]
-            val right = outputArray[i * 4 + 2]
-            val bottom = outputArray[i * 4 + 3]
-            if (left == 0 && top == 0 && right == 0 && bottom == 0) {
-                break
-            }
-            blobs.add(Rect(left, top, right, bottom))
-        }
-
-        return blobs
+        return ImageStatistics.from(outputArray, histogram, statistics)
     }
 
     @JvmOverloads
-    fun glcm(
-        inputArray: ByteArray,
+    fun statistics(
+        inputBuffer: ByteBuffer,
         sizeX: Int,
         sizeY: Int,
-        levels: Int,
         channel: Byte,
-        symmetric: Boolean,
-        normalize: Boolean,
-        excludeTransparent: Boolean,
-        steps: IntArray,
+        statistics: Set<Statistic>,
         restriction: Range2d? = null
-    ): FloatArray {
-        require(inputArray.size >= sizeX * sizeY * 4) {
-            "$externalName glcm. inputArray is too small for the given dimensions. " +
-                    "$sizeX*$sizeY*4 < ${inputArray.size}."
-        }
-        validateGlcmSteps(steps)
-        validateRestriction("glcm", sizeX, sizeY, restriction)
+    ): ImageStatistics {
+        validateDirectBuffer("statistics", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("statistics", sizeX, sizeY, restriction)
 
-        val outputArray = FloatArray(levels * levels)
-        nativeGlcm(
+        val outputArray = DoubleArray(6)
+        val histogram = if (Statistic.Histogram in statistics) IntArray(256 * 4) else null
+        nativeStatisticsBuffer(
             nativeHandle,
-            inputArray,
+            inputBuffer,
             outputArray,
+            histogram,
             sizeX,
             sizeY,
-            levels,
             channel,
-            symmetric,
-            normalize,
-            excludeTransparent,
-            steps,
-            (steps.size / 2).toByte(),
+            statistics.fold(0) { mask, statistic -> mask or statistic.value },
             restriction
         )
-        return outputArray
+        return ImageStatistics.from(outputArray, histogram, statistics)
     }
 
+    @RequiresApi(Build.VERSION_CODES.O)
     @JvmOverloads
-    fun glcm(
-        inputBitmap: Bitmap,
-        levels: Int,
+    fun statistics(
+        inputBuffer: HardwareBuffer,
         channel: Byte,
-        symmetric: Boolean,
-        normalize: Boolean,
-        excludeTransparent: Boolean,
-        steps: IntArray,
+        statistics: Set<Statistic>,
         restriction: Range2d? = null
-    ): FloatArray {
-        validateBitmap("glcm", inputBitmap)
-        validateGlcmSteps(steps)
-        validateRestriction("glcm", inputBitmap, restriction)
+    ): ImageStatistics {
+        validateHardwareBuffer("statistics", inputBuffer)
+        validateRestriction("statistics", inputBuffer.width, inputBuffer.height, restriction)
 
-        val outputArray = FloatArray(levels * levels)
-        nativeGlcmBitmap(
+        val outputArray = DoubleArray(6)
+        val histogram = if (Statistic.Histogram in statistics) IntArray(256 * 4) else null
+        nativeStatisticsBuffer(
             nativeHandle,
-            inputBitmap,
+            inputBuffer,
             outputArray,
-            levels,
+            histogram,
+            inputBuffer.width,
+            inputBuffer.height,
             channel,
-            symmetric,
-            normalize,
-            excludeTransparent,
-            steps,
-            (steps.size / 2).toByte(),
+            statistics.fold(0) { mask, statistic -> mask or statistic.value },
             restriction
         )
-        return outputArray
-    }
-
-    fun xbr2x(
-        inputBitmap: Bitmap
-    ): Bitmap {
-        validateBitmap("xbr2x", inputBitmap)
-
-        val outputBitmap = createBitmap(inputBitmap.width * 2, inputBitmap.height * 2)
-        nativeXbr2xBitmap(nativeHandle, inputBitmap, outputBitmap)
-        return outputBitmap
-    }
-
-    private var nativeHandle: Long = 0
-
-    init {
-        System.loadLibrary("renderscript-toolkit")
-        nativeHandle = createNative()
+        return ImageStatistics.from(outputArray, histogram, statistics)
     }
 
     /**
-     * Shutdown the thread pool.
-     *
-     * Waits for the threads to complete their work and destroys them.
+     * Find the blobs of an image, i.e. the groups of pixels at or above the threshold that touch
+     * horizontally or vertically.
      *
-     * An application should call this method only if it is sure that it won't call the
-     * toolkit again, as it is irreversible.
+     * @param inputArray The buffer of the image, 4 bytes per pixel.
+     * @param sizeX The width of the image.
+     * @param sizeY The height of the image.
+     * @param channel The channel to threshold (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+     * @param threshold The value at or above which a pixel is part of a blob.
+     * @param maxBlobs The maximum number of blobs to return.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels. The blobs
+     * are cut at its edges.
+     * @return The bounding boxes of the blobs, largest first.
      */
-    fun shutdown() {
-        destroyNative(nativeHandle)
-        nativeHandle = 0
-    }
-
-    private external fun createNative(): Long
-
-    private external fun destroyNative(nativeHandle: Long)
-
-    private external fun nativeBlend(
-        nativeHandle: Long,
-        mode: Int,
-        sourceArray: ByteArray,
-        destArray: ByteArray,
+    @JvmOverloads
+    fun findBlobs(
+        inputArray: ByteArray,
         sizeX: Int,
         sizeY: Int,
-        restriction: Range2d?
-    )
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Rect> {
+        val outputArray = findBlobs(
+            inputArray, sizeX, sizeY, channel, threshold, maxBlobs, null, restriction
+        )
+        return blobBounds(outputArray, maxBlobs)
+    }
 
-    private external fun nativeBlendBitmap(
-        nativeHandle: Long,
-        mode: Int,
-        sourceBitmap: Bitmap,
-        destBitmap: Bitmap,
-        restriction: Range2d?
-    )
+    @JvmOverloads
+    fun findBlobs(
+        inputBitmap: Bitmap,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Rect> {
+        val outputArray = findBlobs(inputBitmap, channel, threshold, maxBlobs, null, restriction)
+        return blobBounds(outputArray, maxBlobs)
+    }
 
-    private external fun nativeBlur(
-        nativeHandle: Long,
+    /**
+     * Like [findBlobs], but also returns the area, pixel count and centroid of each blob.
+     */
+    @JvmOverloads
+    fun findBlobsWithStatistics(
         inputArray: ByteArray,
-        vectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        radius: Int,
-        outputArray: ByteArray,
-        restriction: Range2d?
-    )
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Blob> {
+        val statisticsArray = DoubleArray(maxBlobs * 4)
+        val outputArray = findBlobs(
+            inputArray, sizeX, sizeY, channel, threshold, maxBlobs, statisticsArray, restriction
+        )
+        return Blob.from(blobBounds(outputArray, maxBlobs), statisticsArray)
+    }
 
-    private external fun nativeBlurBitmap(
-        nativeHandle: Long,
+    @JvmOverloads
+    fun findBlobsWithStatistics(
         inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        radius: Int,
-        restriction: Range2d?
-    )
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Blob> {
+        val statisticsArray = DoubleArray(maxBlobs * 4)
+        val outputArray = findBlobs(
+            inputBitmap, channel, threshold, maxBlobs, statisticsArray, restriction
+        )
+        return Blob.from(blobBounds(outputArray, maxBlobs), statisticsArray)
+    }
 
-    private external fun nativeColorMatrix(
-        nativeHandle: Long,
+    @JvmOverloads
+    fun findBlobs(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Rect> {
+        val outputArray = findBlobs(
+            inputBuffer, sizeX, sizeY, channel, threshold, maxBlobs, null, restriction
+        )
+        return blobBounds(outputArray, maxBlobs)
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun findBlobs(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Rect> {
+        val outputArray = findBlobs(inputBuffer, channel, threshold, maxBlobs, null, restriction)
+        return blobBounds(outputArray, maxBlobs)
+    }
+
+    @JvmOverloads
+    fun findBlobsWithStatistics(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Blob> {
+        val statisticsArray = DoubleArray(maxBlobs * 4)
+        val outputArray = findBlobs(
+            inputBuffer, sizeX, sizeY, channel, threshold, maxBlobs, statisticsArray, restriction
+        )
+        return Blob.from(blobBounds(outputArray, maxBlobs), statisticsArray)
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun findBlobsWithStatistics(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        restriction: Range2d? = null
+    ): List<Blob> {
+        val statisticsArray = DoubleArray(maxBlobs * 4)
+        val outputArray = findBlobs(
+            inputBuffer, channel, threshold, maxBlobs, statisticsArray, restriction
+        )
+        return Blob.from(blobBounds(outputArray, maxBlobs), statisticsArray)
+    }
+
+    private fun findBlobs(
         inputArray: ByteArray,
-        inputVectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        outputArray: ByteArray,
-        outputVectorSize: Int,
-        matrix: FloatArray,
-        addVector: FloatArray,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        statisticsArray: DoubleArray?,
         restriction: Range2d?
-    )
+    ): IntArray {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName findBlobs. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        validateRestriction("findBlobs", sizeX, sizeY, restriction)
 
-    private external fun nativeColorMatrixBitmap(
-        nativeHandle: Long,
+        val outputArray = IntArray(maxBlobs * 4)
+
+        nativeFindBlobs(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            statisticsArray,
+            maxBlobs,
+            sizeX,
+            sizeY,
+            threshold,
+            channel,
+            restriction
+        )
+
+        return outputArray
+    }
+
+    private fun findBlobs(
         inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        matrix: FloatArray,
-        addVector: FloatArray,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        statisticsArray: DoubleArray?,
         restriction: Range2d?
-    )
+    ): IntArray {
+        validateBitmap("findBlobs", inputBitmap)
+        validateRestriction("findBlobs", inputBitmap, restriction)
 
-    private external fun nativeConvolve(
-        nativeHandle: Long,
-        inputArray: ByteArray,
-        vectorSize: Int,
+        val outputArray = IntArray(maxBlobs * 4)
+
+        nativeFindBlobsBitmap(
+            nativeHandle,
+            inputBitmap,
+            outputArray,
+            statisticsArray,
+            maxBlobs,
+            threshold,
+            channel,
+            restriction
+        )
+
+        return outputArray
+    }
+
+    private fun findBlobs(
+        inputBuffer: ByteBuffer,
         sizeX: Int,
         sizeY: Int,
-        outputArray: ByteArray,
-        coefficients: FloatArray,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        statisticsArray: DoubleArray?,
         restriction: Range2d?
-    )
+    ): IntArray {
+        validateDirectBuffer("findBlobs", inputBuffer, sizeX * sizeY * 4)
+        validateRestriction("findBlobs", sizeX, sizeY, restriction)
+
+        val outputArray = IntArray(maxBlobs * 4)
+
+        nativeFindBlobsBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            statisticsArray,
+            maxBlobs,
+            sizeX,
+            sizeY,
+            threshold,
+            channel,
+            restriction
+        )
+
+        return outputArray
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    private fun findBlobs(
+        inputBuffer: HardwareBuffer,
+        channel: Byte,
+        threshold: Float,
+        maxBlobs: Int,
+        statisticsArray: DoubleArray?,
+        restriction: Range2d?
+    ): IntArray {
+        validateHardwareBuffer("findBlobs", inputBuffer)
+        validateRestriction("findBlobs", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = IntArray(maxBlobs * 4)
+
+        nativeFindBlobsBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            statisticsArray,
+            maxBlobs,
+            inputBuffer.width,
+            inputBuffer.height,
+            threshold,
+            channel,
+            restriction
+        )
+
+        return outputArray
+    }
+
+    private fun blobBounds(outputArray: IntArray, maxBlobs: Int): List<Rect> {
+        val blobs = mutableListOf<Rect>()
+        for (i in 0 until maxBlobs) {
+            val left = outputArray[i * 4]
+            val top = outputArray[i * 4 + 1]
+            val right = outputArray[i * 4 + 2]
+            val bottom = outputArray[i * 4 + 3]
+            if (left == 0 && top == 0 && right == 0 && bottom == 0) {
+                break
+            }
+            blobs.add(Rect(left, top, right, bottom))
+        }
+
+        return blobs
+    }
+
+    @JvmOverloads
+    fun glcm(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName glcm. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        validateGlcmSteps(steps)
+        validateRestriction("glcm", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(levels * levels)
+        nativeGlcm(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            sizeX,
+            sizeY,
+            levels,
+            channel,
+            symmetric,
+            normalize,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            restriction
+        )
+        return outputArray
+    }
+
+    @JvmOverloads
+    fun glcm(
+        inputBitmap: Bitmap,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateBitmap("glcm", inputBitmap)
+        validateGlcmSteps(steps)
+        validateRestriction("glcm", inputBitmap, restriction)
+
+        val outputArray = FloatArray(levels * levels)
+        nativeGlcmBitmap(
+            nativeHandle,
+            inputBitmap,
+            outputArray,
+            levels,
+            channel,
+            symmetric,
+            normalize,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            restriction
+        )
+        return outputArray
+    }
+
+    @JvmOverloads
+    fun glcm(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateDirectBuffer("glcm", inputBuffer, sizeX * sizeY * 4)
+        validateGlcmSteps(steps)
+        validateRestriction("glcm", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(levels * levels)
+        nativeGlcmBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            sizeX,
+            sizeY,
+            levels,
+            channel,
+            symmetric,
+            normalize,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            restriction
+        )
+        return outputArray
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun glcm(
+        inputBuffer: HardwareBuffer,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateHardwareBuffer("glcm", inputBuffer)
+        validateGlcmSteps(steps)
+        validateRestriction("glcm", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = FloatArray(levels * levels)
+        nativeGlcmBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            inputBuffer.width,
+            inputBuffer.height,
+            levels,
+            channel,
+            symmetric,
+            normalize,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Calculate the Haralick texture features of the GLCM of an image, without returning the
+     * GLCM. The pairs are counted like [glcm] does, and the features are computed natively from
+     * the normalized counts.
+     *
+     * @param inputArray The buffer of the RGBA image.
+     * @param sizeX The width of the buffer, as a number of 4 byte cells.
+     * @param sizeY The height of the buffer, as a number of 4 byte cells.
+     * @param levels The number of levels to use in the GLCM, from 1 to 256.
+     * @param channel The channel to use (0 = R, 1 = G, 2 = B, 3 = A, anything else = Gray).
+     * @param symmetric Whether to make the GLCM symmetric.
+     * @param excludeTransparent Whether to exclude transparent pixels.
+     * @param steps The (dx, dy) pairs of the steps.
+     * @param sparse Whether each thread counts the pairs in a small hash table rather than in
+     * levels * levels counters. Slower, but uses less memory at high level counts.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The features.
+     */
+    @JvmOverloads
+    fun glcmFeatures(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): GlcmFeatures {
+        return glcmFeatures(
+            inputArray,
+            sizeX,
+            sizeY,
+            intArrayOf(levels),
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            sparse,
+            restriction
+        )[0]
+    }
+
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBitmap: Bitmap,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): GlcmFeatures {
+        return glcmFeatures(
+            inputBitmap,
+            intArrayOf(levels),
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            sparse,
+            restriction
+        )[0]
+    }
+
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): GlcmFeatures {
+        return glcmFeatures(
+            inputBuffer,
+            sizeX,
+            sizeY,
+            intArrayOf(levels),
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            sparse,
+            restriction
+        )[0]
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBuffer: HardwareBuffer,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): GlcmFeatures {
+        return glcmFeatures(
+            inputBuffer,
+            intArrayOf(levels),
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            sparse,
+            restriction
+        )[0]
+    }
+
+    /**
+     * Same as [glcmFeatures], but for several level counts in one call. The image is read once,
+     * into a plane of quantized pixels per level count.
+     *
+     * @param levels The level counts, each from 1 to 256.
+     * @return The features of each level count, in the order of levels.
+     */
+    @JvmOverloads
+    fun glcmFeatures(
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: IntArray,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): List<GlcmFeatures> {
+        require(inputArray.size >= sizeX * sizeY * 4) {
+            "$externalName glcmFeatures. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*4 < ${inputArray.size}."
+        }
+        validateGlcmLevels(levels)
+        validateGlcmSteps(steps)
+        validateRestriction("glcmFeatures", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(levels.size * GlcmFeatures.COUNT)
+        nativeGlcmFeatures(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            sizeX,
+            sizeY,
+            levels,
+            levels.size,
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            sparse,
+            restriction
+        )
+        return GlcmFeatures.fromBatch(outputArray, levels.size)
+    }
+
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBitmap: Bitmap,
+        levels: IntArray,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): List<GlcmFeatures> {
+        validateBitmap("glcmFeatures", inputBitmap)
+        validateGlcmLevels(levels)
+        validateGlcmSteps(steps)
+        validateRestriction("glcmFeatures", inputBitmap, restriction)
+
+        val outputArray = FloatArray(levels.size * GlcmFeatures.COUNT)
+        nativeGlcmFeaturesBitmap(
+            nativeHandle,
+            inputBitmap,
+            outputArray,
+            levels,
+            levels.size,
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            sparse,
+            restriction
+        )
+        return GlcmFeatures.fromBatch(outputArray, levels.size)
+    }
+
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBuffer: ByteBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        levels: IntArray,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): List<GlcmFeatures> {
+        validateDirectBuffer("glcmFeatures", inputBuffer, sizeX * sizeY * 4)
+        validateGlcmLevels(levels)
+        validateGlcmSteps(steps)
+        validateRestriction("glcmFeatures", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(levels.size * GlcmFeatures.COUNT)
+        nativeGlcmFeaturesBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            sizeX,
+            sizeY,
+            levels,
+            levels.size,
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            sparse,
+            restriction
+        )
+        return GlcmFeatures.fromBatch(outputArray, levels.size)
+    }
+
+    @RequiresApi(Build.VERSION_CODES.O)
+    @JvmOverloads
+    fun glcmFeatures(
+        inputBuffer: HardwareBuffer,
+        levels: IntArray,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        sparse: Boolean = false,
+        restriction: Range2d? = null
+    ): List<GlcmFeatures> {
+        validateHardwareBuffer("glcmFeatures", inputBuffer)
+        validateGlcmLevels(levels)
+        validateGlcmSteps(steps)
+        validateRestriction("glcmFeatures", inputBuffer.width, inputBuffer.height, restriction)
+
+        val outputArray = FloatArray(levels.size * GlcmFeatures.COUNT)
+        nativeGlcmFeaturesBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputArray,
+            inputBuffer.width,
+            inputBuffer.height,
+            levels,
+            levels.size,
+            channel,
+            symmetric,
+            excludeTransparent,
+            steps,
+            (steps.size / 2).toByte(),
+            sparse,
+            restriction
+        )
+        return GlcmFeatures.fromBatch(outputArray, levels.size)
+    }
+
+    /**
+     * Upscale an image 2x using xBR. Only the colors of the input are used in the output.
+     *
+     * Same as xbr with a scale of 2.
+     *
+     * @param inputBitmap The ARGB_8888 image to upscale.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels of the
+     * input.
+     * @return The upscaled image.
+     */
+    @JvmOverloads
+    fun xbr2x(
+        inputBitmap: Bitmap,
+        restriction: Range2d? = null
+    ): Bitmap {
+        return xbr(inputBitmap, 2, restriction)
+    }
+
+    /**
+     * Upscale an image 2x, 3x or 4x using xBR. Only the colors of the input are used in the
+     * output.
+     *
+     * Upscaling 4x at once follows the edges more closely than upscaling 2x twice, and is faster.
+     *
+     * An optional range parameter can be set to restrict the operation to a rectangular subset
+     * of the input. Only the scale x scale output blocks of those pixels are computed; the rest
+     * of the output is transparent.
+     *
+     * @param inputBitmap The ARGB_8888 image to upscale.
+     * @param scale The factor to upscale by, 2, 3 or 4.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels of the
+     * input.
+     * @return The upscaled image.
+     */
+    @JvmOverloads
+    fun xbr(
+        inputBitmap: Bitmap,
+        scale: Int,
+        restriction: Range2d? = null
+    ): Bitmap {
+        validateBitmap("xbr", inputBitmap, alphaAllowed = false)
+        require(scale in 2..4) {
+            "$externalName xbr. The scale should be 2, 3 or 4. $scale provided."
+        }
+        validateRestriction("xbr", inputBitmap, restriction)
+
+        val outputBitmap = createBitmap(inputBitmap.width * scale, inputBitmap.height * scale)
+        nativeXbrBitmap(nativeHandle, inputBitmap, outputBitmap, scale, restriction)
+        return outputBitmap
+    }
+
+    private var nativeHandle: Long = 0
+
+    init {
+        System.loadLibrary("renderscript-toolkit")
+        nativeHandle = createNative()
+    }
+
+    /**
+     * Shutdown the thread pool.
+     *
+     * Waits for the threads to complete their work and destroys them.
+     *
+     * An application should call this method only if it is sure that it won't call the
+     * toolkit again, as it is irreversible.
+     */
+    fun shutdown() {
+        destroyNative(nativeHandle)
+        nativeHandle = 0
+    }
+
+    /**
+     * Sets the priority of the toolkit calls made from the calling thread.
+     *
+     * When calls from several threads are in flight, the pool threads help the calls of highest
+     * priority first. A call always progresses on its calling thread, so calls of low priority
+     * are slowed down but never stalled. The priority lasts until changed. The default is
+     * [ToolkitPriority.NORMAL].
+     *
+     * The priority is attached to the thread, not to a coroutine. Use a dedicated dispatcher
+     * for the calls that need a different priority.
+     *
+     * @param priority The priority of the subsequent calls of this thread.
+     */
+    fun setCallingThreadPriority(priority: ToolkitPriority) {
+        nativeSetCallingThreadPriority(priority.value)
+    }
+
+    /**
+     * Makes toolkit calls without blocking the calling thread.
+     *
+     * The block runs on a pool thread of the toolkit, which processes the calls it makes as the
+     * calling thread would, helped by the other pool threads. So the block should only make
+     * toolkit calls and light work around them, e.g.
+     *
+     *     val blurred = Toolkit.runAsync { blur(bitmap, 10) }
+     *
+     * The calls have the priority of the thread calling runAsync. The coroutine resumes once the
+     * block has completed, even if it's cancelled, so the buffers it uses remain valid.
+     *
+     * @param block The toolkit calls to make.
+     * @return The value returned by the block.
+     */
+    suspend fun <T> runAsync(block: Toolkit.() -> T): T = suspendCoroutine { continuation ->
+        runAsync(block) { result -> continuation.resumeWith(result) }
+    }
+
+    /**
+     * Makes toolkit calls without blocking the calling thread.
+     *
+     * Same as the suspending variant, but calls onComplete on the pool thread with the result of
+     * the block, or the exception it threw.
+     *
+     * @param block The toolkit calls to make.
+     * @param onComplete Called once the block has completed.
+     */
+    fun <T> runAsync(block: Toolkit.() -> T, onComplete: (Result<T>) -> Unit) {
+        nativeRunAsync(nativeHandle, Runnable { onComplete(runCatching { block() }) })
+    }
+
+    /**
+     * Measures, on the running CPU, how large the tiles of each [TilingGroup] should be, and uses
+     * the fastest size for the subsequent calls. Each group runs a typical op on a synthetic
+     * image once per candidate size, the candidates being derived from the sizes of the L1 and
+     * L2 data caches.
+     *
+     * It takes from a fraction of a second to a few seconds, which is best spent once, e.g. when
+     * the application is first run, keeping the result with [getTilingTarget] and restoring it
+     * with [setTilingTarget] afterwards. The measures are only meaningful when the toolkit is
+     * otherwise idle, so it should not be called from the main thread either.
+     */
+    fun calibrateTiling() {
+        nativeCalibrateTiling(nativeHandle)
+    }
+
+    /**
+     * The working set, in bytes, that the tiles of the group are sized for, i.e. the memory a
+     * tile reads and writes. See [calibrateTiling].
+     *
+     * @param group The group of ops.
+     */
+    fun getTilingTarget(group: TilingGroup): Int {
+        return nativeGetTilingTarget(nativeHandle, group.value)
+    }
+
+    /**
+     * Sets the working set, in bytes, that the tiles of the group are sized for. Values below
+     * 2000 are treated as 2000. See [calibrateTiling].
+     *
+     * @param group The group of ops.
+     * @param bytes The working set of a tile.
+     */
+    fun setTilingTarget(group: TilingGroup, bytes: Int) {
+        require(bytes > 0) { "The tiling target should be positive. $bytes provided." }
+        nativeSetTilingTarget(nativeHandle, group.value, bytes)
+    }
+
+    /**
+     * Frees the temporary memory the toolkit's threads keep from one call to the next, e.g.
+     * after processing a large image or from onTrimMemory. Each thread keeps at most 16 MB
+     * otherwise. The following calls allocate it again as they need.
+     */
+    fun trimScratch() {
+        nativeTrimScratch(nativeHandle)
+    }
+
+    private external fun createNative(): Long
+
+    private external fun nativeSetCallingThreadPriority(priority: Int)
+
+    private external fun nativeRunAsync(nativeHandle: Long, job: Runnable)
+
+    private external fun nativeCalibrateTiling(nativeHandle: Long)
+
+    private external fun nativeGetTilingTarget(nativeHandle: Long, group: Int): Int
+
+    private external fun nativeSetTilingTarget(nativeHandle: Long, group: Int, bytes: Int)
+
+    private external fun nativeTrimScratch(nativeHandle: Long)
+
+    private external fun destroyNative(nativeHandle: Long)
+
+    private external fun nativeBlend(
+        nativeHandle: Long,
+        mode: Int,
+        sourceArray: ByteArray,
+        destArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeBlendBitmap(
+        nativeHandle: Long,
+        mode: Int,
+        sourceBitmap: Bitmap,
+        destBitmap: Bitmap,
+        restriction: Range2d?
+    )
+
+    // The buffers of the native*Buffer functions are direct java.nio buffers or HardwareBuffers.
+    private external fun nativeBlendBuffer(
+        nativeHandle: Long,
+        mode: Int,
+        sourceBuffer: Any,
+        destBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeBlur(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        radius: Int,
+        outputArray: ByteArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeBlurBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        radius: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeBlurBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        radius: Int,
+        outputBuffer: Any,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorMatrix(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        inputVectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: ByteArray,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorMatrixBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        matrix: FloatArray,
+        addVector: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorMatrixBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        inputVectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputBuffer: Any,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeConvolve(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: ByteArray,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeConvolveBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeConvolveBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputBuffer: Any,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogram(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: IntArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogramBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: IntArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogramBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: IntArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogramDot(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: IntArray,
+        coefficients: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogramDotBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: IntArray,
+        coefficients: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeHistogramDotBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputArray: IntArray,
+        coefficients: FloatArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLut(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        red: ByteArray,
+        green: ByteArray,
+        blue: ByteArray,
+        alpha: ByteArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLutBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        red: ByteArray,
+        green: ByteArray,
+        blue: ByteArray,
+        alpha: ByteArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLutBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        red: ByteArray,
+        green: ByteArray,
+        blue: ByteArray,
+        alpha: ByteArray,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLut3d(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        cube: ByteArray,
+        cubeSizeX: Int,
+        cubeSizeY: Int,
+        cubeSizeZ: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLut3dBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        cube: ByteArray,
+        cubeSizeX: Int,
+        cubeSizeY: Int,
+        cubeSizeZ: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeLut3dBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        cube: ByteArray,
+        cubeSizeX: Int,
+        cubeSizeY: Int,
+        cubeSizeZ: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeResize(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputArray: ByteArray,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeResizeBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        restriction: Range2d?
+    )
+
+    private external fun nativeResizeBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputBuffer: Any,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeYuvToRgb(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        format: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeYuvToRgbBitmap(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        outputBitmap: Bitmap,
+        value: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeYuvToRgbBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        format: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeYuvPlanesToRgbBitmap(
+        nativeHandle: Long,
+        yPlane: ByteBuffer,
+        uPlane: ByteBuffer,
+        vPlane: ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputBitmap: Bitmap,
+        rotation: Int,
+        crop: Range2d?,
+        restriction: Range2d?
+    )
+
+    private external fun nativeThreshold(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeThresholdBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeThresholdBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativePipeline(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        stageTypes: IntArray,
+        stageFloats: FloatArray,
+        stageInts: IntArray,
+        stageBytes: ByteArray,
+        histogram: IntArray?
+    )
+
+    private external fun nativePipelineBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        stageTypes: IntArray,
+        stageFloats: FloatArray,
+        stageInts: IntArray,
+        stageBytes: ByteArray,
+        histogram: IntArray?
+    )
+
+    private external fun nativePipelineBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        stageTypes: IntArray,
+        stageFloats: FloatArray,
+        stageInts: IntArray,
+        stageBytes: ByteArray,
+        histogram: IntArray?
+    )
+
+    private external fun nativeWeightedAdd(
+        nativeHandle: Long,
+        inputArray1: ByteArray,
+        inputArray2: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        weight1: Float,
+        weight2: Float,
+        absolute: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeWeightedAddBitmap(
+        nativeHandle: Long,
+        inputBitmap1: Bitmap,
+        inputBitmap2: Bitmap,
+        outputBitmap: Bitmap,
+        weight1: Float,
+        weight2: Float,
+        absolute: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeWeightedAddBuffer(
+        nativeHandle: Long,
+        inputBuffer1: Any,
+        inputBuffer2: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        weight1: Float,
+        weight2: Float,
+        absolute: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeMinMax(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeMinMaxBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: FloatArray,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeMinMaxBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeAverage(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeAverageBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        channel: Byte,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeAverageBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeStandardDeviation(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        average: Double,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeStandardDeviationBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        channel: Byte,
+        average: Double,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeStandardDeviationBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        average: Double,
+        restriction: Range2d?
+    ): Double
+
+    private external fun nativeMoment(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeMomentBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: FloatArray,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeMomentBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeStatistics(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: DoubleArray,
+        histogram: IntArray?,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        requested: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeStatisticsBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: DoubleArray,
+        histogram: IntArray?,
+        channel: Byte,
+        requested: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeStatisticsBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: DoubleArray,
+        histogram: IntArray?,
+        sizeX: Int,
+        sizeY: Int,
+        channel: Byte,
+        requested: Int,
+        restriction: Range2d?
+    )
+
+    private external fun nativeFindBlobs(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: IntArray,
+        statisticsArray: DoubleArray?,
+        maxBlobs: Int,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeFindBlobsBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: IntArray,
+        statisticsArray: DoubleArray?,
+        maxBlobs: Int,
+        threshold: Float,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeFindBlobsBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: IntArray,
+        statisticsArray: DoubleArray?,
+        maxBlobs: Int,
+        sizeX: Int,
+        sizeY: Int,
+        threshold: Float,
+        channel: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcm(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcmBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: FloatArray,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcmBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        normalize: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcmFeatures(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: IntArray,
+        levelCount: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        sparse: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcmFeaturesBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputArray: FloatArray,
+        levels: IntArray,
+        levelCount: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        sparse: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeGlcmFeaturesBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        levels: IntArray,
+        levelCount: Int,
+        channel: Byte,
+        symmetric: Boolean,
+        excludeTransparent: Boolean,
+        steps: IntArray,
+        stepCount: Byte,
+        sparse: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorReplace(
+        nativeHandle: Long,
+        inputArray: ByteArray,
+        outputArray: ByteArray,
+        sizeX: Int,
+        sizeY: Int,
+        targetR: Byte,
+        targetG: Byte,
+        targetB: Byte,
+        targetA: Byte,
+        replacementR: Byte,
+        replacementG: Byte,
+        replacementB: Byte,
+        replacementA: Byte,
+        tolerance: Float,
+        interpolate: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorReplaceBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        targetR: Byte,
+        targetG: Byte,
+        targetB: Byte,
+        targetA: Byte,
+        replacementR: Byte,
+        replacementG: Byte,
+        replacementB: Byte,
+        replacementA: Byte,
+        tolerance: Float,
+        interpolate: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeColorReplaceBuffer(
+        nativeHandle: Long,
+        inputBuffer: Any,
+        outputBuffer: Any,
+        sizeX: Int,
+        sizeY: Int,
+        targetR: Byte,
+        targetG: Byte,
+        targetB: Byte,
+        targetA: Byte,
+        replacementR: Byte,
+        replacementG: Byte,
+        replacementB: Byte,
+        replacementA: Byte,
+        tolerance: Float,
+        interpolate: Boolean,
+        restriction: Range2d?
+    )
+
+    private external fun nativeXbrBitmap(
+        nativeHandle: Long,
+        inputBitmap: Bitmap,
+        outputBitmap: Bitmap,
+        scale: Int,
+        restriction: Range2d?
+    )
+
+    /**
+     * Blurs a float image, like the ByteArray variant, but on cells of 1 to 4 floats packed one
+     * after the other, like the data of a [FloatBitmap]. The values aren't clamped or rounded.
+     *
+     * @param inputArray The buffer of the image to be blurred.
+     * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of cells.
+     * @param sizeY The height of both buffers, as a number of cells.
+     * @param radius The radius of the pixels used to blur, a value from 1 to 1000.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The blurred values.
+     */
+    @JvmOverloads
+    fun blur(
+        inputArray: FloatArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        radius: Int = 5,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(vectorSize in 1..4) {
+            "$externalName blur. The vectorSize should be between 1 and 4. $vectorSize provided."
+        }
+        require(inputArray.size >= sizeX * sizeY * vectorSize) {
+            "$externalName blur. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*$vectorSize < ${inputArray.size}."
+        }
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
+        }
+        validateRestriction("blur", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(sizeX * sizeY * vectorSize)
+        nativeBlurFloat(
+            nativeHandle, inputArray, vectorSize, sizeX, sizeY, radius, outputArray, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Like the FloatArray variant, but reads a direct FloatBuffer in the native byte order in
+     * place, from its start. The result is a new direct FloatBuffer.
+     */
+    @JvmOverloads
+    fun blur(
+        inputBuffer: FloatBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        radius: Int = 5,
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName blur. The vectorSize should be between 1 and 4. $vectorSize provided."
+        }
+        validateDirectBuffer("blur", inputBuffer, sizeX * sizeY * vectorSize)
+        require(radius in 1..1000) {
+            "$externalName blur. The radius should be between 1 and 1000. $radius provided."
+        }
+        validateRestriction("blur", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * vectorSize * 4).asFloatBuffer()
+        nativeBlurFloatBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, radius, outputBuffer, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Transforms a float image using a color matrix, like the ByteArray variant, but on cells of
+     * 1 to 4 floats packed one after the other. The values are neither scaled nor clamped: the
+     * output is matrix * input + addVector.
+     *
+     * @param inputArray The buffer of the image to be converted.
+     * @param inputVectorSize The number of floats in each input cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of cells.
+     * @param sizeY The height of both buffers, as a number of cells.
+     * @param outputVectorSize The number of floats in each output cell, a value from 1 to 4.
+     * @param matrix The 4x4 matrix to multiply, in row major format.
+     * @param addVector A vector of four floats that's added to the result of the multiplication.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The converted values.
+     */
+    @JvmOverloads
+    fun colorMatrix(
+        inputArray: FloatArray,
+        inputVectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f),
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateFloatColorMatrix(inputVectorSize, outputVectorSize, matrix, addVector)
+        require(inputArray.size >= sizeX * sizeY * inputVectorSize) {
+            "$externalName colorMatrix. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*$inputVectorSize < ${inputArray.size}."
+        }
+        validateRestriction("colorMatrix", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(sizeX * sizeY * outputVectorSize)
+        nativeColorMatrixFloat(
+            nativeHandle, inputArray, inputVectorSize, sizeX, sizeY, outputArray, outputVectorSize,
+            matrix, addVector, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Like the FloatArray variant, but reads a direct FloatBuffer in the native byte order in
+     * place, from its start. The result is a new direct FloatBuffer.
+     */
+    @JvmOverloads
+    fun colorMatrix(
+        inputBuffer: FloatBuffer,
+        inputVectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f),
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        validateFloatColorMatrix(inputVectorSize, outputVectorSize, matrix, addVector)
+        validateDirectBuffer("colorMatrix", inputBuffer, sizeX * sizeY * inputVectorSize)
+        validateRestriction("colorMatrix", sizeX, sizeY, restriction)
+
+        val outputBuffer =
+            createDirectBuffer(sizeX * sizeY * outputVectorSize * 4).asFloatBuffer()
+        nativeColorMatrixFloatBuffer(
+            nativeHandle, inputBuffer, inputVectorSize, sizeX, sizeY, outputBuffer,
+            outputVectorSize, matrix, addVector, restriction
+        )
+        return outputBuffer
+    }
+
+    private fun validateFloatColorMatrix(
+        inputVectorSize: Int,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray
+    ) {
+        require(inputVectorSize in 1..4) {
+            "$externalName colorMatrix. The inputVectorSize should be between 1 and 4. " +
+                    "$inputVectorSize provided."
+        }
+        require(outputVectorSize in 1..4) {
+            "$externalName colorMatrix. The outputVectorSize should be between 1 and 4. " +
+                    "$outputVectorSize provided."
+        }
+        require(matrix.size == 16) {
+            "$externalName colorMatrix. matrix should have 16 entries. ${matrix.size} provided."
+        }
+        require(addVector.size == 4) {
+            "$externalName colorMatrix. addVector should have 4 entries. " +
+                    "${addVector.size} provided."
+        }
+    }
+
+    /**
+     * Convolves a float image with a kernel of any size, like the ByteArray variant, but on cells
+     * of 1 to 4 floats packed one after the other. Separable kernels are applied as two 1D passes
+     * whatever their sum, and the results aren't clamped or rounded.
+     *
+     * @param inputArray The buffer of the image to be convolved.
+     * @param vectorSize The number of floats in each cell, a value from 1 to 4.
+     * @param sizeX The width of both buffers, as a number of cells.
+     * @param sizeY The height of both buffers, as a number of cells.
+     * @param coefficients The kernelSizeX * kernelSizeY multipliers.
+     * @param kernelSizeX The width of the kernel.
+     * @param kernelSizeY The height of the kernel.
+     * @param borderMode How the cells past the edges are read. Default is [BorderMode.CLAMP].
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The convolved values.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputArray: FloatArray,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(vectorSize in 1..4) {
+            "$externalName convolve. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        require(inputArray.size >= sizeX * sizeY * vectorSize) {
+            "$externalName convolve. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*$vectorSize < ${inputArray.size}."
+        }
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
+        validateRestriction("convolve", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(sizeX * sizeY * vectorSize)
+        nativeConvolveFloat(
+            nativeHandle, inputArray, vectorSize, sizeX, sizeY, outputArray, coefficients,
+            kernelSizeX, kernelSizeY, borderMode.value, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Like the FloatArray variant, but reads a direct FloatBuffer in the native byte order in
+     * place, from its start. The result is a new direct FloatBuffer.
+     */
+    @JvmOverloads
+    fun convolve(
+        inputBuffer: FloatBuffer,
+        vectorSize: Int,
+        sizeX: Int,
+        sizeY: Int,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: BorderMode = BorderMode.CLAMP,
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName convolve. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        validateDirectBuffer("convolve", inputBuffer, sizeX * sizeY * vectorSize)
+        validateKernel("convolve", coefficients, kernelSizeX, kernelSizeY)
+        validateRestriction("convolve", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * vectorSize * 4).asFloatBuffer()
+        nativeConvolveFloatBuffer(
+            nativeHandle, inputBuffer, vectorSize, sizeX, sizeY, outputBuffer, coefficients,
+            kernelSizeX, kernelSizeY, borderMode.value, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Resizes a float image with bicubic interpolation, like the ByteArray variant, but on cells
+     * of 1 to 4 floats packed one after the other. The interpolated values aren't clamped, so they
+     * can overshoot near sharp edges. Unlike [interpolateFloatBitmap], NaN values aren't replaced.
+     *
+     * @param inputArray The buffer of the image to be resized.
+     * @param vectorSize The number of floats in each cell of both buffers, from 1 to 4.
+     * @param inputSizeX The width of the input buffer, as a number of cells.
+     * @param inputSizeY The height of the input buffer, as a number of cells.
+     * @param outputSizeX The width of the output buffer, as a number of cells.
+     * @param outputSizeY The height of the output buffer, as a number of cells.
+     * @param restriction When not null, restricts the operation to a 2D range of pixels.
+     * @return The resized values.
+     */
+    @JvmOverloads
+    fun resize(
+        inputArray: FloatArray,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(vectorSize in 1..4) {
+            "$externalName resize. The vectorSize should be between 1 and 4. $vectorSize provided."
+        }
+        require(inputArray.size >= inputSizeX * inputSizeY * vectorSize) {
+            "$externalName resize. inputArray is too small for the given dimensions. " +
+                    "$inputSizeX*$inputSizeY*$vectorSize < ${inputArray.size}."
+        }
+        validateRestriction("resize", outputSizeX, outputSizeY, restriction)
+
+        val outputArray = FloatArray(outputSizeX * outputSizeY * vectorSize)
+        nativeResizeFloat(
+            nativeHandle, inputArray, vectorSize, inputSizeX, inputSizeY, outputArray,
+            outputSizeX, outputSizeY, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Like the FloatArray variant, but reads a direct FloatBuffer in the native byte order in
+     * place, from its start. The result is a new direct FloatBuffer.
+     */
+    @JvmOverloads
+    fun resize(
+        inputBuffer: FloatBuffer,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputSizeX: Int,
+        outputSizeY: Int,
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName resize. The vectorSize should be between 1 and 4. $vectorSize provided."
+        }
+        validateDirectBuffer("resize", inputBuffer, inputSizeX * inputSizeY * vectorSize)
+        validateRestriction("resize", outputSizeX, outputSizeY, restriction)
+
+        val outputBuffer =
+            createDirectBuffer(outputSizeX * outputSizeY * vectorSize * 4).asFloatBuffer()
+        nativeResizeFloatBuffer(
+            nativeHandle, inputBuffer, vectorSize, inputSizeX, inputSizeY, outputBuffer,
+            outputSizeX, outputSizeY, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * Thresholds a float image, like the ByteArray variant, but on cells of 1 to 4 floats packed
+     * one after the other. Binary outputs are 0 or 1. Gray is the average of the first three
+     * channels, or of all of them when there are fewer, and the channels past the vector size
+     * also mean gray.
+     */
+    @JvmOverloads
+    fun threshold(
+        inputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(vectorSize in 1..4) {
+            "$externalName threshold. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        require(inputArray.size >= sizeX * sizeY * vectorSize) {
+            "$externalName threshold. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*$vectorSize < ${inputArray.size}."
+        }
+        validateRestriction("threshold", sizeX, sizeY, restriction)
+
+        val outputArray = FloatArray(sizeX * sizeY * vectorSize)
+        nativeThresholdFloat(
+            nativeHandle, inputArray, outputArray, sizeX, sizeY, vectorSize, threshold, binary,
+            channel, restriction
+        )
+        return outputArray
+    }
+
+    @JvmOverloads
+    fun threshold(
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        threshold: Float,
+        binary: Boolean,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        require(vectorSize in 1..4) {
+            "$externalName threshold. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        validateDirectBuffer("threshold", inputBuffer, sizeX * sizeY * vectorSize)
+        validateRestriction("threshold", sizeX, sizeY, restriction)
+
+        val outputBuffer = createDirectBuffer(sizeX * sizeY * vectorSize * 4).asFloatBuffer()
+        nativeThresholdFloatBuffer(
+            nativeHandle, inputBuffer, outputBuffer, sizeX, sizeY, vectorSize, threshold, binary,
+            channel, restriction
+        )
+        return outputBuffer
+    }
+
+    /**
+     * The minimum and maximum value of a float image of cells of 1 to 4 floats packed one after
+     * the other. NaN values are skipped, and both are NaN when every value is. Gray is the average
+     * of the first three channels, or of all of them when there are fewer, and the channels past
+     * the vector size also mean gray.
+     */
+    @JvmOverloads
+    fun minMax(
+        inputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateFloatReduction("minMax", inputArray.size, sizeX, sizeY, vectorSize, restriction)
+
+        val outputArray = FloatArray(2)
+        nativeMinMaxFloat(
+            nativeHandle, inputArray, outputArray, sizeX, sizeY, vectorSize, channel, restriction
+        )
+        return outputArray
+    }
+
+    @JvmOverloads
+    fun minMax(
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): FloatArray {
+        validateDirectBuffer("minMax", inputBuffer, sizeX * sizeY * vectorSize)
+        validateFloatReduction("minMax", null, sizeX, sizeY, vectorSize, restriction)
+
+        val outputArray = FloatArray(2)
+        nativeMinMaxFloatBuffer(
+            nativeHandle, inputBuffer, outputArray, sizeX, sizeY, vectorSize, channel, restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * The average value of a float image, with the cells and the channels of the float minMax.
+     * NaN values are skipped, and the average is NaN when every value is.
+     */
+    @JvmOverloads
+    fun average(
+        inputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): Double {
+        validateFloatReduction("average", inputArray.size, sizeX, sizeY, vectorSize, restriction)
+
+        return nativeAverageFloat(
+            nativeHandle, inputArray, sizeX, sizeY, vectorSize, channel, restriction
+        )
+    }
+
+    @JvmOverloads
+    fun average(
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        restriction: Range2d? = null
+    ): Double {
+        validateDirectBuffer("average", inputBuffer, sizeX * sizeY * vectorSize)
+        validateFloatReduction("average", null, sizeX, sizeY, vectorSize, restriction)
+
+        return nativeAverageFloatBuffer(
+            nativeHandle, inputBuffer, sizeX, sizeY, vectorSize, channel, restriction
+        )
+    }
+
+    /**
+     * The standard deviation of a float image, with the cells and the channels of the float
+     * minMax. NaN values are skipped. The average is computed when not provided.
+     */
+    @JvmOverloads
+    fun standardDeviation(
+        inputArray: FloatArray,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        average: Double? = null,
+        restriction: Range2d? = null
+    ): Double {
+        validateFloatReduction(
+            "standardDeviation", inputArray.size, sizeX, sizeY, vectorSize, restriction
+        )
+
+        return nativeStandardDeviationFloat(
+            nativeHandle,
+            inputArray,
+            sizeX,
+            sizeY,
+            vectorSize,
+            channel,
+            average ?: average(inputArray, sizeX, sizeY, vectorSize, channel, restriction),
+            restriction
+        )
+    }
+
+    @JvmOverloads
+    fun standardDeviation(
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        average: Double? = null,
+        restriction: Range2d? = null
+    ): Double {
+        validateDirectBuffer("standardDeviation", inputBuffer, sizeX * sizeY * vectorSize)
+        validateFloatReduction("standardDeviation", null, sizeX, sizeY, vectorSize, restriction)
+
+        return nativeStandardDeviationFloatBuffer(
+            nativeHandle,
+            inputBuffer,
+            sizeX,
+            sizeY,
+            vectorSize,
+            channel,
+            average ?: average(inputBuffer, sizeX, sizeY, vectorSize, channel, restriction),
+            restriction
+        )
+    }
+
+    /**
+     * Checks the arguments of the float reductions. inputSize is null for buffers, whose size is
+     * checked by validateDirectBuffer.
+     */
+    private fun validateFloatReduction(
+        function: String,
+        inputSize: Int?,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        restriction: Range2d?
+    ) {
+        require(vectorSize in 1..4) {
+            "$externalName $function. The vectorSize should be between 1 and 4. " +
+                    "$vectorSize provided."
+        }
+        require(inputSize == null || inputSize >= sizeX * sizeY * vectorSize) {
+            "$externalName $function. inputArray is too small for the given dimensions. " +
+                    "$sizeX*$sizeY*$vectorSize < $inputSize."
+        }
+        validateRestriction(function, sizeX, sizeY, restriction)
+    }
+
+    fun interpolateFloatBitmap(
+        inputArray: FloatArray,
+        inputWidth: Int,
+        inputHeight: Int,
+        channels: Int,
+        outputWidth: Int,
+        outputHeight: Int,
+        srcStartX: Float = 0f,
+        srcStartY: Float = 0f,
+        srcEndX: Float = (inputWidth - 1).toFloat(),
+        srcEndY: Float = (inputHeight - 1).toFloat(),
+        maxSearchRadius: Int = 10,
+        validDistances: IntArray? = null,
+        restriction: Range2d? = null
+    ): FloatArray {
+        require(inputArray.size >= inputWidth * inputHeight * channels) {
+            "$externalName interpolateFloatBitmap. inputArray is too small for the given dimensions."
+        }
+        require(channels in 1..4) {
+            "$externalName interpolateFloatBitmap. channels should be between 1 and 4. $channels provided."
+        }
+        require(outputWidth > 0 && outputHeight > 0) {
+            "$externalName interpolateFloatBitmap. Output dimensions must be positive."
+        }
+        require(validDistances == null || validDistances.size >= inputWidth * inputHeight) {
+            "$externalName interpolateFloatBitmap. validDistances is too small for the given " +
+                    "dimensions."
+        }
+        validateRestriction("interpolateFloatBitmap", outputWidth, outputHeight, restriction)
+
+        val outputArray = FloatArray(outputWidth * outputHeight * channels)
+        nativeInterpolateFloatBitmap(
+            nativeHandle,
+            inputArray,
+            outputArray,
+            inputWidth,
+            inputHeight,
+            channels,
+            outputWidth,
+            outputHeight,
+            srcStartX,
+            srcStartY,
+            srcEndX,
+            srcEndY,
+            maxSearchRadius,
+            validDistances,
+            restriction
+        )
+        return outputArray
+    }
+
+    /**
+     * Like the FloatArray variant, but reads a direct FloatBuffer in the native byte order in
+     * place, from its start. The result is a new direct FloatBuffer.
+     *
+     * When restriction is not null, only that range of the output is computed. The rest is 0.
+     */
+    fun interpolateFloatBitmap(
+        inputBuffer: FloatBuffer,
+        inputWidth: Int,
+        inputHeight: Int,
+        channels: Int,
+        outputWidth: Int,
+        outputHeight: Int,
+        srcStartX: Float = 0f,
+        srcStartY: Float = 0f,
+        srcEndX: Float = (inputWidth - 1).toFloat(),
+        srcEndY: Float = (inputHeight - 1).toFloat(),
+        maxSearchRadius: Int = 10,
+        validDistances: IntArray? = null,
+        restriction: Range2d? = null
+    ): FloatBuffer {
+        validateDirectBuffer(
+            "interpolateFloatBitmap", inputBuffer, inputWidth * inputHeight * channels
+        )
+        require(channels in 1..4) {
+            "$externalName interpolateFloatBitmap. channels should be between 1 and 4. $channels provided."
+        }
+        require(outputWidth > 0 && outputHeight > 0) {
+            "$externalName interpolateFloatBitmap. Output dimensions must be positive."
+        }
+        require(validDistances == null || validDistances.size >= inputWidth * inputHeight) {
+            "$externalName interpolateFloatBitmap. validDistances is too small for the given " +
+                    "dimensions."
+        }
+        validateRestriction("interpolateFloatBitmap", outputWidth, outputHeight, restriction)
+
+        val outputBuffer =
+            createDirectBuffer(outputWidth * outputHeight * channels * 4).asFloatBuffer()
+        nativeInterpolateFloatBuffer(
+            nativeHandle,
+            inputBuffer,
+            outputBuffer,
+            inputWidth,
+            inputHeight,
+            channels,
+            outputWidth,
+            outputHeight,
+            srcStartX,
+            srcStartY,
+            srcEndX,
+            srcEndY,
+            maxSearchRadius,
+            validDistances,
+            restriction
+        )
+        return outputBuffer
+    }
 
-    private external fun nativeConvolveBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        coefficients: FloatArray,
-        restriction: Range2d?
-    )
+    /**
+     * The distance of each pixel of a float image to the nearest valid one, i.e. with no NaN
+     * channel. It's the larger of the distances along the rows and along the columns. Valid
+     * pixels are at 0, and all of them are at Int.MAX_VALUE when none is valid.
+     *
+     * Pass it as the validDistances of interpolateFloatBitmap to reuse it for several outputs of
+     * the same input. Otherwise each call computes its own when the nearest neighbor fallback
+     * needs it.
+     *
+     * @param inputArray The float image, width * height * channels values.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     * @param channels The number of channels per pixel, 1 to 4.
+     * @return The width * height distances.
+     */
+    fun nearestValidDistances(
+        inputArray: FloatArray,
+        width: Int,
+        height: Int,
+        channels: Int
+    ): IntArray {
+        require(inputArray.size >= width * height * channels) {
+            "$externalName nearestValidDistances. inputArray is too small for the given " +
+                    "dimensions."
+        }
+        require(channels in 1..4) {
+            "$externalName nearestValidDistances. channels should be between 1 and 4. " +
+                    "$channels provided."
+        }
 
-    private external fun nativeHistogram(
-        nativeHandle: Long,
-        inputArray: ByteArray,
-        vectorSize: Int,
-        sizeX: Int,
-        sizeY: Int,
-        outputArray: IntArray,
-        restriction: Range2d?
-    )
+        val outputArray = IntArray(width * height)
+        nativeNearestValidDistances(nativeHandle, inputArray, outputArray, width, height, channels)
+        return outputArray
+    }
 
-    private external fun nativeHistogramBitmap(
+    private external fun nativeInterpolateFloatBitmap(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputArray: IntArray,
+        inputArray: FloatArray,
+        outputArray: FloatArray,
+        inputWidth: Int,
+        inputHeight: Int,
+        channels: Int,
+        outputWidth: Int,
+        outputHeight: Int,
+        srcStartX: Float,
+        srcStartY: Float,
+        srcEndX: Float,
+        srcEndY: Float,
+        maxSearchRadius: Int,
+        validDistances: IntArray?,
         restriction: Range2d?
     )
 
-    private external fun nativeHistogramDot(
+    private external fun nativeInterpolateFloatBuffer(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        vectorSize: Int,
-        sizeX: Int,
-        sizeY: Int,
-        outputArray: IntArray,
-        coefficients: FloatArray,
+        inputBuffer: FloatBuffer,
+        outputBuffer: FloatBuffer,
+        inputWidth: Int,
+        inputHeight: Int,
+        channels: Int,
+        outputWidth: Int,
+        outputHeight: Int,
+        srcStartX: Float,
+        srcStartY: Float,
+        srcEndX: Float,
+        srcEndY: Float,
+        maxSearchRadius: Int,
+        validDistances: IntArray?,
         restriction: Range2d?
     )
 
-    private external fun nativeHistogramDotBitmap(
+    private external fun nativeNearestValidDistances(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
+        inputArray: FloatArray,
         outputArray: IntArray,
-        coefficients: FloatArray,
-        restriction: Range2d?
-    )
-
-    private external fun nativeLut(
-        nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: ByteArray,
-        sizeX: Int,
-        sizeY: Int,
-        red: ByteArray,
-        green: ByteArray,
-        blue: ByteArray,
-        alpha: ByteArray,
-        restriction: Range2d?
-    )
-
-    private external fun nativeLutBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        red: ByteArray,
-        green: ByteArray,
-        blue: ByteArray,
-        alpha: ByteArray,
-        restriction: Range2d?
+        width: Int,
+        height: Int,
+        channels: Int
     )
 
-    private external fun nativeLut3d(
+    private external fun nativeBlurFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: ByteArray,
+        inputArray: FloatArray,
+        vectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        cube: ByteArray,
-        cubeSizeX: Int,
-        cubeSizeY: Int,
-        cubeSizeZ: Int,
-        restriction: Range2d?
-    )
-
-    private external fun nativeLut3dBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        cube: ByteArray,
-        cubeSizeX: Int,
-        cubeSizeY: Int,
-        cubeSizeZ: Int,
+        radius: Int,
+        outputArray: FloatArray,
         restriction: Range2d?
     )
 
-    private external fun nativeResize(
+    private external fun nativeBlurFloatBuffer(
         nativeHandle: Long,
-        inputArray: ByteArray,
+        inputBuffer: FloatBuffer,
         vectorSize: Int,
-        inputSizeX: Int,
-        inputSizeY: Int,
-        outputArray: ByteArray,
-        outputSizeX: Int,
-        outputSizeY: Int,
-        restriction: Range2d?
-    )
-
-    private external fun nativeResizeBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        restriction: Range2d?
-    )
-
-    private external fun nativeYuvToRgb(
-        nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: ByteArray,
-        sizeX: Int,
-        sizeY: Int,
-        format: Int
-    )
-
-    private external fun nativeYuvToRgbBitmap(
-        nativeHandle: Long,
-        inputArray: ByteArray,
         sizeX: Int,
         sizeY: Int,
-        outputBitmap: Bitmap,
-        value: Int
+        radius: Int,
+        outputBuffer: FloatBuffer,
+        restriction: Range2d?
     )
 
-    private external fun nativeThreshold(
+    private external fun nativeColorMatrixFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: ByteArray,
+        inputArray: FloatArray,
+        inputVectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        threshold: Float,
-        binary: Boolean,
-        channel: Byte,
-        restriction: Range2d?
-    )
-
-    private external fun nativeThresholdBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        threshold: Float,
-        binary: Boolean,
-        channel: Byte,
+        outputArray: FloatArray,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray,
         restriction: Range2d?
     )
 
-    private external fun nativeWeightedAdd(
+    private external fun nativeColorMatrixFloatBuffer(
         nativeHandle: Long,
-        inputArray1: ByteArray,
-        inputArray2: ByteArray,
-        outputArray: ByteArray,
+        inputBuffer: FloatBuffer,
+        inputVectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        weight1: Float,
-        weight2: Float,
-        absolute: Boolean,
-        restriction: Range2d?
-    )
-
-    private external fun nativeWeightedAddBitmap(
-        nativeHandle: Long,
-        inputBitmap1: Bitmap,
-        inputBitmap2: Bitmap,
-        outputBitmap: Bitmap,
-        weight1: Float,
-        weight2: Float,
-        absolute: Boolean,
+        outputBuffer: FloatBuffer,
+        outputVectorSize: Int,
+        matrix: FloatArray,
+        addVector: FloatArray,
         restriction: Range2d?
     )
 
-    private external fun nativeMinMax(
+    private external fun nativeConvolveFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: FloatArray,
+        inputArray: FloatArray,
+        vectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        channel: Byte,
-        restriction: Range2d?
-    )
-
-    private external fun nativeMinMaxBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
         outputArray: FloatArray,
-        channel: Byte,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: Int,
         restriction: Range2d?
     )
 
-    private external fun nativeAverage(
-        nativeHandle: Long,
-        inputArray: ByteArray,
-        sizeX: Int,
-        sizeY: Int,
-        channel: Byte,
-        restriction: Range2d?
-    ): Double
-
-    private external fun nativeAverageBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        channel: Byte,
-        restriction: Range2d?
-    ): Double
-
-    private external fun nativeStandardDeviation(
+    private external fun nativeConvolveFloatBuffer(
         nativeHandle: Long,
-        inputArray: ByteArray,
+        inputBuffer: FloatBuffer,
+        vectorSize: Int,
         sizeX: Int,
         sizeY: Int,
-        channel: Byte,
-        average: Double,
-        restriction: Range2d?
-    ): Double
-
-    private external fun nativeStandardDeviationBitmap(
-        nativeHandle: Long,
-        inputBitmap: Bitmap,
-        channel: Byte,
-        average: Double,
+        outputBuffer: FloatBuffer,
+        coefficients: FloatArray,
+        kernelSizeX: Int,
+        kernelSizeY: Int,
+        borderMode: Int,
         restriction: Range2d?
-    ): Double
+    )
 
-    private external fun nativeMoment(
+    private external fun nativeResizeFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
+        inputArray: FloatArray,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
         outputArray: FloatArray,
-        sizeX: Int,
-        sizeY: Int,
-        channel: Byte,
+        outputSizeX: Int,
+        outputSizeY: Int,
         restriction: Range2d?
     )
 
-    private external fun nativeMomentBitmap(
+    private external fun nativeResizeFloatBuffer(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputArray: FloatArray,
-        channel: Byte,
+        inputBuffer: FloatBuffer,
+        vectorSize: Int,
+        inputSizeX: Int,
+        inputSizeY: Int,
+        outputBuffer: FloatBuffer,
+        outputSizeX: Int,
+        outputSizeY: Int,
         restriction: Range2d?
     )
 
-    private external fun nativeFindBlobs(
+    private external fun nativeThresholdFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: IntArray,
-        maxBlobs: Int,
+        inputArray: FloatArray,
+        outputArray: FloatArray,
         sizeX: Int,
         sizeY: Int,
+        vectorSize: Int,
         threshold: Float,
+        binary: Boolean,
         channel: Byte,
         restriction: Range2d?
     )
 
-    private external fun nativeFindBlobsBitmap(
+    private external fun nativeThresholdFloatBuffer(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputArray: IntArray,
-        maxBlobs: Int,
+        inputBuffer: FloatBuffer,
+        outputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
         threshold: Float,
+        binary: Boolean,
         channel: Byte,
         restriction: Range2d?
     )
 
-    private external fun nativeGlcm(
+    private external fun nativeMinMaxFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
+        inputArray: FloatArray,
         outputArray: FloatArray,
         sizeX: Int,
         sizeY: Int,
-        levels: Int,
+        vectorSize: Int,
         channel: Byte,
-        symmetric: Boolean,
-        normalize: Boolean,
-        excludeTransparent: Boolean,
-        steps: IntArray,
-        stepCount: Byte,
         restriction: Range2d?
     )
 
-    private external fun nativeGlcmBitmap(
+    private external fun nativeMinMaxFloatBuffer(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
+        inputBuffer: FloatBuffer,
         outputArray: FloatArray,
-        levels: Int,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
         channel: Byte,
-        symmetric: Boolean,
-        normalize: Boolean,
-        excludeTransparent: Boolean,
-        steps: IntArray,
-        stepCount: Byte,
         restriction: Range2d?
     )
 
-    private external fun nativeColorReplace(
+    private external fun nativeAverageFloat(
         nativeHandle: Long,
-        inputArray: ByteArray,
-        outputArray: ByteArray,
+        inputArray: FloatArray,
         sizeX: Int,
         sizeY: Int,
-        targetR: Byte,
-        targetG: Byte,
-        targetB: Byte,
-        targetA: Byte,
-        replacementR: Byte,
-        replacementG: Byte,
-        replacementB: Byte,
-        replacementA: Byte,
-        tolerance: Float,
-        interpolate: Boolean,
+        vectorSize: Int,
+        channel: Byte,
         restriction: Range2d?
-    )
+    ): Double
 
-    private external fun nativeColorReplaceBitmap(
+    private external fun nativeAverageFloatBuffer(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap,
-        targetR: Byte,
-        targetG: Byte,
-        targetB: Byte,
-        targetA: Byte,
-        replacementR: Byte,
-        replacementG: Byte,
-        replacementB: Byte,
-        replacementA: Byte,
-        tolerance: Float,
-        interpolate: Boolean,
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
         restriction: Range2d?
-    )
+    ): Double
 
-    private external fun nativeXbr2xBitmap(
+    private external fun nativeStandardDeviationFloat(
         nativeHandle: Long,
-        inputBitmap: Bitmap,
-        outputBitmap: Bitmap
-    )
-
-    fun interpolateFloatBitmap(
         inputArray: FloatArray,
-        inputWidth: Int,
-        inputHeight: Int,
-        channels: Int,
-        outputWidth: Int,
-        outputHeight: Int,
-        srcStartX: Float = 0f,
-        srcStartY: Float = 0f,
-        srcEndX: Float = (inputWidth - 1).toFloat(),
-        srcEndY: Float = (inputHeight - 1).toFloat(),
-        maxSearchRadius: Int = 10
-    ): FloatArray {
-        require(inputArray.size >= inputWidth * inputHeight * channels) {
-            "$externalName interpolateFloatBitmap. inputArray is too small for the given dimensions."
-        }
-        require(channels in 1..4) {
-            "$externalName interpolateFloatBitmap. channels should be between 1 and 4. $channels provided."
-        }
-        require(outputWidth > 0 && outputHeight > 0) {
-            "$externalName interpolateFloatBitmap. Output dimensions must be positive."
-        }
-
-        val outputArray = FloatArray(outputWidth * outputHeight * channels)
-        nativeInterpolateFloatBitmap(
-            nativeHandle,
-            inputArray,
-            outputArray,
-            inputWidth,
-            inputHeight,
-            channels,
-            outputWidth,
-            outputHeight,
-            srcStartX,
-            srcStartY,
-            srcEndX,
-            srcEndY,
-            maxSearchRadius
-        )
-        return outputArray
-    }
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        average: Double,
+        restriction: Range2d?
+    ): Double
 
-    private external fun nativeInterpolateFloatBitmap(
+    private external fun nativeStandardDeviationFloatBuffer(
         nativeHandle: Long,
-        inputArray: FloatArray,
-        outputArray: FloatArray,
-        inputWidth: Int,
-        inputHeight: Int,
-        channels: Int,
-        outputWidth: Int,
-        outputHeight: Int,
-        srcStartX: Float,
-        srcStartY: Float,
-        srcEndX: Float,
-        srcEndY: Float,
-        maxSearchRadius: Int
-    )
+        inputBuffer: FloatBuffer,
+        sizeX: Int,
+        sizeY: Int,
+        vectorSize: Int,
+        channel: Byte,
+        average: Double,
+        restriction: Range2d?
+    ): Double
 }
 
 
@@ -2247,6 +5717,135 @@ class LookupTable {
     var alpha = ByteArray(256) { it.toByte() }
 }
 
+/**
+ * One step of a [Toolkit.pipeline]. Each stage does what the Toolkit method of the same name does.
+ */
+sealed class PipelineStage {
+    /**
+     * See [Toolkit.colorMatrix].
+     *
+     * @property matrix The 4x4 matrix to multiply, in row major format.
+     * @property addVector A vector of four floats that's added to the result of the multiplication.
+     */
+    class ColorMatrix(
+        val matrix: FloatArray,
+        val addVector: FloatArray = floatArrayOf(0f, 0f, 0f, 0f)
+    ) : PipelineStage() {
+        init {
+            require(matrix.size == 16) {
+                "$externalName pipeline. matrix should have 16 entries. ${matrix.size} provided."
+            }
+            require(addVector.size == 4) {
+                "$externalName pipeline. addVector should have 4 entries. " +
+                        "${addVector.size} provided."
+            }
+        }
+    }
+
+    /**
+     * See [Toolkit.convolve].
+     *
+     * @property coefficients A FloatArray of size 9 or 25, containing the multipliers.
+     */
+    class Convolve(val coefficients: FloatArray) : PipelineStage() {
+        init {
+            require(coefficients.size == 9 || coefficients.size == 25) {
+                "$externalName pipeline. Only 3x3 or 5x5 convolutions are supported. " +
+                        "${coefficients.size} coefficients provided."
+            }
+        }
+    }
+
+    /**
+     * See [Toolkit.lut].
+     */
+    class Lut(val table: LookupTable) : PipelineStage()
+
+    /**
+     * See [Toolkit.threshold].
+     */
+    class Threshold(val threshold: Float, val binary: Boolean, val channel: Byte) : PipelineStage()
+}
+
+/**
+ * The stages of a pipeline, packed in the arrays nativePipeline expects. The types match
+ * RenderScriptToolkit::PipelineStage::Type.
+ */
+private class PackedPipelineStages(stages: List<PipelineStage>) {
+    val types = IntArray(stages.size)
+    val floats: FloatArray
+    val ints: IntArray
+    val bytes: ByteArray
+
+    init {
+        val floatList = mutableListOf<Float>()
+        val intList = mutableListOf<Int>()
+        val byteList = mutableListOf<Byte>()
+        stages.forEachIndexed { index, stage ->
+            when (stage) {
+                is PipelineStage.ColorMatrix -> {
+                    types[index] = 0
+                    floatList.addAll(stage.matrix.toList())
+                    floatList.addAll(stage.addVector.toList())
+                }
+
+                is PipelineStage.Convolve -> {
+                    types[index] = if (stage.coefficients.size == 9) 1 else 2
+                    floatList.addAll(stage.coefficients.toList())
+                }
+
+                is PipelineStage.Lut -> {
+                    types[index] = 3
+                    require(stage.table.red.size == 256 && stage.table.green.size == 256 &&
+                            stage.table.blue.size == 256 && stage.table.alpha.size == 256) {
+                        "$externalName pipeline. The lookup tables should have 256 entries."
+                    }
+                    byteList.addAll(stage.table.red.toList())
+                    byteList.addAll(stage.table.green.toList())
+                    byteList.addAll(stage.table.blue.toList())
+                    byteList.addAll(stage.table.alpha.toList())
+                }
+
+                is PipelineStage.Threshold -> {
+                    types[index] = 4
+                    floatList.add(stage.threshold)
+                    intList.add(if (stage.binary) 1 else 0)
+                    intList.add(stage.channel.toInt() and 0xff)
+                }
+            }
+        }
+        floats = floatList.toFloatArray()
+        ints = intList.toIntArray()
+        bytes = byteList.toByteArray()
+    }
+}
+
+/**
+ * How [Toolkit.convolve] reads the cells past the edges of the image. The values match
+ * RenderScriptToolkit::BorderMode.
+ */
+enum class BorderMode(val value: Int) {
+    /**
+     * The edge cell is repeated: aaa|abcd|ddd. This is what the 3x3 and 5x5 variants do.
+     */
+    CLAMP(0),
+
+    /**
+     * The image is reflected, without repeating the edge cell: dcb|abcd|cba.
+     */
+    MIRROR(1),
+
+    /**
+     * The image is tiled: bcd|abcd|abc.
+     */
+    WRAP(2),
+
+    /**
+     * Zeros are read: 000|abcd|000.
+     */
+    ZERO(3),
+}
+
 /**
  * The YUV formats supported by yuvToRgb.
  */
@@ -2255,6 +5854,159 @@ enum class YuvFormat(val value: Int) {
     YV12(0x32315659),
 }
 
+/**
+ * The priority of the toolkit calls made from a thread. See [Toolkit.setCallingThreadPriority].
+ */
+enum class ToolkitPriority(val value: Int) {
+    BACKGROUND(-1),
+    NORMAL(0),
+    URGENT(1),
+}
+
+/**
+ * The groups of ops whose work is tiled alike. See [Toolkit.calibrateTiling]. The values match
+ * RenderScriptToolkit::TilingGroup.
+ */
+enum class TilingGroup(val value: Int) {
+    /** The ops not in another group, e.g. blend or histogram. */
+    OTHER(0),
+    /** lut and lut3d. */
+    LUT(1),
+    /** colorMatrix. */
+    COLOR_MATRIX(2),
+    /** blur. */
+    BLUR(3),
+    /** convolve. */
+    CONVOLVE(4),
+    /** resize. */
+    RESIZE(5),
+    /** xbr and xbr2x. */
+    XBR(6),
+}
+
+/**
+ * The statistics that [Toolkit.statistics] can compute. The values match
+ * RenderScriptToolkit::Statistic.
+ */
+enum class Statistic(val value: Int) {
+    MinMax(1 shl 0),
+    Average(1 shl 1),
+    StandardDeviation(1 shl 2),
+    Moment(1 shl 3),
+    Histogram(1 shl 4),
+}
+
+/**
+ * The result of [Toolkit.statistics]. The statistics that were not requested are null.
+ *
+ * @property histogram The histogram of the four channels, 256 * 4 counts, like [Toolkit.histogram].
+ */
+class ImageStatistics(
+    val min: Float?,
+    val max: Float?,
+    val average: Double?,
+    val standardDeviation: Double?,
+    val momentX: Float?,
+    val momentY: Float?,
+    val histogram: IntArray?
+) {
+    internal companion object {
+        fun from(
+            output: DoubleArray,
+            histogram: IntArray?,
+            statistics: Set<Statistic>
+        ): ImageStatistics {
+            val hasMinMax = Statistic.MinMax in statistics
+            val hasMoment = Statistic.Moment in statistics
+            return ImageStatistics(
+                if (hasMinMax) output[0].toFloat() else null,
+                if (hasMinMax) output[1].toFloat() else null,
+                if (Statistic.Average in statistics) output[2] else null,
+                if (Statistic.StandardDeviation in statistics) output[3] else null,
+                if (hasMoment) output[4].toFloat() else null,
+                if (hasMoment) output[5].toFloat() else null,
+                histogram
+            )
+        }
+    }
+}
+
+/**
+ * The Haralick texture features computed by [Toolkit.glcmFeatures], from the normalized GLCM
+ * p(i, j). When no pair was counted, they are all 0.
+ *
+ * @property contrast The sum of (i - j)^2 p(i, j).
+ * @property dissimilarity The sum of |i - j| p(i, j).
+ * @property homogeneity The sum of p(i, j) / (1 + (i - j)^2).
+ * @property angularSecondMoment The sum of p(i, j)^2.
+ * @property energy The square root of the angular second moment.
+ * @property entropy Minus the sum of p(i, j) ln(p(i, j)).
+ * @property correlation The correlation of i and j, 1 when either has no variance.
+ * @property maxProbability The largest p(i, j).
+ */
+class GlcmFeatures(
+    val contrast: Float,
+    val dissimilarity: Float,
+    val homogeneity: Float,
+    val angularSecondMoment: Float,
+    val energy: Float,
+    val entropy: Float,
+    val correlation: Float,
+    val maxProbability: Float
+) {
+    internal companion object {
+        /** The number of values of RenderScriptToolkit::glcmFeatures. */
+        const val COUNT = 8
+
+        fun fromBatch(output: FloatArray, count: Int): List<GlcmFeatures> {
+            return (0 until count).map { i ->
+                val offset = i * COUNT
+                GlcmFeatures(
+                    output[offset],
+                    output[offset + 1],
+                    output[offset + 2],
+                    output[offset + 3],
+                    output[offset + 4],
+                    output[offset + 5],
+                    output[offset + 6],
+                    output[offset + 7]
+                )
+            }
+        }
+    }
+}
+
+/**
+ * A blob found by [Toolkit.findBlobsWithStatistics].
+ *
+ * @property bounds The bounding box of the blob.
+ * @property area The area of the bounding box.
+ * @property pixelCount The number of pixels in the blob.
+ * @property centroidX The x coordinate of the centroid of the pixels.
+ * @property centroidY The y coordinate of the centroid of the pixels.
+ */
+class Blob(
+    val bounds: Rect,
+    val area: Int,
+    val pixelCount: Int,
+    val centroidX: Float,
+    val centroidY: Float
+) {
+    internal companion object {
+        fun from(bounds: List<Rect>, statistics: DoubleArray): List<Blob> {
+            return bounds.mapIndexed { i, rect ->
+                Blob(
+                    rect,
+                    statistics[i * 4].toInt(),
+                    statistics[i * 4 + 1].toInt(),
+                    statistics[i * 4 + 2].toFloat(),
+                    statistics[i * 4 + 3].toFloat()
+                )
+            }
+        }
+    }
+}
+
 /**
  * Define a range of data to process.
  *
@@ -2304,7 +6056,8 @@ class Rgba3dArray(val values: ByteArray, val sizeX: Int, val sizeY: Int, val siz
 internal fun validateBitmap(
     function: String,
     inputBitmap: Bitmap,
-    alphaAllowed: Boolean = true
+    alphaAllowed: Boolean = true,
+    paddingAllowed: Boolean = true
 ) {
     if (alphaAllowed) {
         require(
@@ -2320,7 +6073,7 @@ internal fun validateBitmap(
                     "${inputBitmap.config} provided."
         }
     }
-    require(inputBitmap.width * vectorSize(inputBitmap) == inputBitmap.rowBytes) {
+    require(paddingAllowed || inputBitmap.width * vectorSize(inputBitmap) == inputBitmap.rowBytes) {
         "$externalName $function. Only bitmaps with rowSize equal to the width * vectorSize are " +
                 "currently supported. Provided were rowBytes=${inputBitmap.rowBytes}, " +
                 "width={${inputBitmap.width}, and vectorSize=${vectorSize(inputBitmap)}."
@@ -2336,6 +6089,58 @@ internal fun createCompatibleBitmap(inputBitmap: Bitmap, inPlace: Boolean = fals
     )
 }
 
+internal fun validateDirectBuffer(function: String, buffer: Buffer, size: Int) {
+    require(buffer.isDirect) {
+        "$externalName $function. Only direct buffers are supported."
+    }
+    require(buffer.capacity() >= size) {
+        "$externalName $function. The buffer is too small for the given dimensions. " +
+                "${buffer.capacity()} < $size."
+    }
+    // The native code reads the values of multi-byte buffers in the order of the CPU. The order
+    // of a ByteBuffer only affects its own getters, its bytes are read one by one.
+    val order = when (buffer) {
+        is FloatBuffer -> buffer.order()
+        is IntBuffer -> buffer.order()
+        is ShortBuffer -> buffer.order()
+        is LongBuffer -> buffer.order()
+        is DoubleBuffer -> buffer.order()
+        is CharBuffer -> buffer.order()
+        else -> ByteOrder.nativeOrder()
+    }
+    require(order == ByteOrder.nativeOrder()) {
+        "$externalName $function. The buffer should be in the native byte order, " +
+                "${ByteOrder.nativeOrder()}. $order provided. Create it with " +
+                "ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder())."
+    }
+}
+
+internal fun createDirectBuffer(size: Int): ByteBuffer =
+    ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder())
+
+@RequiresApi(Build.VERSION_CODES.O)
+internal fun validateHardwareBuffer(function: String, buffer: HardwareBuffer) {
+    require(!buffer.isClosed) {
+        "$externalName $function. The HardwareBuffer is closed."
+    }
+    require(buffer.format == HardwareBuffer.RGBA_8888) {
+        "$externalName $function. Only RGBA_8888 HardwareBuffers are supported. " +
+                "${buffer.format} provided."
+    }
+    require((buffer.usage and HardwareBuffer.USAGE_CPU_READ_OFTEN) != 0L) {
+        "$externalName $function. The HardwareBuffer should be readable by the CPU."
+    }
+}
+
+@RequiresApi(Build.VERSION_CODES.O)
+internal fun createHardwareBuffer(width: Int, height: Int): HardwareBuffer = HardwareBuffer.create(
+    width,
+    height,
+    HardwareBuffer.RGBA_8888,
+    1,
+    HardwareBuffer.USAGE_CPU_READ_OFTEN or HardwareBuffer.USAGE_CPU_WRITE_OFTEN
+)
+
 internal fun validateHistogramDotCoefficients(
     coefficients: FloatArray?,
     vectorSize: Int
@@ -2389,6 +6194,33 @@ internal fun validateRestriction(
     }
 }
 
+internal fun validateKernel(
+    function: String,
+    coefficients: FloatArray,
+    kernelSizeX: Int,
+    kernelSizeY: Int
+) {
+    require(kernelSizeX >= 1 && kernelSizeY >= 1) {
+        "$externalName $function. The kernel should be at least 1x1. " +
+                "${kernelSizeX}x$kernelSizeY provided."
+    }
+    require(coefficients.size == kernelSizeX * kernelSizeY) {
+        "$externalName $function. A ${kernelSizeX}x$kernelSizeY kernel needs " +
+                "${kernelSizeX * kernelSizeY} coefficients. ${coefficients.size} provided."
+    }
+}
+
+/**
+ * The side of the 3x3 or 5x5 kernel of the original convolve variants.
+ */
+internal fun squareKernelSize(coefficients: FloatArray): Int {
+    require(coefficients.size == 9 || coefficients.size == 25) {
+        "$externalName convolve. Only 3x3 or 5x5 convolutions are supported. " +
+                "${coefficients.size} coefficients provided."
+    }
+    return if (coefficients.size == 9) 3 else 5
+}
+
 internal fun validateGlcmSteps(steps: IntArray) {
     require(steps.size % 2 == 0) {
         "$externalName glcm. Steps must contain (dx, dy) pairs."
@@ -2398,6 +6230,18 @@ internal fun validateGlcmSteps(steps: IntArray) {
     }
 }
 
+internal fun validateGlcmLevels(levels: IntArray) {
+    require(levels.isNotEmpty()) {
+        "$externalName glcmFeatures. At least one number of levels is required."
+    }
+    for (level in levels) {
+        require(level in 1..256) {
+            "$externalName glcmFeatures. The number of levels should be between 1 and 256. " +
+                    "$level provided."
+        }
+    }
+}
+
 internal fun vectorSize(bitmap: Bitmap): Int {
     return when (bitmap.config) {
         Bitmap.Config.ARGB_8888 -> 4
@@ -0,0 +1,14 @@
+package com.kylecorry.andromeda.bitmaps.operations
+
+import android.graphics.Bitmap
+import com.kylecorry.andromeda.bitmaps.BitmapUtils.pipeline
+import com.kylecorry.andromeda.bitmaps.PipelineStage
+
+class Pipeline(
+    private val stages: List<PipelineStage>,
+    private val inPlace: Boolean = false
+) : BitmapOperation {
+    override fun execute(bitmap: Bitmap): Bitmap {
+        return bitmap.pipeline(stages, inPlace = inPlace)
+    }
+}
@@ -2,8 +2,9 @@ package com.kylecorry.andromeda.bitmaps.operations
 
 import android.graphics.Bitmap
 import android.util.Size
-import com.kylecorry.andromeda.bitmaps.BitmapUtils.xbr2xUpscale
+import com.kylecorry.andromeda.bitmaps.BitmapUtils.xbrUpscale
 import com.kylecorry.andromeda.bitmaps.operations.BitmapOperation
+import kotlin.math.min
 
 /**
  * An upscaler that preserves the colors of the pixels but attempts to smooth edges
@@ -16,7 +17,12 @@ class PixelPreservationUpscale(
         var width = bitmap.width
         var height = bitmap.height
         while (width < size.width && height < size.height) {
-            val newBitmap = output.xbr2xUpscale()
+            // Upscale up to 4x at once, rather than chaining 2x, when more is needed
+            val scale = min(
+                ceilDiv(size.width, width),
+                ceilDiv(size.height, height)
+            ).coerceIn(2, 4)
+            val newBitmap = output.xbrUpscale(scale)
             if (output != bitmap) {
                 output.recycle()
             }
@@ -26,4 +32,8 @@ class PixelPreservationUpscale(
         }
         return output
     }
+
+    private fun ceilDiv(a: Int, b: Int): Int {
+        return (a + b - 1) / b
+    }
 }
\ No newline at end of file
@@ -0,0 +1,249 @@
+// Checks that the scratch arenas of the TaskProcessor make repeated calls allocation free: once a
+// few frames have been processed, processing more of the same frames must not touch the heap.
+// Counts every operator new of the process, so it also catches the allocations of the tasks.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+#include "TaskProcessor.h"
+
+using namespace renderscript;
+
+namespace {
+
+std::atomic<uint64_t> heapAllocations{0};
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", message.c_str());
+    if (!ok) failures++;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = nullptr;
+    if (posix_memalign(&p, std::max(sizeof(void*), (size_t)alignment), size == 0 ? 1 : size)) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { free(p); }
+
+namespace {
+
+/**
+ * Nested scopes give their memory back in order, and what doesn't fit goes to the heap until
+ * the outermost scope ends, after which it fits.
+ */
+void testArena() {
+    ScratchArena arena;
+    for (int round = 0; round < 3; round++) {
+        const uint64_t before = ScratchArena::getHeapAllocationCount();
+        uint8_t* outer;
+        {
+            ScratchArena::Scope scope(arena);
+            outer = arena.allocate<uint8_t>(1000);
+            bool aligned = (uintptr_t)outer % kCacheLineSize == 0;
+            {
+                ScratchArena::Scope inner(arena);
+                uint8_t* first = arena.allocate<uint8_t>(5000);
+                uint8_t* second = arena.allocate<uint8_t>(3);
+                aligned = aligned && (uintptr_t)first % kCacheLineSize == 0 &&
+                          (uintptr_t)second % kCacheLineSize == 0;
+                std::fill_n(first, 5000, 1);
+                std::fill_n(second, 3, 2);
+            }
+            // The inner scope gave its memory back, the next allocation reuses it.
+            ScratchArena::Scope inner(arena);
+            uint8_t* again = arena.allocate<uint8_t>(5000);
+            std::fill_n(outer, 1000, 3);
+            std::fill_n(again, 5000, 4);
+            check(aligned, "arena round " + std::to_string(round) + ": allocations are aligned");
+        }
+        const uint64_t allocations = ScratchArena::getHeapAllocationCount() - before;
+        if (round == 0) {
+            check(allocations > 0, "arena round 0: the first round allocates");
+        } else {
+            check(allocations == 0, "arena round " + std::to_string(round) + ": " +
+                                            std::to_string(allocations) + " heap allocations");
+        }
+    }
+}
+
+/**
+ * Needs beyond kMaxRetainedBytes are met from the heap every time, the buffer doesn't grow past
+ * it. trim() frees the buffer, which the next scope grows again.
+ */
+void testRetainedLimit() {
+    ScratchArena arena;
+    for (int round = 0; round < 3; round++) {
+        const uint64_t before = ScratchArena::getHeapAllocationCount();
+        {
+            ScratchArena::Scope scope(arena);
+            std::fill_n(arena.allocate<uint8_t>(ScratchArena::kMaxRetainedBytes), 1000, 1);
+            std::fill_n(arena.allocate<uint8_t>(1000), 1000, 2);
+        }
+        const uint64_t allocations = ScratchArena::getHeapAllocationCount() - before;
+        check(allocations > 0, "over the limit, round " + std::to_string(round) + ": " +
+                                       std::to_string(allocations) + " heap allocations");
+    }
+
+    const uint64_t before = ScratchArena::getHeapAllocationCount();
+    {
+        ScratchArena::Scope scope(arena);
+        std::fill_n(arena.allocate<uint8_t>(ScratchArena::kMaxRetainedBytes), 1000, 3);
+    }
+    check(ScratchArena::getHeapAllocationCount() == before, "the limit itself is retained");
+
+    arena.trim();
+    {
+        ScratchArena::Scope scope(arena);
+        std::fill_n(arena.allocate<uint8_t>(1000), 1000, 4);
+    }
+    check(ScratchArena::getHeapAllocationCount() > before, "trim frees the buffer");
+}
+
+/**
+ * The ops of a typical video frame, all using scratch memory: a conversion from the camera
+ * format, blurs with the direct and the box kernels, convolutions with the separable and the
+ * direct paths, the reductions that have per thread counts, a pipeline with a color matrix and
+ * a histogram, and the search for the blobs it leaves.
+ */
+struct Frame {
+    static constexpr size_t kSizeX = 320;
+    static constexpr size_t kSizeY = 240;
+    std::vector<uint8_t> yuv = std::vector<uint8_t>(kSizeX * kSizeY * 3 / 2);
+    std::vector<uint8_t> rgba = std::vector<uint8_t>(kSizeX * kSizeY * 4);
+    std::vector<uint8_t> alpha = std::vector<uint8_t>(kSizeX * kSizeY);
+    std::vector<uint8_t> out = std::vector<uint8_t>(kSizeX * kSizeY * 4);
+    std::vector<float> gaussian = std::vector<float>(9 * 9, 1.f / 81);
+    std::vector<float> ring = std::vector<float>(7 * 7, 0.f);
+    std::vector<int32_t> histogram = std::vector<int32_t>(256 * 4);
+    std::vector<float> glcm = std::vector<float>(16 * 16);
+    float features[RenderScriptToolkit::kGlcmFeatureCount];
+    double statistics[6];
+    int steps[4] = {1, 0, 0, 1};
+    float grey[16] = {0.3f, 0.3f, 0.3f, 0.f, 0.59f, 0.59f, 0.59f, 0.f,
+                      0.11f, 0.11f, 0.11f, 0.f, 0.f, 0.f, 0.f, 1.f};
+    float smooth[9] = {1.f / 16, 2.f / 16, 1.f / 16, 2.f / 16, 4.f / 16,
+                       2.f / 16, 1.f / 16, 2.f / 16, 1.f / 16};
+    RenderScriptToolkit::PipelineStage stages[3] = {
+            RenderScriptToolkit::PipelineStage::colorMatrix(grey),
+            RenderScriptToolkit::PipelineStage::convolve3x3(smooth),
+            RenderScriptToolkit::PipelineStage::threshold(128.f, true, 4)};
+    int blobs[10 * 4];
+    double blobStatistics[10 * 4];
+
+    Frame() {
+        for (size_t i = 0; i < yuv.size(); i++) yuv[i] = (uint8_t)(i * 7 + i / 320);
+        for (size_t i = 0; i < alpha.size(); i++) alpha[i] = (uint8_t)(i * 13);
+        for (size_t i = 0; i < 7; i++) ring[i] = ring[i * 7] = 0.05f;
+    }
+
+    void process(RenderScriptToolkit& toolkit) {
+        toolkit.yuvToRgb(yuv.data(), rgba.data(), kSizeX, kSizeY,
+                         RenderScriptToolkit::YuvFormat::NV21);
+        toolkit.blur(rgba.data(), out.data(), kSizeX, kSizeY, 4, 10);
+        toolkit.blur(alpha.data(), out.data(), kSizeX, kSizeY, 1, 10);
+        toolkit.blur(rgba.data(), out.data(), kSizeX, kSizeY, 4, 60);
+        toolkit.convolve(rgba.data(), out.data(), 4, kSizeX, kSizeY, gaussian.data(), 9, 9);
+        toolkit.convolve(rgba.data(), out.data(), 4, kSizeX, kSizeY, ring.data(), 7, 7);
+        toolkit.histogram(rgba.data(), histogram.data(), kSizeX, kSizeY, 4);
+        toolkit.histogramDot(rgba.data(), histogram.data(), kSizeX, kSizeY, 4, nullptr);
+        toolkit.statistics(rgba.data(), statistics, histogram.data(), kSizeX, kSizeY, 4,
+                           (uint32_t)RenderScriptToolkit::Statistic::HISTOGRAM |
+                                   (uint32_t)RenderScriptToolkit::Statistic::AVERAGE,
+                           nullptr);
+        toolkit.glcm(rgba.data(), glcm.data(), kSizeX, kSizeY, 16, 4, true, true, false, steps,
+                     2, nullptr);
+        toolkit.glcmFeatures(rgba.data(), features, kSizeX, kSizeY, 256, 4, true, false, steps,
+                             2, true, nullptr);
+        toolkit.pipeline(rgba.data(), out.data(), kSizeX, kSizeY, stages, 3, histogram.data());
+        toolkit.findBlobs(out.data(), blobs, blobStatistics, 10, kSizeX, kSizeY, 128.f, 4,
+                          nullptr);
+    }
+};
+
+void testFrames(int threads) {
+    RenderScriptToolkit toolkit(threads);
+    Frame frame;
+    // The arenas reach their size within the first frames. The pool threads may not all have
+    // processed every kind of tile yet, so warm up a few more.
+    for (int i = 0; i < 10; i++) frame.process(toolkit);
+
+    const uint64_t arenaBefore = ScratchArena::getHeapAllocationCount();
+    const uint64_t heapBefore = heapAllocations.load();
+    for (int i = 0; i < 20; i++) frame.process(toolkit);
+    const uint64_t arena = ScratchArena::getHeapAllocationCount() - arenaBefore;
+    const uint64_t heap = heapAllocations.load() - heapBefore;
+    check(arena == 0 && heap == 0, std::to_string(threads) + " thread(s), 20 frames: " +
+                                           std::to_string(arena) + " arena and " +
+                                           std::to_string(heap) + " heap allocations");
+}
+
+/**
+ * After trimScratch the next frame allocates the scratch memory again, and once warmed up the
+ * frames are allocation free again. The pool threads trim when they are next idle, which they
+ * are given time for.
+ */
+void testTrimScratch(int threads) {
+    RenderScriptToolkit toolkit(threads);
+    Frame frame;
+    for (int i = 0; i < 10; i++) frame.process(toolkit);
+
+    toolkit.trimScratch();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    uint64_t before = ScratchArena::getHeapAllocationCount();
+    frame.process(toolkit);
+    check(ScratchArena::getHeapAllocationCount() > before,
+          std::to_string(threads) + " thread(s): the frame after trimScratch allocates");
+
+    for (int i = 0; i < 10; i++) frame.process(toolkit);
+    before = ScratchArena::getHeapAllocationCount();
+    for (int i = 0; i < 20; i++) frame.process(toolkit);
+    const uint64_t arena = ScratchArena::getHeapAllocationCount() - before;
+    check(arena == 0, std::to_string(threads) + " thread(s), 20 frames after trimScratch: " +
+                              std::to_string(arena) + " arena allocations");
+}
+
+}  // namespace
+
+int main() {
+    testArena();
+    testRetainedLimit();
+    testFrames(1);
+    testFrames(4);
+    testTrimScratch(1);
+    testTrimScratch(4);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
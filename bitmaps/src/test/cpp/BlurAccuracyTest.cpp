@@ -0,0 +1,216 @@
+// Checks how closely RenderScriptToolkit::blur follows a true Gaussian. Radii up to 25 use the
+// direct kernel and larger ones the stacked box blur approximation, so the errors reported for
+// both can be compared. Also checks that restricted and padded blurs, and blurs tiled for other
+// working sets, match the full blur.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+
+namespace {
+
+int failures = 0;
+
+/**
+ * An image of random 24x24 blocks over a diagonal gradient. The blocks give the blur edges to
+ * smooth, the gradient makes sure the clamped borders matter.
+ */
+std::vector<uint8_t> testImage(size_t sizeX, size_t sizeY, size_t vectorSize, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(0, 127);
+    size_t blocksX = (sizeX + 23) / 24;
+    size_t blocksY = (sizeY + 23) / 24;
+    std::vector<int> blocks(blocksX * blocksY * vectorSize);
+    for (auto& value : blocks) value = distribution(generator);
+
+    std::vector<uint8_t> image(sizeX * sizeY * vectorSize);
+    for (size_t y = 0; y < sizeY; y++) {
+        for (size_t x = 0; x < sizeX; x++) {
+            int gradient = (int)(128 * (x + y) / (sizeX + sizeY));
+            for (size_t c = 0; c < vectorSize; c++) {
+                int block = blocks[((y / 24) * blocksX + x / 24) * vectorSize + c];
+                image[(y * sizeX + x) * vectorSize + c] = (uint8_t)(block + gradient);
+            }
+        }
+    }
+    return image;
+}
+
+/**
+ * A separable Gaussian in double precision, with the sigma the toolkit uses for the radius and
+ * the edge pixels repeated past the borders.
+ */
+std::vector<uint8_t> referenceBlur(const std::vector<uint8_t>& in, size_t sizeX, size_t sizeY,
+                                   size_t vectorSize, int radius) {
+    double sigma = 0.4 * radius + 0.6;
+    int reach = (int)std::ceil(4 * sigma);
+    std::vector<double> weights(2 * reach + 1);
+    double total = 0;
+    for (int i = -reach; i <= reach; i++) {
+        weights[i + reach] = std::exp(-(double)i * i / (2 * sigma * sigma));
+        total += weights[i + reach];
+    }
+    for (auto& weight : weights) weight /= total;
+
+    auto at = [](int value, size_t size) {
+        return (size_t)std::min(std::max(value, 0), (int)size - 1);
+    };
+    std::vector<double> vertical(in.size());
+    for (size_t y = 0; y < sizeY; y++) {
+        for (size_t i = 0; i < sizeX * vectorSize; i++) {
+            double sum = 0;
+            for (int k = -reach; k <= reach; k++) {
+                sum += weights[k + reach] * in[at((int)y + k, sizeY) * sizeX * vectorSize + i];
+            }
+            vertical[y * sizeX * vectorSize + i] = sum;
+        }
+    }
+    std::vector<uint8_t> out(in.size());
+    for (size_t y = 0; y < sizeY; y++) {
+        for (size_t x = 0; x < sizeX; x++) {
+            for (size_t c = 0; c < vectorSize; c++) {
+                double sum = 0;
+                for (int k = -reach; k <= reach; k++) {
+                    size_t source = (y * sizeX + at((int)x + k, sizeX)) * vectorSize + c;
+                    sum += weights[k + reach] * vertical[source];
+                }
+                out[(y * sizeX + x) * vectorSize + c] = (uint8_t)(sum + 0.5);
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * Blurs the test image and compares it to the reference. The mean error is what shows on
+ * screen, the max error catches bugs at the borders.
+ */
+void testAccuracy(RenderScriptToolkit& toolkit, size_t sizeX, size_t sizeY, size_t vectorSize,
+                  int radius, double meanTolerance, int maxTolerance) {
+    std::vector<uint8_t> in = testImage(sizeX, sizeY, vectorSize, radius);
+    std::vector<uint8_t> expected = referenceBlur(in, sizeX, sizeY, vectorSize, radius);
+    std::vector<uint8_t> actual(in.size());
+    toolkit.blur(in.data(), actual.data(), sizeX, sizeY, vectorSize, radius);
+
+    double sum = 0;
+    int maxError = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+        int error = std::abs((int)expected[i] - (int)actual[i]);
+        sum += error;
+        maxError = std::max(maxError, error);
+    }
+    double mean = sum / in.size();
+    bool ok = mean <= meanTolerance && maxError <= maxTolerance;
+    printf("%s blur %zux%zu vectorSize %zu radius %d: mean error %.3f, max error %d\n",
+           ok ? "ok  " : "FAIL", sizeX, sizeY, vectorSize, radius, mean, maxError);
+    if (!ok) failures++;
+}
+
+/**
+ * Blurs a restricted area of padded buffers and expects the same pixels as the full blur, give
+ * or take tolerance, with the rest of the output left untouched.
+ */
+void testRestriction(RenderScriptToolkit& toolkit, size_t vectorSize, int radius, int tolerance) {
+    const size_t sizeX = 150;
+    const size_t sizeY = 110;
+    const size_t padding = 12;
+    std::vector<uint8_t> in = testImage(sizeX, sizeY, vectorSize, 7);
+    std::vector<uint8_t> full(in.size());
+    toolkit.blur(in.data(), full.data(), sizeX, sizeY, vectorSize, radius);
+
+    Restriction restriction{20, 130, 35, 70};
+    restriction.inputStride = sizeX * vectorSize + padding;
+    restriction.outputStride = sizeX * vectorSize + 2 * padding;
+    std::vector<uint8_t> paddedIn(restriction.inputStride * sizeY);
+    for (size_t y = 0; y < sizeY; y++) {
+        std::copy_n(&in[y * sizeX * vectorSize], sizeX * vectorSize,
+                    &paddedIn[y * restriction.inputStride]);
+    }
+    std::vector<uint8_t> paddedOut(restriction.outputStride * sizeY, 0xAB);
+    toolkit.blur(paddedIn.data(), paddedOut.data(), sizeX, sizeY, vectorSize, radius,
+                 &restriction);
+
+    int mismatches = 0;
+    for (size_t y = 0; y < sizeY; y++) {
+        for (size_t i = 0; i < restriction.outputStride; i++) {
+            size_t x = i / vectorSize;
+            bool inside = y >= restriction.startY && y < restriction.endY &&
+                          x >= restriction.startX && x < restriction.endX;
+            int expected = inside ? full[y * sizeX * vectorSize + i] : 0xAB;
+            int actual = paddedOut[y * restriction.outputStride + i];
+            if (std::abs(expected - actual) > (inside ? tolerance : 0)) mismatches++;
+        }
+    }
+    printf("%s restricted blur vectorSize %zu radius %d: %d mismatches\n",
+           mismatches == 0 ? "ok  " : "FAIL", vectorSize, radius, mismatches);
+    if (mismatches != 0) failures++;
+}
+
+/**
+ * Blurs with tiles sized for several working sets, from narrow to full rows, and expects the
+ * same pixels as with the default tiles, give or take tolerance.
+ */
+void testTiling(RenderScriptToolkit& toolkit, size_t vectorSize, int radius, int tolerance) {
+    using TilingGroup = RenderScriptToolkit::TilingGroup;
+    const size_t sizeX = 700;
+    const size_t sizeY = 300;
+    std::vector<uint8_t> in = testImage(sizeX, sizeY, vectorSize, 11);
+    std::vector<uint8_t> expected(in.size());
+    toolkit.blur(in.data(), expected.data(), sizeX, sizeY, vectorSize, radius);
+
+    const size_t defaultTarget = toolkit.getTilingTarget(TilingGroup::BLUR);
+    int mismatches = 0;
+    for (size_t target : {2000, 8 * 1024, 256 * 1024, 16 * 1024 * 1024}) {
+        toolkit.setTilingTarget(TilingGroup::BLUR, target);
+        if (toolkit.getTilingTarget(TilingGroup::BLUR) != target) mismatches++;
+        std::vector<uint8_t> out(in.size());
+        toolkit.blur(in.data(), out.data(), sizeX, sizeY, vectorSize, radius);
+        for (size_t i = 0; i < out.size(); i++) {
+            if (std::abs(expected[i] - out[i]) > tolerance) mismatches++;
+        }
+    }
+    toolkit.setTilingTarget(TilingGroup::BLUR, defaultTarget);
+    printf("%s tiled blur vectorSize %zu radius %d: %d mismatches\n",
+           mismatches == 0 ? "ok  " : "FAIL", vectorSize, radius, mismatches);
+    if (mismatches != 0) failures++;
+}
+
+}  // namespace
+
+int main() {
+    RenderScriptToolkit toolkit;
+    // The direct kernel cuts the Gaussian at the radius, about 2.4 sigma, which is the largest
+    // part of its error. The box blurs are a closer fit.
+    for (size_t vectorSize : {1, 4}) {
+        testAccuracy(toolkit, 320, 240, vectorSize, 10, 1.0, 4);
+        testAccuracy(toolkit, 320, 240, vectorSize, 25, 1.0, 4);
+        testAccuracy(toolkit, 320, 240, vectorSize, 50, 1.0, 4);
+        testAccuracy(toolkit, 640, 480, vectorSize, 100, 1.0, 4);
+        testAccuracy(toolkit, 640, 480, vectorSize, 200, 1.0, 4);
+        // The direct kernel rounds differently in its SIMD and scalar parts, which depend on
+        // where the restriction starts. The box blurs always round the same way.
+        testRestriction(toolkit, vectorSize, 10, 1);
+        testRestriction(toolkit, vectorSize, 60, 0);
+        // The running sums of the box blurs restart at each tile, so their rounding depends on
+        // the tiles too.
+        testTiling(toolkit, vectorSize, 10, 1);
+        testTiling(toolkit, vectorSize, 60, 1);
+    }
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
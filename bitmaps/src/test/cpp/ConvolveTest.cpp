@@ -0,0 +1,195 @@
+// Checks RenderScriptToolkit::convolve against a direct floating point convolution, for the
+// separable and the direct paths, every border mode, vector size and a padded restriction.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+using BorderMode = RenderScriptToolkit::BorderMode;
+
+namespace {
+
+int failures = 0;
+
+const char* name(BorderMode mode) {
+    switch (mode) {
+        case BorderMode::CLAMP:
+            return "clamp";
+        case BorderMode::MIRROR:
+            return "mirror";
+        case BorderMode::WRAP:
+            return "wrap";
+        case BorderMode::ZERO:
+            return "zero";
+    }
+    return "?";
+}
+
+// The cell the border mode reads for coordinate i, or -1 for a zero.
+int borderIndex(int i, int size, BorderMode mode) {
+    if (i >= 0 && i < size) return i;
+    switch (mode) {
+        case BorderMode::CLAMP:
+            return std::min(std::max(i, 0), size - 1);
+        case BorderMode::MIRROR:
+            // Reflect until inside, one edge at a time.
+            while (i < 0 || i >= size) {
+                if (size == 1) return 0;
+                i = i < 0 ? -i : 2 * (size - 1) - i;
+            }
+            return i;
+        case BorderMode::WRAP:
+            return ((i % size) + size) % size;
+        case BorderMode::ZERO:
+            return -1;
+    }
+    return -1;
+}
+
+std::vector<uint8_t> reference(const std::vector<uint8_t>& in, size_t sizeX, size_t sizeY,
+                               size_t cellSize, const std::vector<float>& kernel,
+                               int kernelSizeX, int kernelSizeY, BorderMode mode) {
+    std::vector<uint8_t> out(in.size());
+    const int centerX = (kernelSizeX - 1) / 2;
+    const int centerY = (kernelSizeY - 1) / 2;
+    for (int y = 0; y < (int)sizeY; y++) {
+        for (int x = 0; x < (int)sizeX; x++) {
+            for (size_t c = 0; c < cellSize; c++) {
+                double sum = 0;
+                for (int ky = 0; ky < kernelSizeY; ky++) {
+                    int inY = borderIndex(y + ky - centerY, sizeY, mode);
+                    for (int kx = 0; kx < kernelSizeX; kx++) {
+                        int inX = borderIndex(x + kx - centerX, sizeX, mode);
+                        if (inX < 0 || inY < 0) continue;
+                        sum += kernel[ky * kernelSizeX + kx] *
+                               in[(inY * sizeX + inX) * cellSize + c];
+                    }
+                }
+                out[(y * sizeX + x) * cellSize + c] =
+                        (uint8_t)std::min(std::max(sum + 0.5, 0.0), 255.0);
+            }
+        }
+    }
+    return out;
+}
+
+void test(RenderScriptToolkit& toolkit, const std::string& kernelName,
+          const std::vector<float>& kernel, int kernelSizeX, int kernelSizeY, int tolerance) {
+    const size_t sizeX = 67;
+    const size_t sizeY = 45;
+    std::mt19937 generator(kernelSizeX * 100 + kernelSizeY);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    for (size_t vectorSize = 1; vectorSize <= 4; vectorSize++) {
+        const size_t cellSize = vectorSize == 3 ? 4 : vectorSize;
+        std::vector<uint8_t> in(sizeX * sizeY * cellSize);
+        for (auto& value : in) value = (uint8_t)distribution(generator);
+        for (BorderMode mode : {BorderMode::CLAMP, BorderMode::MIRROR, BorderMode::WRAP,
+                                BorderMode::ZERO}) {
+            std::vector<uint8_t> expected =
+                    reference(in, sizeX, sizeY, cellSize, kernel, kernelSizeX, kernelSizeY, mode);
+            std::vector<uint8_t> actual(in.size());
+            toolkit.convolve(in.data(), actual.data(), vectorSize, sizeX, sizeY, kernel.data(),
+                             kernelSizeX, kernelSizeY, mode);
+            int maxDiff = 0;
+            for (size_t i = 0; i < in.size(); i++) {
+                maxDiff = std::max(maxDiff, std::abs((int)expected[i] - (int)actual[i]));
+            }
+
+            // A restricted area of padded buffers must match the full convolution. The SIMD
+            // kernels of convolve3x3 and convolve5x5 may round differently depending on where
+            // the restriction starts.
+            Restriction restriction{9, 50, 3, 40};
+            restriction.inputStride = sizeX * cellSize + 8;
+            restriction.outputStride = sizeX * cellSize + 16;
+            std::vector<uint8_t> paddedIn(restriction.inputStride * sizeY);
+            for (size_t y = 0; y < sizeY; y++) {
+                std::copy_n(&in[y * sizeX * cellSize], sizeX * cellSize,
+                            &paddedIn[y * restriction.inputStride]);
+            }
+            std::vector<uint8_t> paddedOut(restriction.outputStride * sizeY, 0xAB);
+            toolkit.convolve(paddedIn.data(), paddedOut.data(), vectorSize, sizeX, sizeY,
+                             kernel.data(), kernelSizeX, kernelSizeY, mode, &restriction);
+            int mismatches = 0;
+            for (size_t y = 0; y < sizeY; y++) {
+                for (size_t i = 0; i < restriction.outputStride; i++) {
+                    size_t x = i / cellSize;
+                    bool inside = y >= restriction.startY && y < restriction.endY &&
+                                  x >= restriction.startX && x < restriction.endX;
+                    int want = inside ? actual[y * sizeX * cellSize + i] : 0xAB;
+                    int got = paddedOut[y * restriction.outputStride + i];
+                    if (std::abs(want - got) > (inside ? tolerance : 0)) mismatches++;
+                }
+            }
+
+            bool ok = maxDiff <= tolerance && mismatches == 0;
+            printf("%s convolve %s vectorSize %zu %s: max diff %d, %d restriction mismatches\n",
+                   ok ? "ok  " : "FAIL", kernelName.c_str(), vectorSize, name(mode), maxDiff,
+                   mismatches);
+            if (!ok) failures++;
+        }
+    }
+}
+
+std::vector<float> gaussian(int size, float sigma) {
+    std::vector<float> weights(size);
+    float total = 0;
+    for (int i = 0; i < size; i++) {
+        float d = i - (size - 1) / 2.f;
+        weights[i] = std::exp(-d * d / (2 * sigma * sigma));
+        total += weights[i];
+    }
+    for (auto& weight : weights) weight /= total;
+    return weights;
+}
+
+std::vector<float> outer(const std::vector<float>& column, const std::vector<float>& row) {
+    std::vector<float> kernel;
+    for (float c : column) {
+        for (float r : row) kernel.push_back(c * r);
+    }
+    return kernel;
+}
+
+}  // namespace
+
+int main() {
+    RenderScriptToolkit toolkit;
+    // Separable kernels go through the fixed point path, which may be off by one. The tolerance
+    // also applies to the restricted convolutions.
+    test(toolkit, "gaussian 15x9", outer(gaussian(9, 2.f), gaussian(15, 3.f)), 15, 9, 1);
+    test(toolkit, "box 1x21", std::vector<float>(21, 1.f / 21), 21, 1, 1);
+    test(toolkit, "derivative 7x4", outer({1.f, 2.f, 2.f, 1.f}, {-0.3f, -0.2f, -0.1f, 0.f, 0.1f,
+                                                               0.2f, 0.3f}),
+         7, 4, 1);
+    // The direct path, with an even sized kernel and one that's not separable.
+    std::vector<float> ring(49, 0.f);
+    for (int y = 0; y < 7; y++) {
+        for (int x = 0; x < 7; x++) {
+            float d = std::hypot(x - 3.f, y - 3.f);
+            if (d > 1.5f && d < 3.5f) ring[y * 7 + x] = 0.04f;
+        }
+    }
+    test(toolkit, "ring 7x7", ring, 7, 7, 1);
+    std::vector<float> sharpen(6 * 4, -0.05f);
+    sharpen[1 * 6 + 2] = 2.15f;
+    test(toolkit, "sharpen 6x4", sharpen, 6, 4, 1);
+    // 3x3 and 5x5 clamp kernels use convolve3x3 and convolve5x5, whose SIMD kernels have 8 bit
+    // fractions.
+    test(toolkit, "gaussian 5x5", outer(gaussian(5, 1.f), gaussian(5, 1.f)), 5, 5, 4);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
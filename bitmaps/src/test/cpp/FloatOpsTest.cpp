@@ -0,0 +1,351 @@
+// Checks the float variants of the ops: the filters against the byte ops or a direct reference,
+// the reductions against sums in double precision with NaN values sprinkled in, for every
+// vector size and a padded restriction.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+using BorderMode = RenderScriptToolkit::BorderMode;
+
+namespace {
+
+constexpr size_t kSizeX = 67;
+constexpr size_t kSizeY = 45;
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", message.c_str());
+    if (!ok) failures++;
+}
+
+std::string describe(const char* op, size_t vectorSize, double maxDiff) {
+    char text[100];
+    snprintf(text, sizeof(text), "%s vectorSize %zu: max diff %g", op, vectorSize, maxDiff);
+    return text;
+}
+
+// Random byte values stored as floats, so that the byte ops see the same image.
+std::vector<float> image(size_t vectorSize, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<float> values(kSizeX * kSizeY * vectorSize);
+    for (auto& value : values) value = (float)distribution(generator);
+    return values;
+}
+
+// The byte ops pad cells of 3 to 4 bytes.
+std::vector<uint8_t> toBytes(const std::vector<float>& values, size_t vectorSize) {
+    const size_t cellSize = vectorSize == 3 ? 4 : vectorSize;
+    const size_t cells = values.size() / vectorSize;
+    std::vector<uint8_t> bytes(cells * cellSize);
+    for (size_t i = 0; i < cells; i++) {
+        for (size_t c = 0; c < vectorSize; c++) {
+            bytes[i * cellSize + c] = (uint8_t)values[i * vectorSize + c];
+        }
+    }
+    return bytes;
+}
+
+double maxDifference(const std::vector<float>& actual, const std::vector<uint8_t>& bytes,
+                     size_t vectorSize, bool skipClamped) {
+    const size_t cellSize = vectorSize == 3 ? 4 : vectorSize;
+    double maxDiff = 0;
+    for (size_t i = 0; i < actual.size() / vectorSize; i++) {
+        for (size_t c = 0; c < vectorSize; c++) {
+            const uint8_t expected = bytes[i * cellSize + c];
+            if (skipClamped && (expected == 0 || expected == 255)) continue;
+            maxDiff = std::max(maxDiff, std::abs(actual[i * vectorSize + c] - (double)expected));
+        }
+    }
+    return maxDiff;
+}
+
+/**
+ * The float blur matches the byte blur up to the rounding of the bytes, for the direct and the
+ * box kernels. A restricted blur of padded buffers matches the full one.
+ */
+void testBlur(RenderScriptToolkit& toolkit) {
+    for (size_t vectorSize = 1; vectorSize <= 4; vectorSize++) {
+        const std::vector<float> in = image(vectorSize, 10 + vectorSize);
+        const std::vector<uint8_t> bytes = toBytes(in, vectorSize);
+        for (int radius : {3, 25, 40}) {
+            std::vector<float> out(in.size());
+            toolkit.blur(in.data(), out.data(), kSizeX, kSizeY, vectorSize, radius);
+            // The byte blur only takes cells of 1 and 4 bytes.
+            if (vectorSize == 1 || vectorSize == 4) {
+                std::vector<uint8_t> byteOut(bytes.size());
+                toolkit.blur(bytes.data(), byteOut.data(), kSizeX, kSizeY, vectorSize, radius);
+                const double diff = maxDifference(out, byteOut, vectorSize, false);
+                check(diff <= 2, describe(("blur " + std::to_string(radius)).c_str(),
+                                          vectorSize, diff));
+            }
+
+            Restriction restriction{9, 50, 3, 40};
+            restriction.inputStride = (kSizeX * vectorSize + 3) * sizeof(float);
+            restriction.outputStride = (kSizeX * vectorSize + 5) * sizeof(float);
+            const size_t inRow = restriction.inputStride / sizeof(float);
+            const size_t outRow = restriction.outputStride / sizeof(float);
+            std::vector<float> paddedIn(inRow * kSizeY);
+            for (size_t y = 0; y < kSizeY; y++) {
+                std::copy_n(&in[y * kSizeX * vectorSize], kSizeX * vectorSize,
+                            &paddedIn[y * inRow]);
+            }
+            std::vector<float> paddedOut(outRow * kSizeY, -1.f);
+            toolkit.blur(paddedIn.data(), paddedOut.data(), kSizeX, kSizeY, vectorSize, radius,
+                         &restriction);
+            int mismatches = 0;
+            for (size_t y = 0; y < kSizeY; y++) {
+                for (size_t i = 0; i < outRow; i++) {
+                    const size_t x = i / vectorSize;
+                    const bool inside = y >= restriction.startY && y < restriction.endY &&
+                                        x >= restriction.startX && x < restriction.endX;
+                    const float want = inside ? out[y * kSizeX * vectorSize + i] : -1.f;
+                    if (std::abs(want - paddedOut[y * outRow + i]) > 1e-3f) mismatches++;
+                }
+            }
+            check(mismatches == 0, "blur " + std::to_string(radius) + " vectorSize " +
+                                           std::to_string(vectorSize) + ": " +
+                                           std::to_string(mismatches) + " restriction mismatches");
+        }
+    }
+}
+
+// The cell the border mode reads for coordinate i, or -1 for a zero.
+int borderIndex(int i, int size, BorderMode mode) {
+    if (i >= 0 && i < size) return i;
+    switch (mode) {
+        case BorderMode::CLAMP:
+            return std::min(std::max(i, 0), size - 1);
+        case BorderMode::MIRROR:
+            while (i < 0 || i >= size) {
+                if (size == 1) return 0;
+                i = i < 0 ? -i : 2 * (size - 1) - i;
+            }
+            return i;
+        case BorderMode::WRAP:
+            return ((i % size) + size) % size;
+        case BorderMode::ZERO:
+            return -1;
+    }
+    return -1;
+}
+
+/**
+ * The float convolution matches a direct convolution in double precision, separable or not,
+ * with sums that aren't clamped.
+ */
+void testConvolve(RenderScriptToolkit& toolkit) {
+    std::vector<float> derivative;
+    for (float c : {1.f, 2.f, 2.f, 1.f}) {
+        for (float r : {-3.f, -2.f, -1.f, 0.f, 1.f, 2.f, 3.f}) derivative.push_back(c * r);
+    }
+    std::vector<float> ring(7 * 7, 0.f);
+    for (int y = 0; y < 7; y++) {
+        for (int x = 0; x < 7; x++) {
+            const float d = std::hypot(x - 3.f, y - 3.f);
+            if (d > 1.5f && d < 3.5f) ring[y * 7 + x] = 0.04f;
+        }
+    }
+    struct Kernel {
+        const char* name;
+        const std::vector<float>& coefficients;
+        int sizeX;
+        int sizeY;
+    };
+    for (const Kernel& kernel : {Kernel{"derivative 7x4", derivative, 7, 4},
+                                 Kernel{"ring 7x7", ring, 7, 7}}) {
+        for (size_t vectorSize = 1; vectorSize <= 4; vectorSize++) {
+            const std::vector<float> in = image(vectorSize, 20 + vectorSize);
+            for (BorderMode mode : {BorderMode::CLAMP, BorderMode::MIRROR, BorderMode::WRAP,
+                                    BorderMode::ZERO}) {
+                std::vector<float> out(in.size());
+                toolkit.convolve(in.data(), out.data(), vectorSize, kSizeX, kSizeY,
+                                 kernel.coefficients.data(), kernel.sizeX, kernel.sizeY, mode);
+                const int centerX = (kernel.sizeX - 1) / 2;
+                const int centerY = (kernel.sizeY - 1) / 2;
+                double maxDiff = 0;
+                for (int y = 0; y < (int)kSizeY; y++) {
+                    for (int x = 0; x < (int)kSizeX; x++) {
+                        for (size_t c = 0; c < vectorSize; c++) {
+                            double sum = 0;
+                            for (int ky = 0; ky < kernel.sizeY; ky++) {
+                                const int inY = borderIndex(y + ky - centerY, kSizeY, mode);
+                                for (int kx = 0; kx < kernel.sizeX; kx++) {
+                                    const int inX = borderIndex(x + kx - centerX, kSizeX, mode);
+                                    if (inX < 0 || inY < 0) continue;
+                                    sum += kernel.coefficients[ky * kernel.sizeX + kx] *
+                                           in[(inY * kSizeX + inX) * vectorSize + c];
+                                }
+                            }
+                            const float actual = out[(y * kSizeX + x) * vectorSize + c];
+                            maxDiff = std::max(maxDiff, std::abs(actual - sum));
+                        }
+                    }
+                }
+                const std::string name =
+                        std::string(kernel.name) + " border " + std::to_string((int)mode);
+                check(maxDiff < 0.01, describe(name.c_str(), vectorSize, maxDiff));
+            }
+        }
+    }
+}
+
+/**
+ * The float resize matches the byte resize where the bytes aren't clamped, up and down.
+ */
+void testResize(RenderScriptToolkit& toolkit) {
+    for (size_t vectorSize = 1; vectorSize <= 4; vectorSize++) {
+        const std::vector<float> in = image(vectorSize, 30 + vectorSize);
+        const std::vector<uint8_t> bytes = toBytes(in, vectorSize);
+        const size_t cellSize = vectorSize == 3 ? 4 : vectorSize;
+        for (auto size : {std::pair<size_t, size_t>{150, 97}, std::pair<size_t, size_t>{31, 20}}) {
+            std::vector<float> out(size.first * size.second * vectorSize);
+            toolkit.resize(in.data(), out.data(), kSizeX, kSizeY, vectorSize, size.first,
+                           size.second);
+            std::vector<uint8_t> byteOut(size.first * size.second * cellSize);
+            toolkit.resize(bytes.data(), byteOut.data(), kSizeX, kSizeY, vectorSize, size.first,
+                           size.second);
+            const double diff = maxDifference(out, byteOut, vectorSize, true);
+            check(diff <= 1, describe(("resize to " + std::to_string(size.first)).c_str(),
+                                      vectorSize, diff));
+        }
+    }
+}
+
+/**
+ * The float color matrix isn't scaled or clamped.
+ */
+void testColorMatrix(RenderScriptToolkit& toolkit) {
+    const float matrix[16] = {0.5f, -1.f, 2.f, 0.f, 0.25f, 1.f, 0.f, 3.f,
+                              -2.f, 0.f, 1.f, 0.5f, 1.f, 1.f, 1.f, 1.f};
+    const float add[4] = {1.f, -2.f, 3.f, -4.f};
+    for (size_t inputVectorSize = 1; inputVectorSize <= 4; inputVectorSize++) {
+        const std::vector<float> in = image(inputVectorSize, 40 + inputVectorSize);
+        for (size_t outputVectorSize = 1; outputVectorSize <= 4; outputVectorSize++) {
+            std::vector<float> out(kSizeX * kSizeY * outputVectorSize);
+            toolkit.colorMatrix(in.data(), out.data(), inputVectorSize, outputVectorSize, kSizeX,
+                                kSizeY, matrix, add);
+            double maxDiff = 0;
+            for (size_t i = 0; i < kSizeX * kSizeY; i++) {
+                for (size_t r = 0; r < outputVectorSize; r++) {
+                    double sum = add[r];
+                    for (size_t c = 0; c < inputVectorSize; c++) {
+                        sum += matrix[c * 4 + r] * in[i * inputVectorSize + c];
+                    }
+                    maxDiff = std::max(maxDiff, std::abs(out[i * outputVectorSize + r] - sum));
+                }
+            }
+            check(maxDiff < 1e-3, describe(("colorMatrix to " +
+                                            std::to_string(outputVectorSize)).c_str(),
+                                           inputVectorSize, maxDiff));
+        }
+    }
+}
+
+/**
+ * The reductions skip the NaN values and treat the channels past the cell as gray, and the
+ * threshold replaces the channel or the gray channels.
+ */
+void testReductions(RenderScriptToolkit& toolkit) {
+    for (size_t vectorSize = 1; vectorSize <= 4; vectorSize++) {
+        std::vector<float> in = image(vectorSize, 50 + vectorSize);
+        for (auto& value : in) value = value / 255.f - 0.25f;
+        for (size_t i = 0; i < in.size(); i += 37) in[i] = NAN;
+        const size_t grayChannels = std::min(vectorSize, (size_t)3);
+        for (uint8_t channel : {0, 1, 2, 3, 4}) {
+            const bool gray = channel >= vectorSize;
+            std::vector<double> values(kSizeX * kSizeY);
+            for (size_t i = 0; i < values.size(); i++) {
+                if (gray) {
+                    double sum = 0;
+                    for (size_t c = 0; c < grayChannels; c++) sum += in[i * vectorSize + c];
+                    values[i] = (float)(sum / grayChannels);
+                } else {
+                    values[i] = in[i * vectorSize + channel];
+                }
+            }
+            double min = INFINITY, max = -INFINITY, sum = 0;
+            size_t count = 0;
+            for (double value : values) {
+                if (std::isnan(value)) continue;
+                min = std::min(min, value);
+                max = std::max(max, value);
+                sum += value;
+                count++;
+            }
+            const double average = sum / count;
+            double squares = 0;
+            for (double value : values) {
+                if (!std::isnan(value)) squares += (value - average) * (value - average);
+            }
+            const double standardDeviation = std::sqrt(squares / count);
+
+            float minMax[2];
+            toolkit.minMax(in.data(), minMax, kSizeX, kSizeY, vectorSize, channel, nullptr);
+            const double actualAverage =
+                    toolkit.average(in.data(), kSizeX, kSizeY, vectorSize, channel, nullptr);
+            const double actualStandardDeviation = toolkit.standardDeviation(
+                    in.data(), kSizeX, kSizeY, vectorSize, channel, average, nullptr);
+            const double diff = std::max({std::abs(minMax[0] - min), std::abs(minMax[1] - max),
+                                          std::abs(actualAverage - average),
+                                          std::abs(actualStandardDeviation - standardDeviation)});
+            check(diff < 1e-4, describe(("reductions of channel " +
+                                         std::to_string(channel)).c_str(),
+                                        vectorSize, diff));
+
+            std::vector<float> out(in.size());
+            toolkit.threshold(in.data(), out.data(), kSizeX, kSizeY, vectorSize, 0.4f, true,
+                              channel, nullptr);
+            int mismatches = 0;
+            for (size_t i = 0; i < values.size(); i++) {
+                const float replacement = values[i] > 0.4f ? 1.f : 0.f;
+                for (size_t c = 0; c < vectorSize; c++) {
+                    const bool replaced = gray ? c < grayChannels : c == channel;
+                    const float want = replaced ? replacement : in[i * vectorSize + c];
+                    const float got = out[i * vectorSize + c];
+                    if (!(want == got || (std::isnan(want) && std::isnan(got)))) mismatches++;
+                }
+            }
+            check(mismatches == 0, "threshold of channel " + std::to_string(channel) +
+                                           " vectorSize " + std::to_string(vectorSize) + ": " +
+                                           std::to_string(mismatches) + " mismatches");
+        }
+    }
+
+    // Only NaN values.
+    std::vector<float> nan(16, NAN);
+    float minMax[2];
+    toolkit.minMax(nan.data(), minMax, 4, 4, 1, 0, nullptr);
+    check(std::isnan(minMax[0]) && std::isnan(minMax[1]) &&
+                  std::isnan(toolkit.average(nan.data(), 4, 4, 1, 0, nullptr)),
+          "reductions of NaN values are NaN");
+}
+
+}  // namespace
+
+int main() {
+    RenderScriptToolkit toolkit;
+    testBlur(toolkit);
+    testConvolve(toolkit);
+    testResize(toolkit);
+    testColorMatrix(toolkit);
+    testReductions(toolkit);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,410 @@
+// Compares interpolateFloatBitmap with a reference that interpolates each pixel on its own, as
+// the original implementation did: bicubic when the 16 pixels around it are inside the input
+// and valid, else bilinear, else the nearest valid pixel found by searching rings of pixels.
+// The inputs have NaN holes in the middle and at the borders, NaN in a single channel, and no
+// valid pixel at all. Also checks nearestValidDistances against a brute force search.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+
+namespace {
+
+constexpr float kUntouched = 7.f;
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", message.c_str());
+    if (!ok) failures++;
+}
+
+struct Image {
+    int width;
+    int height;
+    int channels;
+    std::vector<float> values;
+
+    const float* pixel(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return nullptr;
+        return &values[(y * width + x) * channels];
+    }
+
+    bool valid(int x, int y) const {
+        const float* p = pixel(x, y);
+        if (p == nullptr) return false;
+        for (int c = 0; c < channels; c++) {
+            if (std::isnan(p[c])) return false;
+        }
+        return true;
+    }
+};
+
+float cubicWeight(float t) {
+    float a = std::fabs(t);
+    if (a <= 1.0f) {
+        return 1.0f - 2.5f * a * a + 1.5f * a * a * a;
+    } else if (a <= 2.0f) {
+        return 2.0f - 4.0f * a + 2.5f * a * a - 0.5f * a * a * a;
+    }
+    return 0.0f;
+}
+
+bool bicubic(const Image& image, float fx, float fy, float* result) {
+    int xInt = (int)std::floor(fx);
+    int yInt = (int)std::floor(fy);
+    float fracX = fx - xInt;
+    float fracY = fy - yInt;
+    for (int c = 0; c < image.channels; c++) {
+        float sum = 0.0f;
+        for (int i = 0; i < 4; i++) {
+            float value = 0.0f;
+            for (int j = 0; j < 4; j++) {
+                const float* p = image.pixel(xInt + j - 1, yInt + i - 1);
+                if (p == nullptr || std::isnan(p[c])) return false;
+                value += p[c] * cubicWeight(fracX - (j - 1));
+            }
+            sum += value * cubicWeight(fracY - (i - 1));
+        }
+        result[c] = sum;
+    }
+    return true;
+}
+
+bool bilinear(const Image& image, float fx, float fy, float* result) {
+    int x0 = (int)fx;
+    int y0 = (int)fy;
+    const float* p00 = image.pixel(x0, y0);
+    const float* p10 = image.pixel(x0 + 1, y0);
+    const float* p01 = image.pixel(x0, y0 + 1);
+    const float* p11 = image.pixel(x0 + 1, y0 + 1);
+    if (!p00 || !p10 || !p01 || !p11) return false;
+    float dx = fx - x0;
+    float dy = fy - y0;
+    for (int c = 0; c < image.channels; c++) {
+        if (std::isnan(p00[c]) || std::isnan(p10[c]) || std::isnan(p01[c]) ||
+            std::isnan(p11[c])) {
+            return false;
+        }
+        result[c] = p00[c] * (1.0f - dx) * (1.0f - dy) + p10[c] * dx * (1.0f - dy) +
+                    p01[c] * (1.0f - dx) * dy + p11[c] * dx * dy;
+    }
+    return true;
+}
+
+/**
+ * The valid pixel closest to (fx, fy) on the first ring around the rounded position that has
+ * one, searching every ring out to maxSearchRadius. A ring is scanned along its top and bottom
+ * rows, then its sides, and the first of equally close pixels is kept.
+ */
+bool nearest(const Image& image, float fx, float fy, int maxSearchRadius, float* result) {
+    int xInt = (int)std::round(fx);
+    int yInt = (int)std::round(fy);
+    float best = std::numeric_limits<float>::max();
+    auto process = [&](int x, int y) {
+        if (!image.valid(x, y)) return;
+        float dist = (x - fx) * (x - fx) + (y - fy) * (y - fy);
+        if (dist < best) {
+            best = dist;
+            std::copy_n(image.pixel(x, y), image.channels, result);
+        }
+    };
+    // The rings past the farthest corner of the image have no pixels.
+    const int lastRing = std::max({std::abs(xInt), std::abs(xInt - (image.width - 1)),
+                                   std::abs(yInt), std::abs(yInt - (image.height - 1))});
+    for (int r = 0; r <= std::min(maxSearchRadius, lastRing); r++) {
+        if (r == 0) {
+            process(xInt, yInt);
+        } else {
+            for (int x = xInt - r; x <= xInt + r; x++) {
+                process(x, yInt - r);
+                process(x, yInt + r);
+            }
+            for (int y = yInt - r + 1; y < yInt + r; y++) {
+                process(xInt - r, y);
+                process(xInt + r, y);
+            }
+        }
+        if (best != std::numeric_limits<float>::max()) return true;
+    }
+    return false;
+}
+
+/**
+ * How the reference computed each pixel, to check that the inputs reach every path.
+ */
+enum Path { kBicubic, kBilinear, kNearest, kNone, kPathCount };
+const char* kPathNames[kPathCount] = {"bicubic", "bilinear", "nearest", "none"};
+size_t pathCounts[kPathCount] = {};
+
+/**
+ * The parameters of one call.
+ */
+struct Case {
+    int outputWidth;
+    int outputHeight;
+    float srcStartX;
+    float srcStartY;
+    float srcEndX;
+    float srcEndY;
+    int maxSearchRadius;
+};
+
+std::vector<float> reference(const Image& image, const Case& c) {
+    std::vector<float> out((size_t)c.outputWidth * c.outputHeight * image.channels);
+    for (int y = 0; y < c.outputHeight; y++) {
+        for (int x = 0; x < c.outputWidth; x++) {
+            float fx = c.outputWidth > 1
+                               ? c.srcStartX + (c.srcEndX - c.srcStartX) *
+                                                       ((float)x / (c.outputWidth - 1))
+                               : c.srcStartX;
+            float fy = c.outputHeight > 1
+                               ? c.srcStartY + (c.srcEndY - c.srcStartY) *
+                                                       ((float)y / (c.outputHeight - 1))
+                               : c.srcStartY;
+            float* result = &out[((size_t)y * c.outputWidth + x) * image.channels];
+            Path path = kBicubic;
+            if (!bicubic(image, fx, fy, result)) {
+                path = kBilinear;
+                if (!bilinear(image, fx, fy, result)) {
+                    path = kNearest;
+                    if (!nearest(image, fx, fy, c.maxSearchRadius, result)) {
+                        path = kNone;
+                        std::fill_n(result, image.channels,
+                                    std::numeric_limits<float>::quiet_NaN());
+                    }
+                }
+            }
+            pathCounts[path]++;
+        }
+    }
+    return out;
+}
+
+/**
+ * Whether two results are the same. The bicubic sums may be contracted differently, e.g. into
+ * fused multiply adds, so they're compared with a small tolerance. NaN must match NaN.
+ */
+bool same(float actual, float expected) {
+    if (std::isnan(expected) || std::isnan(actual)) {
+        return std::isnan(expected) && std::isnan(actual);
+    }
+    return std::fabs(actual - expected) <= 1e-5f * std::max(1.0f, std::fabs(expected));
+}
+
+/**
+ * The toolkit's result for the case, with and without distances given by the caller and with
+ * a restriction, compared with the reference. Nothing outside the restriction must be written.
+ */
+void compare(RenderScriptToolkit& toolkit, const std::string& name, const Image& image,
+             const Case& c) {
+    const std::vector<float> expected = reference(image, c);
+    const size_t channels = image.channels;
+    std::vector<int32_t> distances((size_t)image.width * image.height);
+    toolkit.nearestValidDistances(image.values.data(), distances.data(), image.width,
+                                  image.height, channels);
+
+    Restriction restriction{(size_t)c.outputWidth / 4, (size_t)c.outputWidth,
+                            (size_t)c.outputHeight / 3, (size_t)c.outputHeight * 3 / 4 + 1};
+    for (int variant = 0; variant < 3; variant++) {
+        const bool restricted = variant == 2;
+        std::vector<float> actual(expected.size(), kUntouched);
+        toolkit.interpolateFloatBitmap(image.values.data(), actual.data(), image.width,
+                                       image.height, channels, c.outputWidth, c.outputHeight,
+                                       c.srcStartX, c.srcStartY, c.srcEndX, c.srcEndY,
+                                       c.maxSearchRadius,
+                                       variant == 1 ? distances.data() : nullptr,
+                                       restricted ? &restriction : nullptr);
+        size_t mismatches = 0;
+        size_t touchedOutside = 0;
+        for (int y = 0; y < c.outputHeight; y++) {
+            for (int x = 0; x < c.outputWidth; x++) {
+                const bool inside = !restricted ||
+                                    ((size_t)x >= restriction.startX &&
+                                     (size_t)x < restriction.endX &&
+                                     (size_t)y >= restriction.startY &&
+                                     (size_t)y < restriction.endY);
+                for (size_t k = 0; k < channels; k++) {
+                    const size_t i = ((size_t)y * c.outputWidth + x) * channels + k;
+                    if (!inside) {
+                        touchedOutside += actual[i] != kUntouched;
+                    } else if (!same(actual[i], expected[i])) {
+                        if (mismatches++ == 0) {
+                            printf("     first mismatch at (%d, %d) channel %zu: %g, expected "
+                                   "%g\n", x, y, k, actual[i], expected[i]);
+                        }
+                    }
+                }
+            }
+        }
+        char text[200];
+        snprintf(text, sizeof(text),
+                 "%s, %d channel(s) %dx%d -> %dx%d from (%g, %g) to (%g, %g) radius %d%s: "
+                 "%zu values differ, %zu written outside",
+                 name.c_str(), image.channels, image.width, image.height, c.outputWidth,
+                 c.outputHeight, c.srcStartX, c.srcStartY, c.srcEndX, c.srcEndY,
+                 c.maxSearchRadius,
+                 variant == 1 ? ", given distances" : restricted ? ", restricted" : "",
+                 mismatches, touchedOutside);
+        check(mismatches == 0 && touchedOutside == 0, text);
+    }
+}
+
+/**
+ * nearestValidDistances gives, for each pixel, the chessboard distance to the closest valid
+ * one, or INT32_MAX when there's none.
+ */
+void testDistances(RenderScriptToolkit& toolkit, const std::string& name, const Image& image) {
+    std::vector<int32_t> distances((size_t)image.width * image.height);
+    toolkit.nearestValidDistances(image.values.data(), distances.data(), image.width,
+                                  image.height, image.channels);
+    std::vector<std::pair<int, int>> valid;
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            if (image.valid(x, y)) valid.emplace_back(x, y);
+        }
+    }
+    size_t mismatches = 0;
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            int32_t expected = INT32_MAX;
+            for (const auto& p : valid) {
+                expected = std::min(expected,
+                                    std::max(std::abs(p.first - x), std::abs(p.second - y)));
+            }
+            mismatches += distances[(size_t)y * image.width + x] != expected;
+        }
+    }
+    check(mismatches == 0, name + ", " + std::to_string(image.width) + "x" +
+                                   std::to_string(image.height) + " distances: " +
+                                   std::to_string(mismatches) + " differ");
+}
+
+/**
+ * The NaN patterns of the inputs.
+ */
+enum Holes {
+    // No NaN, every inside pixel takes the bicubic fast path.
+    kNoHoles,
+    // A NaN in a single channel of some pixels, so that the 4x4 neighborhoods that have one
+    // fall back although most of their values are valid.
+    kChannelNans,
+    // Rectangles of NaN in the middle and along each border, wider than the reach of the
+    // bilinear fallback so that the nearest pixel is searched several rings away.
+    kBlocks,
+    // A single valid pixel in a corner.
+    kSingleValid,
+    // No valid pixel.
+    kAllNan,
+};
+
+Image createImage(std::mt19937& generator, int width, int height, int channels, Holes holes) {
+    std::uniform_real_distribution<float> distribution(-100.f, 100.f);
+    Image image{width, height, channels, std::vector<float>((size_t)width * height * channels)};
+    for (auto& value : image.values) value = distribution(generator);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    auto fill = [&](int left, int top, int right, int bottom) {
+        for (int y = std::max(0, top); y < std::min(height, bottom); y++) {
+            for (int x = std::max(0, left); x < std::min(width, right); x++) {
+                std::fill_n(&image.values[((size_t)y * width + x) * channels], channels, nan);
+            }
+        }
+    };
+    switch (holes) {
+        case kNoHoles:
+            break;
+        case kChannelNans:
+            for (size_t i = 0; i < image.values.size(); i += 37) {
+                image.values[i] = nan;
+            }
+            break;
+        case kBlocks:
+            fill(width / 3, height / 3, width / 3 + 6, height / 3 + 5);
+            fill(0, 0, 4, height / 2);
+            fill(width - 5, height / 2, width, height);
+            fill(0, 0, width / 2, 3);
+            fill(width / 2, height - 4, width, height);
+            break;
+        case kSingleValid: {
+            std::vector<float> corner(&image.values[0], &image.values[channels]);
+            fill(0, 0, width, height);
+            std::copy(corner.begin(), corner.end(), image.values.begin());
+            break;
+        }
+        case kAllNan:
+            fill(0, 0, width, height);
+            break;
+    }
+    return image;
+}
+
+}  // namespace
+
+int main() {
+    const struct {
+        Holes holes;
+        const char* name;
+    } patterns[] = {{kNoHoles, "no holes"},
+                    {kChannelNans, "NaN channels"},
+                    {kBlocks, "NaN blocks"},
+                    {kSingleValid, "single valid pixel"},
+                    {kAllNan, "all NaN"}};
+    const int sizes[][2] = {{1, 1}, {2, 2}, {3, 5}, {17, 13}, {40, 31}};
+
+    std::mt19937 generator(11);
+    for (unsigned threads : {1u, 3u}) {
+        RenderScriptToolkit toolkit(threads);
+        for (const auto& pattern : patterns) {
+            for (const auto& size : sizes) {
+                const int w = size[0];
+                const int h = size[1];
+                for (int channels = 1; channels <= 4; channels++) {
+                    const Image image = createImage(generator, w, h, channels, pattern.holes);
+                    testDistances(toolkit, pattern.name, image);
+                    const Case cases[] = {
+                            // Upscaling the whole image, with the search limited or not.
+                            {w * 2 + 1, h * 2 + 1, 0.f, 0.f, w - 1.f, h - 1.f, 1000},
+                            {w * 2 + 1, h * 2 + 1, 0.f, 0.f, w - 1.f, h - 1.f, 2},
+                            // Only the closest pixel, and no nearest neighbor fallback.
+                            {w + 3, h + 2, 0.f, 0.f, w - 1.f, h - 1.f, 0},
+                            {w + 3, h + 2, 0.f, 0.f, w - 1.f, h - 1.f, -1},
+                            // Downscaling part of the image.
+                            {std::max(1, w / 2), std::max(1, h / 3), 0.5f, 1.25f, w * 0.7f,
+                             h * 0.8f, 1000},
+                            // Reaching past the borders, where the taps are outside.
+                            {w + 6, h + 4, -2.5f, -1.75f, w + 1.5f, h + 2.25f, 1000},
+                            // A single output pixel.
+                            {1, 1, w / 2.f, h / 2.f, w / 2.f, h / 2.f, 1000},
+                    };
+                    for (const Case& c : cases) {
+                        compare(toolkit, pattern.name, image, c);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int path = 0; path < kPathCount; path++) {
+        check(pathCounts[path] > 0, std::string(kPathNames[path]) + " path taken " +
+                                            std::to_string(pathCounts[path]) + " times");
+    }
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+// Checks that a pipeline gives the same image and histogram as calling the methods of its stages
+// one after the other, for every sequence of up to 4 stages, with and without a restriction. The
+// longer sequences go through both of the intermediate buffers of the pipeline more than once.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+using Stage = RenderScriptToolkit::PipelineStage;
+
+namespace {
+
+// Odd sizes, so that the tiles and the SIMD blocks don't line up with the image.
+constexpr size_t kSizeX = 93;
+constexpr size_t kSizeY = 61;
+constexpr uint8_t kUntouched = 0x5A;
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    if (!ok) {
+        printf("FAIL %s\n", message.c_str());
+        failures++;
+    }
+}
+
+const float kMatrix[16] = {0.6f, 0.2f,  0.1f, 0.f, 0.3f, 0.7f, 0.1f, 0.f,
+                           0.1f, 0.1f, 0.8f, 0.f, 0.f,  0.f,  0.f,  1.f};
+const float kAddVector[4] = {8.f, -4.f, 2.f, 0.f};
+const float kConvolve3x3[9] = {0.05f, 0.1f, 0.05f, 0.1f, 0.4f, 0.1f, 0.05f, 0.1f, 0.05f};
+float convolve5x5[25];
+uint8_t tables[4][256];
+
+/**
+ * The stages of the pipeline and how to run each of them alone.
+ */
+struct StageCase {
+    const char* name;
+    Stage stage;
+    bool convolution;
+    void (*run)(RenderScriptToolkit& toolkit, const uint8_t* in, uint8_t* out);
+};
+
+std::vector<StageCase> stageCases() {
+    for (int i = 0; i < 25; i++) {
+        convolve5x5[i] = (i % 5 == 2 || i / 5 == 2) ? 0.1f : 0.0125f;
+    }
+    for (int i = 0; i < 256; i++) {
+        // Smooth curves, so that a rounding difference in a previous stage stays small.
+        tables[0][i] = (uint8_t)(255.0 * std::sqrt(i / 255.0) + 0.5);
+        tables[1][i] = (uint8_t)(255 - i);
+        tables[2][i] = (uint8_t)(i / 2 + 64);
+        tables[3][i] = (uint8_t)i;
+    }
+    return {
+            {"colorMatrix", Stage::colorMatrix(kMatrix, kAddVector), false,
+             [](RenderScriptToolkit& t, const uint8_t* in, uint8_t* out) {
+                 t.colorMatrix(in, out, 4, 4, kSizeX, kSizeY, kMatrix, kAddVector);
+             }},
+            {"convolve3x3", Stage::convolve3x3(kConvolve3x3), true,
+             [](RenderScriptToolkit& t, const uint8_t* in, uint8_t* out) {
+                 t.convolve3x3(in, out, 4, kSizeX, kSizeY, kConvolve3x3);
+             }},
+            {"convolve5x5", Stage::convolve5x5(convolve5x5), true,
+             [](RenderScriptToolkit& t, const uint8_t* in, uint8_t* out) {
+                 t.convolve5x5(in, out, 4, kSizeX, kSizeY, convolve5x5);
+             }},
+            {"lut", Stage::lut(tables[0], tables[1], tables[2], tables[3]), false,
+             [](RenderScriptToolkit& t, const uint8_t* in, uint8_t* out) {
+                 t.lut(in, out, kSizeX, kSizeY, tables[0], tables[1], tables[2], tables[3]);
+             }},
+            // Not binary, so that a rounding difference before it doesn't flip a pixel.
+            {"threshold", Stage::threshold(0.5f, false, 4), false,
+             [](RenderScriptToolkit& t, const uint8_t* in, uint8_t* out) {
+                 t.threshold(in, out, kSizeX, kSizeY, 0.5f, false, 4, nullptr);
+             }},
+    };
+}
+
+/**
+ * Runs the stages of the sequence through the pipeline and one after the other, and compares
+ * the images and the histograms, inside the restriction when there's one. Without convolutions
+ * the results must be identical. The convolutions round the columns they compute with scalar
+ * code differently from the SIMD ones, and the tiles of the pipeline and of the unfused calls
+ * split the rows at different places, so a few values may be off by up to 2 there.
+ */
+void compare(RenderScriptToolkit& toolkit, const std::vector<uint8_t>& input,
+             const std::vector<const StageCase*>& sequence, const Restriction* restriction) {
+    std::string name;
+    std::vector<Stage> stages;
+    bool exact = true;
+    for (const StageCase* stageCase : sequence) {
+        exact = exact && !stageCase->convolution;
+        name += name.empty() ? "" : ", ";
+        name += stageCase->name;
+        stages.push_back(stageCase->stage);
+    }
+    name += restriction != nullptr ? " (restricted)" : "";
+
+    // The unfused calls run on the whole image, since the convolutions of the pipeline read
+    // the neighbors of the restriction from the previous stages too.
+    std::vector<uint8_t> expected = input;
+    std::vector<uint8_t> next(input.size());
+    for (const StageCase* stageCase : sequence) {
+        stageCase->run(toolkit, expected.data(), next.data());
+        expected.swap(next);
+    }
+
+    std::vector<uint8_t> actual(input.size(), kUntouched);
+    std::vector<int32_t> histogram(256 * 4);
+    toolkit.pipeline(input.data(), actual.data(), kSizeX, kSizeY, stages.data(), stages.size(),
+                     histogram.data(), restriction);
+
+    const size_t startX = restriction ? restriction->startX : 0;
+    const size_t endX = restriction ? restriction->endX : kSizeX;
+    const size_t startY = restriction ? restriction->startY : 0;
+    const size_t endY = restriction ? restriction->endY : kSizeY;
+    std::vector<int32_t> expectedHistogram(256 * 4);
+    int maxDiff = 0;
+    size_t differences = 0;
+    size_t touchedOutside = 0;
+    for (size_t y = 0; y < kSizeY; y++) {
+        for (size_t x = 0; x < kSizeX; x++) {
+            const bool inside = x >= startX && x < endX && y >= startY && y < endY;
+            for (size_t c = 0; c < 4; c++) {
+                const size_t i = (y * kSizeX + x) * 4 + c;
+                if (!inside) {
+                    touchedOutside += actual[i] != kUntouched;
+                    continue;
+                }
+                const int diff = std::abs(actual[i] - expected[i]);
+                maxDiff = std::max(maxDiff, diff);
+                differences += diff != 0;
+                expectedHistogram[expected[i] * 4 + c]++;
+            }
+        }
+    }
+    // The histogram of the fused result itself, since its values may differ slightly.
+    std::vector<int32_t> actualHistogram(256 * 4);
+    for (size_t y = startY; y < endY; y++) {
+        for (size_t x = startX; x < endX; x++) {
+            for (size_t c = 0; c < 4; c++) {
+                actualHistogram[actual[(y * kSizeX + x) * 4 + c] * 4 + c]++;
+            }
+        }
+    }
+
+    const size_t values = (endX - startX) * (endY - startY) * 4;
+    const bool close = exact ? differences == 0 : maxDiff <= 2 && differences * 20 <= values;
+    check(close,
+          name + ": max diff " + std::to_string(maxDiff) + ", " + std::to_string(differences) +
+                  " of " + std::to_string(values) + " values differ");
+    check(touchedOutside == 0,
+          name + ": " + std::to_string(touchedOutside) + " values written outside");
+    check(histogram == actualHistogram, name + ": histogram differs from the image");
+    if (maxDiff == 0) {
+        check(histogram == expectedHistogram, name + ": histogram differs from the unfused one");
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<uint8_t> input(kSizeX * kSizeY * 4);
+    for (auto& value : input) value = (uint8_t)distribution(generator);
+
+    const std::vector<StageCase> cases = stageCases();
+    // Touches the left and top borders, so that the margins are clamped there.
+    Restriction restriction{0, 71, 9, kSizeY};
+    size_t sequences = 0;
+    RenderScriptToolkit toolkit;
+    for (size_t length = 1; length <= 4; length++) {
+        std::vector<size_t> indices(length, 0);
+        while (true) {
+            std::vector<const StageCase*> sequence;
+            for (size_t index : indices) sequence.push_back(&cases[index]);
+            compare(toolkit, input, sequence, nullptr);
+            compare(toolkit, input, sequence, &restriction);
+            sequences++;
+
+            size_t digit = 0;
+            while (digit < length && ++indices[digit] == cases.size()) {
+                indices[digit++] = 0;
+            }
+            if (digit == length) break;
+        }
+    }
+
+    printf("%zu sequences compared\n", sequences);
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
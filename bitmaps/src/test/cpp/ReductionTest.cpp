@@ -0,0 +1,102 @@
+// Checks the byte reductions against sums in double precision, on images wide enough to fill the
+// runs of kMaxCellsPerReductionRun cells with saturated values, where the integer sums of a run
+// are the largest.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+using Statistic = RenderScriptToolkit::Statistic;
+
+namespace {
+
+// More than two full runs per row, and a partial one.
+constexpr size_t kSizeX = 2048 * 2 + 300;
+constexpr size_t kSizeY = 6;
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", message.c_str());
+    if (!ok) failures++;
+}
+
+std::string describe(const char* image, uint8_t channel, const char* op, double maxDiff) {
+    char text[120];
+    snprintf(text, sizeof(text), "%s channel %d %s: max diff %g", image, channel, op, maxDiff);
+    return text;
+}
+
+/**
+ * The average, the standard deviation and the statistics match references in double precision,
+ * for each channel and gray.
+ */
+void testImage(RenderScriptToolkit& toolkit, const char* name, const std::vector<uint8_t>& in) {
+    for (uint8_t channel : {0, 1, 2, 3, 4}) {
+        std::vector<double> values(kSizeX * kSizeY);
+        for (size_t i = 0; i < values.size(); i++) {
+            const uint8_t* cell = &in[i * 4];
+            values[i] = channel <= 3 ? cell[channel] : (cell[0] + cell[1] + cell[2]) / 3.0;
+        }
+        double sum = 0;
+        for (double value : values) sum += value;
+        const double average = sum / values.size();
+        double squares = 0;
+        for (double value : values) squares += (value - average) * (value - average);
+        const double standardDeviation = std::sqrt(squares / values.size());
+
+        const double actualAverage = toolkit.average(in.data(), kSizeX, kSizeY, channel, nullptr);
+        const double actualStandardDeviation = toolkit.standardDeviation(
+                in.data(), kSizeX, kSizeY, channel, average, nullptr);
+        double diff = std::max(std::abs(actualAverage - average),
+                               std::abs(actualStandardDeviation - standardDeviation));
+        check(diff < 1e-6, describe(name, channel, "average and standardDeviation", diff));
+
+        double output[6] = {};
+        toolkit.statistics(in.data(), output, nullptr, kSizeX, kSizeY, channel,
+                           (uint32_t)Statistic::AVERAGE |
+                                   (uint32_t)Statistic::STANDARD_DEVIATION,
+                           nullptr);
+        diff = std::max(std::abs(output[2] - average), std::abs(output[3] - standardDeviation));
+        check(diff < 1e-6, describe(name, channel, "statistics", diff));
+    }
+}
+
+}  // namespace
+
+int main() {
+    RenderScriptToolkit toolkit;
+    std::vector<uint8_t> in(kSizeX * kSizeY * 4);
+
+    std::fill(in.begin(), in.end(), 255);
+    testImage(toolkit, "saturated", in);
+
+    // Close to saturation, so that the standard deviation isn't 0.
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<int> distribution(240, 255);
+    for (auto& value : in) value = (uint8_t)distribution(generator);
+    testImage(toolkit, "nearly saturated", in);
+
+    // Alternating 0 and 255, the largest standard deviation.
+    for (size_t i = 0; i < kSizeX * kSizeY; i++) {
+        std::fill(&in[i * 4], &in[i * 4 + 4], (i + i / kSizeX) % 2 == 0 ? 0 : 255);
+    }
+    testImage(toolkit, "alternating", in);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
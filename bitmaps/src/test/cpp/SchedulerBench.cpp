@@ -0,0 +1,111 @@
+// Measures the overhead of the TaskProcessor scheduler, i.e. the time spent handing out tiles
+// and waking up the pool, rather than the time of any particular op.
+//
+// Usage:
+//    scheduler_bench [--size 256x256] [--threads 8] [--iterations 2000]
+//
+// Runs a light per pixel task, where the scheduling cost is a large part of the total, and an
+// empty one, where it's all of it. Prints the median time of one doTask call. Compare the
+// results of two builds to evaluate a scheduler change.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "TaskProcessor.h"
+
+using namespace renderscript;
+
+namespace {
+
+class InvertTask : public Task {
+    const uint8_t* mIn;
+    uint8_t* mOut;
+    void processData(int /*threadIndex*/, size_t startX, size_t startY, size_t endX,
+                     size_t endY) override {
+        for (size_t y = startY; y < endY; y++) {
+            size_t offset = (y * mSizeX + startX) * 4;
+            size_t end = (y * mSizeX + endX) * 4;
+            for (; offset < end; offset++) {
+                mOut[offset] = 255 - mIn[offset];
+            }
+        }
+    }
+
+   public:
+    InvertTask(const uint8_t* in, uint8_t* out, size_t sizeX, size_t sizeY)
+        : Task{sizeX, sizeY, 4, true, nullptr}, mIn{in}, mOut{out} {}
+};
+
+class EmptyTask : public Task {
+    void processData(int /*threadIndex*/, size_t /*startX*/, size_t /*startY*/, size_t /*endX*/,
+                     size_t /*endY*/) override {}
+
+   public:
+    EmptyTask(size_t sizeX, size_t sizeY) : Task{sizeX, sizeY, 4, true, nullptr} {}
+};
+
+template <typename MakeTask>
+double medianMicroseconds(TaskProcessor& processor, int iterations, MakeTask makeTask) {
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++) {
+        auto task = makeTask();
+        auto start = std::chrono::steady_clock::now();
+        processor.doTask(&task);
+        auto end = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        samples.push_back(elapsed.count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t sizeX = 256;
+    size_t sizeY = 256;
+    unsigned int threads = 8;
+    int iterations = 2000;
+
+    for (int i = 1; i < argc; i += 2) {
+        std::string arg = argv[i];
+        bool valid = i + 1 < argc;
+        if (valid && arg == "--size") {
+            valid = sscanf(argv[i + 1], "%zux%zu", &sizeX, &sizeY) == 2;
+        } else if (valid && arg == "--threads") {
+            threads = std::max(1, std::stoi(argv[i + 1]));
+        } else if (valid && arg == "--iterations") {
+            iterations = std::max(1, std::stoi(argv[i + 1]));
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            fprintf(stderr, "Usage: %s [--size WxH] [--threads N] [--iterations N]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<uint8_t> in(sizeX * sizeY * 4, 100);
+    std::vector<uint8_t> out(sizeX * sizeY * 4);
+    TaskProcessor processor(threads);
+    EmptyTask tiling(sizeX, sizeY);
+    int tiles = tiling.setTiling(TaskProcessor::kDefaultTilingTarget);
+
+    // Warm up so that the pool threads are all started.
+    medianMicroseconds(processor, 10, [&] { return EmptyTask(sizeX, sizeY); });
+    double invert = medianMicroseconds(processor, iterations, [&] {
+        return InvertTask(in.data(), out.data(), sizeX, sizeY);
+    });
+    double empty = medianMicroseconds(processor, iterations,
+                                      [&] { return EmptyTask(sizeX, sizeY); });
+
+    printf("%zux%zu, %u threads, %d tiles\n", sizeX, sizeY, threads, tiles);
+    printf("%-8s %12.2f us\n", "invert", invert);
+    printf("%-8s %12.2f us\n", "empty", empty);
+    return EXIT_SUCCESS;
+}
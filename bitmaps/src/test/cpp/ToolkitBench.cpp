@@ -0,0 +1,340 @@
+// Times every public RenderScriptToolkit method on the host, so the hot paths can be profiled
+// without a device.
+//
+// Usage:
+//    toolkit_bench [--sizes 640x480,1920x1080] [--threads 1,8] [--iterations 10] [--ops blur,lut]
+//
+// For each op, size and thread count, prints the median time of one call and the throughput
+// in megapixels per second of input.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+
+namespace {
+
+struct Size {
+    size_t x;
+    size_t y;
+};
+
+/**
+ * The buffers shared by all the ops for one image size. Each op reads and writes only the parts
+ * it needs. The outputs are large enough for the 2x upscales.
+ */
+struct Buffers {
+    size_t sizeX;
+    size_t sizeY;
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> rgba2;
+    std::vector<uint8_t> alpha;
+    std::vector<uint8_t> yuv;
+    std::vector<uint8_t> out;
+    std::vector<float> floats;
+    std::vector<float> floatOut;
+    std::vector<int32_t> histogram;
+    std::vector<int> blobs;
+    std::vector<float> glcm;
+    std::vector<int32_t> distances;
+    std::vector<uint8_t> cube;
+    std::vector<uint8_t> lut;
+
+    Buffers(size_t x, size_t y) : sizeX{x}, sizeY{y} {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> distribution(0, 255);
+        auto fill = [&](std::vector<uint8_t>& data, size_t count) {
+            data.resize(count);
+            for (auto& value : data) value = (uint8_t)distribution(generator);
+        };
+        fill(rgba, x * y * 4);
+        fill(rgba2, x * y * 4);
+        fill(alpha, x * y);
+        fill(yuv, x * y * 3 / 2);
+        fill(cube, 16 * 16 * 16 * 4);
+        fill(lut, 256);
+        // Large enough for xbr at 4x.
+        out.resize(x * y * 4 * 16);
+        floats.resize(x * y * 4);
+        for (auto& value : floats) value = (float)distribution(generator);
+        floatOut.resize(x * y * 4 * 4);
+        histogram.resize(256 * 4);
+        blobs.resize(32 * 4);
+        glcm.resize(256 * 256);
+        distances.resize(x * y);
+    }
+};
+
+struct Op {
+    const char* name;
+    std::function<void(RenderScriptToolkit&, Buffers&)> run;
+};
+
+const float kConvolve3x3[9] = {0.f, -1.f, 0.f, -1.f, 5.f, -1.f, 0.f, -1.f, 0.f};
+const float kConvolve5x5[25] = {1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25,
+                                1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25,
+                                1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25,
+                                1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25,
+                                1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25, 1.f / 25};
+// A separable 15x15 Gaussian and a 7x7 kernel that isn't separable, for the NxM convolve.
+const std::vector<float> kGaussian15x15 = [] {
+    std::vector<float> row(15);
+    float total = 0.f;
+    for (int i = 0; i < 15; i++) total += row[i] = std::exp(-(i - 7) * (i - 7) / 18.f);
+    std::vector<float> kernel;
+    for (float y : row) {
+        for (float x : row) kernel.push_back(y * x / (total * total));
+    }
+    return kernel;
+}();
+const std::vector<float> kRing7x7 = [] {
+    std::vector<float> kernel(49);
+    for (int i = 0; i < 49; i++) kernel[i] = (i % 7 == 0 || i % 7 == 6 || i < 7 || i >= 42) / 24.f;
+    return kernel;
+}();
+const float kGreyscale[16] = {0.299f, 0.299f, 0.299f, 0.f, 0.587f, 0.587f, 0.587f, 0.f,
+                              0.114f, 0.114f, 0.114f, 0.f, 0.f, 0.f, 0.f, 1.f};
+const int kGlcmSteps[8] = {1, 0, 1, 1, 0, 1, -1, 1};
+
+std::vector<Op> allOps() {
+    return {
+            {"blend", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blend(RenderScriptToolkit::BlendingMode::SRC_OVER, b.rgba.data(), b.out.data(),
+                         b.sizeX, b.sizeY);
+             }},
+            {"blur", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4, 10);
+             }},
+            {"blur_alpha", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.alpha.data(), b.out.data(), b.sizeX, b.sizeY, 1, 10);
+             }},
+            // The largest radius of the direct kernel, and two of the stacked box blurs whose
+            // times should not depend on the radius.
+            {"blur_r25", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4, 25);
+             }},
+            {"blur_r50", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4, 50);
+             }},
+            {"blur_r200", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4, 200);
+             }},
+            {"blur_alpha_r200", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.blur(b.alpha.data(), b.out.data(), b.sizeX, b.sizeY, 1, 200);
+             }},
+            {"colorMatrix", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.colorMatrix(b.rgba.data(), b.out.data(), 4, 4, b.sizeX, b.sizeY, kGreyscale);
+             }},
+            {"convolve3x3", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.convolve3x3(b.rgba.data(), b.out.data(), 4, b.sizeX, b.sizeY, kConvolve3x3);
+             }},
+            {"convolve5x5", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.convolve5x5(b.rgba.data(), b.out.data(), 4, b.sizeX, b.sizeY, kConvolve5x5);
+             }},
+            {"convolve15x15", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.convolve(b.rgba.data(), b.out.data(), 4, b.sizeX, b.sizeY,
+                            kGaussian15x15.data(), 15, 15);
+             }},
+            {"convolve7x7", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.convolve(b.rgba.data(), b.out.data(), 4, b.sizeX, b.sizeY, kRing7x7.data(), 7,
+                            7);
+             }},
+            {"histogram", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.histogram(b.rgba.data(), b.histogram.data(), b.sizeX, b.sizeY, 4);
+             }},
+            {"histogramDot", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.histogramDot(b.rgba.data(), b.histogram.data(), b.sizeX, b.sizeY, 4, nullptr);
+             }},
+            {"lut", [](RenderScriptToolkit& t, Buffers& b) {
+                 const uint8_t* l = b.lut.data();
+                 t.lut(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, l, l, l, l);
+             }},
+            {"lut3d", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.lut3d(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, b.cube.data(), 16, 16, 16);
+             }},
+            {"resize", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.resize(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4, b.sizeX / 2,
+                          b.sizeY / 2);
+             }},
+            {"threshold", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.threshold(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 128.f, true, 4,
+                             nullptr);
+             }},
+            {"weightedAdd", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.weightedAdd(b.rgba.data(), b.rgba2.data(), b.out.data(), b.sizeX, b.sizeY,
+                               0.5f, 0.5f, false, nullptr);
+             }},
+            {"minMax", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.minMax(b.rgba.data(), b.floatOut.data(), b.sizeX, b.sizeY, 4, nullptr);
+             }},
+            {"average", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.average(b.rgba.data(), b.sizeX, b.sizeY, 4, nullptr);
+             }},
+            {"standardDeviation", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.standardDeviation(b.rgba.data(), b.sizeX, b.sizeY, 4, 127.5, nullptr);
+             }},
+            {"moment", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.moment(b.rgba.data(), b.floatOut.data(), b.sizeX, b.sizeY, 4, nullptr);
+             }},
+            {"statistics", [](RenderScriptToolkit& t, Buffers& b) {
+                 double output[6];
+                 t.statistics(b.rgba.data(), output, b.histogram.data(), b.sizeX, b.sizeY, 4, 0x1f,
+                              nullptr);
+             }},
+            {"findBlobs", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.findBlobs(b.rgba.data(), b.blobs.data(), nullptr, b.blobs.size() / 4, b.sizeX,
+                             b.sizeY, 250.f, 4, nullptr);
+             }},
+            {"glcm", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.glcm(b.rgba.data(), b.glcm.data(), b.sizeX, b.sizeY, 16, 4, true, true, false,
+                        kGlcmSteps, 4, nullptr);
+             }},
+            {"colorReplace", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.colorReplace(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 255, 0, 0, 255, 0,
+                                0, 255, 255, 0.2f, true);
+             }},
+            {"xbr2x", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.xbr2x(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY);
+             }},
+            {"xbr4x", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.xbr(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, 4);
+             }},
+            {"interpolateFloatBitmap", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.interpolateFloatBitmap(b.floats.data(), b.floatOut.data(), b.sizeX, b.sizeY, 1,
+                                          b.sizeX * 2, b.sizeY * 2, 0.f, 0.f, (float)b.sizeX - 1,
+                                          (float)b.sizeY - 1, 0);
+             }},
+            {"nearestValidDistances", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.nearestValidDistances(b.floats.data(), b.distances.data(), b.sizeX, b.sizeY, 1);
+             }},
+            {"pipeline", [](RenderScriptToolkit& t, Buffers& b) {
+                 const uint8_t* l = b.lut.data();
+                 const RenderScriptToolkit::PipelineStage stages[] = {
+                         RenderScriptToolkit::PipelineStage::colorMatrix(kGreyscale, nullptr),
+                         RenderScriptToolkit::PipelineStage::convolve3x3(kConvolve3x3),
+                         RenderScriptToolkit::PipelineStage::lut(l, l, l, l),
+                         RenderScriptToolkit::PipelineStage::threshold(128.f, true, 4)};
+                 t.pipeline(b.rgba.data(), b.out.data(), b.sizeX, b.sizeY, stages, 4);
+             }},
+            {"pipeline_unfused", [](RenderScriptToolkit& t, Buffers& b) {
+                 // The same work as "pipeline", as separate calls.
+                 const uint8_t* l = b.lut.data();
+                 uint8_t* temp = b.out.data() + b.sizeX * b.sizeY * 4;
+                 t.colorMatrix(b.rgba.data(), b.out.data(), 4, 4, b.sizeX, b.sizeY, kGreyscale);
+                 t.convolve3x3(b.out.data(), temp, 4, b.sizeX, b.sizeY, kConvolve3x3);
+                 t.lut(temp, b.out.data(), b.sizeX, b.sizeY, l, l, l, l);
+                 t.threshold(b.out.data(), temp, b.sizeX, b.sizeY, 128.f, true, 4, nullptr);
+             }},
+            {"yuvToRgb", [](RenderScriptToolkit& t, Buffers& b) {
+                 t.yuvToRgb(b.yuv.data(), b.out.data(), b.sizeX, b.sizeY,
+                            RenderScriptToolkit::YuvFormat::NV21);
+             }},
+    };
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--sizes WxH,...] [--threads N,...] [--iterations N] [--ops name,...]\n",
+            program);
+    fprintf(stderr, "Ops:");
+    for (const auto& op : allOps()) fprintf(stderr, " %s", op.name);
+    fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<Size> sizes = {{640, 480}, {1920, 1080}};
+    std::vector<int> threads = {1, (int)std::max(1u, std::thread::hardware_concurrency())};
+    int iterations = 10;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            sizes.clear();
+            for (const auto& size : split(value, ',')) {
+                auto dims = split(size, 'x');
+                if (dims.size() != 2) {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                // yuvToRgb only supports even dimensions.
+                sizes.push_back({std::stoul(dims[0]) & ~1ul, std::stoul(dims[1]) & ~1ul});
+            }
+        } else if (arg == "--threads") {
+            threads.clear();
+            for (const auto& count : split(value, ',')) threads.push_back(std::stoi(count));
+        } else if (arg == "--iterations") {
+            iterations = std::max(1, std::stoi(value));
+        } else if (arg == "--ops") {
+            selected = split(value, ',');
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Op> ops;
+    for (auto& op : allOps()) {
+        if (selected.empty() ||
+            std::find(selected.begin(), selected.end(), op.name) != selected.end()) {
+            ops.push_back(op);
+        }
+    }
+
+    printf("%-24s %12s %8s %12s %12s\n", "op", "size", "threads", "median ms", "MP/s");
+    for (int threadCount : threads) {
+        RenderScriptToolkit toolkit(threadCount);
+        for (const auto& size : sizes) {
+            Buffers buffers(size.x, size.y);
+            std::string sizeName = std::to_string(size.x) + "x" + std::to_string(size.y);
+            for (const auto& op : ops) {
+                // Warm up once so that one time allocations don't skew the first sample.
+                op.run(toolkit, buffers);
+                std::vector<double> samples;
+                for (int i = 0; i < iterations; i++) {
+                    auto start = std::chrono::steady_clock::now();
+                    op.run(toolkit, buffers);
+                    auto end = std::chrono::steady_clock::now();
+                    std::chrono::duration<double, std::milli> elapsed = end - start;
+                    samples.push_back(elapsed.count());
+                }
+                std::sort(samples.begin(), samples.end());
+                double median = samples[samples.size() / 2];
+                double megapixels = (double)(size.x * size.y) / 1e6;
+                printf("%-24s %12s %8d %12.3f %12.1f\n", op.name, sizeName.c_str(), threadCount,
+                       median, megapixels / (median / 1000.0));
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,487 @@
+// Checks that the SSSE3 kernels in x86.cpp produce the same results as the scalar paths of the
+// toolkit. The scalar references below mirror the per cell code of the corresponding Task.
+//
+// Run on any x86/x86_64 Linux host:
+//    cmake -S bitmaps/src/test/cpp -B build && cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace renderscript {
+
+extern "C" void rsdIntrinsicConvolve3x3_K(void* dst, const void* y0, const void* y1,
+                                          const void* y2, const short* coef, uint32_t count);
+extern "C" void rsdIntrinsicConvolve5x5_K(void* dst, const void* y0, const void* y1,
+                                          const void* y2, const void* y3, const void* y4,
+                                          const short* coef, uint32_t count);
+extern void rsdIntrinsicColorMatrix4x4_K(void* dst, const void* src, const short* coef,
+                                         uint32_t count);
+extern void rsdIntrinsicColorMatrix3x3_K(void* dst, const void* src, const short* coef,
+                                         uint32_t count);
+extern void rsdIntrinsicColorMatrixDot_K(void* dst, const void* src, const short* coef,
+                                         uint32_t count);
+extern void rsdIntrinsicBlurVFU4_K(void* dst, const void* pin, int stride, const void* gptr,
+                                   int rct, int x1, int x2);
+extern void rsdIntrinsicBlurHFU4_K(void* dst, const void* pin, const void* gptr, int rct, int x1,
+                                   int x2);
+extern void rsdIntrinsicBlurHFU1_K(void* dst, const void* pin, const void* gptr, int rct, int x1,
+                                   int x2);
+extern void rsdIntrinsicYuv_K(void* dst, const unsigned char* pY, const unsigned char* pUV,
+                              uint32_t count, const short* param);
+extern void rsdIntrinsicYuvR_K(void* dst, const unsigned char* pY, const unsigned char* pUV,
+                               uint32_t count, const short* param);
+extern void rsdIntrinsicYuv2_K(void* dst, const unsigned char* pY, const unsigned char* pU,
+                               const unsigned char* pV, uint32_t count, const short* param);
+extern void rsdIntrinsicBlendSrcOver_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendDstOver_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendSrcIn_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendDstIn_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendSrcOut_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendDstOut_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendSrcAtop_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendDstAtop_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendXor_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendMultiply_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendAdd_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicBlendSub_K(void* dst, const void* src, uint32_t count8);
+extern void rsdIntrinsicReduce_K(void* sums, const void* in, uint32_t channel, uint32_t count4);
+
+}  // namespace renderscript
+
+using namespace renderscript;
+
+namespace {
+
+int failures = 0;
+
+/**
+ * Compares two byte buffers, allowing each value to differ by up to tolerance.
+ */
+void expectClose(const std::string& name, const uint8_t* expected, const uint8_t* actual,
+                 size_t count, int tolerance) {
+    int maxDiff = 0;
+    size_t firstBad = count;
+    for (size_t i = 0; i < count; i++) {
+        int diff = std::abs((int)expected[i] - (int)actual[i]);
+        if (diff > tolerance && firstBad == count) {
+            firstBad = i;
+        }
+        maxDiff = std::max(maxDiff, diff);
+    }
+    if (firstBad != count) {
+        printf("FAIL %s: index %zu expected %d got %d (max diff %d, tolerance %d)\n",
+               name.c_str(), firstBad, expected[firstBad], actual[firstBad], maxDiff, tolerance);
+        failures++;
+    } else {
+        printf("ok   %s (max diff %d)\n", name.c_str(), maxDiff);
+    }
+}
+
+void expectClose(const std::string& name, const float* expected, const float* actual,
+                 size_t count, float tolerance) {
+    for (size_t i = 0; i < count; i++) {
+        if (std::fabs(expected[i] - actual[i]) > tolerance) {
+            printf("FAIL %s: index %zu expected %f got %f\n", name.c_str(), i, expected[i],
+                   actual[i]);
+            failures++;
+            return;
+        }
+    }
+    printf("ok   %s\n", name.c_str());
+}
+
+std::vector<uint8_t> randomBytes(size_t count, uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> distribution(0, 255);
+    std::vector<uint8_t> data(count);
+    for (auto& value : data) {
+        value = (uint8_t)distribution(generator);
+    }
+    return data;
+}
+
+// Same rounding as the Convolve3x3Task and Convolve5x5Task constructors.
+int16_t toFixedPoint(float coefficient) {
+    return coefficient >= 0 ? (int16_t)(coefficient * 256.f + 0.5f)
+                            : (int16_t)(coefficient * 256.f - 0.5f);
+}
+
+/**
+ * The SIMD kernels work with 8.8 fixed point coefficients while the scalar paths use floats.
+ * Returns how far apart that can put the two results, plus one for the final rounding.
+ */
+int quantizationTolerance(const float* coefficients, const int16_t* fixedPoint, int count) {
+    float error = 0;
+    for (int i = 0; i < count; i++) {
+        error += std::fabs(coefficients[i] - fixedPoint[i] / 256.f) * 255.f;
+    }
+    return (int)std::ceil(error) + 1;
+}
+
+uint8_t clampToByte(float value) {
+    return (uint8_t)std::min(std::max(value, 0.f), 255.f);
+}
+
+void testConvolve3x3() {
+    const int sizeX = 67;
+    const float coefficients[9] = {0.1f, 0.2f, 0.05f, -0.1f, 0.5f, 0.1f, 0.05f, 0.05f, 0.05f};
+    int16_t ip[16] = {};
+    for (int i = 0; i < 9; i++) ip[i] = toFixedPoint(coefficients[i]);
+
+    auto rows = randomBytes(3 * sizeX * 4, 1);
+    const uint8_t* py[3] = {rows.data(), rows.data() + sizeX * 4, rows.data() + 2 * sizeX * 4};
+
+    // Same split as Convolve3x3Task::kernelU4: the kernel does two cells per iteration.
+    uint32_t x1 = 1;
+    uint32_t len = (sizeX - x1 - 1) >> 1;
+    std::vector<uint8_t> actual(len * 2 * 4);
+    rsdIntrinsicConvolve3x3_K(actual.data(), py[0] + (x1 - 1) * 4, py[1] + (x1 - 1) * 4,
+                              py[2] + (x1 - 1) * 4, ip, len);
+
+    std::vector<uint8_t> expected(actual.size());
+    for (uint32_t i = 0; i < len * 2; i++) {
+        uint32_t x = x1 + i;
+        for (int c = 0; c < 4; c++) {
+            float sum = 0;
+            for (int row = 0; row < 3; row++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    sum += py[row][(x + dx) * 4 + c] * coefficients[row * 3 + dx + 1];
+                }
+            }
+            expected[i * 4 + c] = clampToByte(sum + 0.5f);
+        }
+    }
+    expectClose("convolve3x3", expected.data(), actual.data(), expected.size(),
+                quantizationTolerance(coefficients, ip, 9));
+}
+
+void testConvolve5x5() {
+    const int sizeX = 71;
+    float coefficients[25];
+    int16_t ip[28] = {};
+    for (int i = 0; i < 25; i++) {
+        coefficients[i] = (i % 3 == 0 ? -0.02f : 0.06f) + (i == 12 ? 0.3f : 0.f);
+        ip[i] = toFixedPoint(coefficients[i]);
+    }
+
+    auto rows = randomBytes(5 * sizeX * 4, 2);
+    const uint8_t* py[5];
+    for (int row = 0; row < 5; row++) py[row] = rows.data() + row * sizeX * 4;
+
+    // Same split as Convolve5x5Task::kernelU4: the kernel does four cells per iteration.
+    uint32_t x1 = 2;
+    uint32_t len = (sizeX - x1 - 3) >> 2;
+    std::vector<uint8_t> actual(len * 4 * 4);
+    rsdIntrinsicConvolve5x5_K(actual.data(), py[0] + (x1 - 2) * 4, py[1] + (x1 - 2) * 4,
+                              py[2] + (x1 - 2) * 4, py[3] + (x1 - 2) * 4, py[4] + (x1 - 2) * 4,
+                              ip, len);
+
+    std::vector<uint8_t> expected(actual.size());
+    for (uint32_t i = 0; i < len * 4; i++) {
+        uint32_t x = x1 + i;
+        for (int c = 0; c < 4; c++) {
+            float sum = 0;
+            for (int row = 0; row < 5; row++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    sum += py[row][(x + dx) * 4 + c] * coefficients[row * 5 + dx + 2];
+                }
+            }
+            expected[i * 4 + c] = clampToByte(sum + 0.5f);
+        }
+    }
+    expectClose("convolve5x5", expected.data(), actual.data(), expected.size(),
+                quantizationTolerance(coefficients, ip, 25));
+}
+
+// Mirrors the uchar4 to uchar4 case of ColorMatrix.cpp One() with a zero add vector.
+void colorMatrixReference(const float* matrix, const uint8_t* in, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = in + i * 4;
+        for (int c = 0; c < 4; c++) {
+            float sum = p[0] * matrix[c] + p[1] * matrix[4 + c] + p[2] * matrix[8 + c] +
+                        p[3] * matrix[12 + c];
+            sum = sum < 0 ? 0 : (sum > 255.5f ? 255.5f : sum);
+            out[i * 4 + c] = (uint8_t)sum;
+        }
+    }
+}
+
+void testColorMatrix(const char* name, const float* matrix,
+                     void (*kernel)(void*, const void*, const short*, uint32_t)) {
+    const size_t count = 64;
+    int16_t ip[16];
+    for (int i = 0; i < 16; i++) ip[i] = (int16_t)(matrix[i] * 256.f + 0.5f);
+
+    // Offset by one cell so that unaligned inputs are covered.
+    auto input = randomBytes((count + 1) * 4, 3);
+    std::vector<uint8_t> actual(count * 4);
+    kernel(actual.data(), input.data() + 4, ip, count >> 2);
+
+    std::vector<uint8_t> expected(count * 4);
+    colorMatrixReference(matrix, input.data() + 4, expected.data(), count);
+    expectClose(name, expected.data(), actual.data(), expected.size(), 2);
+}
+
+void testColorMatrices() {
+    const float full[16] = {0.8f, 0.1f, 0.1f, 0.2f, 0.1f, 0.7f, 0.2f, 0.1f,
+                            0.05f, 0.1f, 0.6f, 0.3f, 0.f, 0.1f, 0.1f, 0.4f};
+    const float rgbOnly[16] = {0.393f, 0.349f, 0.272f, 0.f, 0.769f, 0.686f, 0.534f, 0.f,
+                               0.189f, 0.168f, 0.131f, 0.f, 0.f, 0.f, 0.f, 1.f};
+    const float grey[16] = {0.299f, 0.299f, 0.299f, 0.f, 0.587f, 0.587f, 0.587f, 0.f,
+                            0.114f, 0.114f, 0.114f, 0.f, 0.f, 0.f, 0.f, 1.f};
+    testColorMatrix("colorMatrix4x4", full, rsdIntrinsicColorMatrix4x4_K);
+    testColorMatrix("colorMatrix3x3", rgbOnly, rsdIntrinsicColorMatrix3x3_K);
+    testColorMatrix("colorMatrixDot", grey, rsdIntrinsicColorMatrixDot_K);
+}
+
+// Same as BlurTask::ComputeGaussianWeights.
+int gaussianWeights(float radius, float* weights) {
+    float sigma = 0.4f * radius + 0.6f;
+    float coeff1 = 1.0f / (sqrtf(2.0f * 3.1415926535897932f) * sigma);
+    float coeff2 = -1.0f / (2.0f * sigma * sigma);
+    int iradius = (float)ceil(radius) + 0.5f;
+    float normalizeFactor = 0.0f;
+    for (int r = -iradius; r <= iradius; r++) {
+        weights[r + iradius] = coeff1 * powf(2.718281828459045f, (float)(r * r) * coeff2);
+        normalizeFactor += weights[r + iradius];
+    }
+    for (int r = -iradius; r <= iradius; r++) {
+        weights[r + iradius] /= normalizeFactor;
+    }
+    return iradius;
+}
+
+void testBlur(float radius) {
+    float weights[104] = {};
+    int iradius = gaussianWeights(radius, weights);
+    int diameter = iradius * 2 + 1;
+    const int sizeX = 96;
+    std::string suffix = " r=" + std::to_string((int)radius);
+
+    // Vertical pass, uchar4 to float4, two cells per iteration.
+    auto input = randomBytes(diameter * sizeX * 4, 4);
+    std::vector<float> vertical(sizeX * 4);
+    rsdIntrinsicBlurVFU4_K(vertical.data(), input.data(), sizeX * 4, weights, diameter, 0, sizeX);
+    std::vector<float> expectedVertical(sizeX * 4);
+    for (int x = 0; x < sizeX; x++) {
+        for (int c = 0; c < 4; c++) {
+            float sum = 0;
+            for (int r = 0; r < diameter; r++) {
+                sum += input[(r * sizeX + x) * 4 + c] * weights[r];
+            }
+            expectedVertical[x * 4 + c] = sum;
+        }
+    }
+    expectClose("blurVFU4" + suffix, expectedVertical.data(), vertical.data(), sizeX * 4, 0.01f);
+
+    // Horizontal pass over a padded float row, as done by BlurTask::kernelU4 for interior cells.
+    std::vector<float> row((sizeX + 2 * iradius + 8) * 4);
+    for (size_t i = 0; i < row.size(); i++) row[i] = (float)((i * 37) % 256);
+    int x1 = iradius;
+    int x2 = sizeX - iradius;
+    std::vector<uint8_t> actual((x2 - x1) * 4);
+    rsdIntrinsicBlurHFU4_K(actual.data(), row.data(), weights, diameter, x1, x2);
+    std::vector<uint8_t> expected(actual.size());
+    for (int x = x1; x < x2; x++) {
+        for (int c = 0; c < 4; c++) {
+            float sum = 0;
+            for (int r = 0; r < diameter; r++) sum += row[(x + r) * 4 + c] * weights[r];
+            expected[(x - x1) * 4 + c] = (uint8_t)sum;
+        }
+    }
+    expectClose("blurHFU4" + suffix, expected.data(), actual.data(), expected.size(), 1);
+
+    // Horizontal pass for single channel data, four cells per iteration.
+    std::vector<float> row1(sizeX + 2 * iradius + 8);
+    for (size_t i = 0; i < row1.size(); i++) row1[i] = (float)((i * 53) % 256);
+    int len = (x2 - x1) & ~3;
+    std::vector<uint8_t> actual1(len);
+    rsdIntrinsicBlurHFU1_K(actual1.data(), row1.data(), weights, diameter, x1, x1 + len);
+    std::vector<uint8_t> expected1(len);
+    for (int x = x1; x < x1 + len; x++) {
+        float sum = 0;
+        for (int r = 0; r < diameter; r++) sum += row1[x + r] * weights[r];
+        expected1[x - x1] = (uint8_t)sum;
+    }
+    expectClose("blurHFU1" + suffix, expected1.data(), actual1.data(), expected1.size(), 1);
+}
+
+const short YuvCoeff[] = {
+    298, 409, -100, 516,   -208, 255, 0, 0,
+    16, 16, 16, 16,        16, 16, 16, 16,
+    128, 128, 128, 128, 128, 128, 128, 128,
+    298, 298, 298, 298, 298, 298, 298, 298,
+    255, 255, 255, 255, 255, 255, 255, 255
+};
+
+// Same as rsYuvToRGBA_uchar4 in YuvToRgb.cpp.
+void yuvReference(uint8_t y, uint8_t u, uint8_t v, uint8_t* out) {
+    int Y = (int)y - 16;
+    int U = (int)u - 128;
+    int V = (int)v - 128;
+    int p[3] = {(Y * 298 + V * 409 + 128) >> 8, (Y * 298 - U * 100 - V * 208 + 128) >> 8,
+                (Y * 298 + U * 516 + 128) >> 8};
+    for (int c = 0; c < 3; c++) out[c] = (uint8_t)std::min(std::max(p[c], 0), 255);
+    out[3] = 255;
+}
+
+void testYuv() {
+    const uint32_t blocks = 6;
+    const uint32_t width = blocks * 8;
+    auto y = randomBytes(width, 5);
+    auto uv = randomBytes(width, 6);
+    auto u = randomBytes(width / 2, 7);
+    auto v = randomBytes(width / 2, 8);
+    std::vector<uint8_t> actual(width * 4);
+    std::vector<uint8_t> expected(width * 4);
+
+    // NV21, interleaved V then U.
+    rsdIntrinsicYuv_K(actual.data(), y.data(), uv.data(), blocks, YuvCoeff);
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t cx = (x >> 1) * 2;
+        yuvReference(y[x], uv[cx + 1], uv[cx], &expected[x * 4]);
+    }
+    expectClose("yuv NV21", expected.data(), actual.data(), expected.size(), 0);
+
+    // Interleaved U then V.
+    rsdIntrinsicYuvR_K(actual.data(), y.data(), uv.data(), blocks, YuvCoeff);
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t cx = (x >> 1) * 2;
+        yuvReference(y[x], uv[cx], uv[cx + 1], &expected[x * 4]);
+    }
+    expectClose("yuv NV12", expected.data(), actual.data(), expected.size(), 0);
+
+    // Planar, YV12.
+    rsdIntrinsicYuv2_K(actual.data(), y.data(), u.data(), v.data(), blocks, YuvCoeff);
+    for (uint32_t x = 0; x < width; x++) {
+        yuvReference(y[x], u[x >> 1], v[x >> 1], &expected[x * 4]);
+    }
+    expectClose("yuv YV12", expected.data(), actual.data(), expected.size(), 0);
+}
+
+// Scalar versions of the BlendTask::blend cases, for one uchar4 cell.
+using BlendReference = std::function<void(const uint8_t* in, uint8_t* out)>;
+
+uint8_t clip(uint32_t value) { return (uint8_t)std::min(value, 255u); }
+
+void testBlend(const char* name, void (*kernel)(void*, const void*, uint32_t),
+               const BlendReference& reference, int tolerance) {
+    const uint32_t count8 = 16;
+    auto in = randomBytes(count8 * 8 * 4, 9);
+    auto out = randomBytes(count8 * 8 * 4, 10);
+    std::vector<uint8_t> expected = out;
+    for (uint32_t i = 0; i < count8 * 8; i++) {
+        reference(&in[i * 4], &expected[i * 4]);
+    }
+    kernel(out.data(), in.data(), count8);
+    expectClose(std::string("blend ") + name, expected.data(), out.data(), expected.size(),
+                tolerance);
+}
+
+void testBlends() {
+    testBlend("srcOver", rsdIntrinsicBlendSrcOver_K, [](const uint8_t* in, uint8_t* out) {
+        uint32_t a = 255 - in[3];
+        for (int c = 0; c < 4; c++) out[c] = clip(in[c] + ((out[c] * a) >> 8));
+    }, 1);
+    testBlend("dstOver", rsdIntrinsicBlendDstOver_K, [](const uint8_t* in, uint8_t* out) {
+        uint32_t a = 255 - out[3];
+        for (int c = 0; c < 4; c++) out[c] = clip(out[c] + ((in[c] * a) >> 8));
+    }, 1);
+    testBlend("srcIn", rsdIntrinsicBlendSrcIn_K, [](const uint8_t* in, uint8_t* out) {
+        uint32_t a = out[3];
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)((in[c] * a) >> 8);
+    }, 1);
+    testBlend("dstIn", rsdIntrinsicBlendDstIn_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)((out[c] * in[3]) >> 8);
+    }, 1);
+    testBlend("srcOut", rsdIntrinsicBlendSrcOut_K, [](const uint8_t* in, uint8_t* out) {
+        uint32_t a = 255 - out[3];
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)((in[c] * a) >> 8);
+    }, 1);
+    testBlend("dstOut", rsdIntrinsicBlendDstOut_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)((out[c] * (255 - in[3])) >> 8);
+    }, 1);
+    testBlend("srcAtop", rsdIntrinsicBlendSrcAtop_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = clip((in[c] * out[3] + out[c] * (255 - in[3])) >> 8);
+        }
+    }, 1);
+    testBlend("dstAtop", rsdIntrinsicBlendDstAtop_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = clip((out[c] * in[3] + in[c] * (255 - out[3])) >> 8);
+        }
+        out[3] = in[3];
+    }, 1);
+    testBlend("xor", rsdIntrinsicBlendXor_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] ^= in[c];
+    }, 0);
+    testBlend("multiply", rsdIntrinsicBlendMultiply_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)((in[c] * out[c]) >> 8);
+    }, 1);
+    testBlend("add", rsdIntrinsicBlendAdd_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] = clip(in[c] + out[c]);
+    }, 0);
+    testBlend("subtract", rsdIntrinsicBlendSub_K, [](const uint8_t* in, uint8_t* out) {
+        for (int c = 0; c < 4; c++) out[c] = (uint8_t)std::max(out[c] - in[c], 0);
+    }, 0);
+}
+
+// Same sums as reduceRun in Reduction.cpp: sum, sum of squares, sum of x times value, min, max.
+void testReduce() {
+    // The longest run reduceRun gives the kernel, all 255 first so that the sums are at their
+    // largest, then random.
+    const uint32_t count = 2048;
+    for (int fill = 0; fill < 2; fill++) {
+        auto in = fill == 0 ? std::vector<uint8_t>(count * 4, 255) : randomBytes(count * 4, 11);
+        for (uint32_t channel = 0; channel <= 4; channel++) {
+            uint32_t expected[5] = {0, 0, 0, 255 * 3, 0};
+            for (uint32_t x = 0; x < count; x++) {
+                const uint8_t* v = &in[x * 4];
+                uint32_t value = channel <= 3 ? v[channel] : v[0] + v[1] + v[2];
+                expected[0] += value;
+                expected[1] += value * value;
+                expected[2] += x * value;
+                expected[3] = std::min(expected[3], value);
+                expected[4] = std::max(expected[4], value);
+            }
+            uint32_t actual[5] = {0, 0, 0, 255 * 3, 0};
+            rsdIntrinsicReduce_K(actual, in.data(), channel, count / 4);
+
+            std::string name = "reduce channel " + std::to_string(channel) +
+                               (fill == 0 ? " white" : " random");
+            if (!std::equal(expected, expected + 5, actual)) {
+                printf("FAIL %s: expected %u %u %u %u %u got %u %u %u %u %u\n", name.c_str(),
+                       expected[0], expected[1], expected[2], expected[3], expected[4],
+                       actual[0], actual[1], actual[2], actual[3], actual[4]);
+                failures++;
+            } else {
+                printf("ok   %s\n", name.c_str());
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    testConvolve3x3();
+    testConvolve5x5();
+    testColorMatrices();
+    testBlur(5.f);
+    testBlur(25.f);
+    testYuv();
+    testBlends();
+    testReduce();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
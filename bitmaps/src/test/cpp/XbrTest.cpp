@@ -0,0 +1,320 @@
+// Compares xbr2x and xbr with a reference that evaluates the 5x5 neighborhood of each pixel on
+// its own, as the original 2x implementation did. At 2x the reference fills the blocks the way
+// the original did, at 3x and 4x it rasterizes the lines of xBR with the centers of the cells.
+// Checks the border blocks, where the neighborhood is clamped, apart from the others, and that
+// nothing is written past the output or outside the restriction.
+//
+//    cmake -S bitmaps/src/test/cpp -B build -DCMAKE_CXX_COMPILER=clang++
+//    cmake --build build && ctest --test-dir build
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "RenderScriptToolkit.h"
+
+using namespace renderscript;
+
+namespace {
+
+constexpr uint8_t kUntouched = 0x5A;
+// Bytes after the end of the output that must stay untouched.
+constexpr size_t kGuard = 64;
+
+int failures = 0;
+
+void check(bool ok, const std::string& message) {
+    printf("%s %s\n", ok ? "ok  " : "FAIL", message.c_str());
+    if (!ok) failures++;
+}
+
+float colorDist(uint32_t c1, uint32_t c2) {
+    int r = std::abs((int)(c1 & 0xFF) - (int)(c2 & 0xFF));
+    int g = std::abs((int)((c1 >> 8) & 0xFF) - (int)((c2 >> 8) & 0xFF));
+    int b = std::abs((int)((c1 >> 16) & 0xFF) - (int)((c2 >> 16) & 0xFF));
+    int a = std::abs((int)(c1 >> 24) - (int)(c2 >> 24));
+
+    double y = std::fabs(0.299 * r + 0.587 * g + 0.114 * b);
+    double u = std::fabs(-0.169 * r - 0.331 * g + 0.500 * b);
+    double v = std::fabs(0.500 * r - 0.419 * g - 0.081 * b);
+    return (float)(48.0 * y + 7.0 * u + 6.0 * v + 48.0 * a);
+}
+
+/**
+ * The edge found at a corner of a pixel: whether there's one, the color across it, and whether
+ * it's shallow (it takes the cell next to the corner in the row at 2x) or steep (in the column).
+ */
+struct Edge {
+    bool found = false;
+    uint32_t color = 0;
+    bool shallow = false;
+    bool steep = false;
+};
+
+/**
+ * The corners, in the order the edges are applied: bottom right, top right, top left and
+ * bottom left. The later ones win.
+ */
+enum Corner { kBottomRight, kTopRight, kTopLeft, kBottomLeft };
+
+struct Image {
+    size_t sizeX;
+    size_t sizeY;
+    std::vector<uint32_t> pixels;
+
+    uint32_t get(long x, long y) const {
+        x = std::max(0L, std::min((long)sizeX - 1, x));
+        y = std::max(0L, std::min((long)sizeY - 1, y));
+        return pixels[y * sizeX + x];
+    }
+};
+
+/**
+ * The edges at the four corners of a pixel, with the weights of the original xbr2x.
+ */
+void findEdges(const Image& image, long x, long y, Edge edges[4]) {
+    //     A1 B1 C1
+    // A0  A  B  C  C4
+    // D0  D  E  F  F4
+    // G0  G  H  I  I4
+    //     G5 H5 I5
+    const uint32_t a = image.get(x - 1, y - 1), b = image.get(x, y - 1),
+                   c = image.get(x + 1, y - 1), d = image.get(x - 1, y), e = image.get(x, y),
+                   f = image.get(x + 1, y), g = image.get(x - 1, y + 1),
+                   h = image.get(x, y + 1), i = image.get(x + 1, y + 1);
+    const uint32_t a1 = image.get(x - 1, y - 2), b1 = image.get(x, y - 2),
+                   c1 = image.get(x + 1, y - 2), a0 = image.get(x - 2, y - 1),
+                   c4 = image.get(x + 2, y - 1), d0 = image.get(x - 2, y),
+                   f4 = image.get(x + 2, y), g0 = image.get(x - 2, y + 1),
+                   i4 = image.get(x + 2, y + 1), g5 = image.get(x - 1, y + 2),
+                   h5 = image.get(x, y + 2), i5 = image.get(x + 1, y + 2);
+
+    float wd1 = colorDist(e, c) + colorDist(e, g) + colorDist(i, f4) + colorDist(i, h5) +
+                4 * colorDist(h, f);
+    float wd2 = colorDist(h, d) + colorDist(h, i5) + colorDist(f, i4) + colorDist(f, b) +
+                4 * colorDist(e, i);
+    edges[kBottomRight] = {wd1 < wd2, colorDist(e, f) <= colorDist(e, h) ? f : h, f == g,
+                           h == c};
+
+    wd1 = colorDist(e, i) + colorDist(e, a) + colorDist(c, f4) + colorDist(c, b1) +
+          4 * colorDist(b, f);
+    wd2 = colorDist(b, d) + colorDist(b, c1) + colorDist(f, h) + colorDist(f, c4) +
+          4 * colorDist(e, c);
+    edges[kTopRight] = {wd1 < wd2, colorDist(e, f) <= colorDist(e, b) ? f : b, f == a, b == i};
+
+    wd1 = colorDist(e, g) + colorDist(e, c) + colorDist(a, d0) + colorDist(a, b1) +
+          4 * colorDist(b, d);
+    wd2 = colorDist(b, f) + colorDist(b, a1) + colorDist(d, h) + colorDist(d, a0) +
+          4 * colorDist(e, a);
+    edges[kTopLeft] = {wd1 < wd2, colorDist(e, d) <= colorDist(e, b) ? d : b, d == c, b == g};
+
+    wd1 = colorDist(e, i) + colorDist(e, a) + colorDist(g, d0) + colorDist(g, h5) +
+          4 * colorDist(h, d);
+    wd2 = colorDist(h, f) + colorDist(h, g5) + colorDist(d, b) + colorDist(d, g0) +
+          4 * colorDist(e, g);
+    edges[kBottomLeft] = {wd1 < wd2, colorDist(e, d) <= colorDist(e, h) ? d : h, d == i,
+                          h == a};
+}
+
+/**
+ * The block of a pixel at 2x, filled as the original xbr2x did: the corner cell, plus the
+ * other cell of its row when shallow and of its column when steep.
+ */
+void block2x(const Edge edges[4], uint32_t e, uint32_t* cells) {
+    // The cells of each corner, then the one next to it in the row and in the column.
+    static const int kCells[4][3] = {{3, 2, 1}, {1, 0, 3}, {0, 1, 2}, {2, 3, 0}};
+    for (int i = 0; i < 4; i++) cells[i] = e;
+    for (int corner = 0; corner < 4; corner++) {
+        const Edge& edge = edges[corner];
+        if (!edge.found) continue;
+        cells[kCells[corner][0]] = edge.color;
+        if (edge.shallow) cells[kCells[corner][1]] = edge.color;
+        if (edge.steep) cells[kCells[corner][2]] = edge.color;
+    }
+}
+
+/**
+ * The block of a pixel at any scale. In the frame of the pixel, of size 1 with the corner at
+ * (1, 1), a cell takes the color when its center is on or past x + y = 1.5, x + 2y = 1.75 when
+ * shallow or 2x + y = 1.75 when steep.
+ */
+void blockScaled(const Edge edges[4], uint32_t e, size_t scale, uint32_t* cells) {
+    for (size_t i = 0; i < scale * scale; i++) cells[i] = e;
+    for (int corner = 0; corner < 4; corner++) {
+        const Edge& edge = edges[corner];
+        if (!edge.found) continue;
+        const bool left = corner == kTopLeft || corner == kBottomLeft;
+        const bool top = corner == kTopLeft || corner == kTopRight;
+        for (size_t row = 0; row < scale; row++) {
+            for (size_t column = 0; column < scale; column++) {
+                double x = (column + 0.5) / scale;
+                double y = (row + 0.5) / scale;
+                if (left) x = 1 - x;
+                if (top) y = 1 - y;
+                if (x + y >= 1.5 || (edge.shallow && x + 2 * y >= 1.75) ||
+                    (edge.steep && 2 * x + y >= 1.75)) {
+                    cells[row * scale + column] = edge.color;
+                }
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> reference(const Image& image, size_t scale) {
+    const size_t outSizeX = image.sizeX * scale;
+    std::vector<uint32_t> out(outSizeX * image.sizeY * scale);
+    std::vector<uint32_t> cells(scale * scale);
+    for (size_t y = 0; y < image.sizeY; y++) {
+        for (size_t x = 0; x < image.sizeX; x++) {
+            Edge edges[4];
+            findEdges(image, (long)x, (long)y, edges);
+            const uint32_t e = image.pixels[y * image.sizeX + x];
+            if (scale == 2) {
+                block2x(edges, e, cells.data());
+            } else {
+                blockScaled(edges, e, scale, cells.data());
+            }
+            for (size_t row = 0; row < scale; row++) {
+                for (size_t column = 0; column < scale; column++) {
+                    out[(y * scale + row) * outSizeX + x * scale + column] =
+                            cells[row * scale + column];
+                }
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * A pixel art like image: a few colors, one of them transparent, in blocks and lines, with
+ * some noise.
+ */
+Image createImage(std::mt19937& generator, size_t sizeX, size_t sizeY) {
+    uint32_t palette[5];
+    for (auto& color : palette) color = generator() | 0xFF000000u;
+    palette[4] &= 0x00FFFFFFu;
+    Image image{sizeX, sizeY, std::vector<uint32_t>(sizeX * sizeY)};
+    for (size_t y = 0; y < sizeY; y++) {
+        for (size_t x = 0; x < sizeX; x++) {
+            uint32_t color = palette[(x / 3 + y / 2 + ((x * y) % 7 == 0)) % 5];
+            if (generator() % 17 == 0) color = palette[generator() % 5];
+            image.pixels[y * sizeX + x] = color;
+        }
+    }
+    return image;
+}
+
+/**
+ * Upscales the image with the toolkit and compares each block with the reference. With a
+ * restriction, the blocks of the other pixels must be untouched. The rows are padded when
+ * strided is set.
+ */
+void compare(RenderScriptToolkit& toolkit, const Image& image, size_t scale,
+             bool restricted, bool strided, bool viaXbr2x) {
+    const size_t sizeX = image.sizeX;
+    const size_t sizeY = image.sizeY;
+    const size_t outSizeX = sizeX * scale;
+    const size_t inStride = strided ? sizeX * 4 + 12 : sizeX * 4;
+    const size_t outStride = strided ? outSizeX * 4 + 64 : outSizeX * 4;
+
+    Restriction restriction{0, sizeX, 0, sizeY, 0, 0};
+    if (restricted) {
+        restriction = {sizeX / 3, sizeX - sizeX / 4, sizeY / 4, sizeY - sizeY / 5, 0, 0};
+        if (restriction.endX <= restriction.startX || restriction.endY <= restriction.startY) {
+            return;
+        }
+    }
+    if (strided) {
+        restriction.inputStride = inStride;
+        restriction.outputStride = outStride;
+    }
+    const Restriction* r = restricted || strided ? &restriction : nullptr;
+
+    std::vector<uint8_t> in(inStride * sizeY, 0);
+    for (size_t y = 0; y < sizeY; y++) {
+        memcpy(&in[y * inStride], &image.pixels[y * sizeX], sizeX * 4);
+    }
+    const size_t outBytes = outStride * (sizeY * scale - 1) + outSizeX * 4;
+    std::vector<uint8_t> out(outBytes + kGuard, kUntouched);
+    if (viaXbr2x) {
+        toolkit.xbr2x(in.data(), out.data(), sizeX, sizeY, r);
+    } else {
+        toolkit.xbr(in.data(), out.data(), sizeX, sizeY, scale, r);
+    }
+
+    const std::vector<uint32_t> expected = reference(image, scale);
+    uint32_t untouched;
+    memset(&untouched, kUntouched, sizeof(untouched));
+    size_t borderMismatches = 0;
+    size_t interiorMismatches = 0;
+    size_t touchedOutside = 0;
+    for (size_t y = 0; y < sizeY * scale; y++) {
+        for (size_t x = 0; x < outSizeX; x++) {
+            uint32_t actual;
+            memcpy(&actual, &out[y * outStride + x * 4], 4);
+            const size_t inX = x / scale;
+            const size_t inY = y / scale;
+            if (inX < restriction.startX || inX >= restriction.endX ||
+                inY < restriction.startY || inY >= restriction.endY) {
+                touchedOutside += actual != untouched;
+                continue;
+            }
+            if (actual == expected[y * outSizeX + x]) continue;
+            // The neighborhoods of the two outer rings of pixels are clamped.
+            const bool border = inX < 2 || inY < 2 || inX + 2 >= sizeX || inY + 2 >= sizeY;
+            (border ? borderMismatches : interiorMismatches)++;
+        }
+    }
+    size_t touchedPadding = 0;
+    for (size_t y = 0; y + 1 < sizeY * scale; y++) {
+        for (size_t i = outSizeX * 4; i < outStride; i++) {
+            touchedPadding += out[y * outStride + i] != kUntouched;
+        }
+    }
+    size_t touchedGuard = 0;
+    for (size_t i = outBytes; i < out.size(); i++) touchedGuard += out[i] != kUntouched;
+
+    char name[120];
+    snprintf(name, sizeof(name), "%s %zux%zu at %zux%s%s", viaXbr2x ? "xbr2x" : "xbr", sizeX,
+             sizeY, scale, restricted ? " restricted" : "", strided ? " strided" : "");
+    check(borderMismatches == 0 && interiorMismatches == 0,
+          std::string(name) + ": " + std::to_string(borderMismatches) + " border and " +
+                  std::to_string(interiorMismatches) + " interior pixels differ");
+    check(touchedOutside == 0 && touchedPadding == 0 && touchedGuard == 0,
+          std::string(name) + ": " + std::to_string(touchedOutside) + " pixels outside, " +
+                  std::to_string(touchedPadding) + " padding and " +
+                  std::to_string(touchedGuard) + " guard bytes written");
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 generator(5);
+    const size_t sizes[][2] = {{1, 1}, {2, 3}, {5, 1}, {17, 9}, {64, 48}, {301, 157}};
+    for (unsigned threads : {1u, 3u}) {
+        RenderScriptToolkit toolkit(threads);
+        for (const auto& size : sizes) {
+            const Image image = createImage(generator, size[0], size[1]);
+            for (bool restricted : {false, true}) {
+                for (bool strided : {false, true}) {
+                    compare(toolkit, image, 2, restricted, strided, true);
+                    for (size_t scale : {2, 3, 4}) {
+                        compare(toolkit, image, scale, restricted, strided, false);
+                    }
+                }
+            }
+        }
+    }
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}